@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "pcap-replay-helper.h"
+#include "ns3/string.h"
+
+namespace ns3 {
+
+PcapReplayHelper::PcapReplayHelper (std::string filename)
+{
+  m_factory.SetTypeId (PcapReplay::GetTypeId ());
+  SetAttribute ("Filename", StringValue (filename));
+  m_trace = PcapReplayTrace::Get (filename);
+}
+
+void
+PcapReplayHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+void
+PcapReplayHelper::MapAddress (Ipv4Address captured, Ipv4Address simulated)
+{
+  m_trace->MapAddress (captured, simulated);
+}
+
+ApplicationContainer
+PcapReplayHelper::Install (Ptr<Node> node, Ipv4Address source) const
+{
+  Ptr<PcapReplay> app = m_factory.Create<PcapReplay> ();
+  app->SetAttribute ("Source", Ipv4AddressValue (source));
+  app->SetTrace (m_trace);
+  node->AddApplication (app);
+  return ApplicationContainer (app);
+}
+
+Ptr<PcapReplayTrace>
+PcapReplayHelper::GetTrace (void) const
+{
+  return m_trace;
+}
+
+} // namespace ns3
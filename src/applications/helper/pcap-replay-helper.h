@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_REPLAY_HELPER_H
+#define PCAP_REPLAY_HELPER_H
+
+#include <string>
+#include "ns3/application-container.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/pcap-replay.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup pcapreplay
+ * \brief Replay the hosts of a pcap or pcapng capture on nodes.
+ *
+ * Each captured host is replayed by a PcapReplay application on the
+ * node standing for it; the capture is read once for all of them.
+ *
+ * \code
+ *   PcapReplayHelper replay ("capture.pcap");
+ *   replay.MapAddress ("192.168.1.20", interfaces.GetAddress (1));
+ *   ApplicationContainer apps = replay.Install (nodes.Get (0), "192.168.1.10");
+ *   apps.Start (Seconds (1.0));
+ * \endcode
+ */
+class PcapReplayHelper
+{
+public:
+  /**
+   * Create a PcapReplayHelper to replay a capture.
+   * \param filename The name of the pcap or pcapng file.
+   */
+  PcapReplayHelper (std::string filename);
+
+  /**
+   * Record an attribute to be set in each Application after it is is created.
+   *
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Send the packets captured to an address to another address.
+   * \param captured The address in the capture.
+   * \param simulated The address to send the packets to.
+   */
+  void MapAddress (Ipv4Address captured, Ipv4Address simulated);
+
+  /**
+   * Create an application sending the packets of a captured host.
+   *
+   * \param node The node on which to create the application.
+   * \param source The address of the host in the capture.
+   * \returns The application created.
+   */
+  ApplicationContainer Install (Ptr<Node> node, Ipv4Address source) const;
+
+  /**
+   * \returns The capture replayed.
+   */
+  Ptr<PcapReplayTrace> GetTrace (void) const;
+
+private:
+  ObjectFactory m_factory;        //!< Object factory.
+  Ptr<PcapReplayTrace> m_trace;   //!< The capture replayed.
+};
+
+} // namespace ns3
+
+#endif /* PCAP_REPLAY_HELPER_H */
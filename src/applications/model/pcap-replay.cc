@@ -0,0 +1,646 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/string.h"
+#include "ns3/trace-source-accessor.h"
+#include "pcap-replay.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapReplay");
+
+NS_OBJECT_ENSURE_REGISTERED (PcapReplay);
+
+/** The largest frame read, enough for any IPv4 packet and its link header. */
+static const uint32_t MAX_FRAME_SIZE = 65536 + 64;
+/** The largest UDP payload sent. */
+static const uint32_t MAX_UDP_PAYLOAD = 65507;
+
+/** pcapng section header block type */
+static const uint32_t NG_SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+/** pcapng interface description block type */
+static const uint32_t NG_INTERFACE_DESCRIPTION_BLOCK = 1;
+/** pcapng enhanced packet block type */
+static const uint32_t NG_ENHANCED_PACKET_BLOCK = 6;
+/** pcapng byte order magic, as read in the byte order of the writer */
+static const uint32_t NG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+/** pcapng byte order magic, as read in the other byte order */
+static const uint32_t NG_BYTE_ORDER_MAGIC_SWAPPED = 0x4d3c2b1a;
+
+/**
+ * Read a 16 bit value of a pcapng block.
+ * \param [in] p The value.
+ * \param [in] swap Whether to swap its bytes.
+ * \returns The value.
+ */
+static uint16_t
+NgValue16 (const uint8_t *p, bool swap)
+{
+  uint16_t value;
+  std::memcpy (&value, p, sizeof (value));
+  return swap ? ((value & 0xff) << 8) | (value >> 8) : value;
+}
+
+/**
+ * Read a 32 bit value of a pcapng block.
+ * \param [in] p The value.
+ * \param [in] swap Whether to swap its bytes.
+ * \returns The value.
+ */
+static uint32_t
+NgValue32 (const uint8_t *p, bool swap)
+{
+  uint32_t value;
+  std::memcpy (&value, p, sizeof (value));
+  if (swap)
+    {
+      value = ((value & 0xff) << 24) | ((value & 0xff00) << 8)
+        | ((value >> 8) & 0xff00) | (value >> 24);
+    }
+  return value;
+}
+
+/**
+ * Read a 16 bit value in network byte order.
+ * \param [in] p The value.
+ * \returns The value.
+ */
+static uint16_t
+NetworkValue16 (const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+/**
+ * Get the open captures, by name.
+ * \returns The open captures.
+ */
+static std::map<std::string, PcapReplayTrace *> &
+GetReplayTraces (void)
+{
+  static std::map<std::string, PcapReplayTrace *> traces;
+  return traces;
+}
+
+Ptr<PcapReplayTrace>
+PcapReplayTrace::Get (const std::string &filename)
+{
+  NS_LOG_FUNCTION (filename);
+  std::map<std::string, PcapReplayTrace *>::const_iterator it = GetReplayTraces ().find (filename);
+  if (it != GetReplayTraces ().end ())
+    {
+      return it->second;
+    }
+  Ptr<PcapReplayTrace> trace = Ptr<PcapReplayTrace> (new PcapReplayTrace (filename), false);
+  GetReplayTraces ()[filename] = PeekPointer (trace);
+  return trace;
+}
+
+PcapReplayTrace::PcapReplayTrace (const std::string &filename)
+  : m_filename (filename),
+    m_ng (false),
+    m_ngSwap (false),
+    m_frame (MAX_FRAME_SIZE),
+    m_started (false),
+    m_scheduled (false),
+    m_eof (false),
+    m_firstRead (false),
+    m_packetsRead (0)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_ngFile.open (filename.c_str (), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_ngFile, "PcapReplayTrace: Unable to open file \"" << filename << "\"");
+  uint32_t blockType = 0;
+  m_ngFile.read (reinterpret_cast<char *> (&blockType), sizeof (blockType));
+  if (m_ngFile && blockType == NG_SECTION_HEADER_BLOCK)
+    {
+      m_ng = true;
+      m_ngFile.seekg (0);
+      return;
+    }
+  m_ngFile.close ();
+  m_pcap.Open (filename, std::ios::in);
+  NS_ABORT_MSG_IF (m_pcap.Fail (), "PcapReplayTrace: \"" << filename << "\" is not a pcap or pcapng file");
+}
+
+PcapReplayTrace::~PcapReplayTrace ()
+{
+  NS_LOG_FUNCTION (this);
+  GetReplayTraces ().erase (m_filename);
+}
+
+void
+PcapReplayTrace::MapAddress (Ipv4Address captured, Ipv4Address simulated)
+{
+  NS_LOG_FUNCTION (this << captured << simulated);
+  m_addresses[captured] = simulated;
+}
+
+void
+PcapReplayTrace::AddSource (Ipv4Address source, PcapReplay *app)
+{
+  NS_LOG_FUNCTION (this << source << app);
+  std::map<Ipv4Address, PcapReplay *>::const_iterator it = m_sources.find (source);
+  NS_ABORT_MSG_IF (it != m_sources.end () && it->second != app,
+                   "PcapReplayTrace: " << source << " is already replayed by another application");
+  m_sources[source] = app;
+
+  if (m_scheduled || m_eof)
+    {
+      return;
+    }
+  // Read once the other applications starting now added their source,
+  // so that the packets they send first are not skipped.
+  m_scheduled = true;
+  Simulator::ScheduleNow (&PcapReplayTrace::Start, Ptr<PcapReplayTrace> (this));
+}
+
+void
+PcapReplayTrace::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_scheduled = false;
+  if (m_sources.empty ())
+    {
+      return;
+    }
+  // Skip the packets that were due while no application was running.
+  Time notBefore = Time::Min ();
+  if (m_started)
+    {
+      notBefore = Simulator::Now () - m_startTime;
+    }
+  else
+    {
+      m_started = true;
+      m_startTime = Simulator::Now ();
+    }
+  if (ReadNext (notBefore))
+    {
+      ScheduleNext ();
+    }
+}
+
+void
+PcapReplayTrace::RemoveSource (Ipv4Address source, PcapReplay *app)
+{
+  NS_LOG_FUNCTION (this << source << app);
+  std::map<Ipv4Address, PcapReplay *>::iterator it = m_sources.find (source);
+  if (it != m_sources.end () && it->second == app)
+    {
+      m_sources.erase (it);
+    }
+}
+
+uint64_t
+PcapReplayTrace::GetPacketsRead (void) const
+{
+  return m_packetsRead;
+}
+
+bool
+PcapReplayTrace::ReadFrame (uint32_t &linkType, Time &t, uint32_t &capturedLen)
+{
+  if (m_ng)
+    {
+      return ReadNgFrame (linkType, t, capturedLen);
+    }
+  if (m_pcap.Fail () || m_pcap.Eof ())
+    {
+      return false;
+    }
+  uint32_t tsSec;
+  uint32_t tsFraction;
+  uint32_t inclLen;
+  uint32_t origLen;
+  m_pcap.Read (&m_frame[0], m_frame.size (), tsSec, tsFraction, inclLen, origLen, capturedLen);
+  if (m_pcap.Fail ())
+    {
+      return false;
+    }
+  linkType = m_pcap.GetDataLinkType ();
+  int64_t ns = m_pcap.IsNanoSecMode () ? tsFraction : tsFraction * 1000LL;
+  t = NanoSeconds (tsSec * 1000000000LL + ns);
+  return true;
+}
+
+bool
+PcapReplayTrace::ReadNgFrame (uint32_t &linkType, Time &t, uint32_t &capturedLen)
+{
+  for (;;)
+    {
+      uint8_t header[8];
+      if (!m_ngFile.read (reinterpret_cast<char *> (header), sizeof (header)))
+        {
+          return false;
+        }
+      uint32_t blockType = NgValue32 (header, false);
+      if (blockType == NG_SECTION_HEADER_BLOCK)
+        {
+          // The byte order magic tells the byte order of the section.
+          uint8_t magic[4];
+          if (!m_ngFile.read (reinterpret_cast<char *> (magic), sizeof (magic)))
+            {
+              return false;
+            }
+          uint32_t byteOrder = NgValue32 (magic, false);
+          if (byteOrder != NG_BYTE_ORDER_MAGIC && byteOrder != NG_BYTE_ORDER_MAGIC_SWAPPED)
+            {
+              NS_LOG_WARN ("Invalid pcapng section in " << m_filename);
+              return false;
+            }
+          m_ngSwap = byteOrder == NG_BYTE_ORDER_MAGIC_SWAPPED;
+          m_ngInterfaces.clear ();
+          m_ngFile.ignore (NgValue32 (header + 4, m_ngSwap) - 12);
+          continue;
+        }
+      blockType = NgValue32 (header, m_ngSwap);
+      uint32_t blockLength = NgValue32 (header + 4, m_ngSwap);
+      if (blockLength < 12 || blockLength % 4 != 0)
+        {
+          NS_LOG_WARN ("Invalid pcapng block in " << m_filename);
+          return false;
+        }
+      // The body of the block, and the trailing block length.
+      uint32_t bodyLength = blockLength - 12;
+
+      if (blockType == NG_INTERFACE_DESCRIPTION_BLOCK && bodyLength >= 8)
+        {
+          std::vector<uint8_t> body (bodyLength + 4);
+          if (!m_ngFile.read (reinterpret_cast<char *> (&body[0]), body.size ()))
+            {
+              return false;
+            }
+          Interface interface;
+          interface.linkType = NgValue16 (&body[0], m_ngSwap);
+          interface.tsresol = 6;
+          for (uint32_t offset = 8; offset + 4 <= bodyLength; )
+            {
+              uint16_t code = NgValue16 (&body[offset], m_ngSwap);
+              uint16_t length = NgValue16 (&body[offset + 2], m_ngSwap);
+              if (code == 0)
+                {
+                  break;
+                }
+              if (code == 9 && length >= 1 && offset + 4 < bodyLength)
+                {
+                  interface.tsresol = body[offset + 4];
+                }
+              offset += 4 + ((length + 3) & ~3U);
+            }
+          m_ngInterfaces.push_back (interface);
+          continue;
+        }
+
+      if (blockType == NG_ENHANCED_PACKET_BLOCK && bodyLength >= 20)
+        {
+          uint8_t fields[20];
+          if (!m_ngFile.read (reinterpret_cast<char *> (fields), sizeof (fields)))
+            {
+              return false;
+            }
+          uint32_t id = NgValue32 (fields, m_ngSwap);
+          uint64_t ts = (static_cast<uint64_t> (NgValue32 (fields + 4, m_ngSwap)) << 32)
+            | NgValue32 (fields + 8, m_ngSwap);
+          uint32_t inclLen = std::min (NgValue32 (fields + 12, m_ngSwap), bodyLength - 20);
+          if (id >= m_ngInterfaces.size ())
+            {
+              NS_LOG_WARN ("Packet of an unknown interface in " << m_filename);
+              return false;
+            }
+          capturedLen = std::min (inclLen, static_cast<uint32_t> (m_frame.size ()));
+          if (!m_ngFile.read (reinterpret_cast<char *> (&m_frame[0]), capturedLen))
+            {
+              return false;
+            }
+          m_ngFile.ignore (bodyLength - 20 - capturedLen + 4);
+
+          const Interface &interface = m_ngInterfaces[id];
+          linkType = interface.linkType;
+          uint8_t resolution = interface.tsresol & 0x7f;
+          if (interface.tsresol & 0x80)
+            {
+              t = NanoSeconds (static_cast<int64_t> (ts * 1e9 / std::ldexp (1.0, resolution)));
+            }
+          else if (resolution <= 9)
+            {
+              int64_t scale = 1;
+              for (uint8_t i = resolution; i < 9; ++i)
+                {
+                  scale *= 10;
+                }
+              t = NanoSeconds (ts * scale);
+            }
+          else
+            {
+              uint64_t scale = 1;
+              for (uint8_t i = 9; i < resolution && i < 28; ++i)
+                {
+                  scale *= 10;
+                }
+              t = NanoSeconds (ts / scale);
+            }
+          return true;
+        }
+
+      m_ngFile.ignore (bodyLength + 4);
+    }
+}
+
+bool
+PcapReplayTrace::ReadNext (Time notBefore)
+{
+  NS_LOG_FUNCTION (this << notBefore);
+  uint32_t linkType;
+  Time t;
+  uint32_t capturedLen;
+  while (ReadFrame (linkType, t, capturedLen))
+    {
+      ++m_packetsRead;
+      if (!m_firstRead)
+        {
+          m_firstRead = true;
+          m_firstTime = t;
+        }
+      if (t - m_firstTime < notBefore)
+        {
+          continue;
+        }
+
+      // Find the IPv4 header.
+      const uint8_t *frame = &m_frame[0];
+      uint32_t offset;
+      switch (linkType)
+        {
+        case 0:   // DLT_NULL: the address family, in the byte order of the capturing host
+          if (capturedLen < 4 || (NgValue32 (frame, false) != 2 && NgValue32 (frame, true) != 2))
+            {
+              continue;
+            }
+          offset = 4;
+          break;
+        case 1:   // DLT_EN10MB
+          {
+            offset = 12;
+            while (capturedLen >= offset + 2
+                   && (NetworkValue16 (frame + offset) == 0x8100 || NetworkValue16 (frame + offset) == 0x88a8))
+              {
+                offset += 4;
+              }
+            if (capturedLen < offset + 2 || NetworkValue16 (frame + offset) != 0x0800)
+              {
+                continue;
+              }
+            offset += 2;
+          }
+          break;
+        case 9:   // DLT_PPP, with or without the HDLC address and control fields
+          offset = (capturedLen >= 2 && frame[0] == 0xff && frame[1] == 0x03) ? 2 : 0;
+          if (capturedLen < offset + 2 || NetworkValue16 (frame + offset) != 0x0021)
+            {
+              continue;
+            }
+          offset += 2;
+          break;
+        case 101: // DLT_RAW
+        case 228: // LINKTYPE_IPV4
+          offset = 0;
+          break;
+        case 113: // DLT_LINUX_SLL
+          if (capturedLen < 16 || NetworkValue16 (frame + 14) != 0x0800)
+            {
+              continue;
+            }
+          offset = 16;
+          break;
+        default:
+          continue;
+        }
+
+      // Check the IPv4 header, and skip the trailing fragments.
+      if (capturedLen < offset + 20 || (frame[offset] >> 4) != 4)
+        {
+          continue;
+        }
+      const uint8_t *ip = frame + offset;
+      uint32_t ipHeaderLen = (ip[0] & 0x0f) * 4;
+      uint32_t totalLen = NetworkValue16 (ip + 2);
+      if ((NetworkValue16 (ip + 6) & 0x1fff) != 0)
+        {
+          continue;
+        }
+      Ipv4Address source = Ipv4Address::Deserialize (ip + 12);
+      std::map<Ipv4Address, PcapReplay *>::const_iterator app = m_sources.find (source);
+      if (app == m_sources.end ())
+        {
+          continue;
+        }
+
+      // Find the transport payload.
+      uint32_t transportHeaderLen;
+      if (ip[9] == 17 && capturedLen >= offset + ipHeaderLen + 4)
+        {
+          transportHeaderLen = 8;
+        }
+      else if (ip[9] == 6 && capturedLen >= offset + ipHeaderLen + 13)
+        {
+          transportHeaderLen = (ip[ipHeaderLen + 12] >> 4) * 4;
+        }
+      else
+        {
+          continue;
+        }
+      if (totalLen <= ipHeaderLen + transportHeaderLen)
+        {
+          continue;
+        }
+      uint32_t payloadLen = std::min (totalLen - ipHeaderLen - transportHeaderLen, MAX_UDP_PAYLOAD);
+      uint32_t payloadOffset = offset + ipHeaderLen + transportHeaderLen;
+      uint32_t captured = capturedLen > payloadOffset ? std::min (capturedLen - payloadOffset, payloadLen) : 0;
+
+      Ipv4Address destination = Ipv4Address::Deserialize (ip + 16);
+      std::map<Ipv4Address, Ipv4Address>::const_iterator mapped = m_addresses.find (destination);
+      if (mapped != m_addresses.end ())
+        {
+          destination = mapped->second;
+        }
+
+      m_next.time = t;
+      m_next.source = source;
+      m_next.app = app->second;
+      m_next.destination = destination;
+      m_next.port = NetworkValue16 (ip + ipHeaderLen + 2);
+      m_next.packet = captured > 0 ? Create<Packet> (frame + payloadOffset, captured) : Create<Packet> ();
+      m_next.packet->AddPaddingAtEnd (payloadLen - captured);
+      return true;
+    }
+  NS_LOG_LOGIC ("End of " << m_filename << " after " << m_packetsRead << " packets");
+  m_eof = true;
+  return false;
+}
+
+void
+PcapReplayTrace::ScheduleNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time delay = (m_next.time - m_firstTime) - (Simulator::Now () - m_startTime);
+  m_scheduled = true;
+  Simulator::ScheduleWithContext (m_next.app->GetNode ()->GetId (), Max (delay, Seconds (0)),
+                                  &PcapReplayTrace::Replay, Ptr<PcapReplayTrace> (this));
+}
+
+void
+PcapReplayTrace::Replay (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_scheduled = false;
+  std::map<Ipv4Address, PcapReplay *>::const_iterator it = m_sources.find (m_next.source);
+  if (it != m_sources.end () && it->second == m_next.app)
+    {
+      m_next.app->Send (m_next.packet, m_next.destination, m_next.port);
+    }
+  m_next.packet = 0;
+  if (m_sources.empty ())
+    {
+      // Stop reading until an application starts again.
+      return;
+    }
+  if (ReadNext (Time::Min ()))
+    {
+      ScheduleNext ();
+    }
+}
+
+TypeId
+PcapReplay::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PcapReplay")
+    .SetParent<Application> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<PcapReplay> ()
+    .AddAttribute ("Filename",
+                   "The pcap or pcapng capture to replay",
+                   StringValue (""),
+                   MakeStringAccessor (&PcapReplay::m_filename),
+                   MakeStringChecker ())
+    .AddAttribute ("Source",
+                   "The address of the host of the capture whose packets are sent",
+                   Ipv4AddressValue (),
+                   MakeIpv4AddressAccessor (&PcapReplay::m_source),
+                   MakeIpv4AddressChecker ())
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&PcapReplay::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+PcapReplay::PcapReplay ()
+  : m_sent (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PcapReplay::~PcapReplay ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PcapReplay::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_trace != 0)
+    {
+      m_trace->RemoveSource (m_source, this);
+      m_trace = 0;
+    }
+  m_socket = 0;
+  Application::DoDispose ();
+}
+
+void
+PcapReplay::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_socket == 0)
+    {
+      TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+      m_socket = Socket::CreateSocket (GetNode (), tid);
+      if (m_socket->Bind () == -1)
+        {
+          NS_FATAL_ERROR ("Failed to bind socket");
+        }
+      m_socket->SetAllowBroadcast (true);
+    }
+  if (m_trace == 0)
+    {
+      NS_ABORT_MSG_IF (m_filename.empty (), "PcapReplay: no capture file given");
+      m_trace = PcapReplayTrace::Get (m_filename);
+    }
+  m_trace->AddSource (m_source, this);
+}
+
+void
+PcapReplay::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_trace != 0)
+    {
+      m_trace->RemoveSource (m_source, this);
+    }
+}
+
+void
+PcapReplay::SetTrace (Ptr<PcapReplayTrace> trace)
+{
+  NS_LOG_FUNCTION (this << trace);
+  m_trace = trace;
+}
+
+void
+PcapReplay::Send (Ptr<Packet> packet, Ipv4Address destination, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << packet << destination << port);
+  m_txTrace (packet);
+  if (m_socket->SendTo (packet, 0, InetSocketAddress (destination, port)) >= 0)
+    {
+      ++m_sent;
+    }
+  else
+    {
+      NS_LOG_INFO ("Error while sending " << packet->GetSize () << " bytes to " << destination);
+    }
+}
+
+uint64_t
+PcapReplay::GetSent (void) const
+{
+  return m_sent;
+}
+
+} // namespace ns3
@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_REPLAY_H
+#define PCAP_REPLAY_H
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/application.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/pcap-file.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+class PcapReplay;
+
+/**
+ * \ingroup applications
+ * \defgroup pcapreplay PcapReplay
+ */
+
+/**
+ * \ingroup pcapreplay
+ * \brief A pcap or pcapng capture replayed by PcapReplay applications.
+ *
+ * The capture is read one packet ahead, so a replay needs the same
+ * memory whatever the size of the capture.  Each IPv4 UDP or TCP packet
+ * is handed to the PcapReplay application registered for its source
+ * address, at the time of the packet relative to the first packet of
+ * the capture; the packets of other sources, and the other protocols,
+ * are skipped.  The destination address can be mapped to a simulated
+ * address with MapAddress().
+ *
+ * The link types read are Ethernet (with 802.1Q tags), raw IP, Linux
+ * cooked, BSD loopback and PPP.  pcapng captures may have several
+ * interfaces and sections; their simple packet blocks, which carry no
+ * timestamp, are skipped.
+ *
+ * All the applications replaying a file share one PcapReplayTrace,
+ * returned by Get(), so the file is read once.
+ */
+class PcapReplayTrace : public SimpleRefCount<PcapReplayTrace>
+{
+public:
+  /**
+   * Get the replay of a file, opening it if it is not replayed yet.
+   * \param [in] filename The name of the pcap or pcapng file.
+   * \returns The replay of the file.
+   */
+  static Ptr<PcapReplayTrace> Get (const std::string &filename);
+  ~PcapReplayTrace ();
+
+  /**
+   * Send the packets captured to an address to another address.
+   * \param [in] captured The address in the capture.
+   * \param [in] simulated The address to send the packets to.
+   */
+  void MapAddress (Ipv4Address captured, Ipv4Address simulated);
+
+  /**
+   * Start replaying the packets of a source.  The capture starts being
+   * replayed when the first source is added, after the other sources
+   * added at the same time.
+   * \param [in] source The source address in the capture.
+   * \param [in] app The application sending the packets.
+   */
+  void AddSource (Ipv4Address source, PcapReplay *app);
+  /**
+   * Stop replaying the packets of a source.
+   * \param [in] source The source address in the capture.
+   * \param [in] app The application sending the packets.
+   */
+  void RemoveSource (Ipv4Address source, PcapReplay *app);
+
+  /**
+   * \returns The number of packets read from the capture.
+   */
+  uint64_t GetPacketsRead (void) const;
+
+private:
+  /**
+   * Open a capture.
+   * \param [in] filename The name of the pcap or pcapng file.
+   */
+  PcapReplayTrace (const std::string &filename);
+
+  /**
+   * Read the next captured frame.
+   * \param [out] linkType The link type of the frame.
+   * \param [out] t The time of the frame.
+   * \param [out] capturedLen The number of bytes of the frame captured.
+   * \returns \c false at the end of the capture.
+   */
+  bool ReadFrame (uint32_t &linkType, Time &t, uint32_t &capturedLen);
+  /**
+   * Read the next frame of a pcapng capture.
+   * \param [out] linkType The link type of the frame.
+   * \param [out] t The time of the frame.
+   * \param [out] capturedLen The number of bytes of the frame captured.
+   * \returns \c false at the end of the capture.
+   */
+  bool ReadNgFrame (uint32_t &linkType, Time &t, uint32_t &capturedLen);
+  /**
+   * Read the next packet to replay into m_next.
+   * \param [in] notBefore Skip the packets captured earlier than this,
+   *             relative to the first packet.
+   * \returns \c false at the end of the capture.
+   */
+  bool ReadNext (Time notBefore);
+  /** Start or resume the replay, once the sources starting now are added. */
+  void Start (void);
+  /** Schedule the replay of m_next. */
+  void ScheduleNext (void);
+  /** Replay m_next, and schedule the following packet. */
+  void Replay (void);
+
+  /** A pcapng interface. */
+  struct Interface
+  {
+    uint32_t linkType;  //!< The link type.
+    uint8_t tsresol;    //!< The timestamp resolution (if_tsresol option).
+  };
+
+  /** The next packet to replay. */
+  struct NextPacket
+  {
+    Time time;                //!< The capture time.
+    Ipv4Address source;       //!< The source address.
+    PcapReplay *app;          //!< The application sending it.
+    Ipv4Address destination;  //!< The destination address.
+    uint16_t port;            //!< The destination port.
+    Ptr<Packet> packet;       //!< The payload.
+  };
+
+  std::string m_filename;               //!< The name of the file.
+  bool m_ng;                            //!< Whether the file is a pcapng file.
+  PcapFile m_pcap;                      //!< The pcap file.
+  std::ifstream m_ngFile;               //!< The pcapng file.
+  bool m_ngSwap;                        //!< Whether the pcapng section is in the other byte order.
+  std::vector<Interface> m_ngInterfaces; //!< The interfaces of the pcapng section.
+  std::vector<uint8_t> m_frame;         //!< The frame read.
+  bool m_started;                       //!< Whether the replay started.
+  bool m_scheduled;                     //!< Whether a replay event is pending.
+  bool m_eof;                           //!< Whether the end of the capture was read.
+  bool m_firstRead;                     //!< Whether a frame was read.
+  Time m_firstTime;                     //!< The time of the first frame.
+  Time m_startTime;                     //!< The simulation time of the replay start.
+  uint64_t m_packetsRead;               //!< The number of frames read.
+  NextPacket m_next;                    //!< The next packet to replay.
+  std::map<Ipv4Address, PcapReplay *> m_sources;   //!< The applications, by source.
+  std::map<Ipv4Address, Ipv4Address> m_addresses;  //!< The destination address mapping.
+};
+
+/**
+ * \ingroup pcapreplay
+ * \brief Send the UDP and TCP packets of a source host of a pcap capture.
+ *
+ * The application replays, on its node, the packets that the host with
+ * the address in the \c Source attribute sent in the capture in the
+ * \c Filename attribute, with the same inter-arrival times.  Each packet
+ * is sent as a UDP datagram carrying the transport payload of the
+ * original packet (zero-filled beyond the captured bytes) to the same
+ * destination address and port; TCP segments without payload are not
+ * replayed.  The replay is open loop: TCP flows are replayed without
+ * their congestion control.
+ *
+ * PcapReplayHelper installs such applications, one per captured host,
+ * and maps the captured addresses to the simulated ones.
+ */
+class PcapReplay : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  PcapReplay ();
+  virtual ~PcapReplay ();
+
+  /**
+   * Replay a capture, instead of the one in the \c Filename attribute.
+   * \param [in] trace The capture.
+   */
+  void SetTrace (Ptr<PcapReplayTrace> trace);
+
+  /**
+   * Send a packet of the capture.
+   * \param [in] packet The payload.
+   * \param [in] destination The destination address.
+   * \param [in] port The destination port.
+   */
+  void Send (Ptr<Packet> packet, Ipv4Address destination, uint16_t port);
+
+  /**
+   * \returns The number of packets sent.
+   */
+  uint64_t GetSent (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  std::string m_filename;       //!< The name of the capture file.
+  Ipv4Address m_source;         //!< The source address replayed.
+  Ptr<PcapReplayTrace> m_trace; //!< The replayed capture.
+  Ptr<Socket> m_socket;         //!< The socket.
+  uint64_t m_sent;              //!< The number of packets sent.
+
+  /// Callbacks for tracing the packet Tx events
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_REPLAY_H */
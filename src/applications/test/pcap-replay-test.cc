@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/mac48-address.h"
+#include "ns3/pcap-file.h"
+#include "ns3/pcapng-file.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/packet-sink.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/pcap-replay-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+
+using namespace ns3;
+
+/**
+ * Append a captured IPv4 packet, sent from port 1234 to port 5000 of
+ * 192.168.0.2, to a frame.
+ * \param frame The frame.
+ * \param source The last byte of the source address.
+ * \param protocol The IP protocol.
+ * \param payload The transport payload size.
+ */
+static void
+AppendIpPacket (std::vector<uint8_t> &frame, uint8_t source, uint8_t protocol, uint16_t payload)
+{
+  uint16_t transport = protocol == 6 ? 20 : 8;
+  uint16_t totalLen = 20 + transport + payload;
+  uint8_t ip[20] = { 0x45, 0, static_cast<uint8_t> (totalLen >> 8), static_cast<uint8_t> (totalLen),
+                     0, 0, 0x40, 0, 64, protocol, 0, 0,
+                     192, 168, 0, source,
+                     192, 168, 0, 2 };
+  frame.insert (frame.end (), ip, ip + sizeof (ip));
+  // Source port 1234, destination port 5000
+  uint8_t header[20] = { 0x04, 0xd2, 0x13, 0x88 };
+  if (protocol == 6)
+    {
+      header[12] = 5 << 4;
+    }
+  frame.insert (frame.end (), header, header + transport);
+  for (uint16_t i = 0; i < payload; ++i)
+    {
+      frame.push_back (i);
+    }
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Check that PcapReplay applications send the packets of their captured
+ * host, at the captured times, to the mapped destinations.
+ */
+class PcapReplayTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor.
+   * \param pcapng Whether to replay a pcapng capture on Ethernet, rather
+   *               than a pcap capture of raw IP.
+   */
+  PcapReplayTestCase (bool pcapng);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Write a captured frame.
+   * \param seconds The capture time.
+   * \param source The last byte of the source address.
+   * \param protocol The IP protocol.
+   * \param payload The transport payload size.
+   */
+  void Capture (double seconds, uint8_t source, uint8_t protocol, uint16_t payload);
+  /**
+   * Packet sent by a replay.
+   * \param p The packet.
+   */
+  void Tx (Ptr<const Packet> p);
+
+  bool m_pcapng;                  //!< Whether to write a pcapng capture.
+  PcapFile m_pcap;                //!< The pcap capture.
+  Ptr<PcapNgFile> m_ng;           //!< The pcapng capture.
+  std::vector<Time> m_txTimes;    //!< The times of the packets sent.
+  std::vector<uint32_t> m_txNodes; //!< The nodes sending the packets.
+  std::vector<uint32_t> m_txSizes; //!< The sizes of the packets sent.
+};
+
+PcapReplayTestCase::PcapReplayTestCase (bool pcapng)
+  : TestCase (pcapng ? "Check replaying a pcapng capture" : "Check replaying a pcap capture"),
+    m_pcapng (pcapng)
+{
+}
+
+void
+PcapReplayTestCase::Capture (double seconds, uint8_t source, uint8_t protocol, uint16_t payload)
+{
+  std::vector<uint8_t> frame;
+  if (m_pcapng)
+    {
+      // Ethernet header, with an 802.1Q tag
+      static const uint8_t ethernet[18] = { 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 6, 0x81, 0, 0, 7, 0x08, 0 };
+      frame.insert (frame.end (), ethernet, ethernet + sizeof (ethernet));
+    }
+  AppendIpPacket (frame, source, protocol, payload);
+
+  uint64_t ns = static_cast<uint64_t> (seconds * 1e9 + 0.5);
+  if (m_pcapng)
+    {
+      m_ng->Write (0, NanoSeconds (ns), &frame[0], frame.size ());
+    }
+  else
+    {
+      m_pcap.Write (ns / 1000000000, (ns % 1000000000) / 1000, &frame[0], frame.size ());
+    }
+}
+
+void
+PcapReplayTestCase::Tx (Ptr<const Packet> p)
+{
+  m_txTimes.push_back (Simulator::Now ());
+  m_txNodes.push_back (Simulator::GetContext ());
+  m_txSizes.push_back (p->GetSize ());
+}
+
+void
+PcapReplayTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename (m_pcapng ? "replay.pcapng" : "replay.pcap");
+  if (m_pcapng)
+    {
+      m_ng = PcapNgFile::Open (filename, 0, AsyncFileBuffer::NONE);
+      m_ng->AddInterface (1, 65535);
+    }
+  else
+    {
+      m_pcap.Open (filename, std::ios::out);
+      m_pcap.Init (101, 65535);
+    }
+  Capture (10.0, 1, 17, 100);
+  Capture (10.25, 1, 6, 200);
+  Capture (10.5, 3, 17, 50);
+  // A TCP acknowledgment, and a packet of a host not replayed
+  Capture (10.6, 1, 6, 0);
+  Capture (10.7, 4, 17, 10);
+  Capture (11.0, 3, 17, 20);
+  m_ng = 0;
+  m_pcap.Close ();
+
+  NodeContainer n;
+  n.Create (3);
+  InternetStackHelper internet;
+  internet.Install (n);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < n.GetN (); ++i)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      dev->SetChannel (channel);
+      n.Get (i)->AddDevice (dev);
+      d.Add (dev);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (d);
+
+  PacketSinkHelper sinkHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 5000));
+  ApplicationContainer sink = sinkHelper.Install (n.Get (1));
+
+  PcapReplayHelper replay (filename);
+  replay.MapAddress ("192.168.0.2", interfaces.GetAddress (1));
+  ApplicationContainer apps = replay.Install (n.Get (0), "192.168.0.1");
+  apps.Add (replay.Install (n.Get (2), "192.168.0.3"));
+  apps.Start (Seconds (1.0));
+  apps.Get (1)->SetStopTime (Seconds (1.8));
+  for (uint32_t i = 0; i < apps.GetN (); ++i)
+    {
+      apps.Get (i)->TraceConnectWithoutContext ("Tx", MakeCallback (&PcapReplayTestCase::Tx, this));
+    }
+
+  Simulator::Stop (Seconds (5.0));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), 3, "Wrong number of packets replayed");
+  NS_TEST_EXPECT_MSG_EQ (m_txTimes[0], Seconds (1.0), "Wrong time of the first packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txTimes[1], Seconds (1.25), "Wrong time of the second packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txTimes[2], Seconds (1.5), "Wrong time of the third packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txNodes[0], n.Get (0)->GetId (), "Wrong node of the first packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txNodes[1], n.Get (0)->GetId (), "Wrong node of the second packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txNodes[2], n.Get (2)->GetId (), "Wrong node of the third packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txSizes[0], 100, "Wrong size of the first packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txSizes[1], 200, "Wrong size of the second packet");
+  NS_TEST_EXPECT_MSG_EQ (m_txSizes[2], 50, "Wrong size of the third packet");
+  NS_TEST_EXPECT_MSG_EQ (DynamicCast<PacketSink> (sink.Get (0))->GetTotalRx (), 350,
+                         "The packets did not reach the mapped address");
+  NS_TEST_EXPECT_MSG_EQ (replay.GetTrace ()->GetPacketsRead (), 6, "Wrong number of packets read");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * Check that applications starting at the same time replay all their
+ * packets, when the first captured packet is not from the first
+ * application started.
+ */
+class PcapReplaySameStartTestCase : public TestCase
+{
+public:
+  PcapReplaySameStartTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Packet sent by a replay.
+   * \param p The packet.
+   */
+  void Tx (Ptr<const Packet> p);
+
+  std::vector<Time> m_txTimes;    //!< The times of the packets sent.
+  std::vector<uint32_t> m_txNodes; //!< The nodes sending the packets.
+};
+
+PcapReplaySameStartTestCase::PcapReplaySameStartTestCase ()
+  : TestCase ("Check replaying the first packet of the second application started")
+{
+}
+
+void
+PcapReplaySameStartTestCase::Tx (Ptr<const Packet> p)
+{
+  m_txTimes.push_back (Simulator::Now ());
+  m_txNodes.push_back (Simulator::GetContext ());
+}
+
+void
+PcapReplaySameStartTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("same-start.pcap");
+  PcapFile pcap;
+  pcap.Open (filename, std::ios::out);
+  pcap.Init (101, 65535);
+  const uint8_t sources[] = { 3, 3, 1 };
+  for (uint32_t i = 0; i < sizeof (sources); ++i)
+    {
+      std::vector<uint8_t> frame;
+      AppendIpPacket (frame, sources[i], 17, 10);
+      pcap.Write (20, i * 100000, &frame[0], frame.size ());
+    }
+  pcap.Close ();
+
+  NodeContainer n;
+  n.Create (2);
+  InternetStackHelper internet;
+  internet.Install (n);
+
+  PcapReplayHelper replay (filename);
+  ApplicationContainer apps = replay.Install (n.Get (0), "192.168.0.1");
+  apps.Add (replay.Install (n.Get (1), "192.168.0.3"));
+  apps.Start (Seconds (1.0));
+  for (uint32_t i = 0; i < apps.GetN (); ++i)
+    {
+      apps.Get (i)->TraceConnectWithoutContext ("Tx", MakeCallback (&PcapReplaySameStartTestCase::Tx, this));
+    }
+
+  Simulator::Stop (Seconds (5.0));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_txTimes.size (), 3, "Wrong number of packets replayed");
+  for (uint32_t i = 0; i < sizeof (sources); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_txTimes[i], MilliSeconds (1000 + i * 100), "Wrong time of packet " << i);
+      NS_TEST_EXPECT_MSG_EQ (m_txNodes[i], n.Get (sources[i] == 1 ? 0 : 1)->GetId (),
+                             "Wrong node of packet " << i);
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup applications-test
+ * \ingroup tests
+ *
+ * \brief PcapReplay TestSuite
+ */
+class PcapReplayTestSuite : public TestSuite
+{
+public:
+  PcapReplayTestSuite ();
+};
+
+PcapReplayTestSuite::PcapReplayTestSuite ()
+  : TestSuite ("pcap-replay", UNIT)
+{
+  AddTestCase (new PcapReplayTestCase (false), TestCase::QUICK);
+  AddTestCase (new PcapReplayTestCase (true), TestCase::QUICK);
+  AddTestCase (new PcapReplaySameStartTestCase, TestCase::QUICK);
+}
+
+static PcapReplayTestSuite g_pcapReplayTestSuite; //!< Static variable for test initialization
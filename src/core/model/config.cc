@@ -25,7 +25,11 @@
 #include "names.h"
 #include "pointer.h"
 #include "log.h"
+#include "system-mutex.h"
 
+#include <cstdlib>
+#include <list>
+#include <map>
 #include <sstream>
 
 /**
@@ -261,6 +265,110 @@ ArrayMatcher::StringToUint32 (std::string str, uint32_t *value) const
   return !iss.bad () && !iss.fail ();
 }
 
+/**
+ * \ingroup config-impl
+ * An attribute which a Config path can descend through:
+ * either a Pointer or an ObjectPtrContainer attribute.
+ */
+struct PathAttribute
+{
+  std::string name;                           //!< Attribute name.
+  Ptr<const AttributeAccessor> accessor;      //!< Attribute accessor.
+  uint32_t flags;                             //!< Attribute flags.
+  bool isContainer;                           //!< \c true for ObjectPtrContainer.
+};
+
+/**
+ * \ingroup config-impl
+ * Get the mutex guarding the list of traversable attributes of
+ * each TypeId built by GetPathAttributes.
+ *
+ * \returns The mutex.
+ */
+static SystemMutex &
+GetPathAttributesMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/**
+ * \ingroup config-impl
+ * Get the attributes of a TypeId, and of all its parents, which a
+ * Config path can descend through, in the order the Resolver visits them.
+ *
+ * The list is built once per TypeId, so resolving a path through
+ * many objects of the same type does not repeat the checker casts.
+ * It is rebuilt if attributes were added to the TypeId since; the
+ * lists are never changed once built, so the returned reference
+ * stays valid after another thread rebuilds the list.
+ *
+ * \param [in] tid The instance TypeId.
+ * \returns The traversable attributes.
+ */
+static const std::vector<PathAttribute> &
+GetPathAttributes (TypeId tid)
+{
+  NS_LOG_FUNCTION (tid);
+  struct Entry
+  {
+    std::size_t nAttributes;
+    const std::vector<PathAttribute> *attributes;
+  };
+  static std::map<uint16_t, Entry> index;
+  static std::list<std::vector<PathAttribute> > lists;
+
+  std::size_t nAttributes = 0;
+  TypeId tmp = tid;
+  TypeId parent = tid;
+  do
+    {
+      tmp = parent;
+      nAttributes += tmp.GetAttributeN ();
+      parent = tmp.GetParent ();
+    } while (parent != tmp);
+
+  CriticalSection critical (GetPathAttributesMutex ());
+  std::map<uint16_t, Entry>::iterator it = index.find (tid.GetUid ());
+  if (it != index.end () && it->second.nAttributes == nAttributes)
+    {
+      return *it->second.attributes;
+    }
+  lists.push_back (std::vector<PathAttribute> ());
+  std::vector<PathAttribute> &attributes = lists.back ();
+  parent = tid;
+  do
+    {
+      tmp = parent;
+      for (std::size_t i = 0; i < tmp.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = tmp.GetAttribute (i);
+          PathAttribute attribute;
+          if (dynamic_cast<const PointerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = false;
+            }
+          else if (dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker)) != 0)
+            {
+              attribute.isContainer = true;
+            }
+          else
+            {
+              continue;
+            }
+          attribute.name = info.name;
+          attribute.accessor = info.accessor;
+          attribute.flags = info.flags;
+          attributes.push_back (attribute);
+        }
+      parent = tmp.GetParent ();
+    } while (parent != tmp);
+  Entry &entry = index[tid.GetUid ()];
+  entry.nAttributes = nAttributes;
+  entry.attributes = &attributes;
+  return attributes;
+}
+
 /**
  * \ingroup config-impl
  * Abstract class to parse Config paths into object references.
@@ -304,6 +412,18 @@ private:
    * \param [in,out] vector The resulting list of matching objects.
    */
   void DoArrayResolve (std::string path, const ObjectPtrContainerValue &vector);
+  /**
+   * Parse a plain numeric index on the Config path, such as
+   * \c /NodeList/3, fetching only that element of the container.
+   *
+   * \param [in] path The remaining Config path.
+   * \param [in] root The object holding the container.
+   * \param [in] accessor The container attribute accessor.
+   * \returns \c false if the next path element is not a plain index,
+   *          in which case nothing was done.
+   */
+  bool DoIndexResolve (std::string path, Ptr<Object> root,
+                       const ObjectPtrContainerAccessor *accessor);
   /**
    * Handle one object found on the path.
    *
@@ -483,62 +603,57 @@ Resolver::DoResolve (std::string path, Ptr<Object> root)
   else 
     {
       // this is a normal attribute.
-      TypeId tid;
-      TypeId nextTid = root->GetInstanceTypeId ();
       bool foundMatch = false;
-      
-      do
+      const std::vector<PathAttribute> &attributes = GetPathAttributes (root->GetInstanceTypeId ());
+      for (std::vector<PathAttribute>::const_iterator i = attributes.begin (); i != attributes.end (); ++i)
         {
-          tid = nextTid;
-          
-          for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+          const PathAttribute &info = *i;
+          if (info.name != item && item != "*")
             {
-              struct TypeId::AttributeInformation info;
-              info = tid.GetAttribute(i);
-              if (info.name != item && item != "*")
+              continue;
+            }
+          // as ObjectBase::GetAttribute does
+          if (!(info.flags & TypeId::ATTR_GET) ||
+              !info.accessor->HasGetter ())
+            {
+              NS_FATAL_ERROR ("Attribute name="<<info.name<<" is not gettable for this object: tid="<<
+                              root->GetInstanceTypeId ().GetName ());
+            }
+          if (!info.isContainer)
+            {
+              NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
+              PointerValue pValue;
+              info.accessor->Get (PeekPointer (root), pValue);
+              Ptr<Object> object = pValue.Get<Object> ();
+              if (object == 0)
                 {
+                  NS_LOG_ERROR ("Requested object name=\""<<item<<
+                                "\" exists on path=\""<<GetResolvedPath ()<<"\""
+                                " but is null.");
                   continue;
                 }
-              // attempt to cast to a pointer checker.
-              const PointerChecker *pChecker = dynamic_cast<const PointerChecker *> (PeekPointer(info.checker));
-              if (pChecker != 0)
-                {
-                  NS_LOG_DEBUG ("GetAttribute(ptr)="<<info.name<<" on path="<<GetResolvedPath ());
-                  PointerValue pValue;
-                  root->GetAttribute (info.name, pValue);
-                  Ptr<Object> object = pValue.Get<Object> ();
-                  if (object == 0)
-                    {
-                      NS_LOG_ERROR ("Requested object name=\""<<item<<
-                                    "\" exists on path=\""<<GetResolvedPath ()<<"\""
-                                    " but is null.");
-                      continue;
-                    }
-                  foundMatch = true;
-                  m_workStack.push_back (info.name);
-                  DoResolve (pathLeft, object);
-                  m_workStack.pop_back ();
-                }
-              // attempt to cast to an object vector.
-              const ObjectPtrContainerChecker *vectorChecker = 
-                dynamic_cast<const ObjectPtrContainerChecker *> (PeekPointer (info.checker));
-              if (vectorChecker != 0)
+              foundMatch = true;
+              m_workStack.push_back (info.name);
+              DoResolve (pathLeft, object);
+              m_workStack.pop_back ();
+            }
+          else
+            {
+              NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
+              foundMatch = true;
+              m_workStack.push_back (info.name);
+              const ObjectPtrContainerAccessor *accessor =
+                dynamic_cast<const ObjectPtrContainerAccessor *> (PeekPointer (info.accessor));
+              if (!DoIndexResolve (pathLeft, root, accessor))
                 {
-                  NS_LOG_DEBUG ("GetAttribute(vector)="<<info.name<<" on path="<<GetResolvedPath () << pathLeft);
-                  foundMatch = true;
                   ObjectPtrContainerValue vector;
-                  root->GetAttribute (info.name, vector);
-                  m_workStack.push_back (info.name);
+                  info.accessor->Get (PeekPointer (root), vector);
                   DoArrayResolve (pathLeft, vector);
-                  m_workStack.pop_back ();
                 }
-              // this could be anything else and we don't know what to do with it.
-              // So, we just ignore it.
+              m_workStack.pop_back ();
             }
+        }
 
-          nextTid = tid.GetParent ();
-        } while (nextTid != tid);
-      
       if (!foundMatch)
         {
           NS_LOG_DEBUG ("Requested item="<<item<<" does not exist on path="<<GetResolvedPath ());
@@ -576,6 +691,38 @@ Resolver::DoArrayResolve (std::string path, const ObjectPtrContainerValue &conta
     }
 }
 
+bool
+Resolver::DoIndexResolve (std::string path, Ptr<Object> root,
+                          const ObjectPtrContainerAccessor *accessor)
+{
+  NS_LOG_FUNCTION (this << path << root << accessor);
+  NS_ASSERT ((path.find ("/")) == 0);
+  std::string::size_type next = path.find ("/", 1);
+  if (accessor == 0 || next == std::string::npos)
+    {
+      return false;
+    }
+  std::string item = path.substr (1, next-1);
+  if (item.empty () || item.size () > 9
+      || item.find_first_not_of ("0123456789") != std::string::npos)
+    {
+      return false;
+    }
+  std::string pathLeft = path.substr (next, path.size ()-next);
+
+  std::size_t index = std::strtoul (item.c_str (), 0, 10);
+  Ptr<Object> object = accessor->GetByIndex (PeekPointer (root), index);
+  if (object != 0)
+    {
+      std::ostringstream oss;
+      oss << index;
+      m_workStack.push_back (oss.str ());
+      DoResolve (pathLeft, object);
+      m_workStack.pop_back ();
+    }
+  return true;
+}
+
 /**
  * \ingroup config-impl
  * Config system implementation class.
@@ -589,6 +736,8 @@ public:
   void ConnectWithoutContext (std::string path, const CallbackBase &cb);
   /** \copydoc Config::Connect() */
   void Connect (std::string path, const CallbackBase &cb);
+  /** \copydoc Config::ConnectMany() */
+  void ConnectMany (const std::vector<std::string> &paths, const CallbackBase &cb);
   /** \copydoc Config::DisconnectWithoutContext() */
   void DisconnectWithoutContext (std::string path, const CallbackBase &cb);
   /** \copydoc Config::Disconnect() */
@@ -674,6 +823,25 @@ ConfigImpl::Connect (std::string path, const CallbackBase &cb)
   MatchContainer container = LookupMatches (root);
   container.Connect (leaf, cb);
 }
+void
+ConfigImpl::ConnectMany (const std::vector<std::string> &paths, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (this << paths.size () << &cb);
+
+  // Paths which only differ by their leaf share the object lookup.
+  std::map<std::string, MatchContainer> containers;
+  for (std::vector<std::string>::const_iterator i = paths.begin (); i != paths.end (); ++i)
+    {
+      std::string root, leaf;
+      ParsePath (*i, &root, &leaf);
+      std::map<std::string, MatchContainer>::iterator it = containers.find (root);
+      if (it == containers.end ())
+        {
+          it = containers.insert (std::make_pair (root, LookupMatches (root))).first;
+        }
+      it->second.Connect (leaf, cb);
+    }
+}
 void 
 ConfigImpl::Disconnect (std::string path, const CallbackBase &cb)
 {
@@ -845,6 +1013,12 @@ Connect (std::string path, const CallbackBase &cb)
   NS_LOG_FUNCTION (path << &cb);
   ConfigImpl::Get ()->Connect (path, cb);
 }
+void
+ConnectMany (const std::vector<std::string> &paths, const CallbackBase &cb)
+{
+  NS_LOG_FUNCTION (paths.size () << &cb);
+  ConfigImpl::Get ()->ConnectMany (paths, cb);
+}
 void 
 Disconnect (std::string path, const CallbackBase &cb)
 {
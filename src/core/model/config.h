@@ -131,6 +131,17 @@ void DisconnectWithoutContext (std::string path, const CallbackBase &cb);
  * context string upon trace event notification.
  */
 void Connect (std::string path, const CallbackBase &cb);
+/**
+ * \ingroup config
+ * \param [in] paths The paths to match trace sources.
+ * \param [in] cb The callback to connect to the matching trace sources.
+ *
+ * This function is equivalent to calling Config::Connect on each
+ * of the input paths, but paths which differ only by their trace
+ * source name share a single object lookup.  Use it to connect
+ * per-node traces on large topologies.
+ */
+void ConnectMany (const std::vector<std::string> &paths, const CallbackBase &cb);
 /**
  * \ingroup config
  * \param [in] path A path to match trace sources.
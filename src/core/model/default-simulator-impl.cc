@@ -22,6 +22,7 @@
 #include "default-simulator-impl.h"
 #include "scheduler.h"
 #include "event-impl.h"
+#include "des-metrics.h"
 
 #include "ptr.h"
 #include "pointer.h"
@@ -148,7 +149,11 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
   m_currentTs = next.key.m_ts;
   m_currentContext = next.key.m_context;
   m_currentUid = next.key.m_uid;
+#ifdef ENABLE_DES_METRICS
+  DesMetrics::Get ()->ProfileInvoke (next.impl, m_currentContext);
+#else
   next.impl->Invoke ();
+#endif
   next.impl->Unref ();
 
   ProcessEventsWithContext ();
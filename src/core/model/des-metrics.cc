@@ -26,15 +26,67 @@
  */
 
 #include "des-metrics.h"
+#include "event-impl.h"
+#include "global-value.h"
 #include "simulator.h"
 #include "system-path.h"
+#include "uinteger.h"
 
+#include <algorithm> // sort
+#include <chrono>    // steady_clock
 #include <ctime>    // time_t, time()
 #include <sstream>
 #include <string>
+#include <typeinfo>
+
+#if (__GNUC__ >= 3)
+#include <cstdlib>  // free
+#include <cxxabi.h>
+#endif
 
 namespace ns3 {
 
+/**
+ * \ingroup simulator
+ * The DesMetrics event profile sampling period.
+ *
+ * One event out of every \c DesMetricsProfileSampling is timed;
+ * zero disables profiling.
+ */
+static GlobalValue g_desMetricsProfileSampling = GlobalValue
+  ("DesMetricsProfileSampling",
+   "Time one event out of every N with DesMetrics; 0 disables profiling",
+   UintegerValue (0),
+   MakeUintegerChecker<uint32_t> ());
+
+namespace {
+
+/**
+ * \ingroup simulator
+ * Get the readable name of an EventImpl type.
+ * \param [in] type The type.
+ * \return The demangled type name.
+ */
+std::string
+ProfileTypeName (const std::type_index & type)
+{
+  std::string name = type.name ();
+#if (__GNUC__ >= 3)
+  int status;
+  char * demangled = abi::__cxa_demangle (name.c_str (), NULL, NULL, &status);
+  if (status == 0 && demangled)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  // ';' separates frames in the folded stack format
+  std::replace (name.begin (), name.end (), ';', ',');
+  return name;
+}
+
+}  // unnamed namespace
+
 /* static */
 std::string DesMetrics::m_outputDir; // = "";
 
@@ -70,6 +122,15 @@ DesMetrics::Initialize (std::vector<std::string> args, std::string outDir /* = "
   const char * date = ctime (&current_time);
   std::string capture_date (date, 24);  // discard trailing newline from ctime
 
+  m_profileFile = model_name + ".folded";
+  if (DesMetrics::m_outputDir != "")
+    {
+      m_profileFile = SystemPath::Append (DesMetrics::m_outputDir, m_profileFile);
+    }
+  UintegerValue sampling;
+  g_desMetricsProfileSampling.GetValue (sampling);
+  SetProfileSampling (sampling.Get ());
+
   m_os.open (jsonFile.c_str ());
   m_os << "{" << std::endl;
   m_os << " \"simulator_name\" : \"ns-3\"," << std::endl;
@@ -135,6 +196,68 @@ DesMetrics::TraceWithContext (uint32_t context, const Time & now, const Time & d
   m_separator = ',';
 }
 
+void
+DesMetrics::SetProfileSampling (uint32_t samplingPeriod)
+{
+  m_profilePeriod = samplingPeriod;
+  m_profileCountdown = samplingPeriod;
+}
+
+void
+DesMetrics::ProfileInvoke (EventImpl * event, uint32_t context)
+{
+  if (m_profilePeriod == 0 || --m_profileCountdown != 0)
+    {
+      event->Invoke ();
+      return;
+    }
+  m_profileCountdown = m_profilePeriod;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  event->Invoke ();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+
+  ProfileRecord & record = m_profile.insert
+    (std::make_pair (ProfileKey (typeid (*event), context), ProfileRecord ())).first->second;
+  record.count++;
+  // Scale the sample up to an estimate of the total
+  record.nanoseconds += m_profilePeriod *
+    std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count ();
+}
+
+void
+DesMetrics::WriteProfile (void)
+{
+  if (m_profile.empty ())
+    {
+      return;
+    }
+  std::string profileFile = m_profileFile;
+  if (profileFile == "")
+    {
+      profileFile = "desTraceFile.folded";
+    }
+
+  std::ofstream os (profileFile.c_str ());
+  for (std::map<ProfileKey, ProfileRecord>::const_iterator i = m_profile.begin ();
+       i != m_profile.end (); ++i)
+    {
+      uint32_t context = i->first.second;
+      if (context == Simulator::NO_CONTEXT)
+        {
+          os << "no-context;";
+        }
+      else
+        {
+          os << "node-" << context << ";";
+        }
+      os << ProfileTypeName (i->first.first) << " "
+         << i->second.nanoseconds / 1000 << std::endl;
+    }
+  os.close ();
+  m_profile.clear ();
+}
+
 DesMetrics::~DesMetrics (void)
 {
   Close ();
@@ -33,11 +33,16 @@
 
 #include <stdint.h>    // uint32_t
 #include <fstream>
+#include <map>
 #include <string>
+#include <typeindex>
+#include <utility>     // pair
 #include <vector>
 
 namespace ns3 {
 
+class EventImpl;
+
 /**
  * @ingroup simulator
  *
@@ -104,6 +109,29 @@ namespace ns3 {
  * \li Show the largest file, and total number of trace files: <br/>
  *   \code wc -l *.json | sort -n | tail -2 \endcode
  *
+ * <b> Event Profiling </b>
+ *
+ * When DES Metrics is enabled the simulator can also measure the wall
+ * clock time spent in each event's \c Invoke.  Profiling is off by
+ * default; turn it on by setting the \c DesMetricsProfileSampling
+ * global value to a sampling period \c N, so that one event out of
+ * every \c N is timed:
+ * \verbatim
+   $ ./waf --run "my-script --DesMetricsProfileSampling=100" \endverbatim
+ *
+ * Samples are aggregated by the dynamic type of the EventImpl (which
+ * identifies the callback target, \e e.g. the member function bound by
+ * MakeEvent) and by the context (node id) of the event.  At
+ * Simulator::Destroy the totals are written, scaled by the sampling
+ * period, to \c <model_name>.folded next to the JSON trace file.  Each
+ * line has the form
+ * \verbatim
+   node-3;ns3::WifiPhy::EndReceive(...) 12345 \endverbatim
+ * where the value is the estimated wall clock time in microseconds.
+ * This is the "folded stack" format accepted by \c flamegraph.pl:
+ * \verbatim
+   $ flamegraph.pl my-script.folded > my-script.svg \endverbatim
+ *
  */
 class DesMetrics : public Singleton<DesMetrics> 
 {
@@ -137,6 +165,34 @@ public:
    */
   void TraceWithContext (uint32_t context,  const Time & now, const Time & delay);
 
+  /**
+   * Enable or disable event profiling.
+   *
+   * This overrides the \c DesMetricsProfileSampling global value
+   * until the next call to Initialize().
+   *
+   * \param [in] samplingPeriod Time one event out of every
+   *              \p samplingPeriod; zero disables profiling.
+   */
+  void SetProfileSampling (uint32_t samplingPeriod);
+
+  /**
+   * Invoke an event, timing it if profiling is enabled and this
+   * event is selected by the sampling period.
+   *
+   * \param [in] event The event to invoke.
+   * \param [in] context The context (NodeId) in which the event runs.
+   */
+  void ProfileInvoke (EventImpl * event, uint32_t context);
+
+  /**
+   * Write the accumulated event profile, if any, in folded stack
+   * format, and clear the accumulated samples.
+   *
+   * This is called from Simulator::Destroy.
+   */
+  void WriteProfile (void);
+
   /**
    * Destructor, closes the trace file.
    */
@@ -147,6 +203,16 @@ private:
   /** Close the output file. */
   void Close (void);
 
+  /** Profile key: the EventImpl dynamic type and the event context. */
+  typedef std::pair<std::type_index, uint32_t> ProfileKey;
+
+  /** Accumulated samples for one ProfileKey. */
+  struct ProfileRecord
+  {
+    uint64_t count;        //!< Number of sampled events.
+    int64_t  nanoseconds;  //!< Estimated total wall clock time, in ns.
+  };
+
   /**
    * Cache the last-used output directory.
    *
@@ -159,6 +225,12 @@ private:
   std::ofstream m_os;    //!< The output JSON trace file stream.
   char m_separator;      //!< The separator between event records.
 
+  std::string m_profileFile;   //!< The folded stack profile file name.
+  uint32_t m_profilePeriod;    //!< Profile sampling period, 0 if disabled.
+  uint32_t m_profileCountdown; //!< Events left until the next sample.
+  /** Accumulated event profile. */
+  std::map<ProfileKey, ProfileRecord> m_profile;
+
   /** Mutex to control access to the output file. */
   SystemMutex m_mutex;
   
@@ -0,0 +1,385 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INLINE_CALLBACK_H
+#define INLINE_CALLBACK_H
+
+#include "callback.h"
+
+#include <cstring>      // memset, memcmp
+#include <new>          // placement new
+#include <type_traits>
+#include <utility>      // forward
+
+/**
+ * \file
+ * \ingroup callback
+ * ns3::InlineCallback declaration and template implementation.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup callback
+ * \brief A Callback with inline (small buffer) storage.
+ *
+ * Callback holds a reference counted pointer to a heap allocated
+ * CallbackImpl, so every MakeCallback allocates, and every call
+ * goes through a virtual function.  InlineCallback instead stores
+ * the target (object pointer and member function pointer, function
+ * pointer, and up to two bound arguments) in a fixed size buffer
+ * inside the InlineCallback itself, together with a plain function
+ * pointer which invokes it:
+ *   - constructing an InlineCallback never allocates,
+ *   - copying an InlineCallback copies a few words,
+ *   - invoking an InlineCallback is one indirect call, with no
+ *     virtual dispatch and no RTTI.
+ *
+ * In exchange the stored target must be trivially copyable and fit in
+ * \c Capacity bytes; both are checked at compile time.  In particular
+ * the object is held by raw pointer (as in <tt>MakeInlineCallback
+ * (&MyClass::Handler, this)</tt>) and not by Ptr, and bound arguments
+ * must be plain values (integers, raw pointers, Time, addresses...).
+ * Use Callback for anything else.
+ *
+ * An InlineCallback can be converted to an equivalent Callback with
+ * ToCallback(), for use with APIs which take a Callback.
+ *
+ * Instances are built with MakeInlineCallback and
+ * MakeBoundInlineCallback:
+ * \code
+ *   InlineCallback<void, Ptr<Packet> > cb =
+ *     MakeInlineCallback (&MyDevice::Receive, this);
+ *   cb (packet);
+ * \endcode
+ *
+ * \tparam R \explicit The return type.
+ * \tparam Ts \explicit The argument types.
+ */
+template <typename R, typename... Ts>
+class InlineCallback
+{
+public:
+  /** Size in bytes of the inline target storage. */
+  static const std::size_t Capacity = 4 * sizeof (void *);
+
+  /** Construct a null callback. */
+  InlineCallback ()
+    : m_invoke (0)
+  {
+    std::memset (&m_storage, 0, sizeof (m_storage));
+  }
+
+  /**
+   * Construct from a functor, which is copied into the inline storage.
+   *
+   * \tparam FUNCTOR \deduced The functor type.
+   * \param [in] functor The functor to run on this callback.
+   *
+   * \internal
+   * The two dummy arguments disambiguate this constructor, as
+   * in Callback.
+   */
+  template <typename FUNCTOR>
+  InlineCallback (FUNCTOR const &functor, bool, bool)
+  {
+    static_assert (sizeof (FUNCTOR) <= Capacity,
+                   "InlineCallback target too large for the inline storage");
+    static_assert (std::is_trivially_copyable<FUNCTOR>::value,
+                   "InlineCallback target must be trivially copyable");
+    std::memset (&m_storage, 0, sizeof (m_storage));
+    new (&m_storage) FUNCTOR (functor);
+    m_invoke = &InlineCallback::DoInvoke<FUNCTOR>;
+  }
+
+  /**
+   * Check for a null callback.
+   * \return \c true if there is no target.
+   */
+  bool IsNull (void) const
+  {
+    return m_invoke == 0;
+  }
+  /** Discard the target. */
+  void Nullify (void)
+  {
+    m_invoke = 0;
+    std::memset (&m_storage, 0, sizeof (m_storage));
+  }
+
+  /**
+   * Invoke the target.
+   * \param [in] args The arguments.
+   * \return The target return value.
+   */
+  R operator() (Ts... args) const
+  {
+    return m_invoke (&m_storage, std::forward<Ts> (args)...);
+  }
+
+  /**
+   * Equality test.
+   * \param [in] other The other callback.
+   * \return \c true if both have the same target.
+   */
+  bool IsEqual (const InlineCallback & other) const
+  {
+    return m_invoke == other.m_invoke
+      && std::memcmp (&m_storage, &other.m_storage, sizeof (m_storage)) == 0;
+  }
+
+  /**
+   * Convert to an equivalent, heap allocated, Callback.
+   * \return The Callback.
+   */
+  Callback<R, Ts...> ToCallback (void) const
+  {
+    if (IsNull ())
+      {
+        return Callback<R, Ts...> ();
+      }
+    return Callback<R, Ts...> (*this, true, true);
+  }
+
+private:
+  /**
+   * Invoke a functor stored in the inline storage.
+   * \tparam FUNCTOR \explicit The functor type.
+   * \param [in] storage The inline storage.
+   * \param [in] args The arguments.
+   * \return The functor return value.
+   */
+  template <typename FUNCTOR>
+  static R DoInvoke (const void * storage, Ts... args)
+  {
+    return (*static_cast<const FUNCTOR *> (storage))(std::forward<Ts> (args)...);
+  }
+
+  /** Inline target storage. */
+  typename std::aligned_storage<Capacity>::type m_storage;
+  /** Invoker for the functor in m_storage, or 0 if null. */
+  R (*m_invoke)(const void *, Ts...);
+};
+
+/**
+ * \ingroup callback
+ * Equality test.
+ * \param [in] a InlineCallback
+ * \param [in] b InlineCallback
+ * \return \c true if the callbacks have the same target.
+ */
+template <typename R, typename... Ts>
+bool operator == (const InlineCallback<R, Ts...> & a, const InlineCallback<R, Ts...> & b)
+{
+  return a.IsEqual (b);
+}
+
+/**
+ * \ingroup callback
+ * Inequality test.
+ * \param [in] a InlineCallback
+ * \param [in] b InlineCallback
+ * \return \c true if the callbacks have different targets.
+ */
+template <typename R, typename... Ts>
+bool operator != (const InlineCallback<R, Ts...> & a, const InlineCallback<R, Ts...> & b)
+{
+  return !a.IsEqual (b);
+}
+
+/**
+ * \ingroup callbackimpl
+ * InlineCallback target for a member function of an object held
+ * by raw pointer.
+ */
+template <typename OBJ, typename MEM_PTR>
+struct InlineMemPtrFunctor
+{
+  OBJ * m_objPtr;     //!< The object pointer.
+  MEM_PTR m_memPtr;   //!< The member function pointer.
+  /**
+   * Invoke the member function.
+   * \param [in] args The arguments.
+   * \return The member function return value.
+   */
+  template <typename... As>
+  auto operator() (As&&... args) const -> decltype ((m_objPtr->*m_memPtr)(std::forward<As> (args)...))
+  {
+    return (m_objPtr->*m_memPtr)(std::forward<As> (args)...);
+  }
+};
+
+/**
+ * \ingroup callbackimpl
+ * InlineCallback target for a function pointer with leading bound
+ * arguments.
+ */
+template <typename FN, typename... Bs>
+struct InlineBoundFunctor;
+
+/** InlineCallback target for a function pointer, no bound arguments. */
+template <typename FN>
+struct InlineBoundFunctor<FN>
+{
+  FN m_fnPtr;         //!< The function pointer.
+  /**
+   * Invoke the function.
+   * \param [in] args The arguments.
+   * \return The function return value.
+   */
+  template <typename... As>
+  auto operator() (As&&... args) const -> decltype (m_fnPtr (std::forward<As> (args)...))
+  {
+    return m_fnPtr (std::forward<As> (args)...);
+  }
+};
+
+/** InlineCallback target for a function pointer, one bound argument. */
+template <typename FN, typename B1>
+struct InlineBoundFunctor<FN, B1>
+{
+  FN m_fnPtr;         //!< The function pointer.
+  B1 m_a1;            //!< First bound argument.
+  /**
+   * Invoke the function.
+   * \param [in] args The remaining arguments.
+   * \return The function return value.
+   */
+  template <typename... As>
+  auto operator() (As&&... args) const -> decltype (m_fnPtr (m_a1, std::forward<As> (args)...))
+  {
+    return m_fnPtr (m_a1, std::forward<As> (args)...);
+  }
+};
+
+/** InlineCallback target for a function pointer, two bound arguments. */
+template <typename FN, typename B1, typename B2>
+struct InlineBoundFunctor<FN, B1, B2>
+{
+  FN m_fnPtr;         //!< The function pointer.
+  B1 m_a1;            //!< First bound argument.
+  B2 m_a2;            //!< Second bound argument.
+  /**
+   * Invoke the function.
+   * \param [in] args The remaining arguments.
+   * \return The function return value.
+   */
+  template <typename... As>
+  auto operator() (As&&... args) const -> decltype (m_fnPtr (m_a1, m_a2, std::forward<As> (args)...))
+  {
+    return m_fnPtr (m_a1, m_a2, std::forward<As> (args)...);
+  }
+};
+
+/**
+ * \ingroup callback
+ * Build an InlineCallback for a class method.
+ *
+ * \tparam R \deduced Return type of the callback.
+ * \tparam OBJ \deduced Class type of the method.
+ * \tparam OBJ_PTR \deduced Type of the raw object pointer.
+ * \tparam Ts \deduced Argument types.
+ * \param [in] memPtr Class method member pointer.
+ * \param [in] objPtr Raw pointer to the class instance.
+ * \return A wrapper InlineCallback.
+ */
+template <typename R, typename OBJ, typename OBJ_PTR, typename... Ts>
+InlineCallback<R, Ts...>
+MakeInlineCallback (R (OBJ::*memPtr)(Ts...), OBJ_PTR objPtr)
+{
+  InlineMemPtrFunctor<OBJ, R (OBJ::*)(Ts...)> functor = { objPtr, memPtr };
+  return InlineCallback<R, Ts...> (functor, true, true);
+}
+
+/**
+ * \ingroup callback
+ * \copydoc MakeInlineCallback(R(OBJ::*)(Ts...),OBJ_PTR)
+ */
+template <typename R, typename OBJ, typename OBJ_PTR, typename... Ts>
+InlineCallback<R, Ts...>
+MakeInlineCallback (R (OBJ::*memPtr)(Ts...) const, OBJ_PTR objPtr)
+{
+  InlineMemPtrFunctor<const OBJ, R (OBJ::*)(Ts...) const> functor = { objPtr, memPtr };
+  return InlineCallback<R, Ts...> (functor, true, true);
+}
+
+/**
+ * \ingroup callback
+ * Build an InlineCallback for a function.
+ *
+ * \tparam R \deduced Return type of the callback.
+ * \tparam Ts \deduced Argument types.
+ * \param [in] fnPtr Function pointer.
+ * \return A wrapper InlineCallback.
+ */
+template <typename R, typename... Ts>
+InlineCallback<R, Ts...>
+MakeInlineCallback (R (*fnPtr)(Ts...))
+{
+  InlineBoundFunctor<R (*)(Ts...)> functor = { fnPtr };
+  return InlineCallback<R, Ts...> (functor, true, true);
+}
+
+/**
+ * \ingroup callback
+ * Build an InlineCallback for a function with its first argument bound.
+ *
+ * \tparam R \deduced Return type of the callback.
+ * \tparam B1 \deduced Type of the first function argument.
+ * \tparam Ts \deduced Remaining argument types.
+ * \tparam A1 \deduced Type of the bound argument.
+ * \param [in] fnPtr Function pointer.
+ * \param [in] a1 First argument to bind.
+ * \return A wrapper InlineCallback.
+ */
+template <typename R, typename B1, typename... Ts, typename A1>
+InlineCallback<R, Ts...>
+MakeBoundInlineCallback (R (*fnPtr)(B1, Ts...), A1 a1)
+{
+  typedef typename std::decay<B1>::type Bound1;
+  InlineBoundFunctor<R (*)(B1, Ts...), Bound1> functor = { fnPtr, a1 };
+  return InlineCallback<R, Ts...> (functor, true, true);
+}
+
+/**
+ * \ingroup callback
+ * Build an InlineCallback for a function with its first two
+ * arguments bound.
+ *
+ * \tparam R \deduced Return type of the callback.
+ * \tparam B1 \deduced Type of the first function argument.
+ * \tparam B2 \deduced Type of the second function argument.
+ * \tparam Ts \deduced Remaining argument types.
+ * \tparam A1 \deduced Type of the first bound argument.
+ * \tparam A2 \deduced Type of the second bound argument.
+ * \param [in] fnPtr Function pointer.
+ * \param [in] a1 First argument to bind.
+ * \param [in] a2 Second argument to bind.
+ * \return A wrapper InlineCallback.
+ */
+template <typename R, typename B1, typename B2, typename... Ts, typename A1, typename A2>
+InlineCallback<R, Ts...>
+MakeBoundInlineCallback (R (*fnPtr)(B1, B2, Ts...), A1 a1, A2 a2)
+{
+  typedef typename std::decay<B1>::type Bound1;
+  typedef typename std::decay<B2>::type Bound2;
+  InlineBoundFunctor<R (*)(B1, B2, Ts...), Bound1, Bound2> functor = { fnPtr, a1, a2 };
+  return InlineCallback<R, Ts...> (functor, true, true);
+}
+
+} // namespace ns3
+
+#endif /* INLINE_CALLBACK_H */
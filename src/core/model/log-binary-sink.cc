@@ -0,0 +1,744 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log-binary-sink.h"
+#include "simulator.h"
+#include "nstime.h"
+#include "system-thread.h"
+#include "system-mutex.h"
+#include "system-condition.h"
+#include "callback.h"
+#include "fatal-error.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <unordered_map>
+
+/**
+ * \file
+ * \ingroup logging
+ * ns3::LogBinarySink implementation.
+ */
+
+namespace ns3 {
+
+// Logging is not available here: the sink is where log messages go.
+
+namespace {
+
+/** The first bytes of a binary log file, including a format version. */
+const char LOG_BINARY_MAGIC[8] = { 'N', 'S', '3', 'L', 'O', 'G', 'B', '1' };
+
+/** Record types in a binary log. */
+enum RecordType
+{
+  RECORD_STRING = 'S',       //!< Defines a string id: uint32 id, uint32 size, chars.
+  RECORD_RESOLUTION = 'R',   //!< Time resolution: uint8 Time::Unit.
+  RECORD_MESSAGE = 'M',      //!< A log message, see LogBinarySinkImpl::BeginMessage.
+  RECORD_TEXT = 'T'          //!< Other text written on std::clog: uint32 size, chars.
+};
+
+/** Flags of a message record, telling which prefixes to print. */
+enum MessageFlags
+{
+  FLAG_TIME = 1,    //!< Print the time.
+  FLAG_NODE = 2,    //!< Print the context.
+  FLAG_FUNC = 4,    //!< Print the component and function.
+  FLAG_LEVEL = 8,   //!< Print the level.
+  FLAG_CALL = 16    //!< NS_LOG_FUNCTION: the text is the argument list.
+};
+
+/**
+ * Append a value to a record, in host byte order.
+ * \param [in,out] buffer The record.
+ * \param [in] value The value.
+ */
+template <typename T>
+void
+Append (std::string &buffer, T value)
+{
+  buffer.append (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+/**
+ * Read a value written by Append.
+ * \param [in] is The input stream.
+ * \param [out] value The value read.
+ * \returns \c true if the value was read.
+ */
+template <typename T>
+bool
+Read (std::istream &is, T &value)
+{
+  is.read (reinterpret_cast<char *> (&value), sizeof (value));
+  return is.gcount () == sizeof (value);
+}
+
+/**
+ * Read a size-prefixed string.
+ * \param [in] is The input stream.
+ * \param [out] value The string read.
+ * \returns \c true if the string was read.
+ */
+bool
+ReadString (std::istream &is, std::string &value)
+{
+  uint32_t size;
+  if (!Read (is, size))
+    {
+      return false;
+    }
+  value.resize (size);
+  is.read (&value[0], size);
+  return is.gcount () == static_cast<std::streamsize> (size);
+}
+
+/**
+ * Convert a time step to seconds, as Time::To (Time::S) does when the
+ * time resolution is \p unit.
+ * \param [in] ts The time step.
+ * \param [in] unit The time resolution.
+ * \returns The time in seconds.
+ */
+int64x64_t
+TimeStepToSeconds (int64_t ts, enum Time::Unit unit)
+{
+  // Y, D, H, MIN, S, MS, US, NS, PS, FS, as in Time::SetResolution
+  const int8_t power [Time::LAST] = { 17, 17, 17, 16, 15, 12, 9, 6, 3, 0 };
+  const int32_t coefficient [Time::LAST] = { 315360, 864, 36, 6, 1, 1, 1, 1, 1, 1 };
+  int64x64_t seconds = int64x64_t (ts);
+  int64_t factor = coefficient[unit];
+  if (power[unit] >= power[Time::S])
+    {
+      for (int i = power[Time::S]; i < power[unit]; ++i)
+        {
+          factor *= 10;
+        }
+      if (factor != 1)
+        {
+          seconds *= int64x64_t (factor);
+        }
+    }
+  else
+    {
+      for (int i = power[unit]; i < power[Time::S]; ++i)
+        {
+          factor *= 10;
+        }
+      seconds.MulByInvert (int64x64_t::Invert (factor));
+    }
+  return seconds;
+}
+
+/** The serial number of the last sink created. */
+uint64_t g_sinkSerial = 0;
+
+/** The line a thread is writing on \c std::clog. */
+struct LogBinaryLine
+{
+  uint64_t sink;                //!< The serial number of the sink the line belongs to.
+  std::string text;             //!< The text of the line.
+  bool inMessage;               //!< The line is a log message.
+  std::string header;           //!< The prefix fields of the message.
+  uint32_t contextSize;         //!< The size of the context text of the message.
+  std::string record;           //!< Scratch record buffer.
+};
+
+/**
+ * The binary log sink: a LogBackend for the message prefixes, and
+ * the stream buffer of \c std::clog for the message text.
+ *
+ * Each thread builds its current line in its own LogBinaryLine, so
+ * that threads logging at the same time, such as the FdNetDevice
+ * reader or the realtime simulator, never mix their lines; complete
+ * records are then queued under the mutex.
+ */
+class LogBinarySinkImpl : public LogBackend, public std::streambuf
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] file The open file to write.
+   * \param [in] bufferSize The size of the in-memory buffer.
+   * \param [in] dropWhenFull Drop messages when the buffer is full.
+   */
+  LogBinarySinkImpl (FILE *file, std::size_t bufferSize, bool dropWhenFull);
+  /** Flush the buffer and stop the writer thread. */
+  virtual ~LogBinarySinkImpl ();
+
+  // Inherited from LogBackend
+  virtual void BeginMessage (const LogComponent &component, enum LogLevel level,
+                             const char *function, bool call);
+  virtual void EndContext (void);
+
+  /**
+   * Get the number of messages dropped.
+   * \returns The number of messages dropped.
+   */
+  uint64_t GetDropped (void) const;
+
+protected:
+  // Inherited from std::streambuf
+  virtual int_type overflow (int_type c);
+  virtual std::streamsize xsputn (const char *s, std::streamsize n);
+
+private:
+  /**
+   * Get the id of a string, defining it first if needed.
+   * \param [in] s The string; must stay valid while the sink is enabled.
+   * \returns The string id.
+   */
+  uint32_t Intern (const char *s);
+  /**
+   * Get the line of the calling thread.
+   * \returns The line, cleared if it belonged to an earlier sink.
+   */
+  LogBinaryLine & GetLine (void);
+  /**
+   * Complete the current record, at the end of a line.
+   * \param [in,out] line The line of the calling thread.
+   */
+  void EndRecord (LogBinaryLine &line);
+  /**
+   * Emit the text written since the last record as a text record.
+   * \param [in,out] line The line of the calling thread.
+   * \param [in] newline Add the end of line.
+   */
+  void EmitText (LogBinaryLine &line, bool newline);
+  /**
+   * Queue a record for the writer thread.
+   * \param [in] record The record.
+   * \param [in] droppable The record can be dropped if the buffer is full.
+   */
+  void Commit (const std::string &record, bool droppable);
+  /** The writer thread. */
+  void Write (void);
+
+  FILE *m_file;                 //!< The binary log file.
+  std::size_t m_bufferSize;     //!< The size of the in-memory buffer.
+  bool m_dropWhenFull;          //!< Drop messages when the buffer is full.
+
+  uint64_t m_serial;            //!< The serial number of this sink.
+
+  // Definitions shared by the logging threads, guarded by m_defineMutex.
+  SystemMutex m_defineMutex;    //!< Guards the definitions.
+  int m_resolution;             //!< The time resolution last recorded.
+  /** The ids of the strings already defined, by address. */
+  std::unordered_map<const char *, uint32_t> m_strings;
+  std::string m_record;         //!< Scratch record buffer for the definitions.
+
+  // State shared with the writer thread, guarded by m_mutex.
+  mutable SystemMutex m_mutex;  //!< Guards the buffer.
+  std::string m_front;          //!< Records waiting to be written.
+  bool m_stop;                  //!< Stop the writer thread.
+  uint64_t m_dropped;           //!< The number of messages dropped.
+
+  SystemCondition m_dataReady;  //!< Wakes up the writer thread.
+  SystemCondition m_spaceReady; //!< Wakes up a waiting simulation thread.
+  Ptr<SystemThread> m_thread;   //!< The writer thread.
+};
+
+LogBinarySinkImpl::LogBinarySinkImpl (FILE *file, std::size_t bufferSize, bool dropWhenFull)
+  : m_file (file),
+    m_bufferSize (bufferSize),
+    m_dropWhenFull (dropWhenFull),
+    m_serial (++g_sinkSerial),
+    m_resolution (-1),
+    m_stop (false),
+    m_dropped (0)
+{
+  m_front.reserve (m_bufferSize);
+  std::fwrite (LOG_BINARY_MAGIC, 1, sizeof (LOG_BINARY_MAGIC), m_file);
+  m_thread = Create<SystemThread> (MakeCallback (&LogBinarySinkImpl::Write, this));
+  m_thread->Start ();
+}
+
+LogBinarySinkImpl::~LogBinarySinkImpl ()
+{
+  // Only the calling thread's unfinished line can be reached here.
+  LogBinaryLine &line = GetLine ();
+  if (!line.text.empty ())
+    {
+      EmitText (line, false);
+    }
+  m_mutex.Lock ();
+  m_stop = true;
+  m_mutex.Unlock ();
+  m_dataReady.SetCondition (true);
+  m_dataReady.Signal ();
+  m_thread->Join ();
+  m_thread = 0;
+  std::fclose (m_file);
+}
+
+uint64_t
+LogBinarySinkImpl::GetDropped (void) const
+{
+  CriticalSection cs (m_mutex);
+  return m_dropped;
+}
+
+LogBinaryLine &
+LogBinarySinkImpl::GetLine (void)
+{
+  static thread_local LogBinaryLine line = { 0, std::string (), false, std::string (), 0, std::string () };
+  if (line.sink != m_serial)
+    {
+      line.sink = m_serial;
+      line.text.clear ();
+      line.inMessage = false;
+      line.contextSize = 0;
+    }
+  return line;
+}
+
+uint32_t
+LogBinarySinkImpl::Intern (const char *s)
+{
+  // Commit the definition before another thread can use the id.
+  CriticalSection cs (m_defineMutex);
+  std::unordered_map<const char *, uint32_t>::const_iterator it = m_strings.find (s);
+  if (it != m_strings.end ())
+    {
+      return it->second;
+    }
+  uint32_t id = m_strings.size ();
+  m_strings[s] = id;
+  std::size_t size = std::strlen (s);
+  m_record.clear ();
+  Append<uint8_t> (m_record, RECORD_STRING);
+  Append<uint32_t> (m_record, id);
+  Append<uint32_t> (m_record, size);
+  m_record.append (s, size);
+  Commit (m_record, false);
+  return id;
+}
+
+void
+LogBinarySinkImpl::BeginMessage (const LogComponent &component, enum LogLevel level,
+                                 const char *function, bool call)
+{
+  LogBinaryLine &line = GetLine ();
+  if (!line.text.empty ())
+    {
+      // Text written without an end of line comes before this message.
+      EmitText (line, false);
+    }
+  uint8_t flags = 0;
+  int64_t ts = 0;
+  uint32_t context = 0;
+  if (component.IsEnabled (LOG_PREFIX_TIME) && LogGetTimePrinter () != 0)
+    {
+      flags |= FLAG_TIME;
+      ts = Simulator::Now ().GetTimeStep ();
+      CriticalSection cs (m_defineMutex);
+      if (m_resolution != Time::GetResolution ())
+        {
+          m_resolution = Time::GetResolution ();
+          m_record.clear ();
+          Append<uint8_t> (m_record, RECORD_RESOLUTION);
+          Append<uint8_t> (m_record, m_resolution);
+          Commit (m_record, false);
+        }
+    }
+  if (component.IsEnabled (LOG_PREFIX_NODE) && LogGetNodePrinter () != 0)
+    {
+      flags |= FLAG_NODE;
+      context = Simulator::GetContext ();
+    }
+  if (call)
+    {
+      flags |= FLAG_CALL;
+    }
+  else
+    {
+      if (component.IsEnabled (LOG_PREFIX_FUNC))
+        {
+          flags |= FLAG_FUNC;
+        }
+      if (component.IsEnabled (LOG_PREFIX_LEVEL))
+        {
+          flags |= FLAG_LEVEL;
+        }
+    }
+  uint32_t componentId = 0;
+  uint32_t functionId = 0;
+  if (flags & (FLAG_FUNC | FLAG_CALL))
+    {
+      componentId = Intern (component.Name ());
+      functionId = Intern (function);
+    }
+
+  line.header.clear ();
+  Append<uint8_t> (line.header, RECORD_MESSAGE);
+  Append<uint8_t> (line.header, flags);
+  Append<int64_t> (line.header, ts);
+  Append<uint32_t> (line.header, context);
+  Append<uint32_t> (line.header, componentId);
+  Append<uint32_t> (line.header, functionId);
+  Append<uint32_t> (line.header, level);
+  line.inMessage = true;
+  line.contextSize = 0;
+}
+
+void
+LogBinarySinkImpl::EndContext (void)
+{
+  LogBinaryLine &line = GetLine ();
+  line.contextSize = line.text.size ();
+}
+
+LogBinarySinkImpl::int_type
+LogBinarySinkImpl::overflow (int_type c)
+{
+  if (traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      return traits_type::not_eof (c);
+    }
+  char ch = traits_type::to_char_type (c);
+  LogBinaryLine &line = GetLine ();
+  if (ch == '\n')
+    {
+      EndRecord (line);
+    }
+  else
+    {
+      line.text.push_back (ch);
+    }
+  return c;
+}
+
+std::streamsize
+LogBinarySinkImpl::xsputn (const char *s, std::streamsize n)
+{
+  LogBinaryLine &line = GetLine ();
+  const char *end = s + n;
+  while (s != end)
+    {
+      const char *eol = static_cast<const char *> (std::memchr (s, '\n', end - s));
+      if (eol == 0)
+        {
+          line.text.append (s, end - s);
+          break;
+        }
+      line.text.append (s, eol - s);
+      EndRecord (line);
+      s = eol + 1;
+    }
+  return n;
+}
+
+void
+LogBinarySinkImpl::EndRecord (LogBinaryLine &line)
+{
+  if (!line.inMessage)
+    {
+      EmitText (line, true);
+      return;
+    }
+  line.record = line.header;
+  Append<uint32_t> (line.record, line.contextSize);
+  Append<uint32_t> (line.record, line.text.size ());
+  line.record.append (line.text);
+  Commit (line.record, true);
+  line.text.clear ();
+  line.inMessage = false;
+}
+
+void
+LogBinarySinkImpl::EmitText (LogBinaryLine &line, bool newline)
+{
+  if (newline)
+    {
+      line.text.push_back ('\n');
+    }
+  line.record.clear ();
+  Append<uint8_t> (line.record, RECORD_TEXT);
+  Append<uint32_t> (line.record, line.text.size ());
+  line.record.append (line.text);
+  Commit (line.record, true);
+  line.text.clear ();
+  line.inMessage = false;
+}
+
+void
+LogBinarySinkImpl::Commit (const std::string &record, bool droppable)
+{
+  m_mutex.Lock ();
+  while (!m_front.empty () && m_front.size () + record.size () > m_bufferSize)
+    {
+      if (droppable && m_dropWhenFull)
+        {
+          m_dropped++;
+          m_mutex.Unlock ();
+          return;
+        }
+      if (!droppable)
+        {
+          // String definitions are small, and later records need them.
+          break;
+        }
+      // Wait for the writer thread to take the buffer.
+      m_spaceReady.SetCondition (false);
+      m_mutex.Unlock ();
+      m_dataReady.SetCondition (true);
+      m_dataReady.Signal ();
+      m_spaceReady.TimedWait (1000000);
+      m_mutex.Lock ();
+    }
+  m_front.append (record);
+  bool wake = m_front.size () >= m_bufferSize / 2;
+  m_mutex.Unlock ();
+  if (wake)
+    {
+      m_dataReady.SetCondition (true);
+      m_dataReady.Signal ();
+    }
+}
+
+void
+LogBinarySinkImpl::Write (void)
+{
+  std::string back;
+  back.reserve (m_bufferSize);
+  for (;;)
+    {
+      // TimedWait does not reset the condition: reset it before looking
+      // at the buffer, so that a signal sent from now on ends the wait.
+      m_dataReady.SetCondition (false);
+      m_mutex.Lock ();
+      bool stop = m_stop;
+      m_front.swap (back);
+      m_mutex.Unlock ();
+      if (!back.empty ())
+        {
+          if (std::fwrite (back.data (), 1, back.size (), m_file) != back.size ())
+            {
+              NS_FATAL_ERROR ("Cannot write the binary log: " << std::strerror (errno));
+            }
+          back.clear ();
+          m_spaceReady.SetCondition (true);
+          m_spaceReady.Broadcast ();
+          continue;
+        }
+      if (stop)
+        {
+          break;
+        }
+      // Between wake ups, which come when the buffer is half full, write
+      // out what is there every 10 ms.
+      m_dataReady.TimedWait (10000000);
+    }
+  std::fflush (m_file);
+}
+
+/** The enabled sink, if any. */
+LogBinarySinkImpl *g_sink = 0;
+/** The stream buffer of std::clog before the sink was enabled. */
+std::streambuf *g_clogBuffer = 0;
+
+/** Enable the sink from the environment, and flush it at exit. */
+class LogBinarySinkEnvironment
+{
+public:
+  /** Enable the sink if NS_LOG_BINARY names a file. */
+  LogBinarySinkEnvironment ()
+  {
+    const char *filename = std::getenv ("NS_LOG_BINARY");
+    if (filename != 0 && filename[0] != '\0')
+      {
+        LogBinarySink::Enable (filename);
+      }
+  }
+  /** Flush and close the binary log. */
+  ~LogBinarySinkEnvironment ()
+  {
+    LogBinarySink::Disable ();
+  }
+};
+
+/** Enable the sink from the environment, and flush it at exit. */
+LogBinarySinkEnvironment g_logBinarySinkEnvironment;
+
+}  // unnamed namespace
+
+void
+LogBinarySink::Enable (const std::string &filename,
+                       std::size_t bufferSize /* = 4 * 1024 * 1024 */,
+                       bool dropWhenFull /* = false */)
+{
+  Disable ();
+  FILE *file = std::fopen (filename.c_str (), "wb");
+  if (file == 0)
+    {
+      NS_FATAL_ERROR ("Cannot open binary log \"" << filename << "\": " << std::strerror (errno));
+    }
+  std::clog.flush ();
+  g_sink = new LogBinarySinkImpl (file, bufferSize, dropWhenFull);
+  g_clogBuffer = std::clog.rdbuf (g_sink);
+  LogSetBackend (g_sink);
+}
+
+void
+LogBinarySink::Disable (void)
+{
+  if (g_sink == 0)
+    {
+      return;
+    }
+  LogSetBackend (0);
+  std::clog.rdbuf (g_clogBuffer);
+  g_clogBuffer = 0;
+  delete g_sink;
+  g_sink = 0;
+}
+
+bool
+LogBinarySink::IsEnabled (void)
+{
+  return g_sink != 0;
+}
+
+uint64_t
+LogBinarySink::GetDropped (void)
+{
+  return g_sink == 0 ? 0 : g_sink->GetDropped ();
+}
+
+bool
+LogBinarySink::Decode (std::istream &is, std::ostream &os)
+{
+  char magic[sizeof (LOG_BINARY_MAGIC)];
+  is.read (magic, sizeof (magic));
+  if (is.gcount () != sizeof (magic)
+      || std::memcmp (magic, LOG_BINARY_MAGIC, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+
+  std::map<uint32_t, std::string> strings;
+  enum Time::Unit resolution = Time::GetResolution ();
+  uint8_t type;
+  while (Read (is, type))
+    {
+      switch (type)
+        {
+        case RECORD_STRING:
+          {
+            uint32_t id;
+            std::string s;
+            if (!Read (is, id) || !ReadString (is, s))
+              {
+                return false;
+              }
+            strings[id] = s;
+            break;
+          }
+        case RECORD_RESOLUTION:
+          {
+            uint8_t unit;
+            if (!Read (is, unit) || unit >= Time::LAST)
+              {
+                return false;
+              }
+            resolution = static_cast<enum Time::Unit> (unit);
+            break;
+          }
+        case RECORD_TEXT:
+          {
+            std::string text;
+            if (!ReadString (is, text))
+              {
+                return false;
+              }
+            os << text;
+            break;
+          }
+        case RECORD_MESSAGE:
+          {
+            uint8_t flags;
+            int64_t ts;
+            uint32_t context, componentId, functionId, level, contextSize;
+            std::string text;
+            if (!Read (is, flags) || !Read (is, ts) || !Read (is, context)
+                || !Read (is, componentId) || !Read (is, functionId)
+                || !Read (is, level) || !Read (is, contextSize)
+                || !ReadString (is, text) || contextSize > text.size ())
+              {
+                return false;
+              }
+            if (flags & FLAG_TIME)
+              {
+                // As DefaultTimePrinter.
+                std::ios_base::fmtflags ff = os.flags ();
+                std::streamsize oldPrecision = os.precision ();
+                os << std::fixed;
+                switch (resolution)
+                  {
+                  case Time::US :    os << std::setprecision (6);   break;
+                  case Time::NS :    os << std::setprecision (9);   break;
+                  case Time::PS :    os << std::setprecision (12);  break;
+                  case Time::FS :    os << std::setprecision (15);  break;
+                  default :          os << std::setprecision (5);
+                  }
+                os << TimeStepToSeconds (ts, resolution) << "s ";
+                os << std::setprecision (oldPrecision);
+                os.flags (ff);
+              }
+            if (flags & FLAG_NODE)
+              {
+                // As DefaultNodePrinter.
+                if (context == Simulator::NO_CONTEXT)
+                  {
+                    os << "-1 ";
+                  }
+                else
+                  {
+                    os << context << " ";
+                  }
+              }
+            os.write (text.data (), contextSize);
+            if (flags & FLAG_CALL)
+              {
+                os << strings[componentId] << ":" << strings[functionId] << "(";
+                os.write (text.data () + contextSize, text.size () - contextSize);
+                os << ")" << std::endl;
+                break;
+              }
+            if (flags & FLAG_FUNC)
+              {
+                os << strings[componentId] << ":" << strings[functionId] << "(): ";
+              }
+            if (flags & FLAG_LEVEL)
+              {
+                os << "[" << LogComponent::GetLevelLabel (static_cast<enum LogLevel> (level)) << "] ";
+              }
+            os.write (text.data () + contextSize, text.size () - contextSize);
+            os << std::endl;
+            break;
+          }
+        default:
+          return false;
+        }
+    }
+  return true;
+}
+
+}  // namespace ns3
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LOG_BINARY_SINK_H
+#define LOG_BINARY_SINK_H
+
+/**
+ * \file
+ * \ingroup logging
+ * ns3::LogBinarySink declaration.
+ */
+
+#include "log.h"
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup logging
+ *
+ * Write log messages to a binary file from a background thread.
+ *
+ * While the sink is enabled it captures \c std::clog.  The prefix of
+ * each log message (simulation time, context, component, function and
+ * level) is stored as raw values, with the component and function
+ * names written once and then referred to by id.  Only the message
+ * text itself is formatted.  Records are appended to an in-memory
+ * buffer, which a background thread writes out to the file.
+ *
+ * When the buffer is full the sink either waits for the writer or,
+ * with \c dropWhenFull, drops the message and counts it, so that the
+ * cost of logging on the simulation thread stays bounded.
+ *
+ * Other threads may log while the sink is enabled: each thread builds
+ * its lines separately, so lines of different threads are not mixed.
+ *
+ * The file is decoded with Decode(), or the \c log-decode program in
+ * \c utils/, which prints the same text the messages would have
+ * printed on \c std::clog with the default time and node printers.
+ *
+ * The sink can also be enabled without changing the program, by
+ * setting the \c NS_LOG_BINARY environment variable to the file name:
+ * \code
+ *   $ NS_LOG="TcpSocketBase=level_all|prefix_all" NS_LOG_BINARY=tcp.nslog ./waf --run ...
+ *   $ ./waf --run "log-decode --input=tcp.nslog"
+ * \endcode
+ */
+class LogBinarySink
+{
+public:
+  /**
+   * Start writing log messages to a file.
+   * \param [in] filename The file to write.
+   * \param [in] bufferSize The size of the in-memory buffer, in bytes.
+   * \param [in] dropWhenFull Drop messages when the buffer is full,
+   *             instead of waiting for the writer thread.
+   */
+  static void Enable (const std::string &filename,
+                      std::size_t bufferSize = 4 * 1024 * 1024,
+                      bool dropWhenFull = false);
+  /**
+   * Write out the buffered messages, stop the writer thread and close
+   * the file; log messages go to \c std::clog again.
+   */
+  static void Disable (void);
+  /**
+   * Check if the sink is enabled.
+   * \returns \c true if log messages are written to the binary file.
+   */
+  static bool IsEnabled (void);
+  /**
+   * Get the number of messages dropped because the buffer was full.
+   * \returns The number of messages dropped since Enable().
+   */
+  static uint64_t GetDropped (void);
+
+  /**
+   * Decode a binary log file.
+   * \param [in] is The binary log.
+   * \param [in] os The stream to print the messages on.
+   * \returns \c false if the input is not a valid binary log.
+   */
+  static bool Decode (std::istream &is, std::ostream &os);
+};
+
+}  // namespace ns3
+
+#endif /* LOG_BINARY_SINK_H */
@@ -155,11 +155,22 @@
     {                                                           \
       if (g_log.IsEnabled (level))                              \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          NS_LOG_APPEND_FUNC_PREFIX;                            \
-          NS_LOG_APPEND_LEVEL_PREFIX (level);                   \
+          ns3::LogBackend *nsLogBackend = ns3::LogGetBackend (); \
+          if (nsLogBackend != 0)                                \
+            {                                                   \
+              nsLogBackend->BeginMessage (g_log, level,         \
+                                          __FUNCTION__, false); \
+              NS_LOG_APPEND_CONTEXT;                            \
+              nsLogBackend->EndContext ();                      \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              NS_LOG_APPEND_FUNC_PREFIX;                        \
+              NS_LOG_APPEND_LEVEL_PREFIX (level);               \
+            }                                                   \
           std::clog << msg << std::endl;                        \
         }                                                       \
     }                                                           \
@@ -179,11 +190,23 @@
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "()" << std::endl;       \
+          ns3::LogBackend *nsLogBackend = ns3::LogGetBackend (); \
+          if (nsLogBackend != 0)                                \
+            {                                                   \
+              nsLogBackend->BeginMessage (g_log, ns3::LOG_FUNCTION, \
+                                          __FUNCTION__, true);  \
+              NS_LOG_APPEND_CONTEXT;                            \
+              nsLogBackend->EndContext ();                      \
+              std::clog << std::endl;                           \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "()" << std::endl;   \
+            }                                                   \
         }                                                       \
     }                                                           \
   while (false)
@@ -216,13 +239,26 @@
     {                                                           \
       if (g_log.IsEnabled (ns3::LOG_FUNCTION))                  \
         {                                                       \
-          NS_LOG_APPEND_TIME_PREFIX;                            \
-          NS_LOG_APPEND_NODE_PREFIX;                            \
-          NS_LOG_APPEND_CONTEXT;                                \
-          std::clog << g_log.Name () << ":"                     \
-                    << __FUNCTION__ << "(";                     \
-          ns3::ParameterLogger (std::clog) << parameters;       \
-          std::clog << ")" << std::endl;                        \
+          ns3::LogBackend *nsLogBackend = ns3::LogGetBackend (); \
+          if (nsLogBackend != 0)                                \
+            {                                                   \
+              nsLogBackend->BeginMessage (g_log, ns3::LOG_FUNCTION, \
+                                          __FUNCTION__, true);  \
+              NS_LOG_APPEND_CONTEXT;                            \
+              nsLogBackend->EndContext ();                      \
+              ns3::ParameterLogger (std::clog) << parameters;   \
+              std::clog << std::endl;                           \
+            }                                                   \
+          else                                                  \
+            {                                                   \
+              NS_LOG_APPEND_TIME_PREFIX;                        \
+              NS_LOG_APPEND_NODE_PREFIX;                        \
+              NS_LOG_APPEND_CONTEXT;                            \
+              std::clog << g_log.Name () << ":"                 \
+                        << __FUNCTION__ << "(";                 \
+              ns3::ParameterLogger (std::clog) << parameters;   \
+              std::clog << ")" << std::endl;                    \
+            }                                                   \
         }                                                       \
     }                                                           \
   while (false)
@@ -56,6 +56,12 @@ static TimePrinter g_logTimePrinter = 0;
  */
 static NodePrinter g_logNodePrinter = 0;
 
+/**
+ * \ingroup logging
+ * The log backend, if any.
+ */
+static LogBackend *g_logBackend = 0;
+
 /**
  * \ingroup logging
  * Handler for \c print-list token in NS_LOG
@@ -649,6 +655,19 @@ NodePrinter LogGetNodePrinter (void)
   return g_logNodePrinter;
 }
 
+LogBackend::~LogBackend ()
+{
+}
+
+void LogSetBackend (LogBackend *backend)
+{
+  g_logBackend = backend;
+}
+LogBackend * LogGetBackend (void)
+{
+  return g_logBackend;
+}
+
 
 ParameterLogger::ParameterLogger (std::ostream &os)
   : m_first (true),
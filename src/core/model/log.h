@@ -442,6 +442,49 @@ private:
  */
 LogComponent & GetLogComponent (const std::string name);
 
+/**
+ * A log backend, which receives the prefix of each message as raw
+ * values instead of formatted text.
+ *
+ * While a backend is set, the logging macros call BeginMessage instead
+ * of printing the time, node, function and level prefixes, and
+ * EndContext after the NS_LOG_APPEND_CONTEXT text; the rest of the
+ * message is then written on \c std::clog as usual, up to the end of
+ * line.  The backend is expected to capture \c std::clog.
+ *
+ * \see LogBinarySink
+ */
+class LogBackend
+{
+public:
+  /** Destructor. */
+  virtual ~LogBackend ();
+  /**
+   * Start a log message.
+   * \param [in] component The LogComponent logging the message.
+   * \param [in] level The message level.
+   * \param [in] function The name of the function logging.
+   * \param [in] call \c true for NS_LOG_FUNCTION: the text of the
+   *             message is the list of function arguments.
+   */
+  virtual void BeginMessage (const LogComponent &component, enum LogLevel level,
+                             const char *function, bool call) = 0;
+  /** Mark the end of the NS_LOG_APPEND_CONTEXT text of the message. */
+  virtual void EndContext (void) = 0;
+};
+
+/**
+ * Set the log backend.
+ * \param [in] backend The backend, or 0 to format log messages
+ *             directly on \c std::clog.
+ */
+void LogSetBackend (LogBackend *backend);
+/**
+ * Get the log backend.
+ * \returns The backend currently in use, or 0.
+ */
+LogBackend * LogGetBackend (void);
+
 /**
  * Insert `, ` when streaming function arguments.
  */
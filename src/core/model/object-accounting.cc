@@ -0,0 +1,357 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "object-accounting.h"
+#include "object.h"
+#include "type-id.h"
+#include "simulator.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup object
+ * ns3::ObjectAccounting implementation.
+ */
+
+namespace ns3 {
+
+// Logging is not available here: the log macros create objects.
+
+namespace {
+
+/** Instance counters of one type in one context. */
+struct Counter
+{
+  Counter () : live (0), created (0) {}
+  uint64_t live;      //!< Live instances.
+  uint64_t created;   //!< Instances ever created.
+};
+
+/** The accounting of one type. */
+struct TypeAccount
+{
+  std::string name;                       //!< The type name.
+  std::size_t size;                       //!< The size of an instance.
+  std::map<uint32_t, Counter> contexts;   //!< The counters, by context.
+};
+
+/** The accounting of all types. */
+struct AccountingTable
+{
+  std::mutex mutex;                         //!< Guards the table.
+  std::vector<TypeAccount> types;           //!< The types, by index.
+  std::map<std::string, uint32_t> byName;   //!< The type indices, by name.
+  std::vector<uint32_t> byUid;              //!< The Object type indices, by TypeId uid.
+};
+
+/**
+ * Get the accounting table.
+ *
+ * The table is never deleted, so that instances destroyed by static
+ * destructors can still be counted.
+ *
+ * \returns The table.
+ */
+AccountingTable *
+GetTable (void)
+{
+  static AccountingTable *table = new AccountingTable ();
+  return table;
+}
+
+/**
+ * Find or add a type; the table must be locked.
+ * \param [in] table The table.
+ * \param [in] name The type name.
+ * \param [in] size The size of an instance.
+ * \returns The type index.
+ */
+uint32_t
+LookupType (AccountingTable *table, const std::string &name, std::size_t size)
+{
+  std::map<std::string, uint32_t>::const_iterator it = table->byName.find (name);
+  if (it != table->byName.end ())
+    {
+      return it->second;
+    }
+  uint32_t index = table->types.size ();
+  TypeAccount account;
+  account.name = name;
+  account.size = size;
+  table->types.push_back (account);
+  table->byName[name] = index;
+  return index;
+}
+
+/**
+ * Build a record from the counters of a type.
+ * \param [in] account The type accounting.
+ * \param [in] context The context of the record.
+ * \param [in] counter The counters.
+ * \returns The record.
+ */
+ObjectAccounting::Record
+MakeRecord (const TypeAccount &account, uint32_t context, const Counter &counter)
+{
+  ObjectAccounting::Record record;
+  record.type = account.name;
+  record.context = context;
+  record.live = counter.live;
+  record.bytes = counter.live * account.size;
+  record.created = counter.created;
+  return record;
+}
+
+/**
+ * Order records by decreasing live bytes, then by name and context.
+ * \param [in] a The first record.
+ * \param [in] b The second record.
+ * \returns \c true if \p a should be printed before \p b.
+ */
+bool
+CompareRecords (const ObjectAccounting::Record &a, const ObjectAccounting::Record &b)
+{
+  if (a.bytes != b.bytes)
+    {
+      return a.bytes > b.bytes;
+    }
+  if (a.type != b.type)
+    {
+      return a.type < b.type;
+    }
+  return a.context < b.context;
+}
+
+}  // unnamed namespace
+
+bool
+ObjectAccounting::IsEnabled (void)
+{
+#ifdef NS3_OBJECT_ACCOUNTING
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint32_t
+ObjectAccounting::RegisterType (const char *mangled, std::size_t size)
+{
+  std::string name = mangled;
+#if (__GNUC__ >= 3)
+  int status;
+  char *demangled = abi::__cxa_demangle (mangled, NULL, NULL, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  return LookupType (table, name, size);
+}
+
+uint32_t
+ObjectAccounting::RegisterType (const TypeId &tid)
+{
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  uint16_t uid = tid.GetUid ();
+  if (uid < table->byUid.size () && table->byUid[uid] != 0)
+    {
+      return table->byUid[uid] - 1;
+    }
+  std::size_t size = tid.GetSize ();
+  if (size == (std::size_t)(-1))
+    {
+      // Not registered with NS_OBJECT_ENSURE_REGISTERED.
+      size = sizeof (Object);
+    }
+  uint32_t index = LookupType (table, tid.GetName (), size);
+  if (uid >= table->byUid.size ())
+    {
+      table->byUid.resize (uid + 1, 0);
+    }
+  table->byUid[uid] = index + 1;
+  return index;
+}
+
+uint32_t
+ObjectAccounting::GetContext (void)
+{
+  return Simulator::GetContext ();
+}
+
+void
+ObjectAccounting::Add (uint32_t type, uint32_t context)
+{
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  NS_ASSERT (type < table->types.size ());
+  Counter &counter = table->types[type].contexts[context];
+  counter.live++;
+  counter.created++;
+}
+
+void
+ObjectAccounting::Remove (uint32_t type, uint32_t context)
+{
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  NS_ASSERT (type < table->types.size ());
+  Counter &counter = table->types[type].contexts[context];
+  NS_ASSERT (counter.live > 0);
+  counter.live--;
+}
+
+std::vector<ObjectAccounting::Record>
+ObjectAccounting::GetRecords (bool perContext /* = false */)
+{
+  AccountingTable *table = GetTable ();
+  std::vector<Record> records;
+  {
+    std::lock_guard<std::mutex> lock (table->mutex);
+    for (std::vector<TypeAccount>::const_iterator t = table->types.begin ();
+         t != table->types.end (); ++t)
+      {
+        Counter total;
+        for (std::map<uint32_t, Counter>::const_iterator c = t->contexts.begin ();
+             c != t->contexts.end (); ++c)
+          {
+            if (perContext)
+              {
+                records.push_back (MakeRecord (*t, c->first, c->second));
+              }
+            total.live += c->second.live;
+            total.created += c->second.created;
+          }
+        if (!perContext && total.created > 0)
+          {
+            records.push_back (MakeRecord (*t, Simulator::NO_CONTEXT, total));
+          }
+      }
+  }
+  std::sort (records.begin (), records.end (), &CompareRecords);
+  return records;
+}
+
+ObjectAccounting::Record
+ObjectAccounting::GetRecord (const std::string &type)
+{
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  TypeAccount none;
+  none.name = type;
+  none.size = 0;
+  Counter total;
+  std::map<std::string, uint32_t>::const_iterator it = table->byName.find (type);
+  if (it == table->byName.end ())
+    {
+      return MakeRecord (none, Simulator::NO_CONTEXT, total);
+    }
+  const TypeAccount &account = table->types[it->second];
+  for (std::map<uint32_t, Counter>::const_iterator c = account.contexts.begin ();
+       c != account.contexts.end (); ++c)
+    {
+      total.live += c->second.live;
+      total.created += c->second.created;
+    }
+  return MakeRecord (account, Simulator::NO_CONTEXT, total);
+}
+
+ObjectAccounting::Record
+ObjectAccounting::GetRecord (const std::string &type, uint32_t context)
+{
+  AccountingTable *table = GetTable ();
+  std::lock_guard<std::mutex> lock (table->mutex);
+  TypeAccount none;
+  none.name = type;
+  none.size = 0;
+  std::map<std::string, uint32_t>::const_iterator it = table->byName.find (type);
+  if (it == table->byName.end ())
+    {
+      return MakeRecord (none, context, Counter ());
+    }
+  const TypeAccount &account = table->types[it->second];
+  std::map<uint32_t, Counter>::const_iterator c = account.contexts.find (context);
+  if (c == account.contexts.end ())
+    {
+      return MakeRecord (account, context, Counter ());
+    }
+  return MakeRecord (account, context, c->second);
+}
+
+void
+ObjectAccounting::Print (std::ostream &os, uint32_t n /* = 0 */, bool perContext /* = false */)
+{
+  if (!IsEnabled ())
+    {
+      os << "Object accounting is disabled; configure with --enable-object-accounting"
+         << std::endl;
+      return;
+    }
+  std::vector<Record> records = GetRecords (perContext);
+  if (n > 0 && records.size () > n)
+    {
+      records.resize (n);
+    }
+  std::size_t width = 4;
+  for (std::vector<Record>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      width = std::max (width, r->type.size ());
+    }
+
+  std::ios::fmtflags flags = os.flags ();
+  os << std::left << std::setw (width) << "Type" << std::right;
+  if (perContext)
+    {
+      os << std::setw (10) << "Context";
+    }
+  os << std::setw (12) << "Live"
+     << std::setw (14) << "Bytes"
+     << std::setw (14) << "Created" << std::endl;
+  for (std::vector<Record>::const_iterator r = records.begin (); r != records.end (); ++r)
+    {
+      os << std::left << std::setw (width) << r->type << std::right;
+      if (perContext)
+        {
+          if (r->context == Simulator::NO_CONTEXT)
+            {
+              os << std::setw (10) << "-";
+            }
+          else
+            {
+              os << std::setw (10) << r->context;
+            }
+        }
+      os << std::setw (12) << r->live
+         << std::setw (14) << r->bytes
+         << std::setw (14) << r->created << std::endl;
+    }
+  os.flags (flags);
+}
+
+}  // namespace ns3
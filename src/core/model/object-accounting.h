@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OBJECT_ACCOUNTING_H
+#define OBJECT_ACCOUNTING_H
+
+/**
+ * \file
+ * \ingroup object
+ * ns3::ObjectAccounting declaration.
+ */
+
+#include <stdint.h>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class TypeId;
+
+/**
+ * \ingroup object
+ *
+ * Count the live instances, and their approximate memory, of each
+ * Object and SimpleRefCount type.
+ *
+ * Accounting is compiled in only when ns-3 is configured with
+ * \c --enable-object-accounting, which defines \c NS3_OBJECT_ACCOUNTING;
+ * otherwise the hooks in Object and SimpleRefCount are empty, and
+ * the queries below return no records.
+ *
+ * Objects are counted once constructed, by their TypeId name, and
+ * SimpleRefCount instances (Packet, EventImpl, ...) by the C++ type
+ * they derive SimpleRefCount for: every event counts as an EventImpl.
+ * The bytes reported are the shallow size of each instance: the
+ * registered TypeId size for Objects, \c sizeof for the others; memory
+ * an instance owns through pointers is not included.
+ *
+ * Each instance is also attributed to the simulation context in which
+ * it was created, which is the node id for events run on a node.
+ * Instances created outside of any event, such as during topology
+ * setup, are attributed to Simulator::NO_CONTEXT.
+ *
+ * The counters can be read at any time, and printed periodically
+ * with ShowProgress::SetObjectAccounting.
+ */
+class ObjectAccounting
+{
+public:
+  /** The accounting of one type, in one context or in all of them. */
+  struct Record
+  {
+    std::string type;   //!< The type name.
+    uint32_t context;   //!< The creation context, or NO_CONTEXT.
+    uint64_t live;      //!< The number of live instances.
+    uint64_t bytes;     //!< The approximate bytes used by live instances.
+    uint64_t created;   //!< The number of instances ever created.
+  };
+
+  /**
+   * Check if accounting is compiled in.
+   * \returns \c true if ns-3 was configured with
+   *          \c --enable-object-accounting.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Get the accounting of every type with instances created.
+   * \param [in] perContext Report each creation context separately,
+   *             instead of the totals for each type.
+   * \returns The records, by decreasing live bytes.
+   */
+  static std::vector<Record> GetRecords (bool perContext = false);
+  /**
+   * Get the accounting of one type.
+   * \param [in] type The TypeId name or demangled C++ type name.
+   * \returns The totals for the type, all zero if it is unknown.
+   */
+  static Record GetRecord (const std::string &type);
+  /**
+   * Get the accounting of one type in one creation context.
+   * \param [in] type The TypeId name or demangled C++ type name.
+   * \param [in] context The creation context, usually a node id.
+   * \returns The record, all zero if there are none.
+   */
+  static Record GetRecord (const std::string &type, uint32_t context);
+
+  /**
+   * Print the accounting table.
+   * \param [in] os The output stream.
+   * \param [in] n The number of types to print, the largest first;
+   *             0 prints all of them.
+   * \param [in] perContext Print each creation context separately.
+   */
+  static void Print (std::ostream &os, uint32_t n = 0, bool perContext = false);
+
+  /**
+   * \name Hooks for Object and SimpleRefCount.
+   *
+   * These should not be called by user code.
+   * @{
+   */
+  /**
+   * Register a C++ type.
+   * \param [in] mangled The mangled type name, from \c typeid.
+   * \param [in] size The size of an instance.
+   * \returns The accounting type index.
+   */
+  static uint32_t RegisterType (const char *mangled, std::size_t size);
+  /**
+   * Register an Object type.
+   * \param [in] tid The TypeId.
+   * \returns The accounting type index.
+   */
+  static uint32_t RegisterType (const TypeId &tid);
+  /**
+   * Get the context to attribute a new instance to.
+   * \returns The current simulation context.
+   */
+  static uint32_t GetContext (void);
+  /**
+   * Count an instance created.
+   * \param [in] type The accounting type index.
+   * \param [in] context The creation context.
+   */
+  static void Add (uint32_t type, uint32_t context);
+  /**
+   * Count an instance deleted.
+   * \param [in] type The accounting type index.
+   * \param [in] context The creation context.
+   */
+  static void Remove (uint32_t type, uint32_t context);
+  /**@}*/
+
+};  // class ObjectAccounting
+
+}  // namespace ns3
+
+#endif /* OBJECT_ACCOUNTING_H */
@@ -22,10 +22,13 @@
 #include "trace-source-accessor.h"
 #include "attribute-construction-list.h"
 #include "string.h"
+#include "simple-ref-count.h"
 #include "ns3/core-config.h"
 #ifdef HAVE_STDLIB_H
 #include <cstdlib>
 #endif
+#include <typeinfo>
+#include <vector>
 
 /**
  * \file
@@ -76,93 +79,198 @@ ObjectBase::NotifyConstructionCompleted (void)
   NS_LOG_FUNCTION (this);
 }
 
-void
-ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
+/**
+ * \ingroup object
+ * One attribute to initialize in ObjectBase::ConstructSelf.
+ */
+struct InitialAttribute
 {
-  // loop over the inheritance tree back to the Object base class.
-  NS_LOG_FUNCTION (this << &attributes);
-  TypeId tid = GetInstanceTypeId ();
+  TypeId tid;                               //!< TypeId which declares the attribute.
+  std::string name;                         //!< Attribute name.
+  uint32_t flags;                           //!< Attribute flags.
+  Ptr<const AttributeAccessor> accessor;    //!< Attribute accessor.
+  Ptr<const AttributeChecker> checker;      //!< Attribute checker.
+  /**
+   * The initial value, already validated by the checker,
+   * which can be set directly; or 0 when \c initialValue
+   * must be converted for each object.
+   */
+  Ptr<const AttributeValue> validValue;
+  Ptr<const AttributeValue> initialValue;   //!< The initial value as registered.
+  bool hasEnvValue;                         //!< \c true if set by NS_ATTRIBUTE_DEFAULT.
+  std::string envValue;                     //!< The NS_ATTRIBUTE_DEFAULT value.
+};
+
+/**
+ * \ingroup object
+ * The attributes to initialize for one instance TypeId, in the
+ * order ConstructSelf visits them: from the most derived
+ * class to the root of the inheritance tree.
+ */
+struct InitialAttributeTable : public SimpleRefCount<InitialAttributeTable>
+{
+  uint32_t generation;                       //!< TypeId::GetAttributeGeneration() when built.
+  std::vector<InitialAttribute> attributes;  //!< The attributes.
+};
+
+/**
+ * \ingroup object
+ * Get the initial attribute table of a TypeId, building it if it
+ * does not exist yet or if attributes changed since it was built.
+ *
+ * Building the table walks the TypeId parents, copies the attribute
+ * information and parses NS_ATTRIBUTE_DEFAULT once, rather than for
+ * every constructed object.  Initial values which already have the
+ * checker's value type are validated once as well.  Initial values
+ * of another type, typically a StringValue naming an object to
+ * create for a PointerValue, are still converted for each object, so
+ * that each object gets its own instance.
+ *
+ * \param [in] tid The instance TypeId.
+ * \returns The table.
+ */
+static Ptr<const InitialAttributeTable>
+GetInitialAttributeTable (TypeId tid)
+{
+  NS_LOG_FUNCTION (tid);
+  // Tables are replaced rather than rebuilt in place: setting an
+  // attribute can construct other objects, and so reenter here,
+  // while the caller is still walking its table.
+  static std::vector<Ptr<InitialAttributeTable> > tables;
+  uint32_t generation = TypeId::GetAttributeGeneration ();
+  if (tables.size () <= tid.GetUid ())
+    {
+      tables.resize (tid.GetUid () + 1);
+    }
+  if (tables[tid.GetUid ()] != 0
+      && tables[tid.GetUid ()]->generation == generation)
+    {
+      return tables[tid.GetUid ()];
+    }
+  uint16_t uid = tid.GetUid ();
+  Ptr<InitialAttributeTable> table = Create<InitialAttributeTable> ();
+
+  std::string env;
+#ifdef HAVE_GETENV
+  char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
+  if (envVar != 0)
+    {
+      env = std::string (envVar);
+    }
+#endif /* HAVE_GETENV */
+
   do {
-      // loop over all attributes in object type
-      NS_LOG_DEBUG ("construct tid="<<tid.GetName ()<<", params="<<tid.GetAttributeN ());
       for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
         {
-          struct TypeId::AttributeInformation info = tid.GetAttribute(i);
-          NS_LOG_DEBUG ("try to construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\"");
-          // is this attribute stored in this AttributeConstructionList instance ?
-          Ptr<AttributeValue> value = attributes.Find(info.checker);
-          // See if this attribute should not be set here in the
-          // constructor.
-          if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+          struct TypeId::AttributeInformation info = tid.GetAttribute (i);
+          InitialAttribute attribute;
+          attribute.tid = tid;
+          attribute.name = info.name;
+          attribute.flags = info.flags;
+          attribute.accessor = info.accessor;
+          attribute.checker = info.checker;
+          attribute.initialValue = info.initialValue;
+          Ptr<AttributeValue> prototype = info.checker->Create ();
+          if (typeid (*prototype) == typeid (*info.initialValue))
             {
-              // Handle this attribute if it should not be 
-              // set here.
-              if (value == 0)
-                {
-                  // Skip this attribute if it's not in the
-                  // AttributeConstructionList.
-                  continue;
-                }              
-              else
+              attribute.validValue = info.checker->CreateValidValue (*info.initialValue);
+            }
+          attribute.hasEnvValue = false;
+          std::string::size_type cur = 0;
+          std::string::size_type next = 0;
+          while (!env.empty () && next != std::string::npos)
+            {
+              next = env.find (";", cur);
+              std::string tmp = std::string (env, cur, next-cur);
+              std::string::size_type equal = tmp.find ("=");
+              if (equal != std::string::npos)
                 {
-                  // This is an error because this attribute is not
-                  // settable in its constructor but is present in
-                  // the AttributeConstructionList.
-                  NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<tid.GetName () << ": initial value cannot be set using attributes");
+                  std::string name = tmp.substr (0, equal);
+                  if (name == tid.GetAttributeFullName (i))
+                    {
+                      attribute.hasEnvValue = true;
+                      attribute.envValue = tmp.substr (equal+1, tmp.size () - equal - 1);
+                      break;
+                    }
                 }
+              cur = next + 1;
             }
+          table->attributes.push_back (attribute);
+        }
+      tid = tid.GetParent ();
+    } while (tid != ObjectBase::GetTypeId ());
+  table->generation = generation;
+  tables[uid] = table;
+  return table;
+}
 
-          if (value != 0)
+void
+ObjectBase::ConstructSelf (const AttributeConstructionList &attributes)
+{
+  // loop over the inheritance tree back to the Object base class.
+  NS_LOG_FUNCTION (this << &attributes);
+  Ptr<const InitialAttributeTable> table = GetInitialAttributeTable (GetInstanceTypeId ());
+  for (std::vector<InitialAttribute>::const_iterator i = table->attributes.begin ();
+       i != table->attributes.end (); ++i)
+    {
+      const InitialAttribute &info = *i;
+      NS_LOG_DEBUG ("try to construct \""<< info.tid.GetName ()<<"::"<<
+                    info.name <<"\"");
+      // is this attribute stored in this AttributeConstructionList instance ?
+      Ptr<AttributeValue> value = attributes.Find (info.checker);
+      // See if this attribute should not be set here in the
+      // constructor.
+      if (!(info.flags & TypeId::ATTR_CONSTRUCT))
+        {
+          // Handle this attribute if it should not be 
+          // set here.
+          if (value == 0)
             {
-              // We have a matching attribute value.
-              if (DoSet (info.accessor, info.checker, *value))
-                {
-                  NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                info.name<<"\"");
-                  continue;
-                }
+              // Skip this attribute if it's not in the
+              // AttributeConstructionList.
+              continue;
+            }              
+          else
+            {
+              // This is an error because this attribute is not
+              // settable in its constructor but is present in
+              // the AttributeConstructionList.
+              NS_FATAL_ERROR ("Attribute name="<<info.name<<" tid="<<info.tid.GetName () << ": initial value cannot be set using attributes");
             }
+        }
 
-#ifdef HAVE_GETENV
-          // No matching attribute value so we try to look at the env var.
-          char *envVar = getenv ("NS_ATTRIBUTE_DEFAULT");
-          if (envVar != 0)
+      if (value != 0)
+        {
+          // We have a matching attribute value.
+          if (DoSet (info.accessor, info.checker, *value))
             {
-              std::string env = std::string (envVar);
-              std::string::size_type cur = 0;
-              std::string::size_type next = 0;
-              while (next != std::string::npos)
-                {
-                  next = env.find (";", cur);
-                  std::string tmp = std::string (env, cur, next-cur);
-                  std::string::size_type equal = tmp.find ("=");
-                  if (equal != std::string::npos)
-                    {
-                      std::string name = tmp.substr (0, equal);
-                      std::string envval = tmp.substr (equal+1, tmp.size () - equal - 1);
-                      if (name == tid.GetAttributeFullName (i))
-                        {
-                          if (DoSet (info.accessor, info.checker, StringValue (envval)))
-                            {
-                              NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                                            info.name <<"\" from env var");
-                              break;
-                            }
-                        }
-                    }
-                  cur = next + 1;
-                }
+              NS_LOG_DEBUG ("construct \""<< info.tid.GetName ()<<"::"<<
+                            info.name<<"\"");
+              continue;
             }
-#endif /* HAVE_GETENV */
+        }
+
+      // No matching attribute value so we try to look at the env var.
+      if (info.hasEnvValue
+          && DoSet (info.accessor, info.checker, StringValue (info.envValue)))
+        {
+          NS_LOG_DEBUG ("construct \""<< info.tid.GetName ()<<"::"<<
+                        info.name <<"\" from env var");
+          continue;
+        }
 
-          // No matching attribute value so we try to set the default value.
+      // No matching attribute value so we try to set the default value.
+      if (info.validValue != 0)
+        {
+          info.accessor->Set (this, *info.validValue);
+        }
+      else
+        {
           DoSet (info.accessor, info.checker, *info.initialValue);
-          NS_LOG_DEBUG ("construct \""<< tid.GetName ()<<"::"<<
-                        info.name <<"\" from initial value.");
         }
-      tid = tid.GetParent ();
-    } while (tid != ObjectBase::GetTypeId ());
+      NS_LOG_DEBUG ("construct \""<< info.tid.GetName ()<<"::"<<
+                    info.name <<"\" from initial value.");
+    }
   NotifyConstructionCompleted ();
 }
 
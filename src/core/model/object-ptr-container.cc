@@ -127,6 +127,37 @@ ObjectPtrContainerAccessor::Get (const ObjectBase * object, AttributeValue &valu
     }
   return true;
 }
+Ptr<Object>
+ObjectPtrContainerAccessor::GetByIndex (const ObjectBase * object, std::size_t index) const
+{
+  NS_LOG_FUNCTION (this << object << index);
+  std::size_t n;
+  bool ok = DoGetN (object, &n);
+  if (!ok)
+    {
+      return 0;
+    }
+  // Sequence containers store element i at index i: try that first.
+  std::size_t found;
+  if (index < n)
+    {
+      Ptr<Object> o = DoGet (object, index, &found);
+      if (found == index)
+        {
+          return o;
+        }
+    }
+  // Keyed containers (ObjectMap) do not, so fall back to a scan.
+  for (std::size_t i = 0; i < n; i++)
+    {
+      Ptr<Object> o = DoGet (object, i, &found);
+      if (found == index)
+        {
+          return o;
+        }
+    }
+  return 0;
+}
 bool 
 ObjectPtrContainerAccessor::HasGetter (void) const
 {
@@ -220,6 +220,18 @@ public:
   virtual bool Get (const ObjectBase * object, AttributeValue &value) const;
   virtual bool HasGetter (void) const;
   virtual bool HasSetter (void) const;
+  /**
+   * Get a single instance from the container, identified by its index.
+   *
+   * Unlike Get(), this does not copy the whole container, so it is
+   * the cheap way to reach one element of a large container
+   * such as the NodeList.
+   *
+   * \param [in] object The container object.
+   * \param [in] index The index of the desired instance.
+   * \returns The instance, or 0 if there is none with that index.
+   */
+  Ptr<Object> GetByIndex (const ObjectBase * object, std::size_t index) const;
 private:
   /**
    * Get the number of instances in the container.
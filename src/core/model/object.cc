@@ -25,6 +25,7 @@
 #include "attribute.h"
 #include "log.h"
 #include "string.h"
+#include "object-accounting.h"
 #include <vector>
 #include <sstream>
 #include <cstdlib>
@@ -99,6 +100,9 @@ Object::Object ()
     m_initialized (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
     m_getObjectCount (0)
+#ifdef NS3_OBJECT_ACCOUNTING
+  , m_accountingType (NO_ACCOUNTING)
+#endif
 {
   NS_LOG_FUNCTION (this);
   m_aggregates->n = 1;
@@ -127,6 +131,12 @@ Object::~Object ()
       std::free (m_aggregates);
     }
   m_aggregates = 0;
+#ifdef NS3_OBJECT_ACCOUNTING
+  if (m_accountingType != NO_ACCOUNTING)
+    {
+      ObjectAccounting::Remove (m_accountingType, m_accountingContext);
+    }
+#endif
 }
 Object::Object (const Object &o)
   : m_tid (o.m_tid),
@@ -134,6 +144,9 @@ Object::Object (const Object &o)
     m_initialized (false),
     m_aggregates ((struct Aggregates *) std::malloc (sizeof (struct Aggregates))),
     m_getObjectCount (0)
+#ifdef NS3_OBJECT_ACCOUNTING
+  , m_accountingType (NO_ACCOUNTING)
+#endif
 {
   m_aggregates->n = 1;
   m_aggregates->buffer[0] = this;
@@ -142,6 +155,11 @@ void
 Object::Construct (const AttributeConstructionList &attributes)
 {
   NS_LOG_FUNCTION (this << &attributes);
+#ifdef NS3_OBJECT_ACCOUNTING
+  NS_ASSERT (m_accountingType == NO_ACCOUNTING);
+  m_accountingType = ObjectAccounting::RegisterType (m_tid);
+  ObjectAccounting::Add (m_accountingType, m_accountingContext);
+#endif
   ConstructSelf (attributes);
 }
 
@@ -432,6 +432,15 @@ private:
    * the array of aggregates in most-frequently accessed order.
    */
   uint32_t m_getObjectCount;
+#ifdef NS3_OBJECT_ACCOUNTING
+  /** Flag value for an Object not yet counted by ObjectAccounting. */
+  static const uint32_t NO_ACCOUNTING = 0xffffffff;
+  /**
+   * The ObjectAccounting type index of this Object,
+   * set once it is constructed.
+   */
+  uint32_t m_accountingType;
+#endif
 };
 
 template <typename T>
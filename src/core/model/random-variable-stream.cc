@@ -131,6 +131,16 @@ RandomVariableStream::GetStream(void) const
   return m_stream;
 }
 
+void
+RandomVariableStream::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      values[i] = GetValue ();
+    }
+}
+
 RngStream *
 RandomVariableStream::Peek(void) const
 {
@@ -208,6 +218,21 @@ UniformRandomVariable::GetInteger (void)
   NS_LOG_FUNCTION (this);
   return (uint32_t)GetValue (m_min, m_max + 1);
 }
+void
+UniformRandomVariable::GetValues (double *values, std::size_t n)
+{
+  NS_LOG_FUNCTION (this << values << n);
+  Peek ()->RandU01 (values, n);
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      double v = m_min + values[i] * (m_max - m_min);
+      if (IsAntithetic ())
+        {
+          v = m_min + (m_max - v);
+        }
+      values[i] = v;
+    }
+}
 
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
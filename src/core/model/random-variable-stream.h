@@ -149,6 +149,18 @@ public:
    */
   virtual uint32_t GetInteger (void) = 0;
 
+  /**
+   * \brief Get the next \p n random values drawn from the distribution.
+   *
+   * The values are exactly those \p n successive calls to
+   * GetValue(void) would return.  Subclasses which can draw the
+   * underlying uniform values in one batch override this.
+   *
+   * \param [out] values Where to store the values, with room for \p n values.
+   * \param [in] n The number of values to draw.
+   */
+  virtual void GetValues (double *values, std::size_t n);
+
 protected:
   /**
    * \brief Get the pointer to the underlying RngStream.
@@ -294,6 +306,13 @@ public:
    * \note The upper limit is included in the output range.
    */
   virtual uint32_t GetInteger (void);
+
+  /**
+   * \copydoc RandomVariableStream::GetValues()
+   *
+   * The uniform values are drawn from the RngStream in one batch.
+   */
+  virtual void GetValues (double *values, std::size_t n);
   
 private:
   /** The lower bound on values that can be returned by this RNG stream. */
@@ -22,6 +22,7 @@
 #include "scheduler.h"
 #include "event-impl.h"
 #include "synchronizer.h"
+#include "des-metrics.h"
 
 #include "ptr.h"
 #include "pointer.h"
@@ -33,6 +34,7 @@
 #include "enum.h"
 
 
+#include <algorithm>
 #include <cmath>
 
 
@@ -91,6 +93,7 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
   m_eventCount = 0;
+  m_maxLateness = 0;
 
   m_main = SystemThread::Self();
 
@@ -354,16 +357,36 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
     // 
     // We're about to run the event and we've done our best to synchronize this
-    // event execution time to real time.  Now, if we're in SYNC_HARD_LIMIT mode
-    // we have to decide if we've done a good enough job and if we haven't, we've
-    // been asked to commit ritual suicide.
+    // event execution time to real time.  Record how late we are.
+    //
+    uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
+    std::size_t bucket = 0;
+    if (tsFinal > m_currentTs)
+      {
+        uint64_t late = tsFinal - m_currentTs;
+        m_maxLateness = std::max (m_maxLateness, late);
+        while (late != 0)
+          {
+            ++bucket;
+            late >>= 1;
+          }
+      }
+    if (bucket >= m_lateness.size ())
+      {
+        m_lateness.resize (bucket + 1, 0);
+      }
+    m_lateness[bucket]++;
+
+    //
+    // Now, if we're in SYNC_HARD_LIMIT mode we have to decide if we've done a
+    // good enough job and if we haven't, we've been asked to commit ritual
+    // suicide.
     //
     // We check the simulation time against the current real time to make this
     // judgement.
     //
     if (m_synchronizationMode == SYNC_HARD_LIMIT)
       {
-        uint64_t tsFinal = m_synchronizer->GetCurrentRealtime ();
         uint64_t tsJitter;
 
         if (tsFinal >= m_currentTs)
@@ -390,7 +413,11 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
 
   EventImpl *event = next.impl;
   m_synchronizer->EventStart ();
+#ifdef ENABLE_DES_METRICS
+  DesMetrics::Get ()->ProfileInvoke (event, m_currentContext);
+#else
   event->Invoke ();
+#endif
   m_synchronizer->EventEnd ();
   event->Unref ();
 }
@@ -853,4 +880,59 @@ RealtimeSimulatorImpl::GetHardLimit (void) const
   return m_hardLimit;
 }
 
+std::vector<uint64_t>
+RealtimeSimulatorImpl::GetLatenessHistogram (void) const
+{
+  NS_LOG_FUNCTION (this);
+  CriticalSection cs (m_mutex);
+  return m_lateness;
+}
+
+Time
+RealtimeSimulatorImpl::GetMaxLateness (void) const
+{
+  NS_LOG_FUNCTION (this);
+  CriticalSection cs (m_mutex);
+  return TimeStep (m_maxLateness);
+}
+
+void
+RealtimeSimulatorImpl::ResetLateness (void)
+{
+  NS_LOG_FUNCTION (this);
+  CriticalSection cs (m_mutex);
+  m_lateness.clear ();
+  m_maxLateness = 0;
+}
+
+void
+RealtimeSimulatorImpl::PrintLateness (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::vector<uint64_t> histogram = GetLatenessHistogram ();
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < histogram.size (); ++i)
+    {
+      total += histogram[i];
+    }
+  os << "Event lateness (" << total << " events, max "
+     << GetMaxLateness ().As (Time::US) << "):" << std::endl;
+  for (std::size_t i = 0; i < histogram.size (); ++i)
+    {
+      if (histogram[i] == 0)
+        {
+          continue;
+        }
+      if (i == 0)
+        {
+          os << "  on time";
+        }
+      else
+        {
+          os << "  < " << TimeStep (uint64_t (1) << i).As (Time::US);
+        }
+      os << ": " << histogram[i] << std::endl;
+    }
+}
+
 } // namespace ns3
@@ -32,6 +32,8 @@
 #include "system-mutex.h"
 
 #include <list>
+#include <iostream>
+#include <vector>
 
 /**
  * \file
@@ -155,6 +157,30 @@ public:
    */
   Time GetHardLimit (void) const;
 
+  /**
+   * Get the histogram of event lateness: how long after its scheduled
+   * time, in real time, each event started.
+   *
+   * Bucket 0 counts the events started on time; bucket \c i > 0
+   * counts the events started between \f$2^{i-1}\f$ and \f$2^i - 1\f$
+   * time steps late.  Trailing empty buckets are omitted.
+   *
+   * \returns The event count in each bucket.
+   */
+  std::vector<uint64_t> GetLatenessHistogram (void) const;
+  /**
+   * Get the largest event lateness.
+   * \returns The largest lateness seen.
+   */
+  Time GetMaxLateness (void) const;
+  /** Clear the lateness histogram. */
+  void ResetLateness (void);
+  /**
+   * Print the lateness histogram, one line per bucket.
+   * \param [in] os The output stream.
+   */
+  void PrintLateness (std::ostream &os) const;
+
 private:
   /**
    * Is the simulator running?
@@ -205,6 +231,10 @@ private:
   uint32_t m_currentContext;  
   /** The event count. */
   uint64_t m_eventCount;
+  /** Lateness histogram, see GetLatenessHistogram(). */
+  std::vector<uint64_t> m_lateness;
+  /** Largest event lateness, in time steps. */
+  uint64_t m_maxLateness;
   /**@}*/
 
   /** Mutex to control access to key state. */  
@@ -0,0 +1,326 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "replication-runner.h"
+#include "rng-seed-manager.h"
+#include "simulator.h"
+#include "abort.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::ReplicationRunner implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("ReplicationRunner");
+
+ReplicationRunner::ReplicationRunner (Replication replication)
+  : m_replication (replication),
+    m_firstRun (1),
+    m_nRuns (1),
+    m_maxJobs (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ReplicationRunner::SetRuns (uint32_t first, uint32_t n)
+{
+  NS_LOG_FUNCTION (this << first << n);
+  m_firstRun = first;
+  m_nRuns = n;
+}
+
+void
+ReplicationRunner::SetMaxJobs (uint32_t jobs)
+{
+  NS_LOG_FUNCTION (this << jobs);
+  m_maxJobs = jobs;
+}
+
+void
+ReplicationRunner::RunChild (uint32_t run, int fd)
+{
+  NS_LOG_FUNCTION (this << run << fd);
+  RngSeedManager::SetRun (run);
+  Metrics metrics = m_replication (run);
+  Simulator::Destroy ();
+
+  std::ostringstream oss;
+  oss << std::setprecision (std::numeric_limits<double>::digits10 + 2);
+  for (Metrics::const_iterator i = metrics.begin (); i != metrics.end (); ++i)
+    {
+      NS_ABORT_MSG_IF (i->first.find_first_of ("\t\n") != std::string::npos,
+                       "Metric name \"" << i->first << "\" contains a tab or newline");
+      oss << i->first << "\t" << i->second << "\n";
+    }
+  std::string data = oss.str ();
+  const char *p = data.c_str ();
+  std::size_t left = data.size ();
+  while (left > 0)
+    {
+      ssize_t written = write (fd, p, left);
+      if (written < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      NS_ABORT_MSG_IF (written < 0, "Cannot write replication metrics: " << std::strerror (errno));
+      p += written;
+      left -= written;
+    }
+  close (fd);
+}
+
+void
+ReplicationRunner::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_replication.IsNull (), "No replication to run");
+
+  uint32_t jobs = m_maxJobs;
+  if (jobs == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      jobs = processors > 0 ? static_cast<uint32_t> (processors) : 1;
+    }
+
+  m_runs.clear ();
+  m_metrics.clear ();
+  m_metrics.resize (m_nRuns);
+  for (uint32_t i = 0; i < m_nRuns; ++i)
+    {
+      m_runs.push_back (m_firstRun + i);
+    }
+
+  /// A replication running in a child process.
+  struct Child
+  {
+    pid_t pid;        //!< The child process.
+    int fd;           //!< The read end of the metrics pipe.
+    uint32_t index;   //!< The replication index.
+    std::string data; //!< The metrics read so far.
+  };
+  std::vector<Child> running;
+  uint32_t next = 0;
+  while (next < m_nRuns || !running.empty ())
+    {
+      while (running.size () < jobs && next < m_nRuns)
+        {
+          int fds[2];
+          NS_ABORT_MSG_IF (pipe (fds) != 0, "Cannot create pipe: " << std::strerror (errno));
+          // Do not let the children print what the parent buffered.
+          std::cout.flush ();
+          std::cerr.flush ();
+          std::fflush (0);
+          pid_t pid = fork ();
+          NS_ABORT_MSG_IF (pid < 0, "Cannot fork replication: " << std::strerror (errno));
+          if (pid == 0)
+            {
+              close (fds[0]);
+              // Do not hold the pipes of the other children open.
+              for (std::vector<Child>::const_iterator i = running.begin (); i != running.end (); ++i)
+                {
+                  close (i->fd);
+                }
+              RunChild (m_runs[next], fds[1]);
+              std::cout.flush ();
+              std::cerr.flush ();
+              std::fflush (0);
+              // Skip the destructors of the parent's static objects.
+              _exit (0);
+            }
+          close (fds[1]);
+          NS_LOG_LOGIC ("Run " << m_runs[next] << " in process " << pid);
+          Child child;
+          child.pid = pid;
+          child.fd = fds[0];
+          child.index = next;
+          running.push_back (child);
+          ++next;
+        }
+
+      // Drain every pipe as data arrives, and reap whichever child
+      // closes its pipe first so that its slot can be refilled.
+      std::vector<struct pollfd> fds (running.size ());
+      for (std::size_t i = 0; i < running.size (); ++i)
+        {
+          fds[i].fd = running[i].fd;
+          fds[i].events = POLLIN;
+          fds[i].revents = 0;
+        }
+      if (poll (&fds[0], fds.size (), -1) < 0)
+        {
+          NS_ABORT_MSG_IF (errno != EINTR, "Cannot poll replications: " << std::strerror (errno));
+          continue;
+        }
+      std::size_t done = running.size ();
+      for (std::size_t i = 0; i < running.size (); ++i)
+        {
+          if (fds[i].revents == 0)
+            {
+              continue;
+            }
+          char buffer[4096];
+          ssize_t n = read (running[i].fd, buffer, sizeof (buffer));
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          NS_ABORT_MSG_IF (n < 0, "Cannot read replication metrics: " << std::strerror (errno));
+          if (n == 0)
+            {
+              done = i;
+              break;
+            }
+          running[i].data.append (buffer, n);
+        }
+      if (done == running.size ())
+        {
+          continue;
+        }
+
+      Child child = running[done];
+      running.erase (running.begin () + done);
+      close (child.fd);
+      int status;
+      while (waitpid (child.pid, &status, 0) < 0)
+        {
+          NS_ABORT_MSG_IF (errno != EINTR, "Cannot wait for replication: " << std::strerror (errno));
+        }
+      NS_ABORT_MSG_IF (!WIFEXITED (status) || WEXITSTATUS (status) != 0,
+                       "Replication with run " << m_runs[child.index] << " failed");
+      NS_LOG_LOGIC ("Run " << m_runs[child.index] << " done in process " << child.pid);
+
+      std::istringstream lines (child.data);
+      std::string line;
+      while (std::getline (lines, line))
+        {
+          std::string::size_type tab = line.find ('\t');
+          NS_ASSERT (tab != std::string::npos);
+          double value = std::strtod (line.c_str () + tab + 1, 0);
+          m_metrics[child.index][line.substr (0, tab)] = value;
+        }
+    }
+}
+
+uint32_t
+ReplicationRunner::GetN (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_metrics.size ();
+}
+
+uint32_t
+ReplicationRunner::GetRun (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_runs.size ());
+  return m_runs[i];
+}
+
+const ReplicationRunner::Metrics &
+ReplicationRunner::GetMetrics (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_metrics.size ());
+  return m_metrics[i];
+}
+
+std::map<std::string, ReplicationRunner::Summary>
+ReplicationRunner::GetSummary (void) const
+{
+  NS_LOG_FUNCTION (this);
+  std::map<std::string, Summary> summaries;
+  std::map<std::string, double> sumSquares;
+  for (std::vector<Metrics>::const_iterator m = m_metrics.begin (); m != m_metrics.end (); ++m)
+    {
+      for (Metrics::const_iterator i = m->begin (); i != m->end (); ++i)
+        {
+          std::map<std::string, Summary>::iterator it = summaries.find (i->first);
+          if (it == summaries.end ())
+            {
+              Summary summary;
+              summary.count = 0;
+              summary.mean = 0;
+              summary.stddev = 0;
+              summary.min = i->second;
+              summary.max = i->second;
+              it = summaries.insert (std::make_pair (i->first, summary)).first;
+            }
+          // Welford's running mean and sum of squared deviations.
+          Summary & s = it->second;
+          s.count++;
+          double delta = i->second - s.mean;
+          s.mean += delta / s.count;
+          sumSquares[i->first] += delta * (i->second - s.mean);
+          s.min = std::min (s.min, i->second);
+          s.max = std::max (s.max, i->second);
+        }
+    }
+  for (std::map<std::string, Summary>::iterator it = summaries.begin (); it != summaries.end (); ++it)
+    {
+      Summary & s = it->second;
+      s.stddev = s.count > 1 ? std::sqrt (sumSquares[it->first] / (s.count - 1)) : 0;
+    }
+  return summaries;
+}
+
+void
+ReplicationRunner::Print (std::ostream & os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  std::map<std::string, Summary> summaries = GetSummary ();
+  std::size_t width = 6;
+  for (std::map<std::string, Summary>::const_iterator it = summaries.begin (); it != summaries.end (); ++it)
+    {
+      width = std::max (width, it->first.size ());
+    }
+  os << std::left << std::setw (width) << "Metric"
+     << std::right << std::setw (6) << "N"
+     << std::setw (14) << "Mean"
+     << std::setw (14) << "StdDev"
+     << std::setw (14) << "Min"
+     << std::setw (14) << "Max" << std::endl;
+  for (std::map<std::string, Summary>::const_iterator it = summaries.begin (); it != summaries.end (); ++it)
+    {
+      const Summary & s = it->second;
+      os << std::left << std::setw (width) << it->first
+         << std::right << std::setw (6) << s.count
+         << std::setw (14) << s.mean
+         << std::setw (14) << s.stddev
+         << std::setw (14) << s.min
+         << std::setw (14) << s.max << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLICATION_RUNNER_H
+#define REPLICATION_RUNNER_H
+
+/**
+ * \file
+ * \ingroup core
+ * ns3::ReplicationRunner declaration.
+ */
+
+#include "callback.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup core
+ * \ingroup randomvariable
+ *
+ * Run independent replications of a simulation in parallel, each with
+ * its own RngRun number, and merge the metrics they report.
+ *
+ * The simulator and the object registries (NodeList, ChannelList,
+ * Names, Config) are process-wide, so each replication runs in its own
+ * child process, forked from the calling process.  The children start
+ * from a copy of the caller's memory: data loaded before Run(), such
+ * as large traces, is shared read-only between the replications
+ * without being loaded again.
+ *
+ * A replication is a function which builds and runs one simulation for
+ * the run number given, and returns named scalar metrics.  The
+ * runner sets RngSeedManager::SetRun before calling it, and calls
+ * Simulator::Destroy after it.
+ *
+ * \code
+ *     ReplicationRunner::Metrics
+ *     Replicate (uint32_t run)
+ *     {
+ *       // Create the model, then
+ *       Simulator::Run ();
+ *       ReplicationRunner::Metrics metrics;
+ *       metrics["throughput"] = sink->GetTotalRx () * 8.0 / duration;
+ *       return metrics;
+ *     }
+ *
+ *     int main (int argc, char ** argv)
+ *     {
+ *       ReplicationRunner runner (MakeCallback (&Replicate));
+ *       runner.SetRuns (1, 30);
+ *       runner.Run ();
+ *       runner.Print (std::cout);
+ *     }
+ * \endcode
+ *
+ * Run() must be called before Simulator::Run() in the calling process,
+ * and while the calling process has a single thread.
+ */
+class ReplicationRunner
+{
+public:
+  /** The named metrics reported by one replication. */
+  typedef std::map<std::string, double> Metrics;
+  /** A replication: run the simulation for a run number. */
+  typedef Callback<Metrics, uint32_t> Replication;
+
+  /** Summary of one metric across replications. */
+  struct Summary
+  {
+    uint32_t count;   //!< Number of replications reporting the metric.
+    double mean;      //!< Mean.
+    double stddev;    //!< Sample standard deviation.
+    double min;       //!< Minimum.
+    double max;       //!< Maximum.
+  };
+
+  /**
+   * Constructor.
+   * \param [in] replication The replication to run.
+   */
+  ReplicationRunner (Replication replication);
+
+  /**
+   * Set the run numbers of the replications.
+   * \param [in] first The RngRun number of the first replication.
+   * \param [in] n The number of replications.
+   */
+  void SetRuns (uint32_t first, uint32_t n);
+  /**
+   * Set the number of replications running at once.
+   * \param [in] jobs The maximum number of concurrent replications;
+   *             0, the default, means one per available processor.
+   */
+  void SetMaxJobs (uint32_t jobs);
+
+  /**
+   * Run all the replications and collect their metrics.
+   *
+   * Aborts if a replication does not complete.
+   */
+  void Run (void);
+
+  /**
+   * Get the number of replications run.
+   * \returns The number of replications.
+   */
+  uint32_t GetN (void) const;
+  /**
+   * Get the run number of a replication.
+   * \param [in] i The replication index.
+   * \returns The RngRun number used by the replication.
+   */
+  uint32_t GetRun (uint32_t i) const;
+  /**
+   * Get the metrics reported by a replication.
+   * \param [in] i The replication index.
+   * \returns The metrics.
+   */
+  const Metrics & GetMetrics (uint32_t i) const;
+  /**
+   * Summarize each metric across all replications.
+   * \returns The summary of each metric, by name.
+   */
+  std::map<std::string, Summary> GetSummary (void) const;
+  /**
+   * Print the summary of each metric.
+   * \param [in] os The output stream.
+   */
+  void Print (std::ostream & os) const;
+
+private:
+  /**
+   * Run one replication; called in the child process.
+   * \param [in] run The run number.
+   * \param [in] fd The file descriptor to write the metrics to.
+   */
+  void RunChild (uint32_t run, int fd);
+
+  Replication m_replication;      //!< The replication.
+  uint32_t m_firstRun;            //!< The first run number.
+  uint32_t m_nRuns;               //!< The number of replications.
+  uint32_t m_maxJobs;             //!< The maximum concurrent replications.
+  std::vector<uint32_t> m_runs;   //!< The run number of each replication.
+  std::vector<Metrics> m_metrics; //!< The metrics of each replication.
+};
+
+} // namespace ns3
+
+#endif /* REPLICATION_RUNNER_H */
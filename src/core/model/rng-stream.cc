@@ -329,35 +329,74 @@ namespace ns3 {
 
 using namespace MRG32k3a;
   
-double RngStream::RandU01 ()
+double
+RngStream::RandU01 (void)
 {
-  int32_t k;
-  double p1, p2, u;
-
-  /* Component 1 */
-  p1 = a12 * m_currentState[1] - a13n * m_currentState[0];
-  k = static_cast<int32_t> (p1 / m1);
-  p1 -= k * m1;
-  if (p1 < 0.0)
+  if (m_bufferIndex == BUFFER_SIZE)
     {
-      p1 += m1;
+      Generate (m_buffer, BUFFER_SIZE);
+      m_bufferIndex = 0;
     }
-  m_currentState[0] = m_currentState[1]; m_currentState[1] = m_currentState[2]; m_currentState[2] = p1;
+  return m_buffer[m_bufferIndex++];
+}
 
-  /* Component 2 */
-  p2 = a21 * m_currentState[5] - a23n * m_currentState[3];
-  k = static_cast<int32_t> (p2 / m2);
-  p2 -= k * m2;
-  if (p2 < 0.0)
+void
+RngStream::RandU01 (double *values, std::size_t n)
+{
+  // Values generated ahead come first, to keep the sequence.
+  while (n > 0 && m_bufferIndex < BUFFER_SIZE)
     {
-      p2 += m2;
+      *values++ = m_buffer[m_bufferIndex++];
+      n--;
     }
-  m_currentState[3] = m_currentState[4]; m_currentState[4] = m_currentState[5]; m_currentState[5] = p2;
+  Generate (values, n);
+}
+
+void
+RngStream::Generate (double *values, std::size_t n)
+{
+  double s10 = m_currentState[0];
+  double s11 = m_currentState[1];
+  double s12 = m_currentState[2];
+  double s20 = m_currentState[3];
+  double s21 = m_currentState[4];
+  double s22 = m_currentState[5];
+
+  for (std::size_t i = 0; i < n; ++i)
+    {
+      int32_t k;
+      double p1, p2;
+
+      /* Component 1 */
+      p1 = a12 * s11 - a13n * s10;
+      k = static_cast<int32_t> (p1 / m1);
+      p1 -= k * m1;
+      if (p1 < 0.0)
+        {
+          p1 += m1;
+        }
+      s10 = s11; s11 = s12; s12 = p1;
 
-  /* Combination */
-  u = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+      /* Component 2 */
+      p2 = a21 * s22 - a23n * s20;
+      k = static_cast<int32_t> (p2 / m2);
+      p2 -= k * m2;
+      if (p2 < 0.0)
+        {
+          p2 += m2;
+        }
+      s20 = s21; s21 = s22; s22 = p2;
 
-  return u;
+      /* Combination */
+      values[i] = ((p1 > p2) ? (p1 - p2) * norm : (p1 - p2 + m1) * norm);
+    }
+
+  m_currentState[0] = s10;
+  m_currentState[1] = s11;
+  m_currentState[2] = s12;
+  m_currentState[3] = s20;
+  m_currentState[4] = s21;
+  m_currentState[5] = s22;
 }
 
 RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
@@ -372,6 +411,7 @@ RngStream::RngStream (uint32_t seedNumber, uint64_t stream, uint64_t substream)
     }
   AdvanceNthBy (stream, 127, m_currentState);
   AdvanceNthBy (substream, 76, m_currentState);
+  m_bufferIndex = BUFFER_SIZE;
 }
 
 RngStream::RngStream(const RngStream& r)
@@ -380,6 +420,11 @@ RngStream::RngStream(const RngStream& r)
     {
       m_currentState[i] = r.m_currentState[i];
     }
+  for (std::size_t i = r.m_bufferIndex; i < BUFFER_SIZE; ++i)
+    {
+      m_buffer[i] = r.m_buffer[i];
+    }
+  m_bufferIndex = r.m_bufferIndex;
 }
 
 void 
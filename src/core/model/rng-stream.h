@@ -21,6 +21,7 @@
 #define RNGSTREAM_H
 #include <string>
 #include <stdint.h>
+#include <cstddef>
 
 /**
  * \file
@@ -45,6 +46,11 @@ namespace ns3 {
  * holds a static instance of this class.  The details of this
  * class are explained in:
  * http://www.iro.umontreal.ca/~lecuyer/myftp/papers/streams00.pdf
+ *
+ * Values are generated BUFFER_SIZE at a time, which keeps the
+ * generator state in registers and lets successive steps overlap.
+ * This is invisible to callers: the sequence of values is exactly
+ * the one produced one step at a time.
  */
 class RngStream
 {
@@ -70,8 +76,26 @@ public:
    * \returns The next random.
    */
   double RandU01 (void);
+  /**
+   * Generate the next \p n random numbers for this stream,
+   * exactly as \p n successive calls to RandU01() would.
+   *
+   * \param [out] values Where to store the numbers, with room
+   *             for \p n values.
+   * \param [in] n The number of values to generate.
+   */
+  void RandU01 (double *values, std::size_t n);
 
 private:
+  /** Number of values generated ahead of RandU01() calls. */
+  enum { BUFFER_SIZE = 16 };
+  /**
+   * Step the recurrence \p n times, bypassing the buffer.
+   *
+   * \param [out] values Where to store the numbers.
+   * \param [in] n The number of values to generate.
+   */
+  void Generate (double *values, std::size_t n);
   /**
    * Advance \p state of the RNG by leaps and bounds.
    *
@@ -83,6 +107,10 @@ private:
 
   /** The RNG state vector. */
   double m_currentState[6];
+  /** Values already generated, not yet returned by RandU01(). */
+  double m_buffer[BUFFER_SIZE];
+  /** Index of the next value to return from m_buffer. */
+  std::size_t m_bufferIndex;
 };
 
 } // namespace ns3
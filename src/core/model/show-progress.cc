@@ -30,6 +30,7 @@
 #include "event-id.h"
 #include "log.h"
 #include "nstime.h"
+#include "object-accounting.h"
 #include "simulator.h"
 #include "singleton.h"
 
@@ -49,7 +50,9 @@ ShowProgress::ShowProgress (const Time interval /* = Seconds (1.0) */,
     m_printer (DefaultTimePrinter),
     m_os (&os),
     m_verbose (false),
-    m_repCount (0)
+    m_repCount (0),
+    m_accountingN (0),
+    m_accountingPerContext (false)
 {
   NS_LOG_FUNCTION (this << interval);
   Start ();
@@ -80,6 +83,14 @@ ShowProgress::SetVerbose (bool verbose)
   NS_LOG_FUNCTION (this << verbose);
   m_verbose = verbose;
 }
+
+void
+ShowProgress::SetObjectAccounting (uint32_t n, bool perContext /* = false */)
+{
+  NS_LOG_FUNCTION (this << n << perContext);
+  m_accountingN = n;
+  m_accountingPerContext = perContext;
+}
   
 void
 ShowProgress::SetStream (std::ostream & os)
@@ -213,6 +224,11 @@ ShowProgress::Feedback (void)
   m_os->precision (precision);
   m_os->flags (flags);
 
+  if (m_accountingN > 0)
+    {
+      ObjectAccounting::Print (*m_os, m_accountingN, m_accountingPerContext);
+    }
+
   // And do it again
   Start ();
 
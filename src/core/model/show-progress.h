@@ -109,6 +109,19 @@ public:
    */
   void SetVerbose (bool verbose);
 
+  /**
+   * Print the ObjectAccounting table after each progress message.
+   *
+   * This requires ns-3 to be configured with
+   * \c --enable-object-accounting.
+   *
+   * \param [in] n The number of types to print, with the most live
+   *            bytes first; 0, the default, prints none.
+   * \param [in] perContext Print the types created in each
+   *            context, usually a node, separately.
+   */
+  void SetObjectAccounting (uint32_t n, bool perContext = false);
+
    
 private:
   /** Show execution progress. */
@@ -135,6 +148,8 @@ private:
   std::ostream *m_os;         //!< The output stream to use.
   bool m_verbose;             //!< Verbose mode flag
   uint64_t m_repCount;        //!< Count of progress lines printed
+  uint32_t m_accountingN;     //!< Number of ObjectAccounting types to print
+  bool m_accountingPerContext; //!< Print ObjectAccounting per context
   
 };  // class ShowProgress
   
@@ -28,6 +28,11 @@
 #include "unused.h"
 #include <stdint.h>
 #include <limits>
+#ifdef NS3_OBJECT_ACCOUNTING
+#include "object-accounting.h"
+#include <type_traits>
+#include <typeinfo>
+#endif
 
 /**
  * \file
@@ -37,6 +42,10 @@
 
 namespace ns3 {
 
+#ifdef NS3_OBJECT_ACCOUNTING
+class ObjectBase;
+#endif
+
 /**
  * \ingroup ptr
  * \brief A template-based reference counting class
@@ -76,7 +85,11 @@ public:
   /** Default constructor.  */
   SimpleRefCount ()
     : m_count (1)
-  {}
+  {
+#ifdef NS3_OBJECT_ACCOUNTING
+    AccountingAdd ();
+#endif
+  }
   /**
    * Copy constructor
    * \param [in] o The object to copy into this one.
@@ -85,7 +98,20 @@ public:
     : m_count (1)
   {
     NS_UNUSED (o);
+#ifdef NS3_OBJECT_ACCOUNTING
+    AccountingAdd ();
+#endif
+  }
+#ifdef NS3_OBJECT_ACCOUNTING
+  /** Destructor. */
+  ~SimpleRefCount ()
+  {
+    if (!std::is_base_of<ObjectBase, T>::value)
+      {
+        ObjectAccounting::Remove (GetAccountingType (), m_accountingContext);
+      }
   }
+#endif
   /**
    * Assignment operator
    * \param [in] o The object to copy
@@ -142,6 +168,39 @@ private:
    * change it.
    */
   mutable uint32_t m_count;
+
+#ifdef NS3_OBJECT_ACCOUNTING
+protected:
+  /**
+   * The simulation context this instance was created in,
+   * for ObjectAccounting.
+   */
+  uint32_t m_accountingContext;
+
+private:
+  /**
+   * Get the ObjectAccounting index of \p T.
+   * \returns The type index.
+   */
+  static uint32_t GetAccountingType (void)
+  {
+    static uint32_t type = ObjectAccounting::RegisterType (typeid (T).name (), sizeof (T));
+    return type;
+  }
+  /**
+   * Count this instance with ObjectAccounting.
+   *
+   * Objects are counted by their TypeId instead, in Object::Construct.
+   */
+  void AccountingAdd (void)
+  {
+    m_accountingContext = ObjectAccounting::GetContext ();
+    if (!std::is_base_of<ObjectBase, T>::value)
+      {
+        ObjectAccounting::Add (GetAccountingType (), m_accountingContext);
+      }
+  }
+#endif
 };
 
 } // namespace ns3
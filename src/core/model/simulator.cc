@@ -150,6 +150,9 @@ Simulator::Destroy (void)
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+#ifdef ENABLE_DES_METRICS
+  DesMetrics::Get ()->WriteProfile ();
+#endif
 }
 
 void
@@ -321,6 +324,10 @@ Simulator::GetMaximumSimulationTime (void)
 uint32_t
 Simulator::GetContext (void)
 {
+  if (*PeekImpl () == 0)
+    {
+      return NO_CONTEXT;
+    }
   return GetImpl ()->GetContext ();
 }
   
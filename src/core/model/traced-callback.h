@@ -21,7 +21,8 @@
 #ifndef TRACED_CALLBACK_H
 #define TRACED_CALLBACK_H
 
-#include <list>
+#include <algorithm>
+#include <vector>
 #include "callback.h"
 
 /**
@@ -46,6 +47,29 @@ namespace ns3 {
  * calling one of the \c operator() forms with the appropriate
  * number of arguments.
  *
+ * The chain is stored in a flat vector, and invoking a TracedCallback
+ * with no Callbacks connected costs a single inlined test.  The
+ * arguments are still evaluated at the call site, so when they are
+ * expensive to build (packet copies, aggregated object lookups)
+ * guard the call with IsEmpty():
+ * \code
+ *   if (!m_txTrace.IsEmpty ())
+ *     {
+ *       m_txTrace (packet->Copy (), m_node->GetObject<Ipv4> (), interface);
+ *     }
+ * \endcode
+ *
+ * A Callback may connect or disconnect Callbacks, itself included,
+ * while the chain is invoked: a disconnected Callback is not called
+ * any more, and a newly connected one is called by the same invocation.
+ *
+ * When ns-3 is configured with \c --disable-trace-sources
+ * (which defines \c NS3_TRACE_SOURCES_DISABLE), IsEmpty() is always
+ * \c true and the \c operator() forms are empty, so the compiler
+ * removes trace sources, and guarded argument evaluation, entirely.
+ * Connecting to a trace source still checks the Callback signature,
+ * but the Callback is never invoked.
+ *
  * \tparam T1 \explicit Type of the first argument to the functor.
  * \tparam T2 \explicit Type of the second argument to the functor.
  * \tparam T3 \explicit Type of the third argument to the functor.
@@ -93,6 +117,19 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * Check for connected Callbacks.
+   *
+   * \return \c true if invoking this TracedCallback does nothing.
+   */
+  bool IsEmpty (void) const
+  {
+#ifdef NS3_TRACE_SOURCES_DISABLE
+    return true;
+#else
+    return m_callbackList.empty ();
+#endif
+  }
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -234,9 +271,21 @@ private:
    * \tparam T7 \deduced Type of the seventh argument to the functor.
    * \tparam T8 \deduced Type of the eighth argument to the functor.
    */
-  typedef std::list<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
-  /** The chain of Callbacks. */
-  CallbackList m_callbackList;
+  typedef std::vector<Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> > CallbackList;
+  /**
+   * Finish invoking the chain.  The outermost invocation removes the
+   * Callbacks disconnected while the chain was invoked, which were
+   * only nulled so as not to shift the others.
+   */
+  void EndInvoke (void) const;
+
+  /**
+   * The chain of Callbacks.  Mutable so that the invocation
+   * operators can remove the Callbacks disconnected meanwhile.
+   */
+  mutable CallbackList m_callbackList;
+  /** The number of invocations of the chain in progress. */
+  mutable uint32_t m_invoking;
 };
 
 } // namespace ns3
@@ -253,8 +302,26 @@ template<typename T1, typename T2,
          typename T5, typename T6,
          typename T7, typename T8>
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::TracedCallback ()
-  : m_callbackList () 
+  : m_callbackList (),
+    m_invoking (0)
+{
+}
+template<typename T1, typename T2,
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+void
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::EndInvoke (void) const
 {
+  m_invoking--;
+  if (m_invoking == 0)
+    {
+      typename CallbackList::iterator end =
+        std::remove_if (m_callbackList.begin (), m_callbackList.end (),
+                        [] (const Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> & cb)
+                        { return cb.IsNull (); });
+      m_callbackList.erase (end, m_callbackList.end ());
+    }
 }
 template<typename T1, typename T2,
          typename T3, typename T4,
@@ -266,7 +333,9 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::ConnectWithoutContext (const CallbackBa
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> cb;
   if (!cb.Assign (callback))
     NS_FATAL_ERROR_NO_MSG();
+#ifndef NS3_TRACE_SOURCES_DISABLE
   m_callbackList.push_back (cb);
+#endif
 }
 template<typename T1, typename T2,
          typename T3, typename T4,
@@ -278,8 +347,10 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Connect (const CallbackBase & callback,
   Callback<void,std::string,T1,T2,T3,T4,T5,T6,T7,T8> cb;
   if (!cb.Assign (callback))
     NS_FATAL_ERROR ("when connecting to " << path);
+#ifndef NS3_TRACE_SOURCES_DISABLE
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   m_callbackList.push_back (realCb);
+#endif
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -291,14 +362,21 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::DisconnectWithoutContext (const Callbac
   for (typename CallbackList::iterator i = m_callbackList.begin ();
        i != m_callbackList.end (); /* empty */)
     {
-      if ((*i).IsEqual (callback))
+      if ((*i).IsNull () || !(*i).IsEqual (callback))
         {
-          i = m_callbackList.erase (i);
+          i++;
         }
-      else
+      else if (m_invoking > 0)
         {
+          // Keep the indexes of the chain being invoked; EndInvoke
+          // removes the Callback
+          *i = Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> ();
           i++;
         }
+      else
+        {
+          i = m_callbackList.erase (i);
+        }
     }
 }
 template<typename T1, typename T2, 
@@ -321,11 +399,21 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (void) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
+    {
+      return;
+    }
+  // Index rather than iterate: a Callback may connect others, or
+  // disconnect any Callback, itself included, while the chain is invoked
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
     {
-      (*i)();
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] ();
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -334,11 +422,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
     {
-      (*i)(a1);
+      return;
     }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
+    {
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -347,11 +443,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
+    {
+      return;
+    }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
     {
-      (*i)(a1, a2);
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -360,11 +464,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
+    {
+      return;
+    }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
     {
-      (*i)(a1, a2, a3);
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -373,11 +485,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
+    {
+      return;
+    }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
     {
-      (*i)(a1, a2, a3, a4);
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3, a4);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -386,11 +506,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
     {
-      (*i)(a1, a2, a3, a4, a5);
+      return;
     }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
+    {
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3, a4, a5);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -399,11 +527,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
+    {
+      return;
+    }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
     {
-      (*i)(a1, a2, a3, a4, a5, a6);
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3, a4, a5, a6);
+        }
     }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -412,11 +548,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7);
+      return;
     }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
+    {
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7);
+        }
+    }
+  EndInvoke ();
 }
 template<typename T1, typename T2, 
          typename T3, typename T4,
@@ -425,11 +569,19 @@ template<typename T1, typename T2,
 void 
 TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const
 {
-  for (typename CallbackList::const_iterator i = m_callbackList.begin ();
-       i != m_callbackList.end (); i++)
+  if (IsEmpty ())
     {
-      (*i)(a1, a2, a3, a4, a5, a6, a7, a8);
+      return;
+    }
+  m_invoking++;
+  for (std::size_t i = 0; i < m_callbackList.size (); ++i)
+    {
+      if (!m_callbackList[i].IsNull ())
+        {
+          m_callbackList[i] (a1, a2, a3, a4, a5, a6, a7, a8);
+        }
     }
+  EndInvoke ();
 }
 
 } // namespace ns3
@@ -78,6 +78,8 @@ NS_LOG_COMPONENT_DEFINE ("TypeId");
 class IidManager : public Singleton<IidManager>
 {
 public:
+  /** Constructor. */
+  IidManager ();
   /**
    * Create a new unique type id.
    * \param [in] name The name of this type id.
@@ -216,6 +218,12 @@ public:
   void SetAttributeInitialValue (uint16_t uid,
                                  std::size_t i,
                                  Ptr<const AttributeValue> initialValue);
+  /**
+   * Get the attribute generation.
+   * \returns The number of attribute additions and
+   *          initial value changes so far.
+   */
+  uint32_t GetAttributeGeneration (void) const;
   /**
    * Get the number of attributes.
    * \param [in] uid The id.
@@ -343,6 +351,9 @@ private:
   /** The by-hash index. */
   hashmap_t m_hashmap;
 
+  /** Bumped whenever any attribute is added or its initial value changes. */
+  uint32_t m_attributeGeneration;
+
 
   /** IidManager constants. */
   enum {
@@ -378,6 +389,12 @@ IidManager::Hasher (const std::string name)
  */
 #define IIDL IID << ": "
 
+IidManager::IidManager ()
+  : m_attributeGeneration (0)
+{
+  NS_LOG_FUNCTION (IID);
+}
+
 uint16_t
 IidManager::AllocateUid (std::string name)
 {
@@ -676,6 +693,7 @@ IidManager::AddAttribute (uint16_t uid,
   info.supportLevel = supportLevel;
   info.supportMsg = supportMsg;
   information->attributes.push_back (info);
+  m_attributeGeneration++;
   NS_LOG_LOGIC (IIDL << information->attributes.size () - 1);
 }
 void 
@@ -687,6 +705,14 @@ IidManager::SetAttributeInitialValue (uint16_t uid,
   struct IidInformation *information = LookupInformation (uid);
   NS_ASSERT (i < information->attributes.size ());
   information->attributes[i].initialValue = initialValue;
+  m_attributeGeneration++;
+}
+
+uint32_t
+IidManager::GetAttributeGeneration (void) const
+{
+  NS_LOG_FUNCTION (IID);
+  return m_attributeGeneration;
 }
 
 
@@ -866,6 +892,12 @@ TypeId::GetRegisteredN (void)
   NS_LOG_FUNCTION_NOARGS ();
   return IidManager::Get ()->GetRegisteredN ();
 }
+uint32_t
+TypeId::GetAttributeGeneration (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return IidManager::Get ()->GetAttributeGeneration ();
+}
 TypeId 
 TypeId::GetRegistered (uint16_t i)
 {
@@ -164,6 +164,17 @@ public:
    * \returns The TypeId instance whose index is \c i.
    */
   static TypeId GetRegistered (uint16_t i);
+  /**
+   * Get a counter which changes whenever an attribute is added to any
+   * TypeId, or the initial value of any attribute is changed.
+   *
+   * Caches built from attribute information, such as the initial
+   * attribute tables used by ObjectBase::ConstructSelf, compare it
+   * to the value they were built with to know when they are stale.
+   *
+   * \returns The current attribute generation.
+   */
+  static uint32_t GetAttributeGeneration (void);
 
   /**
    * Constructor.
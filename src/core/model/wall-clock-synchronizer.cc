@@ -20,8 +20,15 @@
 #include <ctime>       // clock_t
 #include <sys/time.h>  // gettimeofday
                        // clock_getres: glibc < 2.17, link with librt
+#include <cstring>     // strerror
+#ifdef __linux__
+#include <pthread.h>   // pthread_setaffinity_np
+#include <sched.h>     // cpu_set_t
+#endif
 
 #include "log.h"
+#include "fatal-error.h"
+#include "integer.h"
 #include "system-condition.h"
 
 #include "wall-clock-synchronizer.h"
@@ -44,6 +51,19 @@ WallClockSynchronizer::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::WallClockSynchronizer")
     .SetParent<Synchronizer> ()
     .SetGroupName ("Core")
+    .AddAttribute ("BusyPollThreshold",
+                   "Busy-poll the clock, instead of sleeping, for the last "
+                   "part of each wait, up to this long. "
+                   "Zero busy-polls waits shorter than three clock ticks.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&WallClockSynchronizer::m_busyPollThreshold),
+                   MakeTimeChecker (Seconds (0)))
+    .AddAttribute ("Cpu",
+                   "The CPU to pin the simulation thread to, "
+                   "or -1 to let the system schedule it (Linux only).",
+                   IntegerValue (-1),
+                   MakeIntegerAccessor (&WallClockSynchronizer::m_cpu),
+                   MakeIntegerChecker<int32_t> (-1))
   ;
   return tid;
 }
@@ -75,10 +95,17 @@ WallClockSynchronizer::WallClockSynchronizer ()
 // requires a delay less than a jiffy.  This is on the order of one millisecond
 // (999848 ns) on the ns-regression machine.
 // 
+// The resolution is read from the clock GetRealtime () reads the time from.
+//
 // If the underlying OS does not support posix clocks, we'll just assume a 
 // one millisecond quantum and deal with this as best we can
 
-#ifdef CLOCK_REALTIME
+#if defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_getres (CLOCK_MONOTONIC, &ts);
+  m_jiffy = ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+  NS_LOG_INFO ("Jiffy is " << m_jiffy << " ns");
+#elif defined (CLOCK_REALTIME)
   struct timespec ts;
   clock_getres (CLOCK_REALTIME, &ts);
   m_jiffy = ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
@@ -119,6 +146,7 @@ WallClockSynchronizer::DoSetOrigin (uint64_t ns)
 // save the real time away so we can subtract it from "now" later and get
 // a count of nanoseconds in real time since the simulation started.
 //
+  PinThread ();
   m_realtimeOriginNano = GetRealtime ();
   NS_LOG_INFO ("origin = " << m_realtimeOriginNano);
 }
@@ -223,9 +251,24 @@ WallClockSynchronizer::DoSynchronize (uint64_t nsCurrent, uint64_t nsDelay)
 // I'm not really sure about this number -- a boss of mine once said, "pick
 // a number and it'll be wrong."  But this works for now.
 //
-// \todo Hardcoded tunable parameter below.
+// With a fine grained clock, the jiffy is a nanosecond and we end up
+// sleeping for nearly the whole delay, waking up tens of microseconds late.
+// The BusyPollThreshold attribute sets how long to busy-poll instead.
 //
-  if (numberJiffies > 3)
+  if (!m_busyPollThreshold.IsZero ())
+    {
+      uint64_t nsPoll = m_busyPollThreshold.GetNanoSeconds ();
+      if (ns > nsPoll)
+        {
+          NS_LOG_INFO ("SleepWait for " << ns - nsPoll << " ns");
+          if (SleepWait (ns - nsPoll) == false)
+            {
+              NS_LOG_INFO ("SleepWait interrupted");
+              return false;
+            }
+        }
+    }
+  else if (numberJiffies > 3)
     {
       NS_LOG_INFO ("SleepWait for " << numberJiffies * m_jiffy << " ns");
       NS_LOG_INFO ("SleepWait until " << nsCurrent + numberJiffies * m_jiffy 
@@ -374,9 +417,40 @@ uint64_t
 WallClockSynchronizer::GetRealtime (void)
 {
   NS_LOG_FUNCTION (this);
+#ifdef CLOCK_MONOTONIC
+  // Nanosecond resolution, and not stepped by NTP.
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+#else
   struct timeval tvNow;
   gettimeofday (&tvNow, NULL);
   return TimevalToNs (&tvNow);
+#endif
+}
+
+void
+WallClockSynchronizer::PinThread (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_cpu < 0)
+    {
+      return;
+    }
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO (&cpus);
+  CPU_SET (m_cpu, &cpus);
+  int error = pthread_setaffinity_np (pthread_self (), sizeof (cpus), &cpus);
+  if (error != 0)
+    {
+      NS_FATAL_ERROR ("Cannot pin the simulation thread to CPU " << m_cpu
+                      << ": " << std::strerror (error));
+    }
+  NS_LOG_INFO ("Simulation thread pinned to CPU " << m_cpu);
+#else
+  NS_LOG_WARN ("Cannot pin the simulation thread to a CPU on this system");
+#endif
 }
 
 uint64_t
@@ -21,6 +21,7 @@
 
 #include "system-condition.h"
 #include "synchronizer.h"
+#include "nstime.h"
 
 /**
  * @file
@@ -60,6 +61,22 @@ namespace ns3 {
  * to use the function @c clock_nanosleep() to sleep until a simulation Time
  * specified by the caller. 
  *
+ * Sleeping on a condition variable wakes up tens of microseconds late,
+ * which is too coarse for hardware in the loop emulation.  Setting the
+ * @c BusyPollThreshold attribute makes the synchronizer sleep only
+ * until that long before each event, and busy-poll the clock for the
+ * rest of the wait.  Busy-polling is only precise if the simulator
+ * thread keeps its CPU, so the @c Cpu attribute pins the thread
+ * running the simulation to one CPU (on Linux), ideally one isolated
+ * from the rest of the system.  RealtimeSimulatorImpl records how late
+ * each event runs; see RealtimeSimulatorImpl::GetLatenessHistogram.
+ *
+ * @code
+ *   Config::SetDefault ("ns3::WallClockSynchronizer::BusyPollThreshold",
+ *                       TimeValue (MicroSeconds (200)));
+ *   Config::SetDefault ("ns3::WallClockSynchronizer::Cpu", IntegerValue (3));
+ * @endcode
+ *
  * @todo Add more on jiffies, sleep, processes, etc.
  *
  * @internal
@@ -150,7 +167,8 @@ protected:
   uint64_t DriftCorrect (uint64_t nsNow, uint64_t nsDelay);
 
   /**
-   * @brief Get the current absolute real time (in ns since the epoch).
+   * @brief Get the current absolute real time, in ns, from the
+   * monotonic clock if there is one.
    *
    * @returns The current real time, in ns.
    */
@@ -177,6 +195,9 @@ protected:
    */
   uint64_t TimevalToNs (struct timeval *tv);
 
+  /** Pin the calling thread to CPU #m_cpu, if set. */
+  void PinThread (void);
+
   /**
    * @brief Add two @c timeval.
    *
@@ -193,6 +214,10 @@ protected:
   uint64_t m_jiffy;
   /** Time recorded by DoEventStart. */
   uint64_t m_nsEventStart;
+  /** Waits up to this long are busy-polled; zero to use #m_jiffy. */
+  Time m_busyPollThreshold;
+  /** The CPU to run the simulation on, or -1 to not pin the thread. */
+  int32_t m_cpu;
 
   /** Thread synchronizer. */
   SystemCondition m_condition;
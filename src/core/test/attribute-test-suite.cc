@@ -832,6 +832,20 @@ RandomVariableStreamAttributeTestCase::DoRun (void)
   //
   ok = p->SetAttributeFailSafe ("TestRandom", StringValue ("ns3::ConstantRandomVariable[Constant=1.0]"));
   NS_TEST_ASSERT_MSG_EQ (ok, true, "Could not SetAttributeFailSafe() a ConstantRandomVariable");
+
+  //
+  // The initial value is a StringValue: each object must get its own
+  // random variable, not one shared by all objects of the type.
+  //
+  Ptr<AttributeObjectTest> q = CreateObject<AttributeObjectTest> ();
+  Ptr<AttributeObjectTest> r = CreateObject<AttributeObjectTest> ();
+  PointerValue qRandom;
+  PointerValue rRandom;
+  q->GetAttribute ("TestRandom", qRandom);
+  r->GetAttribute ("TestRandom", rRandom);
+  NS_TEST_ASSERT_MSG_NE (qRandom.Get<RandomVariableStream> (), 0, "Initial random variable not created");
+  NS_TEST_ASSERT_MSG_NE (qRandom.Get<RandomVariableStream> (), rRandom.Get<RandomVariableStream> (),
+                         "Objects share the random variable created from the initial value");
 }
 
 // ===========================================================================
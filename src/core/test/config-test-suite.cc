@@ -830,6 +830,101 @@ SearchAttributesOfParentObjectsTestCase::DoRun (void)
 
 }
 
+/**
+ * \ingroup config-tests
+ * Test for connecting many trace sources at once, through
+ * plain container indices.
+ */
+class ConnectManyConfigTestCase : public TestCase
+{
+public:
+  /** Constructor. */
+  ConnectManyConfigTestCase ();
+  /** Destructor. */
+  virtual ~ConnectManyConfigTestCase () {}
+
+  /**
+   * Trace callback with context path.
+   * \param path The context path.
+   * \param old The old value.
+   * \param newValue The new value.
+   */
+  void TraceWithPath (std::string path, int16_t old, int16_t newValue)
+  {
+    NS_UNUSED (old);
+    m_newValue = newValue;
+    m_path = path;
+    m_count++;
+  }
+
+private:
+  virtual void DoRun (void);
+
+  int16_t m_newValue; //!< Flag to detect tracing result.
+  std::string m_path; //!< The context path.
+  uint32_t m_count;   //!< Number of trace events.
+};
+
+ConnectManyConfigTestCase::ConnectManyConfigTestCase ()
+  : TestCase ("Check Config::ConnectMany and indexed paths into vectors of Object")
+{
+}
+
+void
+ConnectManyConfigTestCase::DoRun (void)
+{
+  Ptr<ConfigTestObject> root = CreateObject<ConfigTestObject> ();
+  Config::RegisterRootNamespaceObject (root);
+
+  Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject> ();
+  root->SetNodeA (a);
+  std::vector<Ptr<ConfigTestObject> > objects;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ConfigTestObject> obj = CreateObject<ConfigTestObject> ();
+      a->AddNodeA (obj);
+      objects.push_back (obj);
+    }
+
+  //
+  // Index 7 does not exist and must be silently ignored, as
+  // Config::Connect does.
+  //
+  std::vector<std::string> paths;
+  paths.push_back ("/NodeA/NodesA/1/Source");
+  paths.push_back ("/NodeA/NodesA/3/Source");
+  paths.push_back ("/NodeA/NodesA/7/Source");
+  Config::ConnectMany (paths, MakeCallback (&ConnectManyConfigTestCase::TraceWithPath, this));
+
+  m_count = 0;
+  m_newValue = 0;
+  objects[1]->SetAttribute ("Source", IntegerValue (-2));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -2, "Trace 1 did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodesA/1/Source", "Trace 1 did not provide expected context");
+
+  m_newValue = 0;
+  objects[2]->SetAttribute ("Source", IntegerValue (-3));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, 0, "Trace 2 fired unexpectedly");
+
+  objects[3]->SetAttribute ("Source", IntegerValue (-4));
+  NS_TEST_ASSERT_MSG_EQ (m_newValue, -4, "Trace 3 did not fire as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_path, "/NodeA/NodesA/3/Source", "Trace 3 did not provide expected context");
+  NS_TEST_ASSERT_MSG_EQ (m_count, 2, "Trace sources connected more than once");
+
+  //
+  // An indexed path must match exactly what the equivalent
+  // single-element range matches.
+  //
+  Config::MatchContainer indexed = Config::LookupMatches ("/NodeA/NodesA/2");
+  Config::MatchContainer ranged = Config::LookupMatches ("/NodeA/NodesA/[2-2]");
+  NS_TEST_ASSERT_MSG_EQ (indexed.GetN (), 1, "Indexed path did not match one object");
+  NS_TEST_ASSERT_MSG_EQ (ranged.GetN (), 1, "Ranged path did not match one object");
+  NS_TEST_ASSERT_MSG_EQ (indexed.Get (0), objects[2], "Indexed path matched the wrong object");
+  NS_TEST_ASSERT_MSG_EQ (indexed.GetMatchedPath (0), ranged.GetMatchedPath (0), "Indexed path has the wrong context");
+
+  Config::UnregisterRootNamespaceObject (root);
+}
+
 /**
  * \ingroup config-tests
  * The Test Suite that glues all of the Test Cases together.
@@ -848,6 +943,7 @@ ConfigTestSuite::ConfigTestSuite ()
   AddTestCase (new UnderRootNamespaceConfigTestCase);
   AddTestCase (new ObjectVectorConfigTestCase);
   AddTestCase (new SearchAttributesOfParentObjectsTestCase);
+  AddTestCase (new ConnectManyConfigTestCase);
 }
 
 /**
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/inline-callback.h"
+#include <stdint.h>
+
+using namespace ns3;
+
+// ===========================================================================
+// Test InlineCallback to member functions and plain functions
+// ===========================================================================
+class InlineCallbackTestCase : public TestCase
+{
+public:
+  InlineCallbackTestCase ();
+  virtual ~InlineCallbackTestCase () {}
+
+  void Target1 (void) { m_test1 = true; }
+  int Target2 (int a) { m_test2 = true; return a + 1; }
+  int Target3 (int a) const { return a * 2; }
+  void Target6 (int &a) { a = 42; }
+
+private:
+  virtual void DoRun (void);
+
+  bool m_test1;
+  bool m_test2;
+};
+
+static int gInlineCallbackSum;
+
+void
+InlineCallbackTarget4 (int a, int b)
+{
+  gInlineCallbackSum = a + b;
+}
+
+int
+InlineCallbackTarget5 (int a, double b, int c)
+{
+  return a + static_cast<int> (b) + c;
+}
+
+void
+InlineCallbackTarget7 (int &a)
+{
+  a = 7;
+}
+
+void
+InlineCallbackTarget8 (int b, int &a)
+{
+  a = b;
+}
+
+InlineCallbackTestCase::InlineCallbackTestCase ()
+  : TestCase ("Check InlineCallback to member functions and functions"),
+    m_test1 (false),
+    m_test2 (false)
+{
+}
+
+void
+InlineCallbackTestCase::DoRun (void)
+{
+  InlineCallback<void> target1;
+  NS_TEST_ASSERT_MSG_EQ (target1.IsNull (), true, "Default InlineCallback is not null");
+  target1 = MakeInlineCallback (&InlineCallbackTestCase::Target1, this);
+  NS_TEST_ASSERT_MSG_EQ (target1.IsNull (), false, "InlineCallback is null");
+  target1 ();
+  NS_TEST_ASSERT_MSG_EQ (m_test1, true, "InlineCallback did not fire");
+
+  InlineCallback<int, int> target2 = MakeInlineCallback (&InlineCallbackTestCase::Target2, this);
+  InlineCallback<int, int> copy = target2;
+  NS_TEST_ASSERT_MSG_EQ (copy (2), 3, "InlineCallback returned the wrong value");
+  NS_TEST_ASSERT_MSG_EQ (m_test2, true, "InlineCallback did not fire");
+  NS_TEST_ASSERT_MSG_EQ ((copy == target2), true, "Copies are not equal");
+
+  InlineCallback<int, int> target3 = MakeInlineCallback (&InlineCallbackTestCase::Target3, this);
+  NS_TEST_ASSERT_MSG_EQ (target3 (5), 10, "Const member InlineCallback returned the wrong value");
+  NS_TEST_ASSERT_MSG_EQ ((target3 != target2), true, "Different targets compare equal");
+
+  InlineCallback<void, int, int> target4 = MakeInlineCallback (&InlineCallbackTarget4);
+  target4 (1, 2);
+  NS_TEST_ASSERT_MSG_EQ (gInlineCallbackSum, 3, "Function InlineCallback did not fire");
+
+  target4.Nullify ();
+  NS_TEST_ASSERT_MSG_EQ (target4.IsNull (), true, "Nullified InlineCallback is not null");
+
+  // Reference arguments are passed through, not copied.
+  int value = 0;
+  InlineCallback<void, int &> target6 = MakeInlineCallback (&InlineCallbackTestCase::Target6, this);
+  target6 (value);
+  NS_TEST_ASSERT_MSG_EQ (value, 42, "Member InlineCallback did not modify its reference argument");
+  InlineCallback<void, int &> target7 = MakeInlineCallback (&InlineCallbackTarget7);
+  target7 (value);
+  NS_TEST_ASSERT_MSG_EQ (value, 7, "Function InlineCallback did not modify its reference argument");
+}
+
+// ===========================================================================
+// Test bound InlineCallbacks and conversion to Callback
+// ===========================================================================
+class BoundInlineCallbackTestCase : public TestCase
+{
+public:
+  BoundInlineCallbackTestCase ();
+  virtual ~BoundInlineCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+BoundInlineCallbackTestCase::BoundInlineCallbackTestCase ()
+  : TestCase ("Check bound InlineCallbacks and conversion to Callback")
+{
+}
+
+void
+BoundInlineCallbackTestCase::DoRun (void)
+{
+  InlineCallback<void, int> target1 = MakeBoundInlineCallback (&InlineCallbackTarget4, 10);
+  target1 (5);
+  NS_TEST_ASSERT_MSG_EQ (gInlineCallbackSum, 15, "Bound InlineCallback did not fire");
+
+  InlineCallback<int, int> target2 = MakeBoundInlineCallback (&InlineCallbackTarget5, 1, 2.5);
+  NS_TEST_ASSERT_MSG_EQ (target2 (3), 6, "Two bound InlineCallback returned the wrong value");
+
+  InlineCallback<int, int> other = MakeBoundInlineCallback (&InlineCallbackTarget5, 1, 3.5);
+  NS_TEST_ASSERT_MSG_EQ ((other != target2), true, "Different bound values compare equal");
+
+  Callback<int, int> cb = target2.ToCallback ();
+  NS_TEST_ASSERT_MSG_EQ (cb.IsNull (), false, "Converted Callback is null");
+  NS_TEST_ASSERT_MSG_EQ (cb (3), 6, "Converted Callback returned the wrong value");
+
+  int value = 0;
+  InlineCallback<void, int &> target3 = MakeBoundInlineCallback (&InlineCallbackTarget8, 9);
+  target3 (value);
+  NS_TEST_ASSERT_MSG_EQ (value, 9, "Bound InlineCallback did not modify its reference argument");
+  Callback<void, int &> cb3 = target3.ToCallback ();
+  value = 0;
+  cb3 (value);
+  NS_TEST_ASSERT_MSG_EQ (value, 9, "Converted Callback did not modify its reference argument");
+
+  InlineCallback<int, int> null;
+  NS_TEST_ASSERT_MSG_EQ (null.ToCallback ().IsNull (), true, "Converted null Callback is not null");
+}
+
+class InlineCallbackTestSuite : public TestSuite
+{
+public:
+  InlineCallbackTestSuite ();
+};
+
+InlineCallbackTestSuite::InlineCallbackTestSuite ()
+  : TestSuite ("inline-callback", UNIT)
+{
+  AddTestCase (new InlineCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new BoundInlineCallbackTestCase, TestCase::QUICK);
+}
+
+static InlineCallbackTestSuite g_inlineCallbackTestSuite;
@@ -0,0 +1,268 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/log-binary-sink.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/system-thread.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LogBinarySinkTestSuite");
+
+// ===========================================================================
+// Test that a decoded binary log matches the text log
+// ===========================================================================
+class LogBinarySinkTestCase : public TestCase
+{
+public:
+  LogBinarySinkTestCase ();
+  virtual ~LogBinarySinkTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Log a few messages.
+   * \param [in] value A value to log.
+   */
+  void Emit (uint32_t value);
+  /** Run a simulation which logs. */
+  void RunSimulation (void);
+};
+
+LogBinarySinkTestCase::LogBinarySinkTestCase ()
+  : TestCase ("Check a decoded binary log against the text log")
+{
+}
+
+void
+LogBinarySinkTestCase::Emit (uint32_t value)
+{
+  NS_LOG_FUNCTION (this << value << "text");
+  NS_LOG_FUNCTION_NOARGS ();
+  NS_LOG_DEBUG ("value=" << value);
+  NS_LOG_INFO ("first line" << std::endl << "second line");
+  NS_LOG_UNCOND ("unconditional " << value);
+  std::clog << "partial ";
+  NS_LOG_WARN ("after partial text");
+}
+
+void
+LogBinarySinkTestCase::RunSimulation (void)
+{
+  Simulator::Schedule (Seconds (0.5), &LogBinarySinkTestCase::Emit, this, 1);
+  Simulator::ScheduleWithContext (3, MicroSeconds (1500001), &LogBinarySinkTestCase::Emit, this, 2);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LogBinarySinkTestCase::DoRun (void)
+{
+  LogComponentEnable ("LogBinarySinkTestSuite", LogLevel (LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+
+  // The text log.
+  std::ostringstream text;
+  std::streambuf *clogBuffer = std::clog.rdbuf (text.rdbuf ());
+  RunSimulation ();
+  std::clog.rdbuf (clogBuffer);
+
+  // The same messages through the binary log.
+  std::string filename = CreateTempDirFilename ("log-binary-sink.nslog");
+  LogBinarySink::Enable (filename, 64);
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::IsEnabled (), true, "Sink not enabled");
+  RunSimulation ();
+  LogBinarySink::Disable ();
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::IsEnabled (), false, "Sink not disabled");
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::GetDropped (), 0, "Messages dropped");
+
+  LogComponentDisable ("LogBinarySinkTestSuite", LOG_LEVEL_ALL);
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::Decode (is, decoded), true, "Cannot decode the binary log");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), text.str (), "Decoded log differs from the text log");
+#ifdef NS3_LOG_ENABLE
+  NS_TEST_ASSERT_MSG_NE (text.str ().find ("LogBinarySinkTestSuite:Emit("), std::string::npos,
+                         "Function prefix missing");
+#endif
+}
+
+// ===========================================================================
+// Test that threads logging at the same time keep their lines whole
+// ===========================================================================
+class LogBinarySinkThreadsTestCase : public TestCase
+{
+public:
+  LogBinarySinkThreadsTestCase ();
+  virtual ~LogBinarySinkThreadsTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Log a number of messages, some in several writes.
+   * \param [in] thread The thread number.
+   */
+  static void Emit (uint32_t thread);
+
+  static const uint32_t THREADS = 4;   //!< The number of logging threads.
+  static const uint32_t LINES = 500;   //!< The number of lines per thread.
+};
+
+LogBinarySinkThreadsTestCase::LogBinarySinkThreadsTestCase ()
+  : TestCase ("Check the binary log with several logging threads")
+{
+}
+
+void
+LogBinarySinkThreadsTestCase::Emit (uint32_t thread)
+{
+  for (uint32_t i = 0; i < LINES; ++i)
+    {
+      NS_LOG_INFO ("thread " << thread << " message " << i);
+      std::clog << "thread " << thread;
+      std::clog << " text " << i << std::endl;
+    }
+}
+
+void
+LogBinarySinkThreadsTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("log-binary-sink-threads.nslog");
+  LogComponentEnable ("LogBinarySinkTestSuite", LogLevel (LOG_LEVEL_INFO | LOG_PREFIX_FUNC | LOG_PREFIX_LEVEL));
+  LogBinarySink::Enable (filename, 256);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t t = 0; t < THREADS; ++t)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&LogBinarySinkThreadsTestCase::Emit, t)));
+      threads.back ()->Start ();
+    }
+  for (uint32_t t = 0; t < THREADS; ++t)
+    {
+      threads[t]->Join ();
+    }
+  LogBinarySink::Disable ();
+  LogComponentDisable ("LogBinarySinkTestSuite", LOG_LEVEL_ALL);
+
+  std::vector<std::string> expected;
+  for (uint32_t t = 0; t < THREADS; ++t)
+    {
+      for (uint32_t i = 0; i < LINES; ++i)
+        {
+#ifdef NS3_LOG_ENABLE
+          std::ostringstream message;
+          message << "LogBinarySinkTestSuite:Emit(): [INFO ] thread " << t << " message " << i;
+          expected.push_back (message.str ());
+#endif
+          std::ostringstream text;
+          text << "thread " << t << " text " << i;
+          expected.push_back (text.str ());
+        }
+    }
+  std::sort (expected.begin (), expected.end ());
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::Decode (is, decoded), true, "Cannot decode the binary log");
+  std::vector<std::string> lines;
+  std::istringstream iss (decoded.str ());
+  std::string line;
+  while (std::getline (iss, line))
+    {
+      lines.push_back (line);
+    }
+  std::sort (lines.begin (), lines.end ());
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), expected.size (), "Wrong number of lines");
+  NS_TEST_ASSERT_MSG_EQ ((lines == expected), true, "Lines of different threads were mixed");
+}
+
+// ===========================================================================
+// Test that Decode uses the recorded time resolution
+// ===========================================================================
+class LogBinarySinkResolutionTestCase : public TestCase
+{
+public:
+  LogBinarySinkResolutionTestCase ();
+  virtual ~LogBinarySinkResolutionTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+LogBinarySinkResolutionTestCase::LogBinarySinkResolutionTestCase ()
+  : TestCase ("Check Decode with another time resolution")
+{
+}
+
+/**
+ * Append a value to a binary log, in host byte order.
+ * \param [in,out] log The binary log.
+ * \param [in] value The value.
+ */
+template <typename T>
+static void
+AppendValue (std::string &log, T value)
+{
+  log.append (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+void
+LogBinarySinkResolutionTestCase::DoRun (void)
+{
+  // A message logged at 1.5 s with a millisecond resolution.
+  std::string log ("NS3LOGB1");
+  AppendValue<uint8_t> (log, 'R');
+  AppendValue<uint8_t> (log, Time::MS);
+  AppendValue<uint8_t> (log, 'M');
+  AppendValue<uint8_t> (log, 1);              // time prefix only
+  AppendValue<int64_t> (log, 1500);
+  AppendValue<uint32_t> (log, 0);             // context
+  AppendValue<uint32_t> (log, 0);             // component
+  AppendValue<uint32_t> (log, 0);             // function
+  AppendValue<uint32_t> (log, LOG_INFO);
+  AppendValue<uint32_t> (log, 0);             // context text size
+  AppendValue<uint32_t> (log, 5);
+  log.append ("hello");
+
+  enum Time::Unit resolution = Time::GetResolution ();
+  std::istringstream is (log);
+  std::ostringstream decoded;
+  NS_TEST_ASSERT_MSG_EQ (LogBinarySink::Decode (is, decoded), true, "Cannot decode the binary log");
+  NS_TEST_ASSERT_MSG_EQ (decoded.str (), "+1.50000s hello\n", "Wrong decoded time");
+  NS_TEST_ASSERT_MSG_EQ (Time::GetResolution (), resolution, "Decode changed the time resolution");
+}
+
+class LogBinarySinkTestSuite : public TestSuite
+{
+public:
+  LogBinarySinkTestSuite ();
+};
+
+LogBinarySinkTestSuite::LogBinarySinkTestSuite ()
+  : TestSuite ("log-binary-sink", UNIT)
+{
+  AddTestCase (new LogBinarySinkTestCase, TestCase::QUICK);
+  AddTestCase (new LogBinarySinkThreadsTestCase, TestCase::QUICK);
+  AddTestCase (new LogBinarySinkResolutionTestCase, TestCase::QUICK);
+}
+
+static LogBinarySinkTestSuite g_logBinarySinkTestSuite;
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/object-accounting.h"
+#include "ns3/object.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+#include "ns3/ptr.h"
+#include <sstream>
+
+using namespace ns3;
+
+namespace {
+
+/** An Object type to count. */
+class AccountedObject : public Object
+{
+public:
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::AccountedObject")
+      .SetParent<Object> ()
+      .SetGroupName ("Core")
+      .AddConstructor<AccountedObject> ()
+    ;
+    return tid;
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (AccountedObject);
+
+/** A SimpleRefCount type to count. */
+class AccountedItem : public SimpleRefCount<AccountedItem>
+{
+public:
+  char data[100]; //!< Some payload.
+};
+
+}  // unnamed namespace
+
+// ===========================================================================
+// Test live instance counts by type and by creation context
+// ===========================================================================
+class ObjectAccountingTestCase : public TestCase
+{
+public:
+  ObjectAccountingTestCase ();
+  virtual ~ObjectAccountingTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /** Create an item in the current context and keep it. */
+  void CreateItem (void);
+
+  std::vector<Ptr<AccountedItem> > m_items; //!< The items kept alive.
+};
+
+ObjectAccountingTestCase::ObjectAccountingTestCase ()
+  : TestCase ("Check ObjectAccounting counts live instances")
+{
+}
+
+void
+ObjectAccountingTestCase::CreateItem (void)
+{
+  m_items.push_back (Create<AccountedItem> ());
+}
+
+void
+ObjectAccountingTestCase::DoRun (void)
+{
+  if (!ObjectAccounting::IsEnabled ())
+    {
+      std::ostringstream oss;
+      ObjectAccounting::Print (oss);
+      NS_TEST_ASSERT_MSG_NE (oss.str ().find ("--enable-object-accounting"), std::string::npos,
+                             "Print does not tell how to enable accounting");
+      NS_TEST_ASSERT_MSG_EQ (ObjectAccounting::GetRecord ("ns3::AccountedObject").created, 0,
+                             "Objects counted while accounting is disabled");
+      return;
+    }
+
+  const std::string objectName = "ns3::AccountedObject";
+  ObjectAccounting::Record before = ObjectAccounting::GetRecord (objectName);
+  {
+    Ptr<AccountedObject> a = CreateObject<AccountedObject> ();
+    Ptr<AccountedObject> b = CreateObject<AccountedObject> ();
+    ObjectAccounting::Record during = ObjectAccounting::GetRecord (objectName);
+    NS_TEST_ASSERT_MSG_EQ (during.live, before.live + 2, "Wrong number of live objects");
+    NS_TEST_ASSERT_MSG_EQ (during.created, before.created + 2, "Wrong number of created objects");
+    NS_TEST_ASSERT_MSG_EQ (during.bytes, during.live * sizeof (AccountedObject), "Wrong object bytes");
+  }
+  ObjectAccounting::Record after = ObjectAccounting::GetRecord (objectName);
+  NS_TEST_ASSERT_MSG_EQ (after.live, before.live, "Objects not counted when deleted");
+  NS_TEST_ASSERT_MSG_EQ (after.created, before.created + 2, "Wrong number of created objects");
+
+  // SimpleRefCount instances are counted by C++ type, and attributed
+  // to the context they are created in.
+  const std::string itemName = "(anonymous namespace)::AccountedItem";
+  ObjectAccounting::Record items = ObjectAccounting::GetRecord (itemName);
+  Simulator::ScheduleWithContext (7, Seconds (1), &ObjectAccountingTestCase::CreateItem, this);
+  Simulator::ScheduleWithContext (7, Seconds (2), &ObjectAccountingTestCase::CreateItem, this);
+  Simulator::ScheduleWithContext (9, Seconds (3), &ObjectAccountingTestCase::CreateItem, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (ObjectAccounting::GetRecord (itemName).live, items.live + 3,
+                         "Wrong number of live items");
+  NS_TEST_ASSERT_MSG_EQ (ObjectAccounting::GetRecord (itemName, 7).live, 2,
+                         "Wrong number of live items in context 7");
+  NS_TEST_ASSERT_MSG_EQ (ObjectAccounting::GetRecord (itemName, 9).bytes, sizeof (AccountedItem),
+                         "Wrong item bytes in context 9");
+
+  std::ostringstream oss;
+  ObjectAccounting::Print (oss, 0, true);
+  NS_TEST_ASSERT_MSG_NE (oss.str ().find (itemName), std::string::npos,
+                         "Items not printed");
+
+  m_items.clear ();
+  NS_TEST_ASSERT_MSG_EQ (ObjectAccounting::GetRecord (itemName, 7).live, 0,
+                         "Items not counted when deleted");
+}
+
+class ObjectAccountingTestSuite : public TestSuite
+{
+public:
+  ObjectAccountingTestSuite ();
+};
+
+ObjectAccountingTestSuite::ObjectAccountingTestSuite ()
+  : TestSuite ("object-accounting", UNIT)
+{
+  AddTestCase (new ObjectAccountingTestCase, TestCase::QUICK);
+}
+
+static ObjectAccountingTestSuite g_objectAccountingTestSuite;
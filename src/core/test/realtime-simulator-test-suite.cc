@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/realtime-simulator-impl.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/nstime.h"
+#include <sstream>
+
+using namespace ns3;
+
+// ===========================================================================
+// Test the busy-polling synchronizer and the lateness histogram
+// ===========================================================================
+class RealtimeLatenessTestCase : public TestCase
+{
+public:
+  RealtimeLatenessTestCase ();
+  virtual ~RealtimeLatenessTestCase () {}
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  /** Count an event. */
+  void Event (void);
+
+  uint32_t m_events; //!< The number of events run.
+};
+
+RealtimeLatenessTestCase::RealtimeLatenessTestCase ()
+  : TestCase ("Check realtime busy-polling and the lateness histogram"),
+    m_events (0)
+{
+}
+
+void
+RealtimeLatenessTestCase::DoSetup (void)
+{
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::RealtimeSimulatorImpl"));
+  Config::SetDefault ("ns3::WallClockSynchronizer::BusyPollThreshold", TimeValue (MicroSeconds (500)));
+}
+
+void
+RealtimeLatenessTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::WallClockSynchronizer::BusyPollThreshold", TimeValue (Seconds (0)));
+  Config::SetGlobal ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+}
+
+void
+RealtimeLatenessTestCase::Event (void)
+{
+  m_events++;
+}
+
+void
+RealtimeLatenessTestCase::DoRun (void)
+{
+  const uint32_t n = 50;
+  for (uint32_t i = 1; i <= n; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (200 * i), &RealtimeLatenessTestCase::Event, this);
+    }
+  // The realtime simulator keeps waiting for real time events until stopped.
+  Simulator::Stop (MicroSeconds (200 * (n + 1)));
+  Simulator::Run ();
+
+  Ptr<RealtimeSimulatorImpl> impl = DynamicCast<RealtimeSimulatorImpl> (Simulator::GetImplementation ());
+  NS_TEST_ASSERT_MSG_NE (impl, 0, "Not running the realtime simulator");
+  NS_TEST_ASSERT_MSG_EQ (m_events, n, "Events lost");
+  std::vector<uint64_t> histogram = impl->GetLatenessHistogram ();
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < histogram.size (); ++i)
+    {
+      total += histogram[i];
+    }
+  // The stop event is counted too.
+  NS_TEST_ASSERT_MSG_EQ (total, n + 1, "Lateness not recorded for every event");
+  NS_TEST_ASSERT_MSG_GT (histogram.back (), 0, "Trailing empty bucket");
+  NS_TEST_ASSERT_MSG_LT (impl->GetMaxLateness (), TimeStep (uint64_t (1) << histogram.size ()),
+                         "Largest lateness outside the histogram");
+
+  std::ostringstream oss;
+  impl->PrintLateness (oss);
+  NS_TEST_ASSERT_MSG_NE (oss.str ().find ("51 events"), std::string::npos,
+                         "Wrong event count printed");
+  impl->ResetLateness ();
+  NS_TEST_ASSERT_MSG_EQ (impl->GetLatenessHistogram ().size (), 0, "Histogram not reset");
+
+  Simulator::Destroy ();
+}
+
+class RealtimeSimulatorTestSuite : public TestSuite
+{
+public:
+  RealtimeSimulatorTestSuite ();
+};
+
+RealtimeSimulatorTestSuite::RealtimeSimulatorTestSuite ()
+  : TestSuite ("realtime-simulator", UNIT)
+{
+  AddTestCase (new RealtimeLatenessTestCase, TestCase::QUICK);
+}
+
+static RealtimeSimulatorTestSuite g_realtimeSimulatorTestSuite;
@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/replication-runner.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/double.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace ns3;
+
+/// Sum of the random delays drawn by the current replication.
+static double g_replicationSum;
+
+/**
+ * Record one random delay and schedule the next one.
+ * \param [in] rng The random variable.
+ * \param [in] left The number of events left to schedule.
+ */
+static void
+ReplicationEvent (Ptr<UniformRandomVariable> rng, uint32_t left)
+{
+  double delay = rng->GetValue ();
+  g_replicationSum += delay;
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (delay), &ReplicationEvent, rng, left - 1);
+    }
+}
+
+/**
+ * A replication which runs a short chain of random delays.
+ * \param [in] run The run number.
+ * \returns The metrics of the replication.
+ */
+static ReplicationRunner::Metrics
+Replicate (uint32_t run)
+{
+  g_replicationSum = 0;
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetAttribute ("Max", DoubleValue (100));
+  Simulator::Schedule (Seconds (0), &ReplicationEvent, rng, 100);
+  Simulator::Run ();
+  ReplicationRunner::Metrics metrics;
+  metrics["run"] = run;
+  metrics["sum"] = g_replicationSum;
+  metrics["end"] = Simulator::Now ().GetSeconds ();
+  return metrics;
+}
+
+// ===========================================================================
+// Test that replications run independently with their own run numbers
+// ===========================================================================
+class ReplicationRunnerTestCase : public TestCase
+{
+public:
+  ReplicationRunnerTestCase ();
+  virtual ~ReplicationRunnerTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+ReplicationRunnerTestCase::ReplicationRunnerTestCase ()
+  : TestCase ("Check ReplicationRunner runs and merges replications")
+{
+}
+
+void
+ReplicationRunnerTestCase::DoRun (void)
+{
+  ReplicationRunner runner (MakeCallback (&Replicate));
+  runner.SetRuns (3, 4);
+  runner.SetMaxJobs (2);
+  runner.Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (runner.GetN (), 4, "Wrong number of replications");
+  for (uint32_t i = 0; i < runner.GetN (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (runner.GetRun (i), 3 + i, "Wrong run number");
+      ReplicationRunner::Metrics metrics = runner.GetMetrics (i);
+      NS_TEST_ASSERT_MSG_EQ (metrics["run"], runner.GetRun (i), "Metrics reported out of order");
+      NS_TEST_ASSERT_MSG_GT (metrics["sum"], 0, "Replication did not run");
+    }
+  NS_TEST_ASSERT_MSG_NE (runner.GetMetrics (0).find ("sum")->second,
+                         runner.GetMetrics (1).find ("sum")->second,
+                         "Different runs gave the same results");
+
+  // The same run in another process gives the same results.
+  ReplicationRunner again (MakeCallback (&Replicate));
+  again.SetRuns (4, 1);
+  again.Run ();
+  NS_TEST_ASSERT_MSG_EQ (again.GetMetrics (0).find ("sum")->second,
+                         runner.GetMetrics (1).find ("sum")->second,
+                         "Replication is not reproducible");
+
+  std::map<std::string, ReplicationRunner::Summary> summary = runner.GetSummary ();
+  NS_TEST_ASSERT_MSG_EQ (summary["run"].count, 4, "Wrong count in summary");
+  NS_TEST_ASSERT_MSG_EQ_TOL (summary["run"].mean, 4.5, 1e-12, "Wrong mean in summary");
+  NS_TEST_ASSERT_MSG_EQ_TOL (summary["run"].stddev, 1.2909944487358056, 1e-12, "Wrong standard deviation in summary");
+  NS_TEST_ASSERT_MSG_EQ (summary["run"].min, 3, "Wrong minimum in summary");
+  NS_TEST_ASSERT_MSG_EQ (summary["run"].max, 6, "Wrong maximum in summary");
+}
+
+/**
+ * Return the wall clock time, shared by all the processes.
+ * \returns The time in seconds.
+ */
+static double
+WallClock (void)
+{
+  return std::chrono::duration<double> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/**
+ * A replication which takes much longer for the first run.
+ * \param [in] run The run number.
+ * \returns The start and end wall clock times of the replication.
+ */
+static ReplicationRunner::Metrics
+SlowFirstReplicate (uint32_t run)
+{
+  ReplicationRunner::Metrics metrics;
+  metrics["start"] = WallClock ();
+  std::this_thread::sleep_for (std::chrono::milliseconds (run == 1 ? 1000 : 10));
+  metrics["end"] = WallClock ();
+  return metrics;
+}
+
+// ===========================================================================
+// Test that a slow replication does not hold back the free job slots
+// ===========================================================================
+class ReplicationRunnerSlowTestCase : public TestCase
+{
+public:
+  ReplicationRunnerSlowTestCase ();
+  virtual ~ReplicationRunnerSlowTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+ReplicationRunnerSlowTestCase::ReplicationRunnerSlowTestCase ()
+  : TestCase ("Check ReplicationRunner refills the slot of the first replication done")
+{
+}
+
+void
+ReplicationRunnerSlowTestCase::DoRun (void)
+{
+  ReplicationRunner runner (MakeCallback (&SlowFirstReplicate));
+  runner.SetRuns (1, 5);
+  runner.SetMaxJobs (2);
+  runner.Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (runner.GetN (), 5, "Wrong number of replications");
+  double slowEnd = runner.GetMetrics (0).find ("end")->second;
+  for (uint32_t i = 2; i < runner.GetN (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_LT (runner.GetMetrics (i).find ("start")->second, slowEnd,
+                             "Run " << runner.GetRun (i) << " waited for the slow run");
+    }
+}
+
+class ReplicationRunnerTestSuite : public TestSuite
+{
+public:
+  ReplicationRunnerTestSuite ();
+};
+
+ReplicationRunnerTestSuite::ReplicationRunnerTestSuite ()
+  : TestSuite ("replication-runner", UNIT)
+{
+  AddTestCase (new ReplicationRunnerTestCase, TestCase::QUICK);
+  AddTestCase (new ReplicationRunnerSlowTestCase, TestCase::QUICK);
+}
+
+static ReplicationRunnerTestSuite g_replicationRunnerTestSuite;
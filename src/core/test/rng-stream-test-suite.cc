@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/rng-stream.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+// ===========================================================================
+// Test that batched draws from RngStream follow the single step sequence
+// ===========================================================================
+class RngStreamBatchTestCase : public TestCase
+{
+public:
+  RngStreamBatchTestCase ();
+  virtual ~RngStreamBatchTestCase () {}
+
+private:
+  virtual void DoRun (void);
+};
+
+RngStreamBatchTestCase::RngStreamBatchTestCase ()
+  : TestCase ("Check RngStream batched draws against single draws")
+{
+}
+
+void
+RngStreamBatchTestCase::DoRun (void)
+{
+  // Known answer: first MRG32k3a value with all seeds at 12345.
+  RngStream reference (12345, 0, 0);
+  NS_TEST_ASSERT_MSG_EQ_TOL (reference.RandU01 (), 0.12701112204657714, 1e-15,
+                             "First MRG32k3a value differs from the reference");
+
+  const uint32_t n = 1000;
+  RngStream single (1, 2, 3);
+  std::vector<double> expected (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      expected[i] = single.RandU01 ();
+    }
+
+  // Interleave single draws and batches of sizes which straddle
+  // the internal buffer.
+  RngStream batched (1, 2, 3);
+  std::vector<double> values (n);
+  uint32_t i = 0;
+  uint32_t size = 1;
+  while (i < n)
+    {
+      values[i] = batched.RandU01 ();
+      ++i;
+      uint32_t count = std::min (size, n - i);
+      batched.RandU01 (&values[i], count);
+      i += count;
+      size = (size * 3 + 1) % 41;
+    }
+  for (i = 0; i < n; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (values[i], expected[i], "Batched value " << i << " differs");
+    }
+
+  // A copy continues the sequence, even with values generated ahead.
+  RngStream original (1, 2, 3);
+  original.RandU01 ();
+  RngStream copy (original);
+  for (i = 1; i < 40; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (copy.RandU01 (), expected[i], "Copied stream value " << i << " differs");
+    }
+}
+
+// ===========================================================================
+// Test RandomVariableStream::GetValues
+// ===========================================================================
+class RandomVariableStreamGetValuesTestCase : public TestCase
+{
+public:
+  RandomVariableStreamGetValuesTestCase ();
+  virtual ~RandomVariableStreamGetValuesTestCase () {}
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Check GetValues against GetValue on two identical streams.
+   * \param [in] single The stream to draw from one value at a time.
+   * \param [in] batched The stream to draw from in batches.
+   */
+  void Check (Ptr<RandomVariableStream> single, Ptr<RandomVariableStream> batched);
+};
+
+RandomVariableStreamGetValuesTestCase::RandomVariableStreamGetValuesTestCase ()
+  : TestCase ("Check RandomVariableStream::GetValues against GetValue")
+{
+}
+
+void
+RandomVariableStreamGetValuesTestCase::Check (Ptr<RandomVariableStream> single,
+                                              Ptr<RandomVariableStream> batched)
+{
+  single->SetStream (7);
+  batched->SetStream (7);
+  double values[37];
+  for (uint32_t round = 0; round < 5; ++round)
+    {
+      batched->GetValues (values, 37);
+      for (uint32_t i = 0; i < 37; ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (values[i], single->GetValue (), "Batched value " << i << " differs");
+        }
+    }
+}
+
+void
+RandomVariableStreamGetValuesTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> u1 = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> u2 = CreateObject<UniformRandomVariable> ();
+  u1->SetAttribute ("Min", DoubleValue (-3));
+  u2->SetAttribute ("Min", DoubleValue (-3));
+  u1->SetAttribute ("Max", DoubleValue (5));
+  u2->SetAttribute ("Max", DoubleValue (5));
+  Check (u1, u2);
+
+  u1->SetAttribute ("Antithetic", BooleanValue (true));
+  u2->SetAttribute ("Antithetic", BooleanValue (true));
+  Check (u1, u2);
+
+  // The default implementation, through GetValue.
+  Check (CreateObject<ExponentialRandomVariable> (), CreateObject<ExponentialRandomVariable> ());
+}
+
+class RngStreamTestSuite : public TestSuite
+{
+public:
+  RngStreamTestSuite ();
+};
+
+RngStreamTestSuite::RngStreamTestSuite ()
+  : TestSuite ("rng-stream", UNIT)
+{
+  AddTestCase (new RngStreamBatchTestCase, TestCase::QUICK);
+  AddTestCase (new RandomVariableStreamGetValuesTestCase, TestCase::QUICK);
+}
+
+static RngStreamTestSuite g_rngStreamTestSuite;
@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Build this file as if ns-3 had been configured with
+// --disable-trace-sources, whatever the actual configuration.
+// The TracedCallback below is only instantiated with a type private
+// to this file, so no other translation unit sees it differently.
+#ifndef NS3_TRACE_SOURCES_DISABLE
+#define NS3_TRACE_SOURCES_DISABLE
+#endif
+
+#include "ns3/test.h"
+#include "ns3/traced-callback.h"
+#include "ns3/unused.h"
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \ingroup tests
+ *
+ * Argument type private to this file.
+ */
+struct DisabledTraceArg
+{
+  int value; //!< The value traced
+};
+
+} // unnamed namespace
+
+/**
+ * \ingroup tests
+ *
+ * \brief Check that a TracedCallback does nothing when trace sources
+ * are disabled, while connecting still checks the Callback signature.
+ */
+class DisabledTracedCallbackTestCase : public TestCase
+{
+public:
+  DisabledTracedCallbackTestCase ();
+  virtual ~DisabledTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Trace sink.
+   * \param [in] arg The traced argument.
+   */
+  void Sink (DisabledTraceArg arg);
+  /**
+   * Trace sink with context.
+   * \param [in] context The context.
+   * \param [in] arg The traced argument.
+   */
+  void ContextSink (std::string context, DisabledTraceArg arg);
+
+  uint32_t m_calls; //!< The number of sink invocations
+};
+
+DisabledTracedCallbackTestCase::DisabledTracedCallbackTestCase ()
+  : TestCase ("Check TracedCallback with --disable-trace-sources")
+{
+}
+
+void
+DisabledTracedCallbackTestCase::Sink (DisabledTraceArg arg)
+{
+  NS_UNUSED (arg);
+  m_calls++;
+}
+
+void
+DisabledTracedCallbackTestCase::ContextSink (std::string context, DisabledTraceArg arg)
+{
+  NS_UNUSED (context);
+  NS_UNUSED (arg);
+  m_calls++;
+}
+
+void
+DisabledTracedCallbackTestCase::DoRun (void)
+{
+  TracedCallback<DisabledTraceArg> trace;
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "New TracedCallback is not empty");
+
+  trace.ConnectWithoutContext (MakeCallback (&DisabledTracedCallbackTestCase::Sink, this));
+  trace.Connect (MakeCallback (&DisabledTracedCallbackTestCase::ContextSink, this), "/path");
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "Connected TracedCallback is not empty");
+
+  m_calls = 0;
+  DisabledTraceArg arg = { 1 };
+  trace (arg);
+  NS_TEST_ASSERT_MSG_EQ (m_calls, 0, "Disabled TracedCallback invoked a sink");
+
+  trace.DisconnectWithoutContext (MakeCallback (&DisabledTracedCallbackTestCase::Sink, this));
+  trace.Disconnect (MakeCallback (&DisabledTracedCallbackTestCase::ContextSink, this), "/path");
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "Disconnected TracedCallback is not empty");
+}
+
+/**
+ * \ingroup tests
+ *
+ * \brief TracedCallback with trace sources disabled TestSuite
+ */
+class DisabledTracedCallbackTestSuite : public TestSuite
+{
+public:
+  DisabledTracedCallbackTestSuite ();
+};
+
+DisabledTracedCallbackTestSuite::DisabledTracedCallbackTestSuite ()
+  : TestSuite ("traced-callback-disabled", UNIT)
+{
+  AddTestCase (new DisabledTracedCallbackTestCase, TestCase::QUICK);
+}
+
+static DisabledTracedCallbackTestSuite g_disabledTracedCallbackTestSuite; //!< Static variable for test initialization
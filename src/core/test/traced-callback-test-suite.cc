@@ -67,6 +67,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   // these methods do is to set corresponding member variables m_one and m_two.
   //
   TracedCallback<uint8_t, double> trace;
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "New TracedCallback is not empty");
 
   //
   // Connect both callbacks to their respective test methods.  If we hit the 
@@ -75,6 +76,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   //
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbOne, this));
   trace.ConnectWithoutContext (MakeCallback (&BasicTracedCallbackTestCase::CbTwo, this));
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), false, "Connected TracedCallback is empty");
   m_one = false;
   m_two = false;
   trace (1, 2);
@@ -100,6 +102,7 @@ BasicTracedCallbackTestCase::DoRun (void)
   trace (1, 2);
   NS_TEST_ASSERT_MSG_EQ (m_one, false, "Callback CbOne unexpectedly called");
   NS_TEST_ASSERT_MSG_EQ (m_two, false, "Callback CbTwo unexpectedly called");
+  NS_TEST_ASSERT_MSG_EQ (trace.IsEmpty (), true, "Disconnected TracedCallback is not empty");
 
   //
   // If we connect them back up, then both callbacks should be called.
@@ -113,6 +116,105 @@ BasicTracedCallbackTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_two, true, "Callback CbTwo not called");
 }
 
+/**
+ * \ingroup tests
+ *
+ * \brief Check that Callbacks disconnecting themselves, or each other,
+ * while the chain is invoked do not make the chain skip a Callback.
+ */
+class DisconnectTracedCallbackTestCase : public TestCase
+{
+public:
+  DisconnectTracedCallbackTestCase ();
+  virtual ~DisconnectTracedCallbackTestCase () {}
+
+private:
+  virtual void DoRun (void);
+
+  void CbOne (uint32_t a);
+  void CbTwo (uint32_t a);
+  void CbThree (uint32_t a);
+
+  TracedCallback<uint32_t> m_trace;
+  uint32_t m_one;
+  uint32_t m_two;
+  uint32_t m_three;
+};
+
+DisconnectTracedCallbackTestCase::DisconnectTracedCallbackTestCase ()
+  : TestCase ("Check disconnecting Callbacks while the chain is invoked")
+{
+}
+
+void
+DisconnectTracedCallbackTestCase::CbOne (uint32_t a)
+{
+  m_one++;
+  if (a == 1)
+    {
+      m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbOne, this));
+    }
+}
+
+void
+DisconnectTracedCallbackTestCase::CbTwo (uint32_t a)
+{
+  m_two++;
+  if (a == 2)
+    {
+      m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbThree, this));
+      m_trace.DisconnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbTwo, this));
+      // Invoke the chain again while it is invoked
+      m_trace (0);
+    }
+}
+
+void
+DisconnectTracedCallbackTestCase::CbThree (uint32_t a)
+{
+  NS_UNUSED (a);
+  m_three++;
+}
+
+void
+DisconnectTracedCallbackTestCase::DoRun (void)
+{
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbOne, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbTwo, this));
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbThree, this));
+  m_one = 0;
+  m_two = 0;
+  m_three = 0;
+
+  //
+  // CbOne disconnects itself: the Callbacks after it are still called.
+  //
+  m_trace (1);
+  NS_TEST_ASSERT_MSG_EQ (m_one, 1, "Callback CbOne not called");
+  NS_TEST_ASSERT_MSG_EQ (m_two, 1, "Callback CbTwo skipped after CbOne disconnected");
+  NS_TEST_ASSERT_MSG_EQ (m_three, 1, "Callback CbThree skipped after CbOne disconnected");
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_one, 1, "Disconnected callback CbOne called");
+  NS_TEST_ASSERT_MSG_EQ (m_two, 2, "Callback CbTwo not called");
+  NS_TEST_ASSERT_MSG_EQ (m_three, 2, "Callback CbThree not called");
+
+  //
+  // CbTwo disconnects CbThree and itself, then invokes the chain again:
+  // neither is called after being disconnected, and the chain ends up empty.
+  //
+  m_trace (2);
+  NS_TEST_ASSERT_MSG_EQ (m_two, 3, "Callback CbTwo not called once");
+  NS_TEST_ASSERT_MSG_EQ (m_three, 2, "Disconnected callback CbThree called");
+  NS_TEST_ASSERT_MSG_EQ (m_trace.IsEmpty (), true, "Disconnected TracedCallback is not empty");
+
+  //
+  // The chain works as usual afterwards.
+  //
+  m_trace.ConnectWithoutContext (MakeCallback (&DisconnectTracedCallbackTestCase::CbThree, this));
+  m_trace (0);
+  NS_TEST_ASSERT_MSG_EQ (m_three, 3, "Reconnected callback CbThree not called");
+}
+
 class TracedCallbackTestSuite : public TestSuite
 {
 public:
@@ -122,7 +224,11 @@ public:
 TracedCallbackTestSuite::TracedCallbackTestSuite ()
   : TestSuite ("traced-callback", UNIT)
 {
+#ifndef NS3_TRACE_SOURCES_DISABLE
+  // traced-callback-disabled checks the trace sources compiled away
   AddTestCase (new BasicTracedCallbackTestCase, TestCase::QUICK);
+  AddTestCase (new DisconnectTracedCallbackTestCase, TestCase::QUICK);
+#endif
 }
 
 static TracedCallbackTestSuite tracedCallbackTestSuite;
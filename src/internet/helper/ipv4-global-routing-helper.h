@@ -71,6 +71,21 @@ public:
    *
    */
   static void PopulateRoutingTables (void);
+  /**
+   * \brief Build a routing database and let the nodes in the simulation
+   * find their routes on demand.  Makes all nodes in the simulation into
+   * routers.
+   *
+   * Instead of populating the routing tables, each node computes its
+   * routes to a destination when it first looks the destination up, and
+   * keeps them in a route cache of the Ipv4GlobalRouting::RouteCacheSize
+   * destinations it looked up last.  The memory used then grows with the
+   * destinations in use, at the cost of a shortest path calculation for
+   * each destination missing from the cache.
+   *
+   * \see GlobalRouteManager::InitializeRoutesOnDemand
+   */
+  static void PopulateRoutingTablesOnDemand (void);
   /**
    * \brief Remove all routes that were previously installed in a prior call
    * to either PopulateRoutingTables() or RecomputeRoutingTables(), and 
@@ -82,6 +97,8 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * Only the routers that can reach a changed part of the topology have
+   * their routes recomputed; see GlobalRouteManager::UpdateRoutes ().
    */
   static void RecomputeRoutingTables (void);
 private:
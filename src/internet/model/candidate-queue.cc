@@ -16,8 +16,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
-#include <algorithm>
 #include <iostream>
+#include <vector>
 #include "ns3/log.h"
 #include "ns3/assert.h"
 #include "candidate-queue.h"
@@ -57,16 +57,31 @@ operator<< (std::ostream& os, const CandidateQueue& q)
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->second->GetVertexId () << ", "
+      << iter->second->GetDistanceFromRoot () << ", "
+      << iter->second->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
+bool
+CandidateQueue::CandidateKey::operator< (const CandidateKey &other) const
+{
+  if (distance != other.distance)
+    {
+      return distance < other.distance;
+    }
+  if (router != other.router)
+    {
+      return !router;
+    }
+  return order < other.order;
+}
+
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,16 +104,33 @@ CandidateQueue::Clear (void)
     }
 }
 
+void
+CandidateQueue::Insert (SPFVertex *v)
+{
+  CandidateKey key;
+  key.distance = v->GetDistanceFromRoot ();
+  key.router = v->GetVertexType () == SPFVertex::VertexRouter;
+  key.order = m_order++;
+  m_candidates.insert (std::make_pair (key, v));
+  m_keys[v] = key;
+}
+
+void
+CandidateQueue::Remove (SPFVertex *v)
+{
+  std::unordered_map<const SPFVertex*, CandidateKey>::iterator key = m_keys.find (v);
+  NS_ASSERT (key != m_keys.end ());
+  m_candidates.erase (key->second);
+  m_keys.erase (key);
+}
+
 void
 CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Insert (vNew);
+  m_ids.insert (std::make_pair (vNew->GetVertexId (), vNew));
 }
 
 SPFVertex *
@@ -110,8 +142,18 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.begin ()->second;
+  Remove (v);
+  typedef std::multimap<Ipv4Address, SPFVertex*>::iterator Iter_t;
+  std::pair<Iter_t, Iter_t> range = m_ids.equal_range (v->GetVertexId ());
+  for (Iter_t i = range.first; i != range.second; ++i)
+    {
+      if (i->second == v)
+        {
+          m_ids.erase (i);
+          break;
+        }
+    }
   return v;
 }
 
@@ -124,7 +166,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.begin ()->second;
 }
 
 bool
@@ -145,18 +187,20 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  typedef std::multimap<Ipv4Address, SPFVertex*>::const_iterator CIter_t;
+  std::pair<CIter_t, CIter_t> range = m_ids.equal_range (addr);
+  SPFVertex *first = 0;
+  CandidateKey firstKey = CandidateKey ();
+  for (CIter_t i = range.first; i != range.second; ++i)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
+      const CandidateKey &key = m_keys.find (i->second)->second;
+      if (first == 0 || key < firstKey)
         {
-          return v;
+          first = i->second;
+          firstKey = key;
         }
     }
-
-  return 0;
+  return first;
 }
 
 void
@@ -164,37 +208,32 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // Requeue, in their current order, the vertices whose distance changed
+  std::vector<SPFVertex*> changed;
+  for (CandidateList_t::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      if (i->first.distance != i->second->GetDistanceFromRoot ())
+        {
+          changed.push_back (i->second);
+        }
+    }
+  for (std::vector<SPFVertex*>::const_iterator i = changed.begin (); i != changed.end (); i++)
+    {
+      Remove (*i);
+      Insert (*i);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
-/*
- * In this implementation, SPFVertex follows the ordering where
- * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
- * In case of a tie, NetworkLSA is always ranked before RouterLSA.
- *
- * This ordering is necessary for implementing ECMP
- */
-bool 
-CandidateQueue::CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
+void
+CandidateQueue::Reorder (SPFVertex *v)
 {
-  NS_LOG_FUNCTION (&v1 << &v2);
+  NS_LOG_FUNCTION (this << v);
 
-  bool result = false;
-  if (v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ())
-    {
-      result = true;
-    }
-  else if (v1->GetDistanceFromRoot () == v2->GetDistanceFromRoot ())
-    {
-      if (v1->GetVertexType () == SPFVertex::VertexNetwork 
-          && v2->GetVertexType () == SPFVertex::VertexRouter)
-        {
-          result = true;
-        }
-    }
-  return result;
+  NS_ASSERT (m_keys.find (v)->second.distance >= v->GetDistanceFromRoot ());
+  Remove (v);
+  Insert (v);
 }
 
 } // namespace ns3
@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,11 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The vertices are kept in a map keyed by their distance when they were
+ * pushed or reordered, so Push (), Pop (), Find () and the Reorder () of
+ * a vertex take a logarithmic time.  Vertices at the same distance are
+ * popped networks first, then in the order they were pushed.
  */
 class CandidateQueue
 {
@@ -148,12 +154,23 @@ public:
  * increasing distance.
  *
  * This method is provided in case the values of m_distanceFromRoot change
- * during the routing calculations.
+ * during the routing calculations; they may only decrease.
  *
  * @see SPFVertex
  */
   void Reorder (void);
 
+/**
+ * @brief Reorders the Candidate Queue after the distance of one of its
+ * vertices decreased.
+ *
+ * This is equivalent to Reorder (), in a logarithmic time.
+ *
+ * @see SPFVertex
+ * @param v The vertex whose m_distanceFromRoot decreased.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -171,21 +188,42 @@ private:
  * \return copied object
  */
   CandidateQueue& operator= (CandidateQueue& sr);
-/**
- * \brief return true if v1 < v2
- *
- * SPFVertexes are added into the queue according to the ordering
- * defined by this method. If v1 should be popped before v2, this 
- * method return true; false otherwise
- *
- * \param v1 first operand
- * \param v2 second operand
- * \return True if v1 should be popped before v2; false otherwise
- */
-  static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
+  /**
+   * The position of a vertex in the queue.
+   *
+   * A vertex is ranked first if its distance is smaller; in case of a
+   * tie, a NetworkLSA is ranked before a RouterLSA, then the vertex
+   * queued first.  This ordering is necessary for implementing ECMP.
+   */
+  struct CandidateKey
+  {
+    uint32_t distance;  //!< The distance from the root when queued.
+    bool router;        //!< Whether the vertex is a router, queued after networks.
+    uint64_t order;     //!< The queuing order.
+    /**
+     * \param other Another key.
+     * \returns Whether this key is popped before the other.
+     */
+    bool operator< (const CandidateKey &other) const;
+  };
+
+  /**
+   * \brief Queue a vertex after the vertices at the same distance.
+   * \param v The vertex.
+   */
+  void Insert (SPFVertex *v);
+  /**
+   * \brief Remove a vertex from the queue.
+   * \param v The vertex.
+   */
+  void Remove (SPFVertex *v);
+
+  typedef std::map<CandidateKey, SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers, in popping order
   CandidateList_t m_candidates;  //!< SPFVertex candidates
+  std::unordered_map<const SPFVertex*, CandidateKey> m_keys; //!< The keys of the candidates
+  std::multimap<Ipv4Address, SPFVertex*> m_ids; //!< The candidates, by vertex ID
+  uint64_t m_order;  //!< The queuing order of the next vertex queued
 
   /**
    * \brief Stream insertion operator.
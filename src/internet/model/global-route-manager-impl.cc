@@ -30,9 +30,16 @@
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
 #include "global-router-interface.h"
@@ -44,6 +51,30 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads calculating the global routes.
+ */
+static GlobalValue g_globalRoutingThreads =
+  GlobalValue ("GlobalRoutingThreads",
+               "The number of threads calculating the global routes.  "
+               "The routes are the same whatever the number of threads; "
+               "a single thread is used while the calculation is logged.",
+               UintegerValue (1),
+               MakeUintegerChecker<uint32_t> (1));
+
+/**
+ * \ingroup globalrouting
+ * The number of routers whose routes are kept when the routes are found
+ * on demand.
+ */
+static GlobalValue g_globalRoutingSpfCacheSize =
+  GlobalValue ("GlobalRoutingSpfCacheSize",
+               "The number of routers whose routes, calculated when the routes "
+               "are found on demand, are kept for their next lookups.",
+               UintegerValue (64),
+               MakeUintegerChecker<uint32_t> (1));
+
 /**
  * \brief Stream insertion operator.
  *
@@ -468,9 +499,29 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the transit link records, keeping the LSA with the smallest
+// address when several have the same link data.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LSDBMap_t::iterator i = m_linkDataIndex.find (lr->GetLinkData ());
+          if (i == m_linkDataIndex.end ())
+            {
+              m_linkDataIndex.insert (LSDBPair_t (lr->GetLinkData (), lsa));
+            }
+          else if (addr < i->second->GetLinkStateId ())
+            {
+              i->second = lsa;
+            }
+        }
     }
 }
 
@@ -495,13 +546,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,26 +559,23 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of one of its transit link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return i->second;
     }
   return 0;
 }
 
+const std::map<Ipv4Address, GlobalRoutingLSA*>&
+GlobalRouteManagerLSDB::GetLSAs () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_database;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
@@ -539,16 +584,40 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_ownsLsdb (true),
+    m_router (0),
+    m_checkStubs (false),
+    m_jobs (0),
+    m_firstJob (0),
+    m_jobStride (1),
+    m_routersValid (false),
+    m_routesOnDemand (false)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb)
+  :
+    m_spfroot (0),
+    m_lsdb (lsdb),
+    m_ownsLsdb (false),
+    m_router (0),
+    m_checkStubs (false),
+    m_jobs (0),
+    m_firstJob (0),
+    m_jobStride (1),
+    m_routersValid (false),
+    m_routesOnDemand (false)
+{
+  NS_LOG_FUNCTION (this << lsdb);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
@@ -558,11 +627,13 @@ void
 GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
 {
   NS_LOG_FUNCTION (this << lsdb);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
   m_lsdb = lsdb;
+  m_ownsLsdb = true;
+  m_routersValid = false;
 }
 
 void
@@ -578,19 +649,12 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
+      NS_LOG_LOGIC ("Deleting routes from node " << node->GetId ());
+      RemoveRoutes (router->GetRoutingProtocol ());
+      if (m_routesOnDemand)
         {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
+          router->GetRoutingProtocol ()->SetRoutesOnDemand (false);
         }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
     }
   if (m_lsdb)
     {
@@ -598,6 +662,26 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_routers.clear ();
+  m_routersValid = false;
+  m_routesOnDemand = false;
+  SetRoutesOnDemand ();
+}
+
+void
+GlobalRouteManagerImpl::RemoveRoutes (Ptr<Ipv4GlobalRouting> gr)
+{
+  NS_LOG_FUNCTION (this << gr);
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes");
 }
 
 //
@@ -611,6 +695,14 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
 //
 void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase () 
+{
+  NS_LOG_FUNCTION (this);
+  m_routersValid = false;
+  DiscoverLSAs ();
+}
+
+void
+GlobalRouteManagerImpl::DiscoverLSAs () 
 {
   NS_LOG_FUNCTION (this);
 //
@@ -700,6 +792,288 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  GetRouters (m_routers);
+  FindComponents ();
+  std::vector<Router*> routers;
+  for (std::vector<Router>::iterator i = m_routers.begin (); i != m_routers.end (); i++)
+    {
+      if (m_routesOnDemand && i->routing)
+        {
+          i->routing->SetRoutesOnDemand (false);
+        }
+      if (i->calculate)
+        {
+          routers.push_back (&*i);
+        }
+    }
+  m_routesOnDemand = false;
+  SetRoutesOnDemand ();
+  CalculateRoutes (routers);
+  m_routersValid = true;
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::InitializeRoutesOnDemand ()
+{
+  NS_LOG_FUNCTION (this);
+  GetRouters (m_routers);
+  FindComponents ();
+  for (std::vector<Router>::iterator i = m_routers.begin (); i != m_routers.end (); i++)
+    {
+      if (i->routing)
+        {
+          i->routing->SetRoutesOnDemand (true);
+        }
+    }
+  m_routesOnDemand = true;
+  SetRoutesOnDemand ();
+  m_routersValid = true;
+}
+
+void
+GlobalRouteManagerImpl::SetRoutesOnDemand ()
+{
+  NS_LOG_FUNCTION (this);
+  m_routerIndex.clear ();
+  m_spfCache.clear ();
+  m_spfCacheIndex.clear ();
+  if (!m_routesOnDemand)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < m_routers.size (); i++)
+    {
+      if (m_routers[i].routing)
+        {
+          m_routerIndex[PeekPointer (m_routers[i].routing)] = i;
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::GetRoutesTo (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest,
+                                     Ipv4GlobalRouting::RoutesTo &routes)
+{
+  NS_LOG_FUNCTION (this << routing << dest);
+  std::unordered_map<const Ipv4GlobalRouting*, uint32_t>::const_iterator i = m_routerIndex.find (PeekPointer (routing));
+  if (i == m_routerIndex.end () || !m_routers[i->second].calculate)
+    {
+      NS_LOG_LOGIC ("No routes calculated for " << routing);
+      return;
+    }
+  Router &router = m_routers[i->second];
+  std::unordered_map<uint32_t, SpfCache::iterator>::iterator cached = m_spfCacheIndex.find (i->second);
+  if (cached != m_spfCacheIndex.end ())
+    {
+      m_spfCache.splice (m_spfCache.begin (), m_spfCache, cached->second);
+    }
+  else
+    {
+      NS_LOG_LOGIC ("Calculating the routes of node " << router.nodeId);
+      m_checkStubs = NodeList::GetNNodes () > 0;
+      m_router = &router;
+      SPFCalculate (router.routerId);
+      m_router = 0;
+      m_spfCache.push_front (i->second);
+      m_spfCacheIndex[i->second] = m_spfCache.begin ();
+      UintegerValue cacheSize;
+      g_globalRoutingSpfCacheSize.GetValue (cacheSize);
+      while (m_spfCache.size () > cacheSize.Get ())
+        {
+          std::vector<Route> ().swap (m_routers[m_spfCache.back ()].routes);
+          m_spfCacheIndex.erase (m_spfCache.back ());
+          m_spfCache.pop_back ();
+        }
+    }
+  for (std::vector<Route>::const_iterator j = router.routes.begin (); j != router.routes.end (); j++)
+    {
+      switch (j->type)
+        {
+        case HOST_ROUTE:
+          if (j->dest == dest)
+            {
+              routes.hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (j->dest, j->nextHop, j->interface));
+            }
+          break;
+        case NETWORK_ROUTE:
+          if (j->mask.IsMatch (dest, j->dest))
+            {
+              routes.networkRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (j->dest, j->mask, j->nextHop, j->interface));
+            }
+          break;
+        case EXTERNAL_ROUTE:
+          if (j->mask.IsMatch (dest, j->dest))
+            {
+              routes.externalRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (j->dest, j->mask, j->nextHop, j->interface));
+            }
+          break;
+        }
+    }
+}
+
+/**
+ * \brief Compare two LSAs.
+ * \param a An LSA.
+ * \param b Another LSA.
+ * \returns Whether the LSAs advertise the same links.
+ */
+static bool
+SameLSA (const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+//
+// An SPF calculation only reads the LSAs connected to its root, through the
+// links of the LSAs and the attached routers of the network LSAs.  When the
+// LSDB is rebuilt, a router thus only needs a new calculation if an LSA of
+// its connected part changed, or if an attached router of a network LSA of
+// that part is now found in another LSA.  Since a link is advertised by the
+// LSAs at both of its ends, a new link to the part also changes one of its
+// LSAs.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_routersValid)
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  DiscoverLSAs ();
+
+  typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSAs_t;
+  const LSAs_t& lsas = m_lsdb->GetLSAs ();
+  const LSAs_t& oldLsas = oldLsdb->GetLSAs ();
+  std::vector<bool> changed (m_componentLookups.size (), false);
+  for (LSAs_t::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      LSAs_t::const_iterator old = oldLsas.find (i->first);
+      if (old != oldLsas.end () && !SameLSA (old->second, i->second))
+        {
+          NS_LOG_LOGIC ("LSA " << i->first << " changed");
+          changed[m_lsaComponents[i->first]] = true;
+        }
+    }
+  for (LSAs_t::const_iterator i = oldLsas.begin (); i != oldLsas.end (); i++)
+    {
+      if (lsas.find (i->first) == lsas.end ())
+        {
+          NS_LOG_LOGIC ("LSA " << i->first << " withdrawn");
+          changed[m_lsaComponents[i->first]] = true;
+        }
+    }
+  for (uint32_t c = 0; c < m_componentLookups.size (); c++)
+    {
+      for (LinkDataLookups_t::const_iterator i = m_componentLookups[c].begin ();
+           !changed[c] && i != m_componentLookups[c].end (); i++)
+        {
+          const GlobalRoutingLSA* lsa = m_lsdb->GetLSAByLinkData (i->first);
+          if ((lsa == 0) != (i->second == 0)
+              || (lsa != 0 && lsa->GetLinkStateId () != i->second->GetLinkStateId ()))
+            {
+              NS_LOG_LOGIC ("Link data " << i->first << " found in another LSA");
+              changed[c] = true;
+            }
+        }
+    }
+//
+// Any change of the external LSAs affects every router.
+//
+  bool externalsChanged = m_lsdb->GetNumExtLSAs () != oldLsdb->GetNumExtLSAs ();
+  for (uint32_t i = 0; !externalsChanged && i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      externalsChanged = !SameLSA (m_lsdb->GetExtLSA (i), oldLsdb->GetExtLSA (i));
+    }
+
+  std::map<uint32_t, const Router*> oldRouters;
+  for (std::vector<Router>::const_iterator i = m_routers.begin (); i != m_routers.end (); i++)
+    {
+      oldRouters[i->nodeId] = &*i;
+    }
+  std::vector<Router> routers;
+  GetRouters (routers);
+  std::vector<Router*> affected;
+  for (std::vector<Router>::iterator i = routers.begin (); i != routers.end (); i++)
+    {
+      std::map<uint32_t, const Router*>::const_iterator old = oldRouters.find (i->nodeId);
+      if (old != oldRouters.end ()
+          && !externalsChanged
+          && old->second->routerId == i->routerId
+          && old->second->routing == i->routing
+          && old->second->calculate == i->calculate
+          && old->second->addresses == i->addresses
+          && (!i->calculate || !changed[old->second->component]))
+        {
+          continue;
+        }
+      NS_LOG_LOGIC ("Recomputing the routes of node " << i->nodeId);
+      if (m_routesOnDemand)
+        {
+          if (i->routing)
+            {
+              i->routing->SetRoutesOnDemand (true);
+            }
+          continue;
+        }
+      if (i->routing)
+        {
+          RemoveRoutes (i->routing);
+        }
+      if (i->calculate)
+        {
+          affected.push_back (&*i);
+        }
+    }
+  delete oldLsdb;
+  m_routers.swap (routers);
+  FindComponents ();
+  SetRoutesOnDemand ();
+  CalculateRoutes (affected);
+  NS_LOG_INFO ("Recomputed the routes of " << affected.size () << " of " <<
+               m_routers.size () << " routers");
+}
+
+void
+GlobalRouteManagerImpl::GetRouters (std::vector<Router> &routers) const
+{
+  NS_LOG_FUNCTION (this);
+  routers.clear ();
+  uint32_t systemId = MpiInterface::GetSystemId ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -708,26 +1082,299 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Look for the GlobalRouter interface that indicates that the node is
 // participating in routing.
 //
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (!rtr)
         {
           continue;
         }
+      routers.push_back (Router ());
+      Router &router = routers.back ();
+      InitRouter (node, router);
+//
+// if the node has a global router interface, and is assigned to our systemId
+// (distributed sim), then run the global routing algorithms.
+//
+      router.calculate = node->GetSystemId () == systemId && rtr->GetNumLSAs ();
+    }
+}
 
+void
+GlobalRouteManagerImpl::InitRouter (Ptr<Node> node, Router &router) const
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+  router.nodeId = node->GetId ();
+  router.routerId = rtr->GetRouterId ();
+  router.routing = rtr->GetRoutingProtocol ();
+  router.calculate = true;
+  router.component = 0;
+//
+// Routing information is updated using the Ipv4 interface.  If the node is
+// acting as an IP version 4 router, it should absolutely have an Ipv4
+// interface.  Its addresses are kept aside, to find the outgoing interfaces
+// without reaching the node during the calculation.
+//
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::InitRouter (): "
+                 "GetObject for <Ipv4> interface failed");
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+        {
+          router.addresses.push_back (std::make_pair (ipv4->GetAddress (i, j).GetLocal (),
+                                                      static_cast<int32_t> (i)));
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::FindComponents ()
+{
+  NS_LOG_FUNCTION (this);
+  typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSAs_t;
+  const LSAs_t& lsas = m_lsdb->GetLSAs ();
+//
+// Union-find the LSAs through the LSAs their links and attached routers
+// lead to.
+//
+  std::map<const GlobalRoutingLSA*, uint32_t> index;
+  for (LSAs_t::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      index.insert (std::make_pair (i->second, index.size ()));
+    }
+  std::vector<uint32_t> parent (lsas.size ());
+  for (uint32_t i = 0; i < parent.size (); i++)
+    {
+      parent[i] = i;
+    }
+  std::vector<std::pair<uint32_t, std::pair<Ipv4Address, const GlobalRoutingLSA*> > > lookups;
+  for (LSAs_t::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      GlobalRoutingLSA* lsa = i->second;
+      uint32_t n = index[lsa];
+      std::vector<const GlobalRoutingLSA*> neighbors;
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+            {
+              neighbors.push_back (m_lsdb->GetLSA (l->GetLinkId ()));
+            }
+        }
+      for (uint32_t j = 0; j < lsa->GetNAttachedRouters (); j++)
+        {
+          Ipv4Address linkData = lsa->GetAttachedRouter (j);
+          neighbors.push_back (m_lsdb->GetLSAByLinkData (linkData));
+          lookups.push_back (std::make_pair (n, std::make_pair (linkData, neighbors.back ())));
+        }
+      for (std::vector<const GlobalRoutingLSA*>::const_iterator j = neighbors.begin ();
+           j != neighbors.end (); j++)
+        {
+          if (*j == 0)
+            {
+              continue;
+            }
+          uint32_t a = n;
+          uint32_t b = index[*j];
+          while (parent[a] != a)
+            {
+              a = parent[a] = parent[parent[a]];
+            }
+          while (parent[b] != b)
+            {
+              b = parent[b] = parent[parent[b]];
+            }
+          parent[std::max (a, b)] = std::min (a, b);
+        }
+    }
 //
-// if the node has a global router interface, then run the global routing
-// algorithms.
+// Number the components by their first LSA.
 //
-      if (rtr && rtr->GetNumLSAs () )
+  std::vector<uint32_t> component (parent.size ());
+  uint32_t nComponents = 0;
+  for (uint32_t i = 0; i < parent.size (); i++)
+    {
+      if (parent[i] == i)
+        {
+          component[i] = nComponents++;
+        }
+      else
         {
-          SPFCalculate (rtr->GetRouterId ());
+          parent[i] = parent[parent[i]];
+          component[i] = component[parent[i]];
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  m_lsaComponents.clear ();
+  for (LSAs_t::const_iterator i = lsas.begin (); i != lsas.end (); i++)
+    {
+      m_lsaComponents[i->first] = component[index[i->second]];
+    }
+  m_componentLookups.assign (nComponents, LinkDataLookups_t ());
+  for (uint32_t i = 0; i < lookups.size (); i++)
+    {
+      m_componentLookups[component[lookups[i].first]].push_back (lookups[i].second);
+    }
+  for (std::vector<Router>::iterator i = m_routers.begin (); i != m_routers.end (); i++)
+    {
+      std::map<Ipv4Address, uint32_t>::const_iterator c = m_lsaComponents.find (i->routerId);
+      i->component = c == m_lsaComponents.end () ? 0 : c->second;
+    }
+  NS_LOG_LOGIC ("Found " << nComponents << " connected parts in " << lsas.size () << " LSAs");
+}
+
+/**
+ * \brief Check whether the SPF calculation logs anything.
+ * \returns \c true if a log component of the SPF calculation is enabled.
+ */
+static bool
+SpfLogEnabled (void)
+{
+  static const char *components[] = { "GlobalRouteManagerImpl", "CandidateQueue", "GlobalRouter" };
+  LogComponent::ComponentList *list = LogComponent::GetComponentList ();
+  for (uint32_t i = 0; i < sizeof (components) / sizeof (components[0]); i++)
+    {
+      LogComponent::ComponentList::const_iterator c = list->find (components[i]);
+      if (c != list->end () && !c->second->IsNoneEnabled ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::CalculateRoutes (std::vector<Router*> &routers)
+{
+  NS_LOG_FUNCTION (this << routers.size ());
+//
+// A stub router only gets a default route when there are nodes, the unit
+// tests calculating routes without nodes.
+//
+  m_checkStubs = NodeList::GetNNodes () > 0;
+  UintegerValue threads;
+  g_globalRoutingThreads.GetValue (threads);
+  uint32_t nThreads = std::min<uint32_t> (threads.Get (), routers.size ());
+  if (nThreads > 1 && SpfLogEnabled ())
+    {
+      NS_LOG_WARN ("Logging the SPF calculation, which is not thread safe: using a single thread");
+      nThreads = 1;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (nThreads > 1)
+    {
+//
+// Calculate the routers in batches, each worker taking every nThreads-th
+// router, so that the routes calculated but not added yet stay few.
+//
+      std::vector<GlobalRouteManagerImpl*> workers;
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          GlobalRouteManagerImpl* worker = new GlobalRouteManagerImpl (m_lsdb);
+          worker->m_checkStubs = m_checkStubs;
+          worker->m_firstJob = i;
+          worker->m_jobStride = nThreads;
+          workers.push_back (worker);
+        }
+      uint32_t batchSize = 16 * nThreads;
+      for (uint32_t first = 0; first < routers.size (); first += batchSize)
+        {
+          std::vector<Router*> batch (routers.begin () + first,
+                                      routers.begin () + std::min<uint32_t> (first + batchSize, routers.size ()));
+          std::vector<Ptr<SystemThread> > running;
+          for (uint32_t i = 0; i < nThreads; i++)
+            {
+              workers[i]->m_jobs = &batch;
+              running.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::CalculateJobs, workers[i])));
+              running.back ()->Start ();
+            }
+          for (uint32_t i = 0; i < nThreads; i++)
+            {
+              running[i]->Join ();
+            }
+          for (std::vector<Router*>::iterator i = batch.begin (); i != batch.end (); i++)
+            {
+              AddRoutes (**i);
+            }
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          delete workers[i];
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  for (std::vector<Router*>::iterator i = routers.begin (); i != routers.end (); i++)
+    {
+      m_router = *i;
+      SPFCalculate (m_router->routerId);
+      m_router = 0;
+      AddRoutes (**i);
+    }
+}
+
+void
+GlobalRouteManagerImpl::CalculateJobs ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = m_firstJob; i < m_jobs->size (); i += m_jobStride)
+    {
+      m_router = (*m_jobs)[i];
+      SPFCalculate (m_router->routerId);
+      m_router = 0;
+    }
+}
+
+void
+GlobalRouteManagerImpl::AddRoutes (Router &router)
+{
+  NS_LOG_FUNCTION (this << router.routerId << router.routes.size ());
+  if (router.routing)
+    {
+      for (std::vector<Route>::const_iterator i = router.routes.begin (); i != router.routes.end (); i++)
+        {
+          switch (i->type)
+            {
+            case HOST_ROUTE:
+              router.routing->AddHostRouteTo (i->dest, i->nextHop, i->interface);
+              break;
+            case NETWORK_ROUTE:
+              router.routing->AddNetworkRouteTo (i->dest, i->mask, i->nextHop, i->interface);
+              break;
+            case EXTERNAL_ROUTE:
+              router.routing->AddASExternalRouteTo (i->dest, i->mask, i->nextHop, i->interface);
+              break;
+            }
+        }
+    }
+  std::vector<Route> ().swap (router.routes);
+}
+
+void
+GlobalRouteManagerImpl::AddRoute (RouteType type, Ipv4Address dest, Ipv4Mask mask,
+                                  Ipv4Address nextHop, uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << type << dest << mask << nextHop << interface);
+  Route route;
+  route.type = type;
+  route.dest = dest;
+  route.mask = mask;
+  route.nextHop = nextHop;
+  route.interface = interface;
+  m_router->routes.push_back (route);
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus (const GlobalRoutingLSA* lsa) const
+{
+  std::unordered_map<const GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus>::const_iterator i = m_lsaStatus.find (lsa);
+  return i == m_lsaStatus.end () ? GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED : i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetLSAStatus (const GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  m_lsaStatus[lsa] = status;
 }
 
 //
@@ -836,7 +1483,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +1508,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -873,7 +1520,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetLSAStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1535,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -960,7 +1607,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1247,7 +1894,26 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
+  Router router;
+  router.nodeId = 0;
+  router.routerId = root;
+  router.calculate = true;
+  router.component = 0;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr && rtr->GetRouterId () == root)
+        {
+          InitRouter (*i, router);
+          break;
+        }
+    }
+  m_checkStubs = NodeList::GetNNodes () > 0;
+  m_router = &router;
   SPFCalculate (root);
+  m_router = 0;
+  AddRoutes (router);
 }
 
 //
@@ -1320,12 +1986,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  AddRoute (NETWORK_ROUTE, Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
+                            FindOutgoingInterfaceId (transitLink->GetLinkData ()));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
                                 FindOutgoingInterfaceId (transitLink->GetLinkData ()));
@@ -1345,9 +2007,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Initialize the SPF status of the LSAs, kept by the calculation so that the
+// Link State Database is only read.
 //
-  m_lsdb->Initialize ();
+  m_lsaStatus.clear ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1367,7 +2030,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1377,7 +2040,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_checkStubs && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
@@ -1428,7 +2091,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1444,12 +2107,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
 // RFC2328 16.1. (4). 
 //
-// This is the method that actually adds the routes.  It'll walk the list
-// of nodes in the system, looking for the node corresponding to the router
-// ID of the root of the tree -- that is the router we're building the routes
-// for.  It looks for the Ipv4 interface of that node and remembers it.  So
-// we are only actually adding routes to that one node at the root of the SPF 
-// tree.
+// This is the method that actually adds the routes.  They are recorded in
+// the router at the root of the tree -- that is the router we're building
+// the routes for -- and added to its routing table once the calculation is
+// done.  So we are only actually adding routes to that one node at the root
+// of the SPF tree.
 //
 // We're going to pop of a pointer to every vertex in the tree except the 
 // root in order of distance from the root.  For each of the vertices, we call
@@ -1556,62 +2218,25 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
 
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
 //
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
+// The routing information is written to the router at the root of the SPF
+// tree.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  NS_ASSERT_MSG (m_router, "GlobalRouteManagerImpl::SPFAddASExternal (): Root router not set");
+  NS_LOG_LOGIC ("Setting routes for node " << m_router->nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2251,29 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (EXTERNAL_ROUTE, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1721,68 +2336,23 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
+// to this router has a vertex ID which is the router ID of that node.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  NS_ASSERT_MSG (m_router, "GlobalRouteManagerImpl::SPFIntraAddStub (): Root router not set");
+  NS_LOG_LOGIC ("Setting routes for node " << m_router->nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1796,46 +2366,35 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          AddRoute (NETWORK_ROUTE, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// This mirrors GetInterfaceForPrefix(), on the addresses of the node at the
+// root of the SPF tree that were recorded before the calculation.
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
@@ -1844,69 +2403,21 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// Look through the interfaces of the node we're building the routing table
+// for, for one that has the IP address we're looking for.  If we find one,
+// return the corresponding interface index, or -1 if not found.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  NS_ASSERT_MSG (m_router, "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): Root router not set");
+  Ipv4Address prefix = a.CombineMask (amask);
+  for (std::vector<std::pair<Ipv4Address, int32_t> >::const_iterator i = m_router->addresses.begin ();
+       i != m_router->addresses.end (); i++)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
+      if (i->first.CombineMask (amask) == prefix)
         {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
+          return i->second;
         }
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find interface for " << a);
   return -1;
 }
 
@@ -1936,68 +2447,23 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 //
 // The root of the Shortest Path First tree is the router to which we are 
 // going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// to this router has a vertex ID which is the router ID of that node.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+  NS_LOG_LOGIC ("Vertex ID = " << m_spfroot->GetVertexId ());
+  NS_ASSERT_MSG (m_router, "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root router not set");
+  NS_LOG_LOGIC ("Setting routes for node " << m_router->nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2472,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << m_router->nodeId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,46 +2497,33 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              AddRoute (HOST_ROUTE, lr->GetLinkData (), Ipv4Mask::GetOnes (), nextHop, outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
+
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 {
@@ -2078,106 +2531,46 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_ASSERT_MSG (m_spfroot, 
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
-//
-// The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  NS_ASSERT_MSG (m_router, "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root router not set");
+  NS_LOG_LOGIC ("setting routes for node " << m_router->nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          AddRoute (NETWORK_ROUTE, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << m_router->nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
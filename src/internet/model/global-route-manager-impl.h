@@ -26,18 +26,20 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
+#include "ipv4-global-routing.h"
 
 namespace ns3 {
 
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
-class Ipv4GlobalRouting;
 
 /**
  * \ingroup globalrouting
@@ -641,13 +643,23 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get the Link State Advertisements of the database, except the
+ * external ones.
+ *
+ * @returns The LSAs, by link state ID.
+ */
+  const std::map<Ipv4Address, GlobalRoutingLSA*>& GetLSAs () const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
  * This function walks the database and resets the status flags of all of the
- * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  This is done
- * prior to each SPF calculation to reset the state of the SPFVertex structures
- * that will reference the LSAs during the calculation.
+ * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.
+ *
+ * The SPF calculations of GlobalRouteManagerImpl keep the status of the
+ * LSAs aside, so that several calculations can read the database at
+ * the same time, and do not use these flags.
  *
  * @see GlobalRoutingLSA
  * @see SPFVertex
@@ -680,6 +692,7 @@ private:
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LSDBMap_t m_linkDataIndex; //!< the LSAs found by GetLSAByLinkData (), by link data
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -708,6 +721,15 @@ private:
  * and finally configure each of the node's forwarding tables.
  *
  * The design is guided by OSPFv2 \RFC{2328} section 16.1.1 and quagga ospfd.
+ *
+ * The SPF calculations only read the Link State Database, and write the
+ * routes they compute aside until they are added to the forwarding
+ * tables, so the routers can be calculated by several threads (see the
+ * \c GlobalRoutingThreads global value); the tables are the same
+ * whatever the number of threads.  Logging is not thread safe, so a
+ * single thread is used while the calculation is logged.  UpdateRoutes ()
+ * only recalculates the routers whose calculation can read a Link State
+ * Advertisement which changed.
  */
 class GlobalRouteManagerImpl
 {
@@ -735,6 +757,45 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database, and recompute the routes of the
+ * routers affected by the Link State Advertisements which changed since
+ * the routes were computed.
+ *
+ * A router is affected when an LSA changed in the part of the link state
+ * database connected to it, or when its interfaces changed; the other
+ * routers keep their forwarding tables.  The tables are the same as
+ * after DeleteGlobalRoutes (), BuildGlobalRoutingDatabase () and
+ * InitializeRoutes (), which this method falls back to if the routes
+ * were not computed by InitializeRoutes ().
+ */
+  virtual void UpdateRoutes ();
+
+/**
+ * @brief Let the routers find their routes on demand, through
+ * GetRoutesTo (), instead of populating their forwarding tables.
+ *
+ * UpdateRoutes () then flushes the route caches of the affected routers,
+ * instead of recomputing their routes.
+ */
+  virtual void InitializeRoutesOnDemand ();
+
+/**
+ * @brief Compute the routes of a router to a destination.
+ *
+ * The routes are those of the SPF calculation of the router which lead
+ * to the destination.  All the routes calculated are kept for the
+ * routers which looked a destination up last, as many as the
+ * \c GlobalRoutingSpfCacheSize global value, so that the destinations
+ * they look up next are found without a new calculation.
+ *
+ * @param routing The routing protocol of the router.
+ * @param dest The destination.
+ * @param routes The routes found, in forwarding table order.
+ */
+  void GetRoutesTo (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest,
+                    Ipv4GlobalRouting::RoutesTo &routes);
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -747,6 +808,13 @@ public:
   void DebugSPFCalculate (Ipv4Address root);
 
 private:
+/**
+ * @brief Construct an SPF calculation worker, reading the database of
+ * another GlobalRouteManagerImpl.
+ * @param lsdb The database.
+ */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb);
+
 /**
  * @brief GlobalRouteManagerImpl copy construction is disallowed.
  * There's no  need for it and a compiler provided shallow copy would be 
@@ -766,8 +834,136 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /// The kinds of routes computed by the SPF calculation
+  enum RouteType
+  {
+    HOST_ROUTE,     //!< A route added with AddHostRouteTo ()
+    NETWORK_ROUTE,  //!< A route added with AddNetworkRouteTo ()
+    EXTERNAL_ROUTE  //!< A route added with AddASExternalRouteTo ()
+  };
+
+  /// A route computed by the SPF calculation, to be added to the root router
+  struct Route
+  {
+    RouteType type;        //!< The kind of route
+    Ipv4Address dest;      //!< The destination host or network
+    Ipv4Mask mask;         //!< The destination network mask
+    Ipv4Address nextHop;   //!< The next hop
+    uint32_t interface;    //!< The outgoing interface
+  };
+
+  /// A node with a GlobalRouter interface, as of its last SPF calculation
+  struct Router
+  {
+    uint32_t nodeId;                  //!< The node ID
+    Ipv4Address routerId;             //!< The router ID
+    Ptr<Ipv4GlobalRouting> routing;   //!< The routing protocol, or 0
+    bool calculate;                   //!< Whether the routes of the router are calculated
+    std::vector<std::pair<Ipv4Address, int32_t> > addresses; //!< The interface addresses, with their interface
+    uint32_t component;               //!< The connected part of the LSDB holding the router LSA
+    std::vector<Route> routes;        //!< The routes calculated, until they are added, or while cached on demand
+  };
+
+  /// The link data looked up in a connected part of the LSDB, with the LSA found
+  typedef std::vector<std::pair<Ipv4Address, const GlobalRoutingLSA*> > LinkDataLookups_t;
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< whether the LSDB is deleted with this object
+  Router* m_router; //!< the router whose routes SPFCalculate () computes
+  bool m_checkStubs; //!< whether SPFCalculate () installs default routes in stub routers
+  std::unordered_map<const GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus> m_lsaStatus; //!< the LSA status in the SPF calculation
+  std::vector<Router*>* m_jobs; //!< the routers calculated by a worker
+  uint32_t m_firstJob; //!< the first router calculated by a worker
+  uint32_t m_jobStride; //!< the distance between the routers calculated by a worker
+  std::vector<Router> m_routers; //!< the routers of the last calculation
+  bool m_routersValid; //!< whether m_routers and the components describe the current routes
+  std::map<Ipv4Address, uint32_t> m_lsaComponents; //!< the connected part of the LSDB holding each LSA
+  std::vector<LinkDataLookups_t> m_componentLookups; //!< the link data looked up in each connected part
+  bool m_routesOnDemand; //!< whether the routers find their routes on demand
+  std::unordered_map<const Ipv4GlobalRouting*, uint32_t> m_routerIndex; //!< the index of the routers in m_routers, by routing protocol
+  /// The indexes in m_routers of the routers whose routes are kept, most recently used first
+  typedef std::list<uint32_t> SpfCache;
+  SpfCache m_spfCache; //!< the routers whose routes calculated on demand are kept
+  std::unordered_map<uint32_t, SpfCache::iterator> m_spfCacheIndex; //!< index of m_spfCache
+
+  /**
+   * \brief Gather the LSAs of the routers into the LSDB.
+   */
+  void DiscoverLSAs ();
+
+  /**
+   * \brief Describe the nodes with a GlobalRouter interface.
+   * \param routers The routers.
+   */
+  void GetRouters (std::vector<Router> &routers) const;
+
+  /**
+   * \brief Describe a router.
+   * \param node The node.
+   * \param router The router.
+   */
+  void InitRouter (Ptr<Node> node, Router &router) const;
+
+  /**
+   * \brief Find the connected parts of the LSDB, and the link data
+   * looked up in each of them.
+   */
+  void FindComponents ();
+
+  /**
+   * \brief Calculate the routes of routers, and add them to their
+   * forwarding tables.
+   * \param routers The routers.
+   */
+  void CalculateRoutes (std::vector<Router*> &routers);
+
+  /**
+   * \brief Let the routers of m_routers find their routes on demand.
+   */
+  void SetRoutesOnDemand ();
+
+  /**
+   * \brief Calculate the routes of the routers of a worker.
+   */
+  void CalculateJobs ();
+
+  /**
+   * \brief Add the routes calculated for a router to its forwarding table.
+   * \param router The router.
+   */
+  void AddRoutes (Router &router);
+
+  /**
+   * \brief Remove the routes of a router.
+   * \param routing The routing protocol of the router.
+   */
+  void RemoveRoutes (Ptr<Ipv4GlobalRouting> routing);
+
+  /**
+   * \brief Record a route of the router being calculated.
+   * \param type The kind of route.
+   * \param dest The destination host or network.
+   * \param mask The destination network mask.
+   * \param nextHop The next hop.
+   * \param interface The outgoing interface.
+   */
+  void AddRoute (RouteType type, Ipv4Address dest, Ipv4Mask mask,
+                 Ipv4Address nextHop, uint32_t interface);
+
+  /**
+   * \brief Get the status of an LSA in the SPF calculation.
+   * \param lsa The LSA.
+   * \returns The status.
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (const GlobalRoutingLSA* lsa) const;
+
+  /**
+   * \brief Set the status of an LSA in the SPF calculation.
+   * \param lsa The LSA.
+   * \param status The status.
+   */
+  void SetLSAStatus (const GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
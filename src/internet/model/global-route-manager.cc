@@ -58,6 +58,31 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::UpdateRoutes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  UpdateRoutes ();
+}
+
+void
+GlobalRouteManager::InitializeRoutesOnDemand (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  InitializeRoutesOnDemand ();
+}
+
+void
+GlobalRouteManager::GetRoutesTo (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest,
+                                 Ipv4GlobalRouting::RoutesTo &routes)
+{
+  NS_LOG_FUNCTION (routing << dest);
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  GetRoutesTo (routing, dest, routes);
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
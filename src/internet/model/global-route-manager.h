@@ -22,6 +22,11 @@
 #ifndef GLOBAL_ROUTE_MANAGER_H
 #define GLOBAL_ROUTE_MANAGER_H
 
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/ipv4-address.h"
+#include "ipv4-global-routing.h"
+
 namespace ns3 {
 
 /**
@@ -65,6 +70,41 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the per-node forwarding
+ * tables after a change of the topology.
+ *
+ * The routes are the ones DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes () would compute, but only the routers that can reach
+ * a changed Link State Advertisement have their routes recomputed.  With
+ * routes on demand, their route caches are flushed instead.
+ */
+  static void UpdateRoutes ();
+
+/**
+ * @brief Let the routers find their routes on demand, instead of
+ * populating the per-node forwarding tables.
+ *
+ * The routes to a destination are computed by the SPF calculation of a
+ * router when the router first looks the destination up, and are kept
+ * in the route cache of its Ipv4GlobalRouting.  Call it instead of
+ * InitializeRoutes (), after BuildGlobalRoutingDatabase ().
+ *
+ * @see Ipv4GlobalRouting::SetRoutesOnDemand
+ */
+  static void InitializeRoutesOnDemand ();
+
+/**
+ * @brief Compute the routes of a router to a destination.
+ *
+ * @param routing The routing protocol of the router.
+ * @param dest The destination.
+ * @param routes The routes found, in the order of the forwarding table
+ * InitializeRoutes () would populate.
+ */
+  static void GetRoutesTo (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest,
+                           Ipv4GlobalRouting::RoutesTo &routes);
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
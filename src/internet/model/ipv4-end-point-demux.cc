@@ -29,7 +29,8 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_allocated (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -45,25 +46,74 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   m_endPoints.clear ();
 }
 
+uint64_t
+Ipv4EndPointDemux::GetPeerKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return (static_cast<uint64_t> (peerAddress.Get ()) << 32)
+         | (static_cast<uint64_t> (localPort) << 16) | peerPort;
+}
+
+const Ipv4EndPointDemux::EndPoints *
+Ipv4EndPointDemux::FindPeer (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort) const
+{
+  std::unordered_map<uint64_t, EndPoints>::const_iterator i = m_peers.find (GetPeerKey (localPort, peerAddress, peerPort));
+  if (i == m_peers.end ())
+    {
+      return 0;
+    }
+  return &i->second;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Position position;
+  position.endPoint = m_endPoints.insert (m_endPoints.end (), endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  position.port = port.insert (port.end (), endPoint);
+  position.peerKey = GetPeerKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  EndPoints &peer = m_peers[position.peerKey];
+  position.peer = peer.insert (peer.end (), endPoint);
+  position.order = m_allocated++;
+  m_positions[endPoint] = position;
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void
+Ipv4EndPointDemux::UpdatePeer (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Position &position = m_positions[endPoint];
+  std::unordered_map<uint64_t, EndPoints>::iterator old = m_peers.find (position.peerKey);
+  old->second.erase (position.peer);
+  if (old->second.empty ())
+    {
+      m_peers.erase (old);
+    }
+  position.peerKey = GetPeerKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  EndPoints &peer = m_peers[position.peerKey];
+  position.peer = peer.insert (peer.end (), endPoint);
+}
+
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (port);
+  if (endPoints == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
     {
       if ((*i)->GetLocalPort () == port &&
           (*i)->GetLocalAddress () == addr &&
@@ -86,8 +136,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -102,8 +151,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -125,8 +173,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -136,23 +183,22 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  const EndPoints *endPoints = FindPeer (localPort, peerAddress, peerPort);
+  if (endPoints)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPoints::const_iterator i = endPoints->begin (); i != endPoints->end (); i++) 
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetLocalAddress () == localAddress &&
+              ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -161,15 +207,27 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<Ipv4EndPoint *, Position>::iterator position = m_positions.find (endPoint);
+  if (position == m_positions.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  m_endPoints.erase (position->second.endPoint);
+  std::unordered_map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  port->second.erase (position->second.port);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  std::unordered_map<uint64_t, EndPoints>::iterator peer = m_peers.find (position->second.peerKey);
+  peer->second.erase (position->second.peer);
+  if (peer->second.empty ())
+    {
+      m_peers.erase (peer);
+    }
+  m_positions.erase (position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -207,8 +265,25 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval3; // Matches all but local address
   EndPoints retval4; // Exact match on all 4
 
+  // Only the end points connected to the source of the packet, and those
+  // open to any peer, can match
+  EndPoints candidates;
+  const EndPoints *connected = FindPeer (dport, saddr, sport);
+  if (connected)
+    {
+      candidates = *connected;
+    }
+  if (saddr != Ipv4Address::GetAny () || sport != 0)
+    {
+      const EndPoints *open = FindPeer (dport, Ipv4Address::GetAny (), 0);
+      if (open)
+        {
+          candidates.insert (candidates.end (), open->begin (), open->end ());
+        }
+    }
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -345,21 +420,35 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
-  uint32_t genericity = 3;
-  Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  const EndPoints *connected = FindPeer (dport, saddr, sport);
+  if (connected)
     {
-      if ((*i)->GetLocalPort () != dport) 
+      Ipv4EndPoint *exact = 0;
+      uint64_t exactOrder = 0;
+      for (EndPoints::const_iterator i = connected->begin (); i != connected->end (); i++) 
         {
-          continue;
+          uint64_t order = m_positions[*i].order;
+          if ((*i)->GetLocalAddress () == daddr && (exact == 0 || order < exactOrder))
+            {
+              /* this is an exact match, the first allocated if several. */
+              exact = *i;
+              exactOrder = order;
+            }
         }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
+      if (exact)
         {
-          /* this is an exact match. */
-          return *i;
+          return exact;
         }
+    }
+  std::unordered_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (dport);
+  if (endPoints == m_ports.end ())
+    {
+      return 0;
+    }
+  uint32_t genericity = 3;
+  Ipv4EndPoint *generic = 0;
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end () && genericity > 0; i++) 
+    {
       uint32_t tmp = 0;
       if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
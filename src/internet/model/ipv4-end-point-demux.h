@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +41,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are indexed by local port, and by local port and peer, so
+ * that a lookup only looks at the endpoints connected to the peer of the
+ * packet and at those listening on its port, however many connections
+ * the node has.  The endpoints tell the demux when their peer changes.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +172,37 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Add a new end point to the containers.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Move an end point to the index of its new peer.
+   * \param endPoint the end point
+   */
+  void UpdatePeer (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Get the key of the end points with a local port and peer.
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns the key
+   */
+  static uint64_t GetPeerKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points with a local port and peer.
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns the end points, or 0 if there is none
+   */
+  const EndPoints *FindPeer (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort) const;
 
   /**
    * \brief Allocate an ephemeral port.
@@ -192,6 +229,38 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The place of an end point in the containers.
+   */
+  struct Position
+  {
+    EndPointsI endPoint;  //!< The end point in m_endPoints
+    EndPointsI port;      //!< The end point in m_ports
+    EndPointsI peer;      //!< The end point in m_peers
+    uint64_t peerKey;     //!< The key of the end point in m_peers
+    uint64_t order;       //!< The allocation order of the end point
+  };
+
+  /**
+   * \brief The end points, by local port, in allocation order.
+   */
+  std::unordered_map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The end points, by local port and peer (see GetPeerKey ()).
+   */
+  std::unordered_map<uint64_t, EndPoints> m_peers;
+
+  /**
+   * \brief The place of each end point in the containers.
+   */
+  std::unordered_map<Ipv4EndPoint *, Position> m_positions;
+
+  /**
+   * \brief The number of end points allocated.
+   */
+  uint64_t m_allocated;
 };
 
 } // namespace ns3
@@ -27,6 +27,8 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/hash.h"
 #include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
@@ -37,6 +39,9 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4GlobalRouting);
 
+const uint8_t TCP_PROT_NUMBER = 6;  //!< TCP Protocol number
+const uint8_t UDP_PROT_NUMBER = 17; //!< UDP Protocol number
+
 TypeId 
 Ipv4GlobalRouting::GetTypeId (void)
 { 
@@ -53,13 +58,39 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_respondToInterfaceEvents),
                    MakeBooleanChecker ())
+    .AddAttribute ("RouteCacheSize",
+                   "The maximum number of destinations whose routes are kept, when the routes are found on demand",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_routeCacheSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FlowEcmpRouting",
+                   "Set to true if packets are routed among ECMP by a hash of their flow, so that the packets of a flow take the same route; takes precedence over RandomEcmpRouting",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_flowEcmpRouting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EcmpHashSeed",
+                   "The seed hashed with the flows by FlowEcmpRouting; routers with different seeds spread the flows differently",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowletGap",
+                   "With FlowEcmpRouting, the idle time after which a flow is moved to a randomly picked route; zero keeps the flows on their hashed route",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_flowletGap),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_flowEcmpRouting (false),
+    m_ecmpHashSeed (0),
+    m_triesValid (false),
+    m_routesOnDemand (false),
+    m_routeCacheSize (256),
+    m_flowletPurgeSize (1024)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +111,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_triesValid = false;
 }
 
 void 
@@ -90,6 +122,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_triesValid = false;
 }
 
 void 
@@ -105,6 +138,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_triesValid = false;
 }
 
 void 
@@ -118,6 +152,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_triesValid = false;
 }
 
 void 
@@ -133,11 +168,27 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_triesValid = false;
 }
 
 
+/**
+ * \brief Point to routes.
+ * \param [in] routes The routes.
+ * \param [out] candidates Pointers to the routes.
+ */
+static void
+PointToRoutes (std::vector<Ipv4RoutingTableEntry> &routes, std::vector<Ipv4RoutingTableEntry*> &candidates)
+{
+  candidates.clear ();
+  for (std::vector<Ipv4RoutingTableEntry>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      candidates.push_back (&*i);
+    }
+}
+
 Ptr<Ipv4Route>
-Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif, uint32_t flowHash, uint32_t size)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
@@ -146,81 +197,108 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
+  RoutesTo *onDemand = 0;
+  if (m_routesOnDemand)
+    {
+      onDemand = &GetRoutesTo (dest);
+    }
+  else if (!m_triesValid)
+    {
+      BuildTries ();
+    }
+  RouteVec_t candidates;
+
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  if (onDemand)
+    {
+      PointToRoutes (onDemand->hostRoutes, candidates);
+    }
+  else
+    {
+      m_hostTrie.Lookup (dest, candidates);
+    }
+  for (RouteVec_t::const_iterator i = candidates.begin ();
+       i != candidates.end ();
+       i++)
     {
       NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      if (oif != 0)
         {
-          if (oif != 0)
+          if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
+      allRoutes.push_back (*i);
+      NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i);
     }
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      if (onDemand)
+        {
+          PointToRoutes (onDemand->networkRoutes, candidates);
+        }
+      else
+        {
+          m_networkTrie.Lookup (dest, candidates);
+        }
+      for (RouteVec_t::const_iterator j = candidates.begin ();
+           j != candidates.end ();
+           j++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          if (oif != 0)
             {
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
+          allRoutes.push_back (*j);
+          NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
         }
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
+      if (onDemand)
+        {
+          PointToRoutes (onDemand->externalRoutes, candidates);
+        }
+      else
+        {
+          m_ASexternalTrie.Lookup (dest, candidates);
+        }
+      for (RouteVec_t::const_iterator k = candidates.begin ();
+           k != candidates.end ();
            k++)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          NS_LOG_LOGIC ("Found external route" << *k);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          allRoutes.push_back (*k);
+          break;
         }
     }
   if (allRoutes.size () > 0 ) // if route(s) is found
     {
-      // pick up one of the routes uniformly at random if random
+      // pick up one of the routes by the flow of the packet if flow
+      // ECMP routing is enabled, uniformly at random if random
       // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
+      // consistently if ECMP routing is disabled
       uint32_t selectIndex;
-      if (m_randomEcmpRouting)
+      if (m_flowEcmpRouting)
+        {
+          selectIndex = SelectEcmpRoute (allRoutes.size (), flowHash, size);
+        }
+      else if (m_randomEcmpRouting)
         {
           selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
         }
@@ -229,6 +307,12 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
           selectIndex = 0;
         }
       Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
+      if (size > 0)
+        {
+          NextHopCounters &counters = m_nextHopCounters[NextHop (route->GetInterface (), route->GetGateway ())];
+          counters.packets++;
+          counters.bytes += size;
+        }
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
@@ -245,6 +329,175 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 }
 
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header, bool ports) const
+{
+  NS_LOG_FUNCTION (this << p << header << ports);
+  // The seed, the addresses, the protocol and the ports
+  uint8_t flow[17] = { 0 };
+  flow[0] = m_ecmpHashSeed >> 24;
+  flow[1] = m_ecmpHashSeed >> 16;
+  flow[2] = m_ecmpHashSeed >> 8;
+  flow[3] = m_ecmpHashSeed;
+  header.GetSource ().Serialize (flow + 4);
+  header.GetDestination ().Serialize (flow + 8);
+  flow[12] = header.GetProtocol ();
+  // Only the first fragment holds the ports: the fragments are routed
+  // by their addresses and protocol, so that they stay together
+  if (ports && p && p->GetSize () >= 4
+      && header.GetFragmentOffset () == 0 && header.IsLastFragment ())
+    {
+      p->CopyData (flow + 13, 4);
+    }
+  return Hash32 (reinterpret_cast<char *> (flow), sizeof (flow));
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectEcmpRoute (uint32_t nRoutes, uint32_t flowHash, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << nRoutes << flowHash << size);
+  if (m_flowletGap.IsZero () || size == 0)
+    {
+      return flowHash % nRoutes;
+    }
+  Time now = Simulator::Now ();
+  std::unordered_map<uint32_t, Flowlet>::iterator i = m_flowlets.find (flowHash);
+  if (i == m_flowlets.end ())
+    {
+      if (m_flowlets.size () >= m_flowletPurgeSize)
+        {
+          for (i = m_flowlets.begin (); i != m_flowlets.end (); )
+            {
+              if (now - i->second.lastSeen >= m_flowletGap)
+                {
+                  i = m_flowlets.erase (i);
+                }
+              else
+                {
+                  i++;
+                }
+            }
+          m_flowletPurgeSize = std::max<uint32_t> (1024, 2 * m_flowlets.size ());
+        }
+      Flowlet flowlet;
+      flowlet.lastSeen = now;
+      flowlet.route = flowHash % nRoutes;
+      m_flowlets[flowHash] = flowlet;
+      return flowlet.route;
+    }
+  Flowlet &flowlet = i->second;
+  if (now - flowlet.lastSeen >= m_flowletGap || flowlet.route >= nRoutes)
+    {
+      flowlet.route = m_rand->GetInteger (0, nRoutes - 1);
+      NS_LOG_LOGIC ("New flowlet of flow " << flowHash << " on route " << flowlet.route);
+    }
+  flowlet.lastSeen = now;
+  return flowlet.route;
+}
+
+Ipv4GlobalRouting::NextHopCounters::NextHopCounters ()
+  : packets (0),
+    bytes (0)
+{
+}
+
+Ipv4GlobalRouting::NextHopCounters
+Ipv4GlobalRouting::GetNextHopCounters (uint32_t interface, Ipv4Address gateway) const
+{
+  NS_LOG_FUNCTION (this << interface << gateway);
+  std::map<NextHop, NextHopCounters>::const_iterator i = m_nextHopCounters.find (NextHop (interface, gateway));
+  if (i == m_nextHopCounters.end ())
+    {
+      return NextHopCounters ();
+    }
+  return i->second;
+}
+
+void
+Ipv4GlobalRouting::ResetNextHopCounters (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nextHopCounters.clear ();
+}
+
+void
+Ipv4GlobalRouting::BuildTries (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hostTrie.Clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      m_hostTrie.Insert ((*i)->GetDest (), Ipv4Mask::GetOnes (), *i);
+    }
+  m_networkTrie.Clear ();
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      m_networkTrie.Insert ((*j)->GetDestNetwork (), (*j)->GetDestNetworkMask (), *j);
+    }
+  m_ASexternalTrie.Clear ();
+  for (ASExternalRoutesCI k = m_ASexternalRoutes.begin (); k != m_ASexternalRoutes.end (); k++)
+    {
+      m_ASexternalTrie.Insert ((*k)->GetDestNetwork (), (*k)->GetDestNetworkMask (), *k);
+    }
+  m_triesValid = true;
+  NS_LOG_LOGIC ("Indexed " << GetNRoutes () << " routes in "
+                << m_hostTrie.GetNNodes () + m_networkTrie.GetNNodes () + m_ASexternalTrie.GetNNodes ()
+                << " trie nodes");
+}
+
+Ipv4GlobalRouting::RoutesTo &
+Ipv4GlobalRouting::GetRoutesTo (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  std::unordered_map<Ipv4Address, RouteCache::iterator, Ipv4AddressHash>::iterator i = m_routeCacheIndex.find (dest);
+  if (i != m_routeCacheIndex.end ())
+    {
+      m_routeCache.splice (m_routeCache.begin (), m_routeCache, i->second);
+      return i->second->second;
+    }
+  NS_LOG_LOGIC ("Finding the routes to " << dest);
+  m_routeCache.push_front (std::make_pair (dest, RoutesTo ()));
+  m_routeCacheIndex[dest] = m_routeCache.begin ();
+  GlobalRouteManager::GetRoutesTo (this, dest, m_routeCache.front ().second);
+  while (m_routeCache.size () > m_routeCacheSize)
+    {
+      NS_LOG_LOGIC ("Forgetting the routes to " << m_routeCache.back ().first);
+      m_routeCacheIndex.erase (m_routeCache.back ().first);
+      m_routeCache.pop_back ();
+    }
+  return m_routeCache.front ().second;
+}
+
+void
+Ipv4GlobalRouting::SetRoutesOnDemand (bool onDemand)
+{
+  NS_LOG_FUNCTION (this << onDemand);
+  m_routesOnDemand = onDemand;
+  FlushRouteCache ();
+}
+
+bool
+Ipv4GlobalRouting::GetRoutesOnDemand (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_routesOnDemand;
+}
+
+void
+Ipv4GlobalRouting::FlushRouteCache (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_routeCache.clear ();
+  m_routeCacheIndex.clear ();
+}
+
+uint32_t
+Ipv4GlobalRouting::GetNCachedDestinations (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_routeCache.size ();
+}
+
 uint32_t 
 Ipv4GlobalRouting::GetNRoutes (void) const
 {
@@ -309,6 +562,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  m_triesValid = false;
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -392,6 +646,13 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostTrie.Clear ();
+  m_networkTrie.Clear ();
+  m_ASexternalTrie.Clear ();
+  m_triesValid = false;
+  FlushRouteCache ();
+  m_flowlets.clear ();
+  m_nextHopCounters.clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -468,7 +729,15 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
 // See if this is a unicast packet we have a route for.
 //
   NS_LOG_LOGIC ("Unicast destination- looking up");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif);
+  // The TCP segments are routed with their header, but UDP sockets ask
+  // for a route before adding theirs: only TCP flows have their ports
+  uint32_t flowHash = 0;
+  if (m_flowEcmpRouting)
+    {
+      flowHash = GetFlowHash (p, header, header.GetProtocol () == TCP_PROT_NUMBER);
+    }
+  uint32_t size = p ? p->GetSize () + header.GetSerializedSize () : 0;
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), oif, flowHash, size);
   if (rtentry)
     {
       sockerr = Socket::ERROR_NOTERROR;
@@ -517,7 +786,14 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, const Ipv4Header &header, P
     }
   // Next, try to find a route
   NS_LOG_LOGIC ("Unicast destination- looking up global route");
-  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination ());
+  uint32_t flowHash = 0;
+  if (m_flowEcmpRouting)
+    {
+      uint8_t protocol = header.GetProtocol ();
+      flowHash = GetFlowHash (p, header, protocol == TCP_PROT_NUMBER || protocol == UDP_PROT_NUMBER);
+    }
+  Ptr<Ipv4Route> rtentry = LookupGlobal (header.GetDestination (), 0, flowHash,
+                                         p->GetSize () + header.GetSerializedSize ());
   if (rtentry != 0)
     {
       NS_LOG_LOGIC ("Found unicast destination- calling unicast callback");
@@ -537,9 +813,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -549,9 +823,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -561,9 +833,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -573,9 +843,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -21,6 +21,10 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +32,9 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-prefix-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -65,6 +72,32 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * The routes are kept in lists, in the order they were added.  For
+ * forwarding they are indexed by prefix in Ipv4PrefixTrie tries, built
+ * at the first lookup after the routes change (typically after
+ * GlobalRouteManager has populated the routing tables), so that a
+ * lookup does not scan every route.  The tries return the candidate
+ * routes in list order, so the route chosen, and the ECMP candidates
+ * of RandomEcmpRouting, are those a scan of the lists would find.
+ *
+ * With routes on demand (see SetRoutesOnDemand ()), the routes are not
+ * kept in the lists: the routes to a destination are asked to
+ * GlobalRouteManager at the first lookup of the destination, and kept in
+ * a cache of the \c RouteCacheSize destinations looked up last.  The
+ * memory used then grows with the number of destinations in use rather
+ * than with the number of routes of the topology.
+ *
+ * Among equal cost routes, the first one is used, unless
+ * RandomEcmpRouting picks one at random for each packet, or
+ * FlowEcmpRouting picks one by a hash of the flow of the packet, so that
+ * the packets of a flow are not reordered.  The flow is the source and
+ * destination addresses, the protocol and, for TCP and UDP, the ports;
+ * the \c EcmpHashSeed attribute is hashed with it, so that routers with
+ * different seeds spread the flows differently.  With a \c FlowletGap,
+ * a flow moves to a randomly picked route when it has been idle for the
+ * gap (flowlet switching).  The packets and bytes routed through each
+ * next hop are counted (see GetNextHopCounters ()).
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -228,6 +261,61 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /// The routes to a destination
+  struct RoutesTo
+  {
+    std::vector<Ipv4RoutingTableEntry> hostRoutes;     //!< The host routes, in table order
+    std::vector<Ipv4RoutingTableEntry> networkRoutes;  //!< The network routes, in table order
+    std::vector<Ipv4RoutingTableEntry> externalRoutes; //!< The external routes, in table order
+  };
+
+  /**
+   * \brief Ask the routes to a destination to GlobalRouteManager when it
+   * is looked up, instead of looking the routes of the route lists up.
+   *
+   * The route cache is flushed.
+   *
+   * \param onDemand Whether the routes are found on demand.
+   */
+  void SetRoutesOnDemand (bool onDemand);
+
+  /**
+   * \returns Whether the routes are found on demand.
+   */
+  bool GetRoutesOnDemand (void) const;
+
+  /**
+   * \brief Forget the routes found on demand.
+   */
+  void FlushRouteCache (void);
+
+  /**
+   * \returns The number of destinations whose routes are cached.
+   */
+  uint32_t GetNCachedDestinations (void) const;
+
+  /// The traffic routed through a next hop
+  struct NextHopCounters
+  {
+    NextHopCounters ();
+    uint64_t packets; //!< The number of packets
+    uint64_t bytes;   //!< The number of bytes, with their IPv4 header
+  };
+
+  /**
+   * \brief Get the traffic routed through a next hop, since the last
+   * ResetNextHopCounters ().
+   * \param interface The output interface.
+   * \param gateway The gateway, or 0.0.0.0 for a direct route.
+   * \returns The counters of the next hop.
+   */
+  NextHopCounters GetNextHopCounters (uint32_t interface, Ipv4Address gateway) const;
+
+  /**
+   * \brief Reset the counters of all the next hops.
+   */
+  void ResetNextHopCounters (void);
+
 protected:
   void DoDispose (void);
 
@@ -238,6 +326,12 @@ private:
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP 
   Ptr<UniformRandomVariable> m_rand;
+  /// Set to true if packets are routed among ECMP by a hash of their flow
+  bool m_flowEcmpRouting;
+  /// The seed hashed with the flows
+  uint32_t m_ecmpHashSeed;
+  /// The idle time after which a flow may move to another route, or zero
+  Time m_flowletGap;
 
   /// container of Ipv4RoutingTableEntry (routes to hosts)
   typedef std::list<Ipv4RoutingTableEntry *> HostRoutes;
@@ -264,14 +358,76 @@ private:
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
    * \param oif output interface if any (put 0 otherwise)
+   * \param flowHash the hash of the flow of the packet, for FlowEcmpRouting
+   * \param size the size of the packet with its IPv4 header, or 0 if no
+   * packet is routed
    * \return Ipv4Route to route the packet to reach dest address
    */
-  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
+  Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0,
+                               uint32_t flowHash = 0, uint32_t size = 0);
+
+  /**
+   * \brief Hash the flow of a packet, with the ECMP hash seed.
+   * \param p the packet, without its IPv4 header, or 0
+   * \param header the IPv4 header
+   * \param ports whether the packet starts with its TCP or UDP header
+   * \return the hash of the flow
+   */
+  uint32_t GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header, bool ports) const;
+
+  /**
+   * \brief Pick one of equal cost routes for a packet.
+   * \param nRoutes the number of routes
+   * \param flowHash the hash of the flow of the packet
+   * \param size the size of the packet, or 0 if no packet is routed
+   * \return the index of the route
+   */
+  uint32_t SelectEcmpRoute (uint32_t nRoutes, uint32_t flowHash, uint32_t size);
+
+  /**
+   * \brief Index the routes of the route lists in the tries.
+   */
+  void BuildTries (void);
+
+  /**
+   * \brief Get the routes to a destination found on demand, asking them
+   * to GlobalRouteManager if they are not cached.
+   * \param dest The destination.
+   * \returns The routes to the destination.
+   */
+  RoutesTo &GetRoutesTo (Ipv4Address dest);
 
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4PrefixTrie m_hostTrie;           //!< Index of m_hostRoutes
+  Ipv4PrefixTrie m_networkTrie;        //!< Index of m_networkRoutes
+  Ipv4PrefixTrie m_ASexternalTrie;     //!< Index of m_ASexternalRoutes
+  bool m_triesValid;                   //!< Whether the tries index the current routes
+
+  /// The routes found on demand, most recently used first
+  typedef std::list<std::pair<Ipv4Address, RoutesTo> > RouteCache;
+
+  bool m_routesOnDemand;               //!< Whether the routes are found on demand
+  uint32_t m_routeCacheSize;           //!< The maximum number of destinations cached
+  RouteCache m_routeCache;             //!< The routes found on demand
+  std::unordered_map<Ipv4Address, RouteCache::iterator, Ipv4AddressHash> m_routeCacheIndex; //!< Index of m_routeCache
+
+  /// The route of a flowlet
+  struct Flowlet
+  {
+    Time lastSeen;   //!< The time of the last packet of the flowlet
+    uint32_t route;  //!< The index of the route among the equal cost routes
+  };
+
+  std::unordered_map<uint32_t, Flowlet> m_flowlets; //!< The flowlets, by flow hash
+  uint32_t m_flowletPurgeSize;         //!< The number of flowlets above which the idle ones are forgotten
+
+  /// A next hop: the output interface and the gateway
+  typedef std::pair<uint32_t, Ipv4Address> NextHop;
+  std::map<NextHop, NextHopCounters> m_nextHopCounters; //!< The traffic routed through each next hop
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
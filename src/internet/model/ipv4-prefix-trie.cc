@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ipv4-prefix-trie.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4PrefixTrie");
+
+/**
+ * \param [in] length A prefix length.
+ * \returns The mask of the prefix.
+ */
+static uint32_t
+PrefixMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffffU << (32 - length);
+}
+
+/**
+ * \param [in] value An address.
+ * \param [in] position A bit position, from the most significant bit.
+ * \returns The bit of the address at the position.
+ */
+static uint32_t
+BitAt (uint32_t value, uint8_t position)
+{
+  return (value >> (31 - position)) & 1;
+}
+
+/**
+ * \param [in] a An address.
+ * \param [in] b Another address.
+ * \returns The length of the common prefix of the addresses.
+ */
+static uint8_t
+CommonLength (uint32_t a, uint32_t b)
+{
+  uint32_t diff = a ^ b;
+  uint8_t length = 0;
+  while (length < 32 && !(diff & 0x80000000U))
+    {
+      diff <<= 1;
+      ++length;
+    }
+  return length;
+}
+
+Ipv4PrefixTrie::Ipv4PrefixTrie ()
+  : m_nRoutes (0)
+{
+  NewNode (0, 0);
+}
+
+void
+Ipv4PrefixTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nodes.clear ();
+  m_others.clear ();
+  m_nRoutes = 0;
+  NewNode (0, 0);
+}
+
+int32_t
+Ipv4PrefixTrie::NewNode (uint32_t prefix, uint8_t length)
+{
+  Node node;
+  node.prefix = prefix & PrefixMask (length);
+  node.length = length;
+  node.child[0] = -1;
+  node.child[1] = -1;
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+void
+Ipv4PrefixTrie::Insert (Ipv4Address network, Ipv4Mask mask, Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << network << mask << route);
+  RankedRoute ranked (m_nRoutes++, route);
+  uint8_t length = mask.GetPrefixLength ();
+  if (mask.Get () != PrefixMask (length))
+    {
+      OtherRoute other;
+      other.network = network;
+      other.mask = mask;
+      other.route = ranked;
+      m_others.push_back (other);
+      return;
+    }
+  uint32_t prefix = network.Get () & PrefixMask (length);
+
+  // Walk down from the root, whose prefix is a prefix of every address.
+  int32_t current = 0;
+  for (;;)
+    {
+      if (m_nodes[current].length == length)
+        {
+          m_nodes[current].routes.push_back (ranked);
+          return;
+        }
+      uint32_t bit = BitAt (prefix, m_nodes[current].length);
+      int32_t child = m_nodes[current].child[bit];
+      if (child < 0)
+        {
+          int32_t leaf = NewNode (prefix, length);
+          m_nodes[leaf].routes.push_back (ranked);
+          m_nodes[current].child[bit] = leaf;
+          return;
+        }
+      uint8_t common = std::min (CommonLength (m_nodes[child].prefix, prefix),
+                                 std::min (m_nodes[child].length, length));
+      if (common == m_nodes[child].length)
+        {
+          current = child;
+          continue;
+        }
+      // The new prefix and the child diverge, or the new prefix is a
+      // prefix of the child: insert a node in between.
+      int32_t middle = NewNode (prefix, common);
+      m_nodes[middle].child[BitAt (m_nodes[child].prefix, common)] = child;
+      m_nodes[current].child[bit] = middle;
+      if (common == length)
+        {
+          m_nodes[middle].routes.push_back (ranked);
+        }
+      else
+        {
+          int32_t leaf = NewNode (prefix, length);
+          m_nodes[leaf].routes.push_back (ranked);
+          m_nodes[middle].child[BitAt (prefix, common)] = leaf;
+        }
+      return;
+    }
+}
+
+void
+Ipv4PrefixTrie::Lookup (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry *> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  uint32_t address = dest.Get ();
+  std::vector<RankedRoute> &found = m_found;
+  found.clear ();
+  int32_t current = 0;
+  uint32_t matching = 0;
+  while (current >= 0)
+    {
+      const Node &node = m_nodes[current];
+      if ((address & PrefixMask (node.length)) != node.prefix)
+        {
+          break;
+        }
+      if (!node.routes.empty ())
+        {
+          found.insert (found.end (), node.routes.begin (), node.routes.end ());
+          ++matching;
+        }
+      if (node.length == 32)
+        {
+          break;
+        }
+      current = node.child[BitAt (address, node.length)];
+    }
+  for (std::vector<OtherRoute>::const_iterator i = m_others.begin (); i != m_others.end (); ++i)
+    {
+      if (i->mask.IsMatch (dest, i->network))
+        {
+          found.push_back (i->route);
+          ++matching;
+        }
+    }
+
+  // The routes of a node are in insertion order; merge those of
+  // different nodes.
+  if (matching > 1)
+    {
+      std::sort (found.begin (), found.end ());
+    }
+  routes.clear ();
+  for (std::vector<RankedRoute>::const_iterator i = found.begin (); i != found.end (); ++i)
+    {
+      routes.push_back (i->second);
+    }
+}
+
+uint32_t
+Ipv4PrefixTrie::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+uint32_t
+Ipv4PrefixTrie::GetNNodes (void) const
+{
+  return m_nodes.size ();
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_PREFIX_TRIE_H
+#define IPV4_PREFIX_TRIE_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief A path-compressed binary trie of routes, indexed by prefix.
+ *
+ * Lookup() returns all the routes whose prefix matches an address in
+ * at most 33 steps, instead of scanning a route list.  Each node of the
+ * trie is either a prefix holding routes or a branching point, so the
+ * trie has fewer than two nodes per distinct prefix and its size
+ * grows with the number of routes only.
+ *
+ * The routes keep their insertion order: Lookup() returns the matching
+ * routes in the order they were inserted, whatever their prefix
+ * lengths, so that a route table scanned in list order can be replaced
+ * by the trie without changing which route is picked.
+ *
+ * Routes with a non-contiguous mask are kept aside and matched one by
+ * one.
+ */
+class Ipv4PrefixTrie
+{
+public:
+  Ipv4PrefixTrie ();
+
+  /** Remove all the routes. */
+  void Clear (void);
+
+  /**
+   * Add a route.
+   * \param [in] network The destination network.
+   * \param [in] mask The network mask.
+   * \param [in] route The route.
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, Ipv4RoutingTableEntry *route);
+
+  /**
+   * Find the routes matching an address.
+   * \param [in] dest The address.
+   * \param [out] routes The matching routes, in insertion order.
+   */
+  void Lookup (Ipv4Address dest, std::vector<Ipv4RoutingTableEntry *> &routes) const;
+
+  /**
+   * \returns The number of routes.
+   */
+  uint32_t GetNRoutes (void) const;
+
+  /**
+   * \returns The number of nodes of the trie.
+   */
+  uint32_t GetNNodes (void) const;
+
+private:
+  /** A route, with its insertion rank. */
+  typedef std::pair<uint32_t, Ipv4RoutingTableEntry *> RankedRoute;
+
+  /** A node of the trie. */
+  struct Node
+  {
+    uint32_t prefix;                   //!< The prefix bits, zero beyond length.
+    uint8_t length;                    //!< The prefix length.
+    int32_t child[2];                  //!< The children, by next bit, or -1.
+    std::vector<RankedRoute> routes;   //!< The routes to this prefix.
+  };
+
+  /**
+   * Create a node.
+   * \param [in] prefix The prefix bits.
+   * \param [in] length The prefix length.
+   * \returns The index of the node.
+   */
+  int32_t NewNode (uint32_t prefix, uint8_t length);
+
+  /** A route with a non-contiguous mask. */
+  struct OtherRoute
+  {
+    Ipv4Address network;  //!< The destination network.
+    Ipv4Mask mask;        //!< The network mask.
+    RankedRoute route;    //!< The route.
+  };
+
+  std::vector<Node> m_nodes;          //!< The nodes; the root is the first.
+  std::vector<OtherRoute> m_others;   //!< The routes with a non-contiguous mask.
+  mutable std::vector<RankedRoute> m_found; //!< The routes found by Lookup(), reused.
+  uint32_t m_nRoutes;                 //!< The number of routes.
+};
+
+} // namespace ns3
+
+#endif /* IPV4_PREFIX_TRIE_H */
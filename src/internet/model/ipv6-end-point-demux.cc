@@ -29,7 +29,8 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_allocated (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -45,23 +46,82 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   m_endPoints.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::PeerKey::operator== (const PeerKey &other) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  return localPort == other.localPort && peerPort == other.peerPort
+         && peerAddress == other.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::PeerKeyHash::operator() (const PeerKey &key) const
+{
+  return Ipv6AddressHash () (key.peerAddress) ^ ((key.localPort << 16) | key.peerPort);
+}
+
+Ipv6EndPointDemux::PeerKey Ipv6EndPointDemux::GetPeerKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  PeerKey key;
+  key.peerAddress = peerAddress;
+  key.localPort = localPort;
+  key.peerPort = peerPort;
+  return key;
+}
+
+const Ipv6EndPointDemux::EndPoints *Ipv6EndPointDemux::FindPeer (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort) const
+{
+  std::unordered_map<PeerKey, EndPoints, PeerKeyHash>::const_iterator i = m_peers.find (GetPeerKey (localPort, peerAddress, peerPort));
+  if (i == m_peers.end ())
     {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
+      return 0;
     }
-  return false;
+  return &i->second;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Position position;
+  position.endPoint = m_endPoints.insert (m_endPoints.end (), endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  position.port = port.insert (port.end (), endPoint);
+  position.peerKey = GetPeerKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  EndPoints &peer = m_peers[position.peerKey];
+  position.peer = peer.insert (peer.end (), endPoint);
+  position.order = m_allocated++;
+  m_positions[endPoint] = position;
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void Ipv6EndPointDemux::UpdatePeer (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Position &position = m_positions[endPoint];
+  std::unordered_map<PeerKey, EndPoints, PeerKeyHash>::iterator old = m_peers.find (position.peerKey);
+  old->second.erase (position.peer);
+  if (old->second.empty ())
+    {
+      m_peers.erase (old);
+    }
+  position.peerKey = GetPeerKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  EndPoints &peer = m_peers[position.peerKey];
+  position.peer = peer.insert (peer.end (), endPoint);
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (port);
+  if (endPoints == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++)
     {
       if ((*i)->GetLocalPort () == port &&
           (*i)->GetLocalAddress () == addr &&
@@ -83,8 +143,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -98,8 +157,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -119,8 +177,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -129,23 +186,22 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  const EndPoints *endPoints = FindPeer (localPort, peerAddress, peerPort);
+  if (endPoints)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress &&
-          ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+      for (EndPoints::const_iterator i = endPoints->begin (); i != endPoints->end (); i++)
         {
-          NS_LOG_WARN ("Duplicated endpoint.");
-          return 0;
+          if ((*i)->GetLocalAddress () == localAddress &&
+              ((*i)->GetBoundNetDevice () == boundNetDevice || (*i)->GetBoundNetDevice () == 0))
+            {
+              NS_LOG_WARN ("Duplicated endpoint.");
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -153,15 +209,27 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<Ipv6EndPoint *, Position>::iterator position = m_positions.find (endPoint);
+  if (position == m_positions.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  m_endPoints.erase (position->second.endPoint);
+  std::unordered_map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  port->second.erase (position->second.port);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  std::unordered_map<PeerKey, EndPoints, PeerKeyHash>::iterator peer = m_peers.find (position->second.peerKey);
+  peer->second.erase (position->second.peer);
+  if (peer->second.empty ())
+    {
+      m_peers.erase (peer);
     }
+  m_positions.erase (position);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -180,8 +248,25 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval3; /* Matches all but local address */
   EndPoints retval4; /* Exact match on all 4 */
 
+  /* Only the end points connected to the source of the packet, and
+     those open to any peer, can match */
+  EndPoints candidates;
+  const EndPoints *connected = FindPeer (dport, saddr, sport);
+  if (connected)
+    {
+      candidates = *connected;
+    }
+  if (saddr != Ipv6Address::GetAny () || sport != 0)
+    {
+      const EndPoints *open = FindPeer (dport, Ipv6Address::GetAny (), 0);
+      if (open)
+        {
+          candidates.insert (candidates.end (), open->begin (), open->end ());
+        }
+    }
+
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -290,24 +375,38 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
-  uint32_t genericity = 3;
-  Ipv6EndPoint *generic = 0;
-
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  const EndPoints *connected = FindPeer (dport, src, sport);
+  if (connected)
     {
-      uint32_t tmp = 0;
-
-      if ((*i)->GetLocalPort () != dport)
+      Ipv6EndPoint *exact = 0;
+      uint64_t exactOrder = 0;
+      for (EndPoints::const_iterator i = connected->begin (); i != connected->end (); i++)
         {
-          continue;
+          uint64_t order = m_positions[*i].order;
+          if ((*i)->GetLocalAddress () == dst && (exact == 0 || order < exactOrder))
+            {
+              /* this is an exact match, the first allocated if several. */
+              exact = *i;
+              exactOrder = order;
+            }
         }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
+      if (exact)
         {
-          /* this is an exact match. */
-          return *i;
+          return exact;
         }
+    }
+
+  std::unordered_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (dport);
+  if (endPoints == m_ports.end ())
+    {
+      return 0;
+    }
+  uint32_t genericity = 3;
+  Ipv6EndPoint *generic = 0;
+
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end () && genericity > 0; i++)
+    {
+      uint32_t tmp = 0;
 
       if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
         {
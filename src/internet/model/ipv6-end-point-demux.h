@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +35,11 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The endpoints are indexed by local port, and by local port and peer, so
+ * that a lookup only looks at the endpoints connected to the peer of the
+ * packet and at those listening on its port, however many connections
+ * the node has.  The endpoints tell the demux when their peer changes.
  */
 class Ipv6EndPointDemux
 {
@@ -153,6 +159,68 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The key of the end points with a local port and peer.
+   */
+  struct PeerKey
+  {
+    Ipv6Address peerAddress;  //!< The peer address
+    uint16_t localPort;       //!< The local port
+    uint16_t peerPort;        //!< The peer port
+
+    /**
+     * \brief Compare two keys.
+     * \param other the other key
+     * \returns true if the keys are equal
+     */
+    bool operator== (const PeerKey &other) const;
+  };
+
+  /**
+   * \brief Hash function class for PeerKey.
+   */
+  struct PeerKeyHash
+  {
+    /**
+     * \brief Hash a key.
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator() (const PeerKey &key) const;
+  };
+
+  /**
+   * \brief Add a new end point to the containers.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Move an end point to the index of its new peer.
+   * \param endPoint the end point
+   */
+  void UpdatePeer (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Get the key of the end points with a local port and peer.
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns the key
+   */
+  static PeerKey GetPeerKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Find the end points with a local port and peer.
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns the end points, or 0 if there is none
+   */
+  const EndPoints *FindPeer (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort) const;
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -178,6 +246,38 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The place of an end point in the containers.
+   */
+  struct Position
+  {
+    EndPointsI endPoint;  //!< The end point in m_endPoints
+    EndPointsI port;      //!< The end point in m_ports
+    EndPointsI peer;      //!< The end point in m_peers
+    PeerKey peerKey;      //!< The key of the end point in m_peers
+    uint64_t order;       //!< The allocation order of the end point
+  };
+
+  /**
+   * \brief The end points, by local port, in allocation order.
+   */
+  std::unordered_map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The end points, by local port and peer.
+   */
+  std::unordered_map<PeerKey, EndPoints, PeerKeyHash> m_peers;
+
+  /**
+   * \brief The place of each end point in the containers.
+   */
+  std::unordered_map<Ipv6EndPoint *, Position> m_positions;
+
+  /**
+   * \brief The number of end points allocated.
+   */
+  uint64_t m_allocated;
 };
 
 } /* namespace ns3 */
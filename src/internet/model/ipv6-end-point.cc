@@ -23,6 +23,7 @@
 #include "ns3/simulator.h"
 
 #include "ipv6-end-point.h"
+#include "ipv6-end-point-demux.h"
 
 namespace ns3
 {
@@ -34,7 +35,8 @@ Ipv6EndPoint::Ipv6EndPoint (Ipv6Address addr, uint16_t port)
     m_localPort (port),
     m_peerAddr (Ipv6Address::GetAny ()),
     m_peerPort (0),
-    m_rxEnabled (true)
+    m_rxEnabled (true),
+    m_demux (0)
 {
 }
 
@@ -94,6 +96,10 @@ void Ipv6EndPoint::SetPeer (Ipv6Address addr, uint16_t port)
 {
   m_peerAddr = addr;
   m_peerPort = port;
+  if (m_demux)
+    {
+      m_demux->UpdatePeer (this);
+    }
 }
 
 void Ipv6EndPoint::SetRxCallback (Callback<void, Ptr<Packet>, Ipv6Header, uint16_t, Ptr<Ipv6Interface> > callback)
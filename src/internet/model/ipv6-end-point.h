@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \ingroup ipv6
@@ -236,6 +237,13 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  friend class Ipv6EndPointDemux;
+
+  /**
+   * \brief The demux indexing the endpoint, told when the peer changes.
+   */
+  Ipv6EndPointDemux *m_demux;
 };
 
 } /* namespace ns3 */
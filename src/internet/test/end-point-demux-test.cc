@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-end-point.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-interface.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that Ipv4EndPointDemux finds the most specific end point
+ * through its indexes, as the peers of the end points change.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of Ipv4EndPointDemux")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  Ipv4Address local ("10.0.0.1");
+
+  Ipv4EndPoint *listener = demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener not allocated");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, 80), 0, "Duplicated listener allocated");
+  Ipv4EndPoint *boundListener = demux.Allocate (0, local, 80);
+  NS_TEST_ASSERT_MSG_NE (boundListener, 0, "Bound listener not allocated");
+
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      Ipv4Address peer (Ipv4Address ("10.1.0.0").Get () + i);
+      connections.push_back (demux.Allocate (0, local, 80, peer, 1024 + i % 7));
+      NS_TEST_ASSERT_MSG_NE (connections.back (), 0, "Connection not allocated");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, Ipv4Address ("10.1.0.5"), 1024 + 5), 0,
+                         "Duplicated connection allocated");
+
+  Ipv4EndPointDemux::EndPoints found;
+  for (uint32_t i = 0; i < 1000; i += 37)
+    {
+      Ipv4Address peer (Ipv4Address ("10.1.0.0").Get () + i);
+      found = demux.Lookup (local, 80, peer, 1024 + i % 7, interface);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Connection not found");
+      NS_TEST_EXPECT_MSG_EQ (found.front (), connections[i], "Wrong connection found");
+      NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1024 + i % 7), connections[i],
+                             "Wrong connection found by SimpleLookup");
+    }
+  // A new peer falls back on the listener bound to the address, then on
+  // the listener bound to any address.
+  found = demux.Lookup (local, 80, Ipv4Address ("10.2.0.1"), 1024, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Bound listener not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), boundListener, "Wrong listener found");
+  found = demux.Lookup (Ipv4Address ("10.0.0.2"), 80, Ipv4Address ("10.2.0.1"), 1024, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Wrong listener found");
+  found = demux.Lookup (local, 81, Ipv4Address ("10.2.0.1"), 1024, interface);
+  NS_TEST_EXPECT_MSG_EQ (found.size (), 0, "End point found on a closed port");
+
+  // An ephemeral end point is found once connected.
+  Ipv4EndPoint *client = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Ephemeral end point not allocated");
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, Ipv4Address ("10.3.0.1"), 80, interface).front (), client,
+                         "Unconnected end point not found");
+  client->SetLocalAddress (local);
+  client->SetPeer (Ipv4Address ("10.3.0.1"), 80);
+  found = demux.Lookup (local, port, Ipv4Address ("10.3.0.1"), 80, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Connected end point not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), client, "Wrong end point found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, Ipv4Address ("10.3.0.2"), 80, interface).size (), 0,
+                         "Connected end point found for another peer");
+
+  // The ephemeral ports count up, skipping the ports in use.
+  Ipv4EndPoint *next = demux.Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (next->GetLocalPort (), port + 1, "Wrong ephemeral port");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), true, "Port not in use");
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Port still in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, Ipv4Address ("10.3.0.1"), 80, interface).size (), 0,
+                         "Deallocated end point found");
+
+  demux.DeAllocate (connections[37]);
+  found = demux.Lookup (local, 80, Ipv4Address ("10.1.0.37"), 1024 + 37 % 7, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Bound listener not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), boundListener, "Deallocated connection found");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 1002, "Wrong number of end points");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that Ipv6EndPointDemux finds the most specific end point
+ * through its indexes, as the peers of the end points change.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the lookups of Ipv6EndPointDemux")
+{
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ptr<Ipv6Interface> interface = CreateObject<Ipv6Interface> ();
+  Ipv6Address local ("2001:db8::1");
+
+  Ipv6EndPoint *listener = demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener not allocated");
+  Ipv6EndPoint *boundListener = demux.Allocate (0, local, 80);
+  NS_TEST_ASSERT_MSG_NE (boundListener, 0, "Bound listener not allocated");
+
+  std::vector<Ipv6EndPoint *> connections;
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint8_t peer[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 1 };
+      peer[14] = i >> 8;
+      peer[15] = i;
+      connections.push_back (demux.Allocate (0, local, 80, Ipv6Address (peer), 1024 + i % 7));
+      NS_TEST_ASSERT_MSG_NE (connections.back (), 0, "Connection not allocated");
+    }
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 80, connections[5]->GetPeerAddress (), 1024 + 5), 0,
+                         "Duplicated connection allocated");
+
+  Ipv6EndPointDemux::EndPoints found;
+  for (uint32_t i = 0; i < 1000; i += 37)
+    {
+      Ipv6Address peer = connections[i]->GetPeerAddress ();
+      found = demux.Lookup (local, 80, peer, 1024 + i % 7, interface);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Connection not found");
+      NS_TEST_EXPECT_MSG_EQ (found.front (), connections[i], "Wrong connection found");
+      NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1024 + i % 7), connections[i],
+                             "Wrong connection found by SimpleLookup");
+    }
+  found = demux.Lookup (local, 80, Ipv6Address ("2001:db8:2::1"), 1024, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Bound listener not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), boundListener, "Wrong listener found");
+  found = demux.Lookup (Ipv6Address ("2001:db8::2"), 80, Ipv6Address ("2001:db8:2::1"), 1024, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), listener, "Wrong listener found");
+
+  Ipv6EndPoint *client = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Ephemeral end point not allocated");
+  uint16_t port = client->GetLocalPort ();
+  client->SetLocalAddress (local);
+  client->SetPeer (Ipv6Address ("2001:db8:3::1"), 80);
+  found = demux.Lookup (local, port, Ipv6Address ("2001:db8:3::1"), 80, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Connected end point not found");
+  NS_TEST_EXPECT_MSG_EQ (found.front (), client, "Wrong end point found");
+  NS_TEST_EXPECT_MSG_EQ (demux.Lookup (local, port, Ipv6Address ("2001:db8:3::2"), 80, interface).size (), 0,
+                         "Connected end point found for another peer");
+
+  Ipv6EndPoint *next = demux.Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (next->GetLocalPort (), port + 1, "Wrong ephemeral port");
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Port still in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 1003, "Wrong number of end points");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 and IPv6 end point demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
@@ -226,6 +226,60 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the order in which the CandidateQueue pops the vertices.
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue ordering")
+{
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  SPFVertex *v[6];
+  static const uint32_t distances[6] = { 5, 3, 5, 7, 3, 9 };
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      v[i] = new SPFVertex;
+      v[i]->SetVertexId (Ipv4Address (i + 1));
+      v[i]->SetVertexType (i == 2 ? SPFVertex::VertexNetwork : SPFVertex::VertexRouter);
+      v[i]->SetDistanceFromRoot (distances[i]);
+      candidate.Push (v[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 6, "Wrong queue size");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (4)), v[3], "Vertex not found");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (7)), 0, "Unknown vertex found");
+
+  // A shorter path to a vertex moves it behind the vertices at its new
+  // distance.
+  v[5]->SetDistanceFromRoot (3);
+  candidate.Reorder (v[5]);
+
+  // Equal distances pop networks first, then in push order.
+  static const uint32_t order[6] = { 1, 4, 5, 2, 0, 3 };
+  for (uint32_t i = 0; i < 6; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (candidate.Top (), v[order[i]], "Wrong top vertex " << i);
+      SPFVertex *popped = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (popped, v[order[i]], "Wrong vertex popped " << i);
+      NS_TEST_ASSERT_MSG_EQ (candidate.Find (popped->GetVertexId ()), 0, "Popped vertex found");
+      delete popped;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -243,6 +297,7 @@ GlobalRouteManagerImplTestSuite::GlobalRouteManagerImplTestSuite ()
   : TestSuite ("global-route-manager-impl", UNIT)
 {
   AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+  AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
 }
 
 static GlobalRouteManagerImplTestSuite g_globalRoutingManagerImplTestSuite; //!< Static variable for test initialization
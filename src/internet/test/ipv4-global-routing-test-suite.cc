@@ -14,9 +14,14 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/global-route-manager.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
@@ -42,6 +47,7 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/tcp-header.h"
 
 using namespace ns3;
 
@@ -1244,6 +1250,626 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the route tries of Ipv4GlobalRouting pick the
+ * routes a scan of the route lists would pick.
+ */
+class Ipv4GlobalRoutingLookupTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \returns A pseudo-random number.
+   */
+  uint32_t Random (void);
+  /// \brief Copy the routes of the routing protocol into m_routes.
+  void ListRoutes (void);
+  /**
+   * \brief Find the route to a destination by scanning the routes.
+   * \param dest The destination.
+   * \param oif The output interface, or zero.
+   * \returns The route, or zero.
+   */
+  Ipv4RoutingTableEntry *ScanRoutes (Ipv4Address dest, uint32_t oif) const;
+  /**
+   * \brief Check the route to a destination.
+   * \param dest The destination.
+   * \param oif The output interface, or zero.
+   */
+  void CheckRoute (Ipv4Address dest, uint32_t oif);
+
+  uint32_t m_seed;                    //!< The state of Random().
+  Ptr<Ipv4> m_ipv4;                   //!< The IPv4 stack.
+  Ptr<Ipv4GlobalRouting> m_routing;   //!< The routing protocol.
+  uint32_t m_nHostRoutes;             //!< The number of host routes.
+  uint32_t m_nNetworkRoutes;          //!< The number of network routes.
+  std::vector<Ipv4RoutingTableEntry *> m_routes; //!< The routes, in lookup order.
+};
+
+Ipv4GlobalRoutingLookupTestCase::Ipv4GlobalRoutingLookupTestCase ()
+  : TestCase ("Global routing lookups through the route tries"),
+    m_seed (1),
+    m_nHostRoutes (0),
+    m_nNetworkRoutes (0)
+{
+}
+
+uint32_t
+Ipv4GlobalRoutingLookupTestCase::Random (void)
+{
+  m_seed = m_seed * 1664525 + 1013904223;
+  return m_seed >> 8;
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::ListRoutes (void)
+{
+  m_routes.clear ();
+  for (uint32_t i = 0; i < m_routing->GetNRoutes (); i++)
+    {
+      m_routes.push_back (m_routing->GetRoute (i));
+    }
+}
+
+Ipv4RoutingTableEntry *
+Ipv4GlobalRoutingLookupTestCase::ScanRoutes (Ipv4Address dest, uint32_t oif) const
+{
+  for (uint32_t i = 0; i < m_nHostRoutes; i++)
+    {
+      Ipv4RoutingTableEntry *route = m_routes[i];
+      if (route->GetDest () == dest && (oif == 0 || route->GetInterface () == oif))
+        {
+          return route;
+        }
+    }
+  for (uint32_t i = m_nHostRoutes; i < m_routes.size (); i++)
+    {
+      Ipv4RoutingTableEntry *route = m_routes[i];
+      if (route->GetDestNetworkMask ().IsMatch (dest, route->GetDestNetwork ())
+          && (oif == 0 || route->GetInterface () == oif))
+        {
+          return route;
+        }
+    }
+  return 0;
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::CheckRoute (Ipv4Address dest, uint32_t oif)
+{
+  Ipv4RoutingTableEntry *expected = ScanRoutes (dest, oif);
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<NetDevice> device = oif == 0 ? 0 : m_ipv4->GetNetDevice (oif);
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, device, sockerr);
+  if (expected == 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (route, 0, "Unexpected route to " << dest);
+      return;
+    }
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to " << dest);
+  NS_TEST_EXPECT_MSG_EQ (route->GetGateway (), expected->GetGateway (), "Wrong route to " << dest);
+  NS_TEST_EXPECT_MSG_EQ (route->GetOutputDevice (), m_ipv4->GetNetDevice (expected->GetInterface ()),
+                         "Wrong interface to " << dest);
+}
+
+void
+Ipv4GlobalRoutingLookupTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (node);
+  SimpleNetDeviceHelper simpleHelper;
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      devices.Add (simpleHelper.Install (node));
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("192.168.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      ipv4.Assign (NetDeviceContainer (devices.Get (i)));
+      ipv4.NewNetwork ();
+    }
+  m_ipv4 = node->GetObject<Ipv4> ();
+  m_routing = m_ipv4->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+
+  // Overlapping routes of many lengths, in a small part of 10.0.0.0/8,
+  // with equal cost routes to some prefixes; the gateway identifies
+  // each route.
+  static const uint8_t lengths[] = { 8, 12, 16, 20, 22, 24, 26, 28, 30, 32 };
+  uint32_t gateway = Ipv4Address ("172.16.0.0").Get ();
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      Ipv4Address dest (0x0a000000 | (Random () & 0x0003ff0f));
+      m_routing->AddHostRouteTo (dest, Ipv4Address (++gateway), 1 + Random () % 3);
+      m_nHostRoutes++;
+      if (Random () % 4 == 0)
+        {
+          m_routing->AddHostRouteTo (dest, Ipv4Address (++gateway), 1 + Random () % 3);
+          m_nHostRoutes++;
+        }
+    }
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      Ipv4Mask mask (~0U << (32 - lengths[Random () % 10]));
+      Ipv4Address network (0x0a000000 | (Random () & 0x0003ff0f));
+      m_routing->AddNetworkRouteTo (network.CombineMask (mask), mask, Ipv4Address (++gateway), 1 + Random () % 3);
+      m_nNetworkRoutes++;
+    }
+  m_routing->AddASExternalRouteTo ("10.0.0.0", "255.0.0.0", Ipv4Address (++gateway), 2);
+  m_routing->AddASExternalRouteTo ("0.0.0.0", "0.0.0.0", Ipv4Address (++gateway), 1);
+  m_routing->AddASExternalRouteTo ("0.0.0.0", "0.0.0.0", Ipv4Address (++gateway), 3);
+  // A non-contiguous mask is matched, if not indexed.
+  m_routing->AddNetworkRouteTo ("10.0.0.1", "255.255.0.255", Ipv4Address (++gateway), 2);
+  m_nNetworkRoutes++;
+
+  NS_TEST_ASSERT_MSG_EQ (m_nHostRoutes + m_nNetworkRoutes + 3, m_routing->GetNRoutes (), "Wrong route count");
+  ListRoutes ();
+
+  for (uint32_t i = 0; i < 3000; i++)
+    {
+      Ipv4Address dest (0x0a000000 | (Random () & 0x0003ff0f));
+      if (i % 10 == 0)
+        {
+          dest = Ipv4Address (Random ());
+        }
+      CheckRoute (dest, i % 5 == 0 ? 1 + Random () % 3 : 0);
+    }
+
+  // The tries follow the removal of routes.
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      uint32_t index = Random () % (m_nHostRoutes + m_nNetworkRoutes);
+      if (index < m_nHostRoutes)
+        {
+          m_nHostRoutes--;
+        }
+      else
+        {
+          m_nNetworkRoutes--;
+        }
+      m_routing->RemoveRoute (index);
+      ListRoutes ();
+      for (uint32_t j = 0; j < 10; j++)
+        {
+          Ipv4Address dest (0x0a000000 | (Random () & 0x0003ff0f));
+          CheckRoute (dest, 0);
+        }
+    }
+
+  // The equal cost routes are all candidates of RandomEcmpRouting.
+  m_routing->AddHostRouteTo ("10.9.9.9", "172.31.0.1", 1);
+  m_routing->AddHostRouteTo ("10.9.9.9", "172.31.0.2", 2);
+  m_routing->AddHostRouteTo ("10.9.9.9", "172.31.0.3", 3);
+  m_routing->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  std::set<Ipv4Address> gateways;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ipv4Header header;
+      header.SetDestination ("10.9.9.9");
+      Socket::SocketErrno sockerr;
+      Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+      NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.9.9.9");
+      gateways.insert (route->GetGateway ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (gateways.size (), 3, "Not all the equal cost routes were used");
+  NS_TEST_EXPECT_MSG_EQ ((gateways.begin ()->Get () >> 8), (Ipv4Address ("172.31.0.0").Get () >> 8),
+                         "A route not to 10.9.9.9 was used");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the routes updated by GlobalRouteManager::UpdateRoutes,
+ * or calculated by several threads, are the routes of a full calculation.
+ */
+class Ipv4GlobalRoutingUpdateTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingUpdateTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Print the routes of the nodes.
+   * \returns The routes, in table order, one node per line.
+   */
+  std::string GetRoutes (void) const;
+  /**
+   * \brief Delete, rebuild and recalculate all the routes.
+   * \param threads The number of threads calculating the routes.
+   */
+  void Recompute (uint32_t threads);
+
+  NodeContainer m_nodes;   //!< The nodes.
+};
+
+Ipv4GlobalRoutingUpdateTestCase::Ipv4GlobalRoutingUpdateTestCase ()
+  : TestCase ("Global routing updates and parallel calculations")
+{
+}
+
+std::string
+Ipv4GlobalRoutingUpdateTestCase::GetRoutes (void) const
+{
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<Ipv4> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          oss << *routing->GetRoute (j) << "; ";
+        }
+      oss << std::endl;
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::Recompute (uint32_t threads)
+{
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (threads));
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::DoRun (void)
+{
+  // A ring of 8 routers on point-to-point links, with a chord and a LAN,
+  // so that there are equal cost paths; and a separate pair of routers.
+  m_nodes.Create (10);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  devHelper.SetNetDevicePointToPointMode (true);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (i), m_nodes.Get ((i + 1) % 8))));
+      ipv4.NewNetwork ();
+    }
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (0), m_nodes.Get (4))));
+  ipv4.NewNetwork ();
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (8), m_nodes.Get (9))));
+  ipv4.NewNetwork ();
+  devHelper.SetNetDevicePointToPointMode (false);
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (2), m_nodes.Get (6), m_nodes.Get (7))));
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string initial = GetRoutes ();
+  Ptr<Ipv4GlobalRouting> routing8 = m_nodes.Get (8)->GetObject<Ipv4> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  NS_TEST_ASSERT_MSG_EQ (routing8->GetNRoutes (), 1, "Node 8 has no default route");
+
+  Recompute (4);
+  NS_TEST_ASSERT_MSG_EQ (GetRoutes (), initial, "Routes calculated by 4 threads differ");
+
+  // Take a link of the ring down: the routes of the ring are updated,
+  // those of the separate pair are kept.
+  Ipv4RoutingTableEntry *route8 = routing8->GetRoute (0);
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Ptr<Ipv4> ipv4Node1 = m_nodes.Get (1)->GetObject<Ipv4> ();
+  ipv4Node1->SetDown (2);
+  GlobalRouteManager::UpdateRoutes ();
+  std::string updated = GetRoutes ();
+  NS_TEST_ASSERT_MSG_NE (updated, initial, "The routes were not updated");
+  NS_TEST_EXPECT_MSG_EQ (routing8->GetRoute (0), route8, "The routes of node 8 were recalculated");
+  Recompute (1);
+  NS_TEST_ASSERT_MSG_EQ (GetRoutes (), updated, "Updated routes differ from recalculated routes");
+
+  // And back up, updated by 3 threads.
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (3));
+  ipv4Node1->SetUp (2);
+  GlobalRouteManager::UpdateRoutes ();
+  NS_TEST_EXPECT_MSG_EQ (GetRoutes (), initial, "Routes updated by 3 threads differ");
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the routes found on demand are those of the
+ * routing tables.
+ */
+class Ipv4GlobalRoutingOnDemandTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingOnDemandTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look the addresses of the nodes up from every node.
+   * \returns The gateway and interface of each lookup, one node per line.
+   */
+  std::string GetLookups (void) const;
+
+  NodeContainer m_nodes;                 //!< The nodes.
+  std::vector<Ipv4Address> m_addresses;  //!< The addresses looked up.
+};
+
+Ipv4GlobalRoutingOnDemandTestCase::Ipv4GlobalRoutingOnDemandTestCase ()
+  : TestCase ("Global routes found on demand")
+{
+}
+
+std::string
+Ipv4GlobalRoutingOnDemandTestCase::GetLookups (void) const
+{
+  std::ostringstream oss;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> ipv4 = m_nodes.Get (i)->GetObject<Ipv4> ();
+      Ptr<Ipv4GlobalRouting> routing = ipv4->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      for (std::vector<Ipv4Address>::const_iterator j = m_addresses.begin (); j != m_addresses.end (); j++)
+        {
+          Ipv4Header header;
+          header.SetDestination (*j);
+          Socket::SocketErrno sockerr;
+          Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+          if (route)
+            {
+              oss << route->GetGateway () << "/" << ipv4->GetInterfaceForDevice (route->GetOutputDevice ()) << " ";
+            }
+          else
+            {
+              oss << "none ";
+            }
+        }
+      oss << std::endl;
+    }
+  return oss.str ();
+}
+
+void
+Ipv4GlobalRoutingOnDemandTestCase::DoRun (void)
+{
+  // A ring of 8 routers on point-to-point links, with a chord and a LAN.
+  m_nodes.Create (8);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  devHelper.SetNetDevicePointToPointMode (true);
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (i), m_nodes.Get ((i + 1) % 8))));
+      ipv4.NewNetwork ();
+    }
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (0), m_nodes.Get (4))));
+  ipv4.NewNetwork ();
+  devHelper.SetNetDevicePointToPointMode (false);
+  ipv4.Assign (devHelper.Install (NodeContainer (m_nodes.Get (2), m_nodes.Get (6), m_nodes.Get (7))));
+
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4> node = m_nodes.Get (i)->GetObject<Ipv4> ();
+      for (uint32_t j = 1; j < node->GetNInterfaces (); j++)
+        {
+          m_addresses.push_back (node->GetAddress (j, 0).GetLocal ());
+        }
+    }
+  m_addresses.push_back ("10.1.9.99");
+  m_addresses.push_back ("192.168.1.1");
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string tables = GetLookups ();
+
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  Ptr<Ipv4GlobalRouting> routing0 = m_nodes.Get (0)->GetObject<Ipv4> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  routing0->SetAttribute ("RouteCacheSize", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTablesOnDemand ();
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetRoutesOnDemand (), true, "Routes not on demand");
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetNRoutes (), 0, "Routes added to the table");
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetNCachedDestinations (), 0, "Routes found before a lookup");
+  NS_TEST_ASSERT_MSG_EQ (GetLookups (), tables, "Routes found on demand differ from the tables");
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetNCachedDestinations (), 4, "Wrong number of destinations cached");
+  // Twice, through the route caches.
+  NS_TEST_ASSERT_MSG_EQ (GetLookups (), tables, "Cached routes differ from the tables");
+  // Again, calculating the routes of the routers evicted from a small
+  // SPF cache.
+  Config::SetGlobal ("GlobalRoutingSpfCacheSize", UintegerValue (2));
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      m_nodes.Get (i)->GetObject<Ipv4> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ()->FlushRouteCache ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (GetLookups (), tables, "Routes of evicted routers differ from the tables");
+  Config::SetGlobal ("GlobalRoutingSpfCacheSize", UintegerValue (64));
+
+  // A link down flushes the caches.
+  Ptr<Ipv4> ipv4Node1 = m_nodes.Get (1)->GetObject<Ipv4> ();
+  ipv4Node1->SetDown (1);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetNCachedDestinations (), 0, "Route cache not flushed");
+  std::string updated = GetLookups ();
+  NS_TEST_ASSERT_MSG_NE (updated, tables, "Routes not updated");
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetRoutesOnDemand (), false, "Routes still on demand");
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (GetLookups (), updated, "Updated routes differ from the tables");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that FlowEcmpRouting keeps the packets of a flow on one
+ * route, spreads the flows, and moves the flowlets.
+ */
+class Ipv4GlobalRoutingFlowEcmpTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFlowEcmpTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Route a TCP segment of node 0 to node 3.
+   * \param port The source port of the segment.
+   * \returns The gateway of the route.
+   */
+  Ipv4Address Route (uint16_t port);
+
+  /**
+   * \brief Route a TCP segment of a flow, and record its gateway.
+   */
+  void RouteFlowlet (void);
+
+  Ptr<Ipv4GlobalRouting> m_routing;        //!< The routing protocol of node 0.
+  Ipv4Address m_destination;               //!< The address of node 3.
+  std::vector<Ipv4Address> m_flowletRoutes; //!< The gateways of the flowlet segments.
+};
+
+Ipv4GlobalRoutingFlowEcmpTestCase::Ipv4GlobalRoutingFlowEcmpTestCase ()
+  : TestCase ("Global routing per-flow ECMP and flowlets")
+{
+}
+
+Ipv4Address
+Ipv4GlobalRoutingFlowEcmpTestCase::Route (uint16_t port)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  TcpHeader tcpHeader;
+  tcpHeader.SetSourcePort (port);
+  tcpHeader.SetDestinationPort (80);
+  p->AddHeader (tcpHeader);
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.0.1"));
+  header.SetDestination (m_destination);
+  header.SetProtocol (6);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (p, header, 0, sockerr);
+  NS_ASSERT (route);
+  return route->GetGateway ();
+}
+
+void
+Ipv4GlobalRoutingFlowEcmpTestCase::RouteFlowlet (void)
+{
+  m_flowletRoutes.push_back (Route (1000));
+}
+
+void
+Ipv4GlobalRoutingFlowEcmpTestCase::DoRun (void)
+{
+  // Two equal cost routes from node 0 to node 3, through nodes 1 and 2.
+  NodeContainer nodes;
+  nodes.Create (4);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  uint32_t links[4][2] = { { 0, 1 }, { 0, 2 }, { 1, 3 }, { 2, 3 } };
+  Ipv4InterfaceContainer interfaces;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      interfaces.Add (ipv4.Assign (devHelper.Install (NodeContainer (nodes.Get (links[i][0]), nodes.Get (links[i][1])))));
+      ipv4.NewNetwork ();
+    }
+  m_destination = interfaces.GetAddress (7);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  m_routing = nodes.Get (0)->GetObject<Ipv4> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  m_routing->SetAttribute ("FlowEcmpRouting", BooleanValue (true));
+  m_routing->ResetNextHopCounters ();
+
+  // The segments of a flow take the same route; the flows take both.
+  std::vector<Ipv4Address> routes;
+  std::map<Ipv4Address, uint32_t> routesUsed;
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      Ipv4Address gateway = Route (port);
+      NS_TEST_ASSERT_MSG_EQ (Route (port), gateway, "A flow changed route");
+      routes.push_back (gateway);
+      routesUsed[gateway] += 2;
+    }
+  NS_TEST_ASSERT_MSG_EQ (routesUsed.size (), 2, "The flows are not spread over the routes");
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = routesUsed.begin (); i != routesUsed.end (); i++)
+    {
+      uint32_t interface = i->first == interfaces.GetAddress (1) ? 1 : 2;
+      Ipv4GlobalRouting::NextHopCounters counters = m_routing->GetNextHopCounters (interface, i->first);
+      NS_TEST_EXPECT_MSG_EQ (counters.packets, i->second, "Wrong number of packets through " << i->first);
+      NS_TEST_EXPECT_MSG_EQ (counters.bytes, i->second * 140, "Wrong number of bytes through " << i->first);
+    }
+  m_routing->ResetNextHopCounters ();
+  NS_TEST_EXPECT_MSG_EQ (m_routing->GetNextHopCounters (1, interfaces.GetAddress (1)).packets, 0, "Counters not reset");
+
+  // Another seed spreads the flows differently.
+  m_routing->SetAttribute ("EcmpHashSeed", UintegerValue (1));
+  uint32_t moved = 0;
+  for (uint16_t port = 1000; port < 1064; port++)
+    {
+      moved += Route (port) != routes[port - 1000];
+    }
+  NS_TEST_ASSERT_MSG_GT (moved, 0, "The seed does not change the hash");
+
+  // With flowlets, a flow keeps its route while its segments are closer
+  // than the gap, and takes both routes when its flowlets are apart.
+  m_routing->SetAttribute ("FlowletGap", TimeValue (MilliSeconds (10)));
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Simulator::Schedule (MilliSeconds (5 * i), &Ipv4GlobalRoutingFlowEcmpTestCase::RouteFlowlet, this);
+    }
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Simulator::Schedule (Seconds (1) + MilliSeconds (20 * i), &Ipv4GlobalRoutingFlowEcmpTestCase::RouteFlowlet, this);
+    }
+  Simulator::Run ();
+  std::set<Ipv4Address> flowletRoutes;
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_flowletRoutes[i], m_flowletRoutes[0], "A flowlet changed route");
+    }
+  for (uint32_t i = 20; i < m_flowletRoutes.size (); i++)
+    {
+      flowletRoutes.insert (m_flowletRoutes[i]);
+    }
+  NS_TEST_EXPECT_MSG_EQ (flowletRoutes.size (), 2, "The flowlets did not move");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1893,10 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingLookupTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingUpdateTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingOnDemandTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFlowEcmpTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
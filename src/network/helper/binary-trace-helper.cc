@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/packet.h"
+#include "binary-trace-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceHelper");
+
+namespace {
+
+/**
+ * \ingroup tracing
+ * The trace sinks of a device, writing its events to a binary trace.
+ */
+class DeviceSink : public SimpleRefCount<DeviceSink>
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] file The file to write the events to.
+   * \param [in] nd The device.
+   */
+  DeviceSink (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd)
+    : m_file (file),
+      m_node (nd->GetNode ()->GetId ()),
+      m_device (nd->GetIfIndex ())
+  {
+  }
+  /**
+   * Packet enqueued.
+   * \param [in] p The packet.
+   */
+  void Enqueue (Ptr<const Packet> p)
+  {
+    m_file->Write (Simulator::Now (), m_node, m_device, BinaryTraceFile::ENQUEUE, p);
+  }
+  /**
+   * Packet dequeued.
+   * \param [in] p The packet.
+   */
+  void Dequeue (Ptr<const Packet> p)
+  {
+    m_file->Write (Simulator::Now (), m_node, m_device, BinaryTraceFile::DEQUEUE, p);
+  }
+  /**
+   * Packet dropped.
+   * \param [in] p The packet.
+   */
+  void Drop (Ptr<const Packet> p)
+  {
+    m_file->Write (Simulator::Now (), m_node, m_device, BinaryTraceFile::DROP, p);
+  }
+  /**
+   * Packet received.
+   * \param [in] p The packet.
+   */
+  void Receive (Ptr<const Packet> p)
+  {
+    m_file->Write (Simulator::Now (), m_node, m_device, BinaryTraceFile::RECEIVE, p);
+  }
+
+private:
+  Ptr<BinaryTraceFile> m_file;  //!< The file.
+  uint32_t m_node;              //!< The node id.
+  uint32_t m_device;            //!< The device index.
+};
+
+} // unnamed namespace
+
+Ptr<BinaryTraceFile>
+BinaryTraceHelper::CreateFile (const std::string &filename, uint32_t headerBytes,
+                               uint32_t bufferSize)
+{
+  NS_LOG_FUNCTION (filename << headerBytes << bufferSize);
+  Ptr<BinaryTraceFile> file = Create<BinaryTraceFile> (filename, headerBytes, bufferSize);
+  NS_ABORT_MSG_IF (file->Fail (), "BinaryTraceHelper::CreateFile(): Unable to open file \"" << filename << "\"");
+  return file;
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd)
+{
+  NS_LOG_FUNCTION (file << nd);
+  Ptr<DeviceSink> sink = Create<DeviceSink> (file, nd);
+
+  PointerValue queue;
+  if (nd->GetAttributeFailSafe ("TxQueue", queue) && queue.Get<Object> () != 0)
+    {
+      Ptr<Object> q = queue.Get<Object> ();
+      q->TraceConnectWithoutContext ("Enqueue", MakeCallback (&DeviceSink::Enqueue, sink));
+      q->TraceConnectWithoutContext ("Dequeue", MakeCallback (&DeviceSink::Dequeue, sink));
+      q->TraceConnectWithoutContext ("Drop", MakeCallback (&DeviceSink::Drop, sink));
+    }
+  nd->TraceConnectWithoutContext ("MacRx", MakeCallback (&DeviceSink::Receive, sink));
+  nd->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&DeviceSink::Drop, sink));
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      EnableBinary (file, *i);
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n)
+{
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          EnableBinary (file, node->GetDevice (j));
+        }
+    }
+}
+
+void
+BinaryTraceHelper::EnableBinaryAll (Ptr<BinaryTraceFile> file)
+{
+  EnableBinary (file, NodeContainer::GetGlobal ());
+}
+
+} // namespace ns3
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_HELPER_H
+#define BINARY_TRACE_HELPER_H
+
+#include <string>
+#include "ns3/ptr.h"
+#include "ns3/binary-trace-file.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class NetDevice;
+
+/**
+ * \ingroup tracing
+ *
+ * \brief Manage binary trace files of device events.
+ *
+ * This is an alternative to the ASCII traces of AsciiTraceHelper for
+ * large simulations: the enqueue, dequeue, drop and receive events of
+ * devices are written to a BinaryTraceFile, in fixed-width records,
+ * instead of being printed.  The \c trace-convert program turns such a
+ * file into CSV or ASCII trace lines afterwards.
+ *
+ * \code
+ *   BinaryTraceHelper binary;
+ *   Ptr<BinaryTraceFile> file = binary.CreateFile ("example.nstrace");
+ *   binary.EnableBinaryAll (file);
+ * \endcode
+ *
+ * The events are taken from the \c Enqueue, \c Dequeue and \c Drop
+ * trace sources of the queue in the \c TxQueue attribute of the
+ * device, and from its \c MacRx and \c PhyRxDrop trace sources; a
+ * device without some of them simply does not report those events.
+ */
+class BinaryTraceHelper
+{
+public:
+  /**
+   * Create a binary trace file.
+   * \param [in] filename The name of the file.
+   * \param [in] headerBytes The number of bytes of each packet to record.
+   * \param [in] bufferSize The size of the in-memory buffer, in bytes.
+   * \returns The file.
+   */
+  Ptr<BinaryTraceFile> CreateFile (const std::string &filename, uint32_t headerBytes = 0,
+                                   uint32_t bufferSize = 4 * 1024 * 1024);
+
+  /**
+   * Trace the events of a device.
+   * \param [in] file The file to write the events to.
+   * \param [in] nd The device.
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, Ptr<NetDevice> nd);
+  /**
+   * Trace the events of devices.
+   * \param [in] file The file to write the events to.
+   * \param [in] d The devices.
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NetDeviceContainer d);
+  /**
+   * Trace the events of all the devices of nodes.
+   * \param [in] file The file to write the events to.
+   * \param [in] n The nodes.
+   */
+  void EnableBinary (Ptr<BinaryTraceFile> file, NodeContainer n);
+  /**
+   * Trace the events of all the devices of all the nodes.
+   * \param [in] file The file to write the events to.
+   */
+  void EnableBinaryAll (Ptr<BinaryTraceFile> file);
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_HELPER_H */
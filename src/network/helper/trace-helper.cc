@@ -28,6 +28,7 @@
 #include "ns3/names.h"
 #include "ns3/net-device.h"
 #include "ns3/pcap-file-wrapper.h"
+#include "ns3/enum.h"
 
 #include "trace-helper.h"
 
@@ -35,6 +36,46 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+/**
+ * Get the default value of an enum attribute of PcapFileWrapper.
+ * \param [in] name The attribute name.
+ * \returns The default value.
+ */
+static int
+GetPcapFileWrapperDefault (const std::string &name)
+{
+  struct TypeId::AttributeInformation info;
+  NS_ABORT_MSG_UNLESS (PcapFileWrapper::GetTypeId ().LookupAttributeByName (name, &info),
+                       "No attribute " << name);
+  return DynamicCast<const EnumValue> (info.initialValue)->Get ();
+}
+
+/**
+ * Check if the files created by PcapHelper are pcapng files, shared
+ * by all the devices of a node.
+ * \returns \c true if PcapFileWrapper writes pcapng files by default.
+ */
+static bool
+IsPcapNg (void)
+{
+  return GetPcapFileWrapperDefault ("Format") == PcapFileWrapper::PCAPNG;
+}
+
+/**
+ * Get the extension of the files created by PcapHelper.
+ * \returns The file name extension, including the dot.
+ */
+static std::string
+GetPcapExtension (void)
+{
+  std::string extension = IsPcapNg () ? ".pcapng" : ".pcap";
+  if (GetPcapFileWrapperDefault ("Compression") == AsyncFileBuffer::GZIP)
+    {
+      extension += ".gz";
+    }
+  return extension;
+}
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -105,6 +146,13 @@ PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bo
       oss << node->GetId ();
     }
 
+  if (IsPcapNg ())
+    {
+      // All the devices of the node write to the same file.
+      oss << GetPcapExtension ();
+      return oss.str ();
+    }
+
   oss << "-";
 
   if (devicename.size ())
@@ -116,7 +164,7 @@ PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bo
       oss << device->GetIfIndex ();
     }
 
-  oss << ".pcap";
+  oss << GetPcapExtension ();
 
   return oss.str ();
 }
@@ -154,7 +202,14 @@ PcapHelper::GetFilenameFromInterfacePair (std::string prefix, Ptr<Object> object
       oss << "n" << node->GetId ();
     }
 
-  oss << "-i" << interface << ".pcap";
+  if (IsPcapNg ())
+    {
+      // All the interfaces of the object write to the same file.
+      oss << GetPcapExtension ();
+      return oss.str ();
+    }
+
+  oss << "-i" << interface << GetPcapExtension ();
 
   return oss.str ();
 }
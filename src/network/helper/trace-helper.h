@@ -73,6 +73,10 @@ public:
   /**
    * @brief Let the pcap helper figure out a reasonable filename to use for a
    * pcap file associated with a device.
+   *
+   * When ns3::PcapFileWrapper::Format defaults to PcapNg, the name only
+   * depends on the node, so that all its devices share a pcapng file.
+   * The extension follows ns3::PcapFileWrapper::Compression.
    * 
    * @param prefix prefix string
    * @param device NetDevice
@@ -84,6 +88,9 @@ public:
   /**
    * @brief Let the pcap helper figure out a reasonable filename to use for the
    * pcap file associated with a node.
+   *
+   * As with GetFilenameFromDevice(), pcapng files are shared by all the
+   * interfaces of the object.
    * 
    * @param prefix prefix string
    * @param object interface (such as Ipv4Interface or Ipv6Interface)
@@ -20,6 +20,9 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <cstring>
+#include <list>
+#include <vector>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -51,15 +54,16 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+struct Buffer::AllocatorStats Buffer::g_allocatorStats;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
+ * keep track of 3 possible states for the g_allocator variable:
  *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
+ *    so no one has created the associated allocator (it is created
  *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
+ *  - initialized means that the allocator exists and is valid
  *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
+ *    have run so, the allocator has released its memory
  * The key is that in destroyed state, we are careful not re-create it
  * which is a typical weakness of lazy evaluation schemes which use 
  * '0' as a special value to indicate both un-initialized and destroyed.
@@ -70,27 +74,257 @@ uint32_t Buffer::g_recommendedStart = 0;
  * constructor orderings.
  */
 #define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
+#define IS_UNINITIALIZED(x) (x == (Buffer::DataAllocator*)0)
+#define IS_DESTROYED(x) (x == (Buffer::DataAllocator*)MAGIC_DESTROYED)
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
+#define DESTROYED ((Buffer::DataAllocator*)MAGIC_DESTROYED)
+#define UNINITIALIZED ((Buffer::DataAllocator*)0)
+
+/**
+ * \ingroup packet
+ * \brief Size-class slab allocator of buffer data storage.
+ *
+ * Storage sizes are rounded up to a size class between MIN_SIZE and
+ * MAX_SIZE bytes.  There are STEPS classes per power of two, so the
+ * storage is at most a quarter larger than requested: an MTU-sized
+ * buffer gets 1536 bytes and a 9000 byte jumbo buffer 10240 bytes.
+ *
+ * Each size class carves its storage out of slabs of about SLAB_SIZE
+ * bytes.  Each slab keeps its own released storage, so that a mix of
+ * small and large packets reuses storage of the right size instead of
+ * calling the system allocator.  Once all of the storage of a slab is
+ * released, and its class has at least MAX_FREE_BYTES of other free
+ * storage, the slab is returned to the system, so that the memory of
+ * a burst of packets is not kept for the rest of the run.  Larger
+ * storage is allocated and released individually.
+ */
+struct Buffer::DataAllocator
+{
+  static const uint32_t MIN_SHIFT = 6;                  //!< log2 of the smallest class size
+  static const uint32_t MAX_SHIFT = 16;                 //!< log2 of the largest class size
+  static const uint32_t MIN_SIZE = 1 << MIN_SHIFT;      //!< Smallest class size
+  static const uint32_t MAX_SIZE = 1 << MAX_SHIFT;      //!< Largest class size
+  static const uint32_t STEP_SHIFT = 2;                 //!< log2 of the classes per power of two
+  static const uint32_t STEPS = 1 << STEP_SHIFT;        //!< Classes per power of two
+  static const uint32_t N_CLASSES = 1 + STEPS * (MAX_SHIFT - MIN_SHIFT); //!< Number of size classes
+  static const uint32_t SLAB_SIZE = 64 * 1024;          //!< Target slab size, in bytes
+  static const uint32_t MIN_SLAB_STORAGES = 4;          //!< Minimum storages per slab
+  static const uint32_t MAX_FREE_BYTES = 8 * SLAB_SIZE; //!< Free storage kept by a class
+
+  /**
+   * A slab.  Each storage of the slab is preceded by a pointer to
+   * the slab, so that released storage finds its slab.
+   */
+  struct Slab
+  {
+    uint8_t *memory;                         //!< The memory of the slab
+    uint32_t storages;                       //!< Storages carved out of the slab
+    std::vector<struct Buffer::Data *> free; //!< Released storage of this slab
+    std::list<Slab *>::iterator position;    //!< Position in the list of slabs with free storage
+  };
+
+  /// A size class
+  struct SizeClass
+  {
+    SizeClass ()
+      : slabs (0),
+        storages (0),
+        free (0)
+    {
+    }
+    std::list<Slab *> partial; //!< The slabs with free storage
+    uint32_t slabs;            //!< Slabs of this class
+    uint32_t storages;         //!< Storages carved out of the slabs
+    uint32_t free;             //!< Free storages in the slabs
+  };
+
+  /**
+   * \param size a storage size, at most MAX_SIZE
+   * \returns the index of the smallest class which holds size bytes
+   */
+  static uint32_t GetClass (uint32_t size)
+  {
+    if (size <= MIN_SIZE)
+      {
+        return 0;
+      }
+    // size is in (2^shift, 2^(shift+1)], split in STEPS classes
+    uint32_t shift = MIN_SHIFT;
+    while ((2U << shift) < size)
+      {
+        shift++;
+      }
+    uint32_t step = (1U << shift) >> STEP_SHIFT;
+    uint32_t steps = (size - (1U << shift) + step - 1) / step;
+    return 1 + STEPS * (shift - MIN_SHIFT) + steps - 1;
+  }
+
+  /**
+   * \param index a size class index
+   * \returns the storage size of the class
+   */
+  static uint32_t GetClassSize (uint32_t index)
+  {
+    if (index == 0)
+      {
+        return MIN_SIZE;
+      }
+    uint32_t shift = MIN_SHIFT + (index - 1) / STEPS;
+    uint32_t steps = (index - 1) % STEPS + 1;
+    return (1U << shift) + steps * ((1U << shift) >> STEP_SHIFT);
+  }
+
+  /**
+   * \param size a storage size
+   * \returns the distance between two storages of that size in a slab
+   */
+  static uint32_t GetStride (uint32_t size)
+  {
+    return (sizeof (Slab *) + size - 1 + sizeof (struct Buffer::Data) + 7) & ~7U;
+  }
+
+  /**
+   * \param data storage carved out of a slab
+   * \returns the slab
+   */
+  static Slab *GetSlab (struct Buffer::Data *data)
+  {
+    Slab *slab;
+    memcpy (&slab, reinterpret_cast<uint8_t *> (data) - sizeof (Slab *), sizeof (Slab *));
+    return slab;
+  }
+
+  /**
+   * \brief Carve a new slab into free storage of a size class.
+   * \param index the size class index
+   */
+  void Grow (uint32_t index)
+  {
+    SizeClass &sizeClass = classes[index];
+    uint32_t size = GetClassSize (index);
+    uint32_t stride = GetStride (size);
+    uint32_t n = SLAB_SIZE / stride;
+    if (n < MIN_SLAB_STORAGES)
+      {
+        n = MIN_SLAB_STORAGES;
+      }
+    Slab *slab = new Slab;
+    slab->memory = new uint8_t [n * stride];
+    slab->storages = n;
+    g_allocatorStats.allocs++;
+    g_allocatorStats.bytes += n * stride;
+    // In reverse order, so that storage is handed out in address order.
+    for (uint32_t i = n; i > 0; i--)
+      {
+        uint8_t *storage = slab->memory + (i - 1) * stride;
+        memcpy (storage, &slab, sizeof (Slab *));
+        struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (storage + sizeof (Slab *));
+        data->m_size = size;
+        data->m_count = 0;
+        slab->free.push_back (data);
+      }
+    slab->position = sizeClass.partial.insert (sizeClass.partial.end (), slab);
+    sizeClass.slabs++;
+    sizeClass.storages += n;
+    sizeClass.free += n;
+  }
+
+  /**
+   * \brief Take free storage of a size class.
+   * \param index the size class index
+   * \returns the storage
+   */
+  struct Buffer::Data *Take (uint32_t index)
+  {
+    SizeClass &sizeClass = classes[index];
+    if (sizeClass.partial.empty ())
+      {
+        Grow (index);
+      }
+    else
+      {
+        g_allocatorStats.reuses++;
+      }
+    Slab *slab = sizeClass.partial.front ();
+    struct Buffer::Data *data = slab->free.back ();
+    slab->free.pop_back ();
+    sizeClass.free--;
+    if (slab->free.empty ())
+      {
+        sizeClass.partial.erase (slab->position);
+      }
+    return data;
+  }
+
+  /**
+   * \brief Give back storage of a size class, returning its slab
+   * to the system if it is all free and the class has enough other
+   * free storage.
+   * \param index the size class index
+   * \param data the storage
+   */
+  void Give (uint32_t index, struct Buffer::Data *data)
+  {
+    SizeClass &sizeClass = classes[index];
+    Slab *slab = GetSlab (data);
+    if (slab->free.empty ())
+      {
+        slab->position = sizeClass.partial.insert (sizeClass.partial.end (), slab);
+      }
+    slab->free.push_back (data);
+    sizeClass.free++;
+    if (slab->free.size () == slab->storages &&
+        (uint64_t)(sizeClass.free - slab->storages) * GetClassSize (index) >= MAX_FREE_BYTES)
+      {
+        sizeClass.partial.erase (slab->position);
+        sizeClass.slabs--;
+        sizeClass.storages -= slab->storages;
+        sizeClass.free -= slab->storages;
+        Release (index, slab);
+      }
+  }
+
+  /**
+   * \brief Return a slab to the system.
+   * \param index the size class index
+   * \param slab the slab
+   */
+  static void Release (uint32_t index, Slab *slab)
+  {
+    g_allocatorStats.frees++;
+    g_allocatorStats.bytes -= slab->storages * GetStride (GetClassSize (index));
+    delete [] slab->memory;
+    delete slab;
+  }
+
+  SizeClass classes[N_CLASSES]; //!< The size classes
+};
+
+Buffer::DataAllocator *Buffer::g_allocator = 0;
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
+  if (IS_INITIALIZED (g_allocator))
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      for (uint32_t i = 0; i < DataAllocator::N_CLASSES; i++)
         {
-          Buffer::Deallocate (*i);
+          DataAllocator::SizeClass &sizeClass = g_allocator->classes[i];
+          if (sizeClass.free != sizeClass.storages)
+            {
+              // Some buffers are still alive: leak the slabs they use.
+              continue;
+            }
+          // All the slabs are free, hence in the partial list
+          for (std::list<DataAllocator::Slab *>::iterator j = sizeClass.partial.begin ();
+               j != sizeClass.partial.end (); j++)
+            {
+              DataAllocator::Release (i, *j);
+            }
         }
-      delete g_freeList;
-      g_freeList = DESTROYED;
+      delete g_allocator;
+      g_allocator = DESTROYED;
     }
 }
 
@@ -99,44 +333,38 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  NS_ASSERT (!IS_UNINITIALIZED (g_allocator));
+  if (data->m_size > DataAllocator::MAX_SIZE)
     {
       Buffer::Deallocate (data);
     }
-  else
+  else if (IS_INITIALIZED (g_allocator))
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      uint32_t index = DataAllocator::GetClass (data->m_size);
+      NS_ASSERT (data->m_size == DataAllocator::GetClassSize (index));
+      g_allocator->Give (index, data);
     }
+  /* else, the allocator is destroyed: the storage belongs to a slab
+   * leaked at exit, or was allocated after the allocator was destroyed,
+   * and is released with the rest of the process memory.
+   */
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
+  g_allocatorStats.creates++;
+  if (IS_UNINITIALIZED (g_allocator))
     {
-      g_freeList = new Buffer::FreeList ();
+      g_allocator = new Buffer::DataAllocator ();
     }
-  else if (IS_INITIALIZED (g_freeList))
+  if (IS_INITIALIZED (g_allocator) && dataSize <= DataAllocator::MAX_SIZE)
     {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
+      struct Buffer::Data *data = g_allocator->Take (DataAllocator::GetClass (dataSize));
+      NS_ASSERT (data->m_count == 0);
+      data->m_count = 1;
+      return data;
     }
   struct Buffer::Data *data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
@@ -155,6 +383,7 @@ Buffer::Data *
 Buffer::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
+  g_allocatorStats.creates++;
   return Allocate (size);
 }
 #endif /* BUFFER_FREE_LIST */
@@ -170,6 +399,8 @@ Buffer::Allocate (uint32_t reqSize)
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
   uint8_t *b = new uint8_t [size];
+  g_allocatorStats.allocs++;
+  g_allocatorStats.bytes += size;
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
@@ -181,10 +412,57 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+  g_allocatorStats.frees++;
+  g_allocatorStats.bytes -= data->m_size - 1 + sizeof (struct Buffer::Data);
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
   delete [] buf;
 }
 
+Buffer::AllocatorStats
+Buffer::GetAllocatorStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return g_allocatorStats;
+}
+
+void
+Buffer::ResetAllocatorStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  uint64_t bytes = g_allocatorStats.bytes;
+  g_allocatorStats = AllocatorStats ();
+  g_allocatorStats.bytes = bytes;
+}
+
+void
+Buffer::PrintAllocatorStats (std::ostream &os)
+{
+  NS_LOG_FUNCTION (&os);
+  os << "creates=" << g_allocatorStats.creates
+     << " reuses=" << g_allocatorStats.reuses
+     << " allocs=" << g_allocatorStats.allocs
+     << " frees=" << g_allocatorStats.frees
+     << " bytes=" << g_allocatorStats.bytes << std::endl;
+#ifdef BUFFER_FREE_LIST
+  if (!IS_INITIALIZED (g_allocator))
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < DataAllocator::N_CLASSES; i++)
+    {
+      const DataAllocator::SizeClass &sizeClass = g_allocator->classes[i];
+      if (sizeClass.storages == 0)
+        {
+          continue;
+        }
+      os << "  " << DataAllocator::GetClassSize (i) << " bytes:"
+         << " slabs=" << sizeClass.slabs
+         << " storages=" << sizeClass.storages
+         << " free=" << sizeClass.free << std::endl;
+    }
+#endif /* BUFFER_FREE_LIST */
+}
+
 Buffer::Buffer ()
 {
   NS_LOG_FUNCTION (this);
@@ -221,7 +499,7 @@ Buffer::CheckInternalState (void) const
     m_zeroAreaEnd <= m_end;
   bool dirtyOk =
     m_start >= m_data->m_dirtyStart &&
-    m_end <= m_data->m_dirtyEnd;
+    GetInternalEnd () <= m_data->m_dirtyEnd;
   bool internalSizeOk = m_end - (m_zeroAreaEnd - m_zeroAreaStart) <= m_data->m_size &&
     m_start <= m_data->m_size &&
     m_zeroAreaStart <= m_data->m_size;
@@ -251,7 +529,7 @@ Buffer::Initialize (uint32_t zeroSize)
   m_zeroAreaEnd = m_zeroAreaStart + zeroSize;
   m_end = m_zeroAreaEnd;
   m_data->m_dirtyStart = m_start;
-  m_data->m_dirtyEnd = m_end;
+  m_data->m_dirtyEnd = GetInternalEnd ();
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -344,7 +622,7 @@ Buffer::AddAtStart (uint32_t start)
 
       // update dirty area
       m_data->m_dirtyStart = m_start;
-      m_data->m_dirtyEnd = m_end;
+      m_data->m_dirtyEnd = GetInternalEnd ();
     }
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("add start=" << start << ", ");
@@ -355,7 +633,9 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
+  // The dirty area is in storage offsets: buffers sharing the data
+  // may have zero areas of different sizes
+  bool isDirty = m_data->m_count > 1 && GetInternalEnd () < m_data->m_dirtyEnd;
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
       /* enough space in buffer and not dirty
@@ -363,10 +643,10 @@ Buffer::AddAtEnd (uint32_t end)
        * Before: |**----*****|
        * After:  |**----...**|
        */
-      NS_ASSERT (m_data->m_count == 1 || m_end == m_data->m_dirtyEnd);
+      NS_ASSERT (m_data->m_count == 1 || GetInternalEnd () == m_data->m_dirtyEnd);
       m_end += end;
       // update dirty area.
-      m_data->m_dirtyEnd = m_end;
+      m_data->m_dirtyEnd = GetInternalEnd ();
     } 
   else
     {
@@ -389,7 +669,7 @@ Buffer::AddAtEnd (uint32_t end)
 
       // update dirty area
       m_data->m_dirtyStart = m_start;
-      m_data->m_dirtyEnd = m_end;
+      m_data->m_dirtyEnd = GetInternalEnd ();
     } 
   m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
   LOG_INTERNAL_STATE ("add end=" << end << ", ");
@@ -400,21 +680,49 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
+  if (&o == this)
+    {
+      Buffer copy = o;
+      AddAtEnd (copy);
+      return;
+    }
+  if (o.GetSize () == 0)
+    {
+      return;
+    }
+  if (GetSize () == 0)
+    {
+      *this = o;
+      return;
+    }
+  if (m_data == o.m_data && AddAtEndAdjacent (o))
+    {
+      /**
+       * Both buffers reference adjacent bytes of the same data
+       * storage, typically two fragments of one packet: no copy.
+       */
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
+
+  uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+  uint32_t oZeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+  if (oZeroSize > 0 &&
       m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
-      o.m_start == o.m_zeroAreaStart &&
-      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
+      o.m_start == o.m_zeroAreaStart)
     {
       /**
        * This is an optimization which kicks in when
        * we attempt to aggregate two buffers which contain
        * adjacent zero areas.
        */
-      uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
-      m_zeroAreaEnd += zeroSize;
+      if (m_data->m_count != 1 || GetInternalEnd () != m_data->m_dirtyEnd)
+        {
+          Unshare ();
+        }
+      m_zeroAreaEnd += oZeroSize;
       m_end = m_zeroAreaEnd;
-      m_data->m_dirtyEnd = m_zeroAreaEnd;
+      m_data->m_dirtyEnd = GetInternalEnd ();
       uint32_t endData = o.m_end - o.m_zeroAreaEnd;
       AddAtEnd (endData);
       Buffer::Iterator dst = End ();
@@ -425,15 +733,120 @@ Buffer::AddAtEnd (const Buffer &o)
       NS_ASSERT (CheckInternalState ());
       return;
     }
+  if (zeroSize == 0 && oZeroSize > 0)
+    {
+      /**
+       * Only the other buffer has a zero area: keep it, and
+       * prepend the bytes of this buffer.
+       */
+      Buffer tmp = o;
+      tmp.AddAtStart (GetSize ());
+      if (tmp.m_data == m_data)
+        {
+          // Grown in place: copy from other storage than the bytes read
+          tmp.Unshare ();
+        }
+      tmp.Begin ().Write (Begin (), End ());
+      *this = tmp;
+      NS_ASSERT (CheckInternalState ());
+      return;
+    }
 
+  /**
+   * Flatten this buffer first: its zero area cannot stay virtual
+   * once data is written after it in storage other buffers share.
+   */
   *this = CreateFullCopy ();
   AddAtEnd (o.GetSize ());
+  if (m_data == o.m_data)
+    {
+      // Grown in place: copy from other storage than the bytes read
+      Unshare ();
+    }
   Buffer::Iterator destStart = End ();
   destStart.Prev (o.GetSize ());
   destStart.Write (o.Begin (), o.End ());
   NS_ASSERT (CheckInternalState ());
 }
 
+bool
+Buffer::AddAtEndAdjacent (const Buffer &o)
+{
+  NS_LOG_FUNCTION (this << &o);
+  NS_ASSERT (m_data == o.m_data);
+  /* The bytes before the zero area are stored from m_start to
+   * m_zeroAreaStart, and the bytes after it are stored from
+   * m_zeroAreaStart on.
+   */
+  uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+  uint32_t oZeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
+  uint32_t zeroAreaStart = m_zeroAreaStart;
+  uint32_t zeroAreaEnd = m_zeroAreaEnd;
+  uint32_t end;
+  if (oZeroSize == 0)
+    {
+      if (GetInternalEnd () != o.m_start)
+        {
+          return false;
+        }
+      end = m_end + o.GetSize ();
+    }
+  else if (zeroSize == 0)
+    {
+      if (m_end != o.m_start)
+        {
+          return false;
+        }
+      zeroAreaStart = o.m_zeroAreaStart;
+      zeroAreaEnd = o.m_zeroAreaEnd;
+      end = o.m_end;
+    }
+  else
+    {
+      if (m_end != m_zeroAreaEnd ||
+          o.m_start != o.m_zeroAreaStart ||
+          o.m_zeroAreaStart != m_zeroAreaStart)
+        {
+          return false;
+        }
+      zeroAreaEnd += oZeroSize;
+      end = zeroAreaEnd + (o.m_end - o.m_zeroAreaEnd);
+    }
+  if (end - (zeroAreaEnd - zeroAreaStart) > m_data->m_dirtyEnd)
+    {
+      // Not a range other buffers know to be in use.
+      return false;
+    }
+  m_zeroAreaStart = zeroAreaStart;
+  m_zeroAreaEnd = zeroAreaEnd;
+  m_end = end;
+  m_maxZeroAreaStart = std::max (m_maxZeroAreaStart, m_zeroAreaStart);
+  LOG_INTERNAL_STATE ("add adjacent ");
+  return true;
+}
+
+void
+Buffer::Unshare (void)
+{
+  NS_LOG_FUNCTION (this);
+  struct Buffer::Data *newData = Buffer::Create (GetInternalSize ());
+  memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
+  m_data->m_count--;
+  if (m_data->m_count == 0)
+    {
+      Buffer::Recycle (m_data);
+    }
+  m_data = newData;
+
+  m_zeroAreaStart -= m_start;
+  m_zeroAreaEnd -= m_start;
+  m_end -= m_start;
+  m_start = 0;
+  m_data->m_dirtyStart = m_start;
+  m_data->m_dirtyEnd = GetInternalEnd ();
+  NS_ASSERT (CheckInternalState ());
+}
+
 void 
 Buffer::RemoveAtStart (uint32_t start)
 {
@@ -843,27 +1256,35 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  uint8_t *to;
+  if (m_current <= m_zeroStart)
+    {
+      to = &m_data[m_current];
+    }
+  else
+    {
+      to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+    }
+  m_current += size;
   if (start.m_current <= start.m_zeroStart)
     {
       uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
+      memcpy (to, &start.m_data[start.m_current], toCopy);
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   if (start.m_current <= start.m_zeroEnd)
     {
       uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      memset (to, 0, toCopy);
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
   uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
   uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
   memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
@@ -525,6 +525,9 @@ private:
    * \param o the buffer to append to the end of this buffer.
    *
    * Add bytes at the end of the Buffer.
+   * If o references the bytes which follow those of this Buffer in
+   * the same data, as fragments of one buffer do, no byte is copied.
+   * Zero areas are kept virtual where possible.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -611,6 +614,39 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief Statistics of the allocator of the buffer data storage.
+   */
+  struct AllocatorStats
+  {
+    uint64_t creates; //!< Number of data storages requested
+    uint64_t reuses;  //!< Number of requests served from a free list
+    uint64_t allocs;  //!< Number of calls to the system allocator
+    uint64_t frees;   //!< Number of calls to release memory to the system
+    uint64_t bytes;   //!< Bytes currently obtained from the system allocator
+  };
+  /**
+   * \brief Get the statistics of the data storage allocator.
+   *
+   * The storage of all Buffer instances comes from a single
+   * allocator, so these are totals over the whole program.
+   *
+   * \returns the allocator statistics
+   */
+  static AllocatorStats GetAllocatorStats (void);
+  /**
+   * \brief Reset the allocator call counters.
+   *
+   * The number of bytes currently allocated is not reset.
+   */
+  static void ResetAllocatorStats (void);
+  /**
+   * \brief Print the allocator statistics, and the use of each
+   * size class of the allocator.
+   * \param os the output stream
+   */
+  static void PrintAllocatorStats (std::ostream &os);
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -726,6 +762,20 @@ private:
    */
   uint32_t GetInternalEnd (void) const;
 
+  /**
+   * \brief Append a buffer which references the bytes of the same data
+   * storage that follow the bytes of this buffer, without copying.
+   * \param o the buffer to append, which shares the data of this buffer.
+   * \returns false if the bytes of o do not follow those of this buffer.
+   */
+  bool AddAtEndAdjacent (const Buffer &o);
+  /**
+   * \brief Copy the bytes of this buffer to a data storage of its own.
+   *
+   * The zero area is not copied.
+   */
+  void Unshare (void);
+
   /**
    * \brief Recycle the buffer memory
    * \param data the buffer data storage
@@ -790,16 +840,17 @@ private:
    */
   uint32_t m_end;
 
+  static AllocatorStats g_allocatorStats; //!< Allocator statistics
+
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
+  /// Size-class slab allocator of buffer data storage
+  struct DataAllocator;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
+  static DataAllocator *g_allocator; //!< Buffer data allocator
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
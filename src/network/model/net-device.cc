@@ -19,6 +19,8 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/queue-item.h"
+#include "ns3/net-device-queue-interface.h"
 #include "net-device.h"
 
 namespace ns3 {
@@ -41,4 +43,25 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+std::size_t
+NetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  Ptr<NetDeviceQueueInterface> ndqi = GetObject<NetDeviceQueueInterface> ();
+  std::size_t sent = 0;
+  for (std::vector<Ptr<QueueDiscItem> >::const_iterator i = items.begin ();
+       i != items.end (); i++, sent++)
+    {
+      // the device queue may have been stopped by the previous packet
+      if (ndqi && ndqi->GetTxQueue ((*i)->GetTxQueueIndex ())->IsStopped ())
+        {
+          NS_LOG_LOGIC ("Device queue stopped after " << sent << " packets");
+          break;
+        }
+      Send ((*i)->GetPacket (), (*i)->GetAddress (), (*i)->GetProtocol ());
+    }
+  return sent;
+}
+
 } // namespace ns3
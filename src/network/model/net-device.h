@@ -22,6 +22,7 @@
 #define NET_DEVICE_H
 
 #include <stdint.h>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
@@ -34,6 +35,7 @@ namespace ns3 {
 
 class Node;
 class Channel;
+class QueueDiscItem;
 
 /**
  * \ingroup network
@@ -260,6 +262,24 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param items the packets to send, in order, with their destination
+   *        address and protocol number
+   *
+   *  Called by the traffic control layer to hand a batch of packets to
+   *  the Network Device at once, similarly to the xmit_more hint of Linux.
+   *  The device stops accepting packets as soon as the device transmission
+   *  queue of the next packet is stopped; the caller keeps the remaining
+   *  packets and sends them again when the queue is woken up.
+   *
+   *  The default implementation calls Send on each packet. Devices which
+   *  can transmit several packets back to back override this method to
+   *  queue the whole batch before starting the transmission.
+   *
+   * \return the number of packets, at the beginning of the batch, which
+   *         were handed to the device
+   */
+  virtual std::size_t SendBatch (const std::vector<Ptr<QueueDiscItem> > &items);
   /**
    * \returns the node base class which contains this network
    *          interface.
@@ -669,16 +669,55 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
       return;
     }
 
+  if (m_nPending == PENDING_MAX)
+    {
+      FlushPending (1);
+    }
+  PendingHeader &pending = m_pending[m_nPending];
+  pending.typeUid = uid;
+  pending.size = size;
+  pending.chunkUid = m_chunkUid;
+  m_chunkUid++;
+  m_nPending++;
+}
+void
+PacketMetadata::DoAddHeaderItem (uint32_t uid, uint32_t size, uint16_t chunkUid)
+{
+  NS_LOG_FUNCTION (this << uid << size << chunkUid);
   struct PacketMetadata::SmallItem item;
   item.next = m_head;
   item.prev = 0xffff;
   item.typeUid = uid;
   item.size = size;
-  item.chunkUid = m_chunkUid;
-  m_chunkUid++;
+  item.chunkUid = chunkUid;
   uint16_t written = AddSmall (&item);
   UpdateHead (written);
 }
+void
+PacketMetadata::FlushPending (uint8_t n)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (n));
+  NS_ASSERT (n <= m_nPending);
+  // The oldest pending header is the closest to the head of the list.
+  for (uint8_t i = 0; i < n; i++)
+    {
+      DoAddHeaderItem (m_pending[i].typeUid, m_pending[i].size, m_pending[i].chunkUid);
+    }
+  for (uint8_t i = n; i < m_nPending; i++)
+    {
+      m_pending[i - n] = m_pending[i];
+    }
+  m_nPending -= n;
+}
+void
+PacketMetadata::Materialize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nPending > 0)
+    {
+      const_cast<PacketMetadata *> (this)->FlushPending (m_nPending);
+    }
+}
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
@@ -690,6 +729,17 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_nPending > 0)
+    {
+      const PendingHeader &pending = m_pending[m_nPending - 1];
+      if (pending.typeUid == uid && pending.size == size)
+        {
+          // The header was never added to the list.
+          m_nPending--;
+          return;
+        }
+      Materialize ();
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -760,6 +810,11 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  if (m_tail == 0xffff)
+    {
+      // The trailer can only be a pending header.
+      Materialize ();
+    }
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
@@ -807,6 +862,8 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
       m_metadataSkipped = true;
       return;
     }
+  Materialize ();
+  o.Materialize ();
   if (m_tail == 0xffff)
     {
       // We have no items so 'AddAtEnd' is 
@@ -896,6 +953,7 @@ PacketMetadata::RemoveAtStart (uint32_t start)
       return;
     }
   NS_ASSERT (m_data != 0);
+  Materialize ();
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -959,6 +1017,7 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
       return;
     }
   NS_ASSERT (m_data != 0);
+  Materialize ();
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
@@ -1046,6 +1105,7 @@ PacketMetadata::ItemIterator
 PacketMetadata::BeginItem (Buffer buffer) const
 {
   NS_LOG_FUNCTION (this << &buffer);
+  Materialize ();
   return ItemIterator (this, buffer);
 }
 PacketMetadata::ItemIterator::ItemIterator (const PacketMetadata *metadata, Buffer buffer)
@@ -1145,6 +1205,7 @@ PacketMetadata::GetSerializedSize (void) const
     {
       return totalSize;
     }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -1185,6 +1246,7 @@ PacketMetadata::Serialize (uint8_t* buffer, uint32_t maxSize) const
     {
       return 0;
     }
+  Materialize ();
 
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
@@ -74,6 +74,15 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * Headers are not added to the linked list right away: the last few
+ * headers added are kept in a small array within the PacketMetadata
+ * instance, and removing the last header added just drops it from the
+ * array.  The linked list is only updated when this array is full, or
+ * when an operation which needs the complete list, such as printing
+ * the packet or fragmenting it, is performed.  Packets which have
+ * their headers added and removed layer by layer thus never touch
+ * the shared data buffer.
  */
 class PacketMetadata 
 {
@@ -620,6 +629,25 @@ public:
    * \param size header serialized size
    */
   void DoAddHeader (uint32_t uid, uint32_t size);
+  /**
+   * \brief Add an header item at the head of the linked list
+   * \param uid header's uid to add
+   * \param size header serialized size
+   * \param chunkUid the chunk uid of the header
+   */
+  void DoAddHeaderItem (uint32_t uid, uint32_t size, uint16_t chunkUid);
+  /**
+   * \brief Add the oldest pending headers to the linked list
+   * \param n the number of pending headers to add
+   */
+  void FlushPending (uint8_t n);
+  /**
+   * \brief Add all pending headers to the linked list
+   *
+   * This does not change the logical content of the metadata, so
+   * it is also called from const methods which read the list.
+   */
+  void Materialize (void) const;
   /**
    * \brief Check if the metadata state is ok
    * \returns true if the internal state is ok
@@ -675,6 +703,16 @@ public:
   static uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
 
+  /// A header added but not yet stored in the linked list.
+  struct PendingHeader
+  {
+    uint32_t typeUid;  //!< The header type uid
+    uint32_t size;     //!< The header size
+    uint16_t chunkUid; //!< The header chunk uid
+  };
+  /// Maximum number of pending headers
+  static const uint8_t PENDING_MAX = 4;
+
   struct Data *m_data; //!< Metadata storage
   /*
      head -(next)-> tail
@@ -685,6 +723,12 @@ public:
   uint16_t m_tail; //!< list tail
   uint16_t m_used; //!< used portion
   uint64_t m_packetUid; //!< packet Uid
+  /**
+   * Pending headers, which come before the head of the linked list,
+   * the last added one last.
+   */
+  PendingHeader m_pending[PENDING_MAX];
+  uint8_t m_nPending; //!< Number of pending headers
 };
 
 } // namespace ns3
@@ -696,7 +740,8 @@ PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
-    m_packetUid (uid)
+    m_packetUid (uid),
+    m_nPending (0)
 {
   memset (m_data->m_data, 0xff, 4);
   if (size > 0)
@@ -709,8 +754,13 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_head (o.m_head),
     m_tail (o.m_tail),
     m_used (o.m_used),
-    m_packetUid (o.m_packetUid)
+    m_packetUid (o.m_packetUid),
+    m_nPending (o.m_nPending)
 {
+  for (uint8_t i = 0; i < m_nPending; i++)
+    {
+      m_pending[i] = o.m_pending[i];
+    }
   NS_ASSERT (m_data != 0);
   NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
   m_data->m_count++;
@@ -735,6 +785,11 @@ PacketMetadata::operator = (PacketMetadata const& o)
   m_tail = o.m_tail;
   m_used = o.m_used;
   m_packetUid = o.m_packetUid;
+  m_nPending = o.m_nPending;
+  for (uint8_t i = 0; i < m_nPending; i++)
+    {
+      m_pending[i] = o.m_pending[i];
+    }
   return *this;
 }
 PacketMetadata::~PacketMetadata ()
@@ -28,12 +28,37 @@
 #include "tag.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include <algorithm>
 #include <cstring>
+#include <vector>
+
+#define FREE_LIST_SIZE 1000
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+/**
+ * \ingroup packet
+ *
+ * \brief Container for the released small PacketTagList::TagData structs
+ *
+ * Internal use only.
+ */
+static class PacketTagListFreeList : public std::vector<void *>
+{
+public:
+  ~PacketTagListFreeList ();
+} g_freeList; //!< Container for the released TagData structs
+
+PacketTagListFreeList::~PacketTagListFreeList ()
+{
+  for (PacketTagListFreeList::iterator i = begin (); i != end (); i++)
+    {
+      std::free (*i);
+    }
+}
+
 PacketTagList::TagData *
 PacketTagList::CreateTagData (size_t dataSize)
 {
@@ -43,14 +68,39 @@ PacketTagList::CreateTagData (size_t dataSize)
                  << " exceeds maximum "
                  << std::numeric_limits<decltype(TagData::size)>::max () );
 
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
+  void * p;
+  if (dataSize <= SMALL_TAG_SIZE && !g_freeList.empty ())
+    {
+      p = g_freeList.back ();
+      g_freeList.pop_back ();
+    }
+  else
+    {
+      // Small TagData are all the same size, so they can be reused
+      p = std::malloc (sizeof (TagData) + std::max<size_t> (dataSize, SMALL_TAG_SIZE) - 1);
+    }
+  // The matching releases are in FreeTagData
 
   TagData * tag = new (p) TagData;
   tag->size = dataSize;
   return tag;
 }
 
+void
+PacketTagList::FreeTagData (TagData * tag)
+{
+  bool small = tag->size <= SMALL_TAG_SIZE;
+  tag->~TagData ();
+  if (small && g_freeList.size () < FREE_LIST_SIZE)
+    {
+      g_freeList.push_back (tag);
+    }
+  else
+    {
+      std::free (tag);
+    }
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -194,8 +244,7 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
   if (preMerge)
     {
       // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      FreeTagData (cur);
     }
   else
     {
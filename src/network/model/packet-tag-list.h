@@ -119,6 +119,11 @@ class Tag;
  *       The portion of the list between the first branch and the target is
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
+ *
+ *   - TagData structures holding no more than #SMALL_TAG_SIZE bytes are
+ *     kept on a free list when they are released, and reused by the next
+ *     #Add, #Replace or copy, so the usual per-hop tags do not go
+ *     through the allocator.
  */
 class PacketTagList 
 {
@@ -228,6 +233,19 @@ private:
    */
   static
   TagData * CreateTagData (size_t dataSize);
+  /**
+   * Destroy and release a TagData struct made by CreateTagData.
+   *
+   * \param [in] tag The TagData to release.
+   */
+  static
+  void FreeTagData (TagData * tag);
+
+  /**
+   * TagData structs with room for at most this many bytes of data
+   * are recycled instead of being freed.
+   */
+  static const uint32_t SMALL_TAG_SIZE = 32;
   
   /**
    * Typedef of method function pointer for copy-on-write operations
@@ -341,15 +359,13 @@ PacketTagList::RemoveAll (void)
         }
       if (prev != 0) 
         {
-          prev->~TagData ();
-          std::free (prev);
+          FreeTagData (prev);
         }
       prev = cur;
     }
   if (prev != 0) 
     {
-      prev->~TagData ();
-      std::free (prev);
+      FreeTagData (prev);
     }
   m_next = 0;
 }
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/mac48-address.h"
+#include "ns3/binary-trace-file.h"
+#include "ns3/binary-trace-helper.h"
+#include "ns3/simple-net-device-helper.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Convert a binary trace file to text.
+ * \param [in] filename The name of the file.
+ * \param [in] format The text format.
+ * \param [out] text The text.
+ * \returns \c true if the conversion succeeded.
+ */
+static bool
+ConvertFile (std::string filename, BinaryTraceFile::TextFormat format, std::string &text)
+{
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream os;
+  bool ok = BinaryTraceFile::Convert (is, os, format);
+  text = os.str ();
+  return ok;
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that records written to a binary trace convert to the
+ * expected CSV and ASCII text.
+ */
+class BinaryTraceFileTestCase : public TestCase
+{
+public:
+  BinaryTraceFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceFileTestCase::BinaryTraceFileTestCase ()
+  : TestCase ("Check writing and converting binary trace records")
+{
+}
+
+void
+BinaryTraceFileTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("binary-trace.nstrace");
+  uint8_t data[6] = { 0x45, 0x00, 0xab, 0xcd, 0xef, 0x01 };
+  Ptr<Packet> big = Create<Packet> (data, sizeof (data));
+  Ptr<Packet> small = Create<Packet> (data, 2);
+
+  Ptr<BinaryTraceFile> file = Create<BinaryTraceFile> (filename, 4, 16);
+  NS_TEST_ASSERT_MSG_EQ (file->Fail (), false, "Could not create " << filename);
+  NS_TEST_EXPECT_MSG_EQ (file->GetHeaderBytes (), 4, "Wrong header bytes");
+  file->Write (NanoSeconds (1500000001), 3, 1, BinaryTraceFile::ENQUEUE, big);
+  file->Write (Seconds (2), 3, 1, BinaryTraceFile::DEQUEUE, big);
+  file->Write (MicroSeconds (2000001), 0, 2, BinaryTraceFile::DROP, small);
+  file->Write (Seconds (12), 7, 0, BinaryTraceFile::RECEIVE, small);
+  NS_TEST_EXPECT_MSG_EQ (file->Fail (), false, "Writing " << filename << " failed");
+  file = 0;
+
+  std::ostringstream expected;
+  expected << "time,node,device,event,uid,size,header\n"
+           << "1.500000001,3,1,+," << big->GetUid () << ",6,4500abcd\n"
+           << "2.000000000,3,1,-," << big->GetUid () << ",6,4500abcd\n"
+           << "2.000001000,0,2,d," << small->GetUid () << ",2,4500\n"
+           << "12.000000000,7,0,r," << small->GetUid () << ",2,4500\n";
+  std::string text;
+  NS_TEST_EXPECT_MSG_EQ (ConvertFile (filename, BinaryTraceFile::CSV, text), true, "Conversion failed");
+  NS_TEST_EXPECT_MSG_EQ (text, expected.str (), "Wrong CSV text");
+
+  expected.str ("");
+  expected << "+ 1.500000001 /NodeList/3/DeviceList/1 uid=" << big->GetUid () << " size=6 4500abcd\n"
+           << "- 2.000000000 /NodeList/3/DeviceList/1 uid=" << big->GetUid () << " size=6 4500abcd\n"
+           << "d 2.000001000 /NodeList/0/DeviceList/2 uid=" << small->GetUid () << " size=2 4500\n"
+           << "r 12.000000000 /NodeList/7/DeviceList/0 uid=" << small->GetUid () << " size=2 4500\n";
+  NS_TEST_EXPECT_MSG_EQ (ConvertFile (filename, BinaryTraceFile::ASCII, text), true, "Conversion failed");
+  NS_TEST_EXPECT_MSG_EQ (text, expected.str (), "Wrong ASCII text");
+
+  // A truncated file is rejected.
+  std::string truncated = CreateTempDirFilename ("truncated.nstrace");
+  {
+    std::ifstream is (filename.c_str (), std::ios::binary);
+    std::ofstream os (truncated.c_str (), std::ios::binary);
+    std::vector<char> bytes (16 + 36 + 10);
+    is.read (&bytes[0], bytes.size ());
+    os.write (&bytes[0], bytes.size ());
+  }
+  NS_TEST_EXPECT_MSG_EQ (ConvertFile (truncated, BinaryTraceFile::CSV, text), false,
+                         "A truncated file should be rejected");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Check that BinaryTraceHelper records the queue events of a device.
+ */
+class BinaryTraceHelperTestCase : public TestCase
+{
+public:
+  BinaryTraceHelperTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceHelperTestCase::BinaryTraceHelperTestCase ()
+  : TestCase ("Check tracing devices with BinaryTraceHelper")
+{
+}
+
+void
+BinaryTraceHelperTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("binary-trace-helper.nstrace");
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices = simple.Install (node);
+
+  BinaryTraceHelper binary;
+  Ptr<BinaryTraceFile> file = binary.CreateFile (filename);
+  binary.EnableBinary (file, devices);
+
+  Ptr<Packet> p = Create<Packet> (100);
+  devices.Get (0)->Send (p, Mac48Address::GetBroadcast (), 0x800);
+  Simulator::Run ();
+  file->Flush ();
+
+  std::ostringstream expected;
+  expected << "time,node,device,event,uid,size\n"
+           << "0.000000000," << node->GetId () << ",0,+," << p->GetUid () << ",100\n"
+           << "0.000000000," << node->GetId () << ",0,-," << p->GetUid () << ",100\n";
+  std::string text;
+  NS_TEST_EXPECT_MSG_EQ (ConvertFile (filename, BinaryTraceFile::CSV, text), true, "Conversion failed");
+  NS_TEST_EXPECT_MSG_EQ (text, expected.str (), "Wrong events recorded");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Binary trace TestSuite
+ */
+class BinaryTraceTestSuite : public TestSuite
+{
+public:
+  BinaryTraceTestSuite ()
+    : TestSuite ("binary-trace", UNIT)
+  {
+    AddTestCase (new BinaryTraceFileTestCase (), TestCase::QUICK);
+    AddTestCase (new BinaryTraceHelperTestCase (), TestCase::QUICK);
+  }
+};
+
+static BinaryTraceTestSuite g_binaryTraceTestSuite; //!< Static variable for test initialization
@@ -389,6 +389,256 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer data allocator unit tests.
+ */
+class BufferAllocatorTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferAllocatorTest ();
+};
+
+BufferAllocatorTest::BufferAllocatorTest ()
+  : TestCase ("Buffer data allocator") {
+}
+
+void
+BufferAllocatorTest::DoRun (void)
+{
+  const uint32_t sizes[] = { 40, 60, 1500, 9000, 70000 };
+  const uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+
+  // Warm up the size classes.
+  {
+    std::vector<Buffer> buffers;
+    for (uint32_t i = 0; i < nSizes; i++)
+      {
+        buffers.push_back (Buffer ());
+        buffers.back ().AddAtStart (sizes[i]);
+      }
+  }
+
+  Buffer::ResetAllocatorStats ();
+  for (uint32_t round = 0; round < 10; round++)
+    {
+      std::vector<Buffer> buffers;
+      for (uint32_t i = 0; i < nSizes; i++)
+        {
+          Buffer buffer;
+          buffer.AddAtStart (sizes[i]);
+          buffer.Begin ().WriteU8 (0x5a, sizes[i]);
+          buffers.push_back (buffer);
+        }
+      for (uint32_t i = 0; i < nSizes; i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (buffers[i].GetSize (), sizes[i], "Bad buffer size");
+          NS_TEST_ASSERT_MSG_EQ (buffers[i].PeekData ()[sizes[i] - 1], 0x5a, "Bad buffer content");
+        }
+    }
+  Buffer::AllocatorStats stats = Buffer::GetAllocatorStats ();
+  NS_TEST_ASSERT_MSG_GT (stats.creates, 0, "No data storage created");
+  NS_TEST_ASSERT_MSG_GT (stats.bytes, 0, "No bytes allocated");
+#ifdef BUFFER_FREE_LIST
+  // Only the storage larger than the largest size class is allocated
+  // again in each round.
+  NS_TEST_ASSERT_MSG_EQ (stats.allocs, 10, "Storage of a size class not reused");
+  NS_TEST_ASSERT_MSG_EQ (stats.frees, 10, "Storage of a size class released");
+  NS_TEST_ASSERT_MSG_EQ (stats.reuses, stats.creates - 10, "Bad reuse count");
+
+  // The storage of a burst of packets is returned to the system once
+  // released, except for a bounded amount kept for reuse.
+  uint64_t bytes = stats.bytes;
+  {
+    std::vector<Buffer> buffers;
+    for (uint32_t i = 0; i < 4000; i++)
+      {
+        buffers.push_back (Buffer ());
+        buffers.back ().AddAtStart (1500);
+      }
+    NS_TEST_ASSERT_MSG_GT (Buffer::GetAllocatorStats ().bytes, bytes + 4000 * 1500,
+                           "Burst not allocated");
+    NS_TEST_ASSERT_MSG_LT (Buffer::GetAllocatorStats ().bytes, bytes + 4000 * 1600,
+                           "Storage more than a quarter larger than requested");
+  }
+  NS_TEST_ASSERT_MSG_GT (Buffer::GetAllocatorStats ().frees, stats.frees, "No slab released");
+  NS_TEST_ASSERT_MSG_LT (Buffer::GetAllocatorStats ().bytes, bytes + 1024 * 1024,
+                         "Storage of the burst kept");
+#endif
+
+  std::ostringstream oss;
+  Buffer::PrintAllocatorStats (oss);
+  NS_TEST_ASSERT_MSG_NE (oss.str ().find ("creates="), std::string::npos, "Statistics not printed");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer fragment reassembly unit tests.
+ */
+class BufferReassemblyTest : public TestCase {
+private:
+  /**
+   * Check that two buffers hold the same bytes.
+   * \param a The first buffer
+   * \param b The second buffer
+   * \param msg The message on failure
+   */
+  void CheckSameBytes (const Buffer &a, const Buffer &b, std::string msg);
+  /**
+   * Copy the bytes of a buffer into new, unshared, storage.
+   * \param buffer The buffer
+   * \returns The copy
+   */
+  static Buffer Snapshot (const Buffer &buffer);
+public:
+  virtual void DoRun (void);
+  BufferReassemblyTest ();
+};
+
+BufferReassemblyTest::BufferReassemblyTest ()
+  : TestCase ("Buffer fragment reassembly") {
+}
+
+Buffer
+BufferReassemblyTest::Snapshot (const Buffer &buffer)
+{
+  Buffer snapshot (0);
+  snapshot.AddAtStart (buffer.GetSize ());
+  Buffer::Iterator i = snapshot.Begin ();
+  i.Write (buffer.Begin (), buffer.End ());
+  return snapshot;
+}
+
+void
+BufferReassemblyTest::CheckSameBytes (const Buffer &a, const Buffer &b, std::string msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (a.GetSize (), b.GetSize (), msg << ": bad size");
+  Buffer::Iterator i = a.Begin ();
+  Buffer::Iterator j = b.Begin ();
+  for (uint32_t k = 0; k < a.GetSize (); k++)
+    {
+      uint32_t byteA = i.ReadU8 ();
+      uint32_t byteB = j.ReadU8 ();
+      NS_TEST_ASSERT_MSG_EQ (byteA, byteB, msg << ": bad byte " << k);
+    }
+}
+
+void
+BufferReassemblyTest::DoRun (void)
+{
+  // A header, a virtual zero payload, and a trailer.
+  Buffer original (1000);
+  original.AddAtStart (40);
+  Buffer::Iterator i = original.Begin ();
+  for (uint32_t k = 0; k < 40; k++)
+    {
+      i.WriteU8 (k);
+    }
+  original.AddAtEnd (20);
+  i = original.End ();
+  i.Prev (20);
+  for (uint32_t k = 0; k < 20; k++)
+    {
+      i.WriteU8 (0x80 + k);
+    }
+
+  const uint32_t cuts[][2] = { { 0, 1060 }, { 10, 1060 }, { 40, 1060 }, { 500, 1060 },
+                               { 30, 1045 }, { 500, 1040 }, { 1040, 1050 } };
+  for (uint32_t c = 0; c < sizeof (cuts) / sizeof (cuts[0]); c++)
+    {
+      Buffer first = original.CreateFragment (0, cuts[c][0]);
+      Buffer second = original.CreateFragment (cuts[c][0], cuts[c][1] - cuts[c][0]);
+      Buffer third = original.CreateFragment (cuts[c][1], original.GetSize () - cuts[c][1]);
+      Buffer::ResetAllocatorStats ();
+      Buffer reassembled = first;
+      reassembled.AddAtEnd (second);
+      reassembled.AddAtEnd (third);
+      NS_TEST_ASSERT_MSG_EQ (Buffer::GetAllocatorStats ().creates, 0,
+                             "Fragments " << cuts[c][0] << " " << cuts[c][1] << " copied");
+      CheckSameBytes (reassembled, original, "Bad reassembly");
+    }
+
+  // Out of order fragments are copied.
+  Buffer head = original.CreateFragment (0, 30);
+  Buffer tail = original.CreateFragment (1045, 15);
+  Buffer joined = tail;
+  joined.AddAtEnd (head);
+  NS_TEST_ASSERT_MSG_EQ (joined.GetSize (), 45, "Bad size");
+  i = joined.Begin ();
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)i.ReadU8 (), 0x80 + 5, "Bad first byte");
+  i.Next (14);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t)i.ReadU8 (), 0, "Bad header byte");
+
+  // Appending to a shared buffer does not modify the other one.
+  Buffer copy = original;
+  copy.AddAtEnd (head);
+  CheckSameBytes (original.CreateFragment (0, 30), head, "Original modified");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetSize (), original.GetSize () + 30, "Bad size");
+
+  // Appending to a buffer, through each of the append paths, does not
+  // modify the bytes of a copy sharing its storage.
+  Buffer headers = Snapshot (original.CreateFragment (0, 40));
+  Buffer appended[] = { original.CreateFragment (40, 1020), tail, Buffer (300), head };
+  Buffer appendTo[] = { original.CreateFragment (0, 40), original, Buffer (200), headers };
+  Buffer originalBytes = Snapshot (original);
+  for (uint32_t a = 0; a < sizeof (appendTo) / sizeof (appendTo[0]); a++)
+    {
+      for (uint32_t b = 0; b < sizeof (appended) / sizeof (appended[0]); b++)
+        {
+          Buffer buffer = appendTo[a];
+          Buffer shared = buffer;
+          Buffer expected = Snapshot (shared);
+          buffer.AddAtEnd (appended[b]);
+          NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), appendTo[a].GetSize () + appended[b].GetSize (),
+                                 "Bad size " << a << " " << b);
+          CheckSameBytes (shared, expected, "Shared copy modified");
+          CheckSameBytes (original, originalBytes, "Shared storage modified");
+          Buffer result = Snapshot (appendTo[a]);
+          result.AddAtEnd (Snapshot (appended[b]));
+          CheckSameBytes (buffer, result, "Bad append");
+        }
+    }
+
+  // Zero areas stay virtual.
+  Buffer zeroes (500);
+  zeroes.AddAtEnd (Buffer (500));
+  NS_TEST_ASSERT_MSG_EQ (zeroes.GetSize (), 1000, "Bad size");
+  NS_TEST_ASSERT_MSG_EQ (zeroes.GetSerializedSize (), Buffer (1000).GetSerializedSize (),
+                         "Zero area written out");
+  zeroes.AddAtEnd (zeroes);
+  NS_TEST_ASSERT_MSG_EQ (zeroes.GetSize (), 2000, "Bad self append");
+
+  // Merging the zero areas of two fragments of a packet leaves the
+  // storage shared: growing the result must not write over the
+  // trailer of the packet.
+  Buffer packet (48);
+  packet.AddAtStart (10);
+  packet.Begin ().WriteU8 (1, 10);
+  packet.AddAtEnd (18);
+  i = packet.End ();
+  i.Prev (18);
+  i.WriteU8 (9, 18);
+  Buffer packetBytes = Snapshot (packet);
+  Buffer zeroFragment = packet.CreateFragment (16, 33);
+  Buffer merged = zeroFragment;
+  merged.AddAtEnd (zeroFragment);
+  Buffer grown = merged;
+  grown.AddAtEnd (3);
+  i = grown.End ();
+  i.Prev (3);
+  i.WriteU8 (7, 3);
+  CheckSameBytes (packet, packetBytes, "Packet modified by a merged fragment");
+  NS_TEST_ASSERT_MSG_EQ (grown.GetSize (), 69, "Bad size");
+  i = grown.Begin ();
+  i.Next (66);
+  uint32_t byte = i.ReadU8 ();
+  NS_TEST_ASSERT_MSG_EQ (byte, 7, "Bad appended byte");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -405,6 +655,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferAllocatorTest, TestCase::QUICK);
+  AddTestCase (new BufferReassemblyTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/string.h"
+#include <iterator>
+#include <list>
 
 using namespace ns3;
 
@@ -83,6 +85,232 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((packet == 0), true, "There are really no packets in there");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * A queue which can enqueue at both ends and remove items from the middle.
+ */
+class RingTestQueue : public Queue<Packet>
+{
+public:
+  virtual bool Enqueue (Ptr<Packet> item)
+  {
+    return DoEnqueue (Tail (), item);
+  }
+  /**
+   * Enqueue an item at the head of the queue.
+   * \param item The item.
+   * \return True if the item was enqueued.
+   */
+  bool PushFront (Ptr<Packet> item)
+  {
+    return DoEnqueue (Head (), item);
+  }
+  /**
+   * Enqueue an item before the given item of the queue.
+   * \param n The index of the item, from the head of the queue.
+   * \param item The item.
+   * \return True if the item was enqueued.
+   */
+  bool InsertAt (uint32_t n, Ptr<Packet> item)
+  {
+    ConstIterator it = Head ();
+    for (uint32_t i = 0; i < n; i++)
+      {
+        it++;
+      }
+    return DoEnqueue (it, item);
+  }
+  virtual Ptr<Packet> Dequeue (void)
+  {
+    return DoDequeue (Head ());
+  }
+  virtual Ptr<Packet> Remove (void)
+  {
+    return DoRemove (Head ());
+  }
+  virtual Ptr<const Packet> Peek (void) const
+  {
+    return DoPeek (Head ());
+  }
+  /**
+   * Remove every other item, iterating as WifiMacQueue does.
+   * \param first Remove the first item, the third and so on,
+   *        instead of the second, the fourth and so on.
+   */
+  void RemoveEveryOther (bool first)
+  {
+    bool remove = first;
+    for (ConstIterator it = Head (); it != Tail (); )
+      {
+        if (remove)
+          {
+            ConstIterator curr = it++;
+            DoRemove (curr);
+          }
+        else
+          {
+            it++;
+          }
+        remove = !remove;
+      }
+  }
+  /**
+   * Get the items in the queue.
+   * \return The items, from the head of the queue.
+   */
+  std::list<Ptr<Packet> > GetItems (void) const
+  {
+    std::list<Ptr<Packet> > items;
+    for (ConstIterator it = Head (); it != Tail (); ++it)
+      {
+        items.push_back (*it);
+      }
+    return items;
+  }
+};
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the ring buffer of the queue against a list.
+ */
+class QueueRingBufferTestCase : public TestCase
+{
+public:
+  QueueRingBufferTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Check the queue against the reference list.
+   * \param msg The message to print on failure.
+   */
+  void Check (const char *msg);
+  /**
+   * Insert items at various positions in the middle of the queue and
+   * of the reference list.
+   * \param n The number of items to insert.
+   */
+  void InsertInMiddle (uint32_t n);
+
+  Ptr<RingTestQueue> m_queue;          //!< The queue
+  std::list<Ptr<Packet> > m_reference; //!< The expected items
+};
+
+QueueRingBufferTestCase::QueueRingBufferTestCase ()
+  : TestCase ("Check the ring buffer of the queue")
+{
+}
+
+void
+QueueRingBufferTestCase::Check (const char *msg)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_queue->GetNPackets (), m_reference.size (), msg << ": wrong size");
+  NS_TEST_EXPECT_MSG_EQ ((m_queue->GetItems () == m_reference), true, msg << ": wrong items");
+}
+
+void
+QueueRingBufferTestCase::InsertInMiddle (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      uint32_t pos = 1 + (i * 7) % (m_reference.size () - 1);
+      NS_TEST_EXPECT_MSG_EQ (m_queue->InsertAt (pos, p), true, "item not inserted");
+      std::list<Ptr<Packet> >::iterator it = m_reference.begin ();
+      std::advance (it, pos);
+      m_reference.insert (it, p);
+    }
+}
+
+void
+QueueRingBufferTestCase::DoRun (void)
+{
+  m_queue = CreateObject<RingTestQueue> ();
+  m_queue->SetMaxSize (QueueSize ("1000p"));
+
+  // Grow the ring buffer a few times
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      m_queue->Enqueue (p);
+      m_reference.push_back (p);
+    }
+  Check ("grow");
+
+  // Wrap around the end of the ring buffer
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      m_queue->Enqueue (p);
+      m_reference.push_back (p);
+      Ptr<Packet> q = m_queue->Dequeue ();
+      NS_TEST_EXPECT_MSG_EQ (q, m_reference.front (), "wrong item dequeued");
+      m_reference.pop_front ();
+    }
+  Check ("wrap");
+
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      m_queue->PushFront (p);
+      m_reference.push_front (p);
+    }
+  Check ("push front");
+
+  // Insert in the middle, across the wrap-around and while the ring
+  // buffer grows, shifting the following items
+  InsertInMiddle (30);
+  Check ("insert");
+
+  // Leave holes, which iterators skip
+  m_queue->RemoveEveryOther (false);
+  bool remove = false;
+  for (std::list<Ptr<Packet> >::iterator it = m_reference.begin (); it != m_reference.end (); )
+    {
+      it = remove ? m_reference.erase (it) : ++it;
+      remove = !remove;
+    }
+  Check ("holes");
+
+  // Insert in the middle, shifting the holes too
+  InsertInMiddle (10);
+  Check ("insert with holes");
+
+  // Fill the ring buffer, which is rebuilt without holes
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Ptr<Packet> p = Create<Packet> ();
+      m_queue->Enqueue (p);
+      m_reference.push_back (p);
+      if (i % 3 == 0)
+        {
+          Ptr<Packet> q = m_queue->Dequeue ();
+          NS_TEST_EXPECT_MSG_EQ (q, m_reference.front (), "wrong item dequeued");
+          m_reference.pop_front ();
+        }
+    }
+  Check ("refill");
+
+  // Remove every other item, starting with the first, then flush
+  m_queue->RemoveEveryOther (true);
+  remove = true;
+  for (std::list<Ptr<Packet> >::iterator it = m_reference.begin (); it != m_reference.end (); )
+    {
+      it = remove ? m_reference.erase (it) : ++it;
+      remove = !remove;
+    }
+  Check ("remove first");
+  m_queue->Flush ();
+  m_reference.clear ();
+  Check ("flush");
+  NS_TEST_EXPECT_MSG_EQ ((m_queue->Peek () == 0), true, "The queue should be empty");
+
+  m_queue = 0;
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -96,6 +324,7 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new QueueRingBufferTestCase (), TestCase::QUICK);
   }
 };
 
@@ -900,6 +900,36 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // more headers added and removed than are kept pending
+  // before the history is read.
+  p = Create<Packet> (10);
+  ADD_HEADER (p, 1);
+  ADD_HEADER (p, 2);
+  ADD_HEADER (p, 3);
+  ADD_HEADER (p, 4);
+  ADD_HEADER (p, 5);
+  ADD_HEADER (p, 6);
+  REM_HEADER (p, 6);
+  REM_HEADER (p, 5);
+  p1 = p->Copy ();
+  ADD_HEADER (p1, 7);
+  REM_HEADER (p, 4);
+  REM_HEADER (p, 3);
+  REM_HEADER (p, 2);
+  ADD_TRAILER (p, 8);
+  CHECK_HISTORY (p1, 6, 
+                 7, 4, 3, 2, 1, 10);
+  CHECK_HISTORY (p, 3, 
+                 1, 10, 8);
+  p2 = p1->CreateFragment (0, 7 + 4);
+  CHECK_HISTORY (p2, 2, 
+                 7, 4);
+  REM_HEADER (p1, 7);
+  REM_HEADER (p1, 4);
+  REM_HEADER (p1, 3);
+  CHECK_HISTORY (p1, 3, 
+                 2, 1, 10);
 }
 
 
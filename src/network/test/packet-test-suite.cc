@@ -27,6 +27,7 @@
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <vector>
 
 using namespace ns3;
 
@@ -973,6 +974,63 @@ PacketTagListTest::DoRun (void)
 #   undef RemoveCheck
   }  // Removal
 
+  { // Recycled tags
+    std::cout << GetName () << "check recycled small and large tags" << std::endl;
+    ATestTag<40> big (1);  // too large to be recycled
+    PacketTagList ptl;
+    ptl.Add (big);
+    ptl.Add (t1);
+    ptl.Add (t2);
+    PacketTagList cpy = ptl;
+    cpy.Add (t3);
+    cpy.Remove (t1);
+    ptl.Remove (big);
+    const char * msg = "recycled copy";
+    CheckRef (cpy, big, msg, false);
+    CheckRef (cpy, t1, msg, true);
+    CheckRef (cpy, t2, msg, false);
+    CheckRef (cpy, t3, msg, false);
+    msg = "recycled orig";
+    CheckRef (ptl, big, msg, true);
+    CheckRef (ptl, t1, msg, false);
+    CheckRef (ptl, t2, msg, false);
+    CheckRef (ptl, t3, msg, true);
+
+    // Iterate over the tags, newest first, through the shared branch
+    Ptr<Packet> p = Create<Packet> (10);
+    p->AddPacketTag (big);
+    p->AddPacketTag (t1);
+    p->AddPacketTag (t2);
+    p->AddPacketTag (t3);
+    p->AddPacketTag (t4);
+    p->AddPacketTag (t5);
+    Ptr<Packet> q = p->Copy ();
+    q->RemovePacketTag (t2);
+    q->AddPacketTag (t6);
+    std::vector<std::string> names;
+    PacketTagIterator i = q->GetPacketTagIterator ();
+    while (i.HasNext ())
+      {
+        PacketTagIterator::Item item = i.Next ();
+        ATestTagBase *tag = dynamic_cast<ATestTagBase *> (item.GetTypeId ().GetConstructor () ());
+        NS_TEST_EXPECT_MSG_NE (tag, 0, "iteration");
+        item.GetTag (*tag);
+        NS_TEST_EXPECT_MSG_EQ (tag->m_error, false, "iteration " << item.GetTypeId ().GetName ());
+        NS_TEST_EXPECT_MSG_EQ (tag->GetData (), 1, "iteration " << item.GetTypeId ().GetName ());
+        names.push_back (item.GetTypeId ().GetName ());
+        delete tag;
+      }
+    const char * order[] = { "anon::ATestTag<6>", "anon::ATestTag<5>", "anon::ATestTag<4>",
+                             "anon::ATestTag<3>", "anon::ATestTag<1>", "anon::ATestTag<40>" };
+    NS_TEST_ASSERT_MSG_EQ (names.size (), 6, "iteration count");
+    for (uint32_t j = 0; j < names.size (); ++j)
+      {
+        NS_TEST_EXPECT_MSG_EQ (names[j], order[j], "iteration order at " << j);
+      }
+    NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (t2), true, "original lost a tag");
+    NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (t6), false, "original got a tag");
+  }
+
   { // Replace
 
     std::cout << GetName () << "check replacing each tag" << std::endl;
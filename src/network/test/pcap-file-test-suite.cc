@@ -21,10 +21,23 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <fstream>
 
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/trace-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/node.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/network-config.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
 
 using namespace ns3;
 
@@ -77,6 +90,15 @@ CheckFileLength (std::string filename, uint64_t sizeExpected)
   return sizeActual == sizeExpected;
 }
 
+static std::string
+ReadFile (std::string filename)
+{
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream oss;
+  oss << is.rdbuf ();
+  return oss.str ();
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1144,6 +1166,201 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that files written through an
+ * AsyncFileBuffer hold the same bytes as files written directly.
+ */
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  BufferedWriteTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write the known packets, truncated to N_PACKET_BYTES, many times.
+   * \param f The open file.
+   */
+  void WritePackets (PcapFile &f);
+};
+
+BufferedWriteTestCase::BufferedWriteTestCase ()
+  : TestCase ("Check that PcapFile::OpenBuffered writes the same file as PcapFile::Open")
+{
+}
+
+void
+BufferedWriteTestCase::WritePackets (PcapFile &f)
+{
+  f.Init (1, N_PACKET_BYTES);
+  for (uint32_t j = 0; j < 100; ++j)
+    {
+      for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+        {
+          PacketEntry const & p = knownPackets[i];
+          f.Write (p.tsSec + j, p.tsUsec, (uint8_t const *)p.data, p.origLen);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Close must not fail");
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+  std::string direct = CreateTempDirFilename ("direct.pcap");
+  PcapFile f;
+  f.Open (direct, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << direct << ", \"std::ios::out\") returns error");
+  WritePackets (f);
+  std::string expected = ReadFile (direct);
+  NS_TEST_ASSERT_MSG_EQ (expected.size (), 24 + 600 * (16 + N_PACKET_BYTES), "Unexpected file size");
+
+  // A small buffer, so that the writer thread takes many of them.
+  std::string buffered = CreateTempDirFilename ("buffered.pcap");
+  PcapFile g;
+  g.OpenBuffered (buffered, 1000);
+  NS_TEST_ASSERT_MSG_EQ (g.Fail (), false, "OpenBuffered (" << buffered << ") returns error");
+  WritePackets (g);
+  NS_TEST_EXPECT_MSG_EQ ((ReadFile (buffered) == expected), true, "Buffered file differs");
+
+  if (!AsyncFileBuffer::IsSupported (AsyncFileBuffer::GZIP))
+    {
+      return;
+    }
+#ifdef HAVE_ZLIB
+  std::string compressed = CreateTempDirFilename ("buffered.pcap.gz");
+  PcapFile h;
+  h.OpenBuffered (compressed, 1000, AsyncFileBuffer::GZIP);
+  NS_TEST_ASSERT_MSG_EQ (h.Fail (), false, "OpenBuffered (" << compressed << ") returns error");
+  WritePackets (h);
+  NS_TEST_EXPECT_MSG_LT (ReadFile (compressed).size (), expected.size (), "File not compressed");
+
+  gzFile gz = gzopen (compressed.c_str (), "rb");
+  NS_TEST_ASSERT_MSG_NE (gz, 0, "Cannot open " << compressed);
+  std::string decompressed (expected.size () + 1, 0);
+  int size = gzread (gz, &decompressed[0], decompressed.size ());
+  gzclose (gz);
+  decompressed.resize (size > 0 ? size : 0);
+  NS_TEST_EXPECT_MSG_EQ ((decompressed == expected), true, "Decompressed file differs");
+#endif /* HAVE_ZLIB */
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that PcapFileWrapper objects share a
+ * pcapng file, and that PcapHelper names it after the node.
+ */
+class PcapNgTestCase : public TestCase
+{
+public:
+  PcapNgTestCase ();
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+  /**
+   * Read a 32 bit value from the file data.
+   * \param data The file data.
+   * \param offset The offset of the value.
+   * \returns The value.
+   */
+  uint32_t Read32 (const std::string &data, uint32_t offset);
+};
+
+PcapNgTestCase::PcapNgTestCase ()
+  : TestCase ("Check that the interfaces of a pcapng file share it")
+{
+}
+
+void
+PcapNgTestCase::DoTeardown (void)
+{
+  Config::SetDefault ("ns3::PcapFileWrapper::Format", StringValue ("Pcap"));
+}
+
+uint32_t
+PcapNgTestCase::Read32 (const std::string &data, uint32_t offset)
+{
+  uint32_t value = 0;
+  if (offset + 4 <= data.size ())
+    {
+      std::memcpy (&value, data.data () + offset, 4);
+    }
+  return value;
+}
+
+void
+PcapNgTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::PcapFileWrapper::Format", StringValue ("PcapNg"));
+
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> devA = CreateObject<SimpleNetDevice> ();
+  Ptr<SimpleNetDevice> devB = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (devA);
+  node->AddDevice (devB);
+
+  PcapHelper helper;
+  std::string filename = helper.GetFilenameFromDevice (CreateTempDirFilename ("pcapng"), devA);
+  std::ostringstream expectedName;
+  expectedName << CreateTempDirFilename ("pcapng") << "-" << node->GetId () << ".pcapng";
+  NS_TEST_ASSERT_MSG_EQ (filename, expectedName.str (), "Wrong pcapng file name");
+  NS_TEST_ASSERT_MSG_EQ (helper.GetFilenameFromDevice (CreateTempDirFilename ("pcapng"), devB), filename,
+                         "The devices of a node must share the file");
+
+  Ptr<PcapFileWrapper> fileA = helper.CreateFile (filename, std::ios::out, PcapHelper::DLT_PPP, 100);
+  Ptr<PcapFileWrapper> fileB = helper.CreateFile (filename, std::ios::out, PcapHelper::DLT_EN10MB);
+  NS_TEST_EXPECT_MSG_EQ (fileA->GetDataLinkType (), PcapHelper::DLT_PPP, "Wrong link type");
+  NS_TEST_EXPECT_MSG_EQ (fileB->GetDataLinkType (), PcapHelper::DLT_EN10MB, "Wrong link type");
+  fileA->Write (Seconds (1), Create<Packet> (50));
+  fileB->Write (NanoSeconds (5000000001ULL), Create<Packet> (150));
+  fileA->Write (Seconds (2), Create<Packet> (150));
+  NS_TEST_EXPECT_MSG_EQ (fileA->Fail (), false, "Write must not fail");
+  fileA = 0;
+  fileB = 0;
+
+  std::string data = ReadFile (filename);
+  // Section header
+  NS_TEST_ASSERT_MSG_EQ (Read32 (data, 0), 0x0a0d0d0a, "No section header block");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (data, 4), 28, "Wrong section header block length");
+  NS_TEST_ASSERT_MSG_EQ (Read32 (data, 8), 0x1a2b3c4d, "Wrong byte order magic");
+  uint32_t offset = 28;
+  // Interfaces: link type and snap length
+  uint32_t interfaces[2][2] = { { 9, 100 }, { 1, PcapFile::SNAPLEN_DEFAULT } };
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Read32 (data, offset), 1, "No interface description block");
+      NS_TEST_ASSERT_MSG_EQ (Read32 (data, offset + 4), 32, "Wrong interface description block length");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + 8), interfaces[i][0], "Wrong link type");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + 12), interfaces[i][1], "Wrong snap length");
+      offset += 32;
+    }
+  // Packets: interface, timestamp, captured and original length
+  uint64_t packets[3][4] = { { 0, 1000000000, 50, 50 }, { 1, 5000000001ULL, 150, 150 },
+                             { 0, 2000000000, 100, 150 } };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      uint32_t length = 32 + ((packets[i][2] + 3) & ~3U);
+      NS_TEST_ASSERT_MSG_EQ (Read32 (data, offset), 6, "No enhanced packet block");
+      NS_TEST_ASSERT_MSG_EQ (Read32 (data, offset + 4), length, "Wrong enhanced packet block length");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + 8), packets[i][0], "Wrong interface");
+      uint64_t ns = (uint64_t (Read32 (data, offset + 12)) << 32) | Read32 (data, offset + 16);
+      NS_TEST_EXPECT_MSG_EQ (ns, packets[i][1], "Wrong timestamp");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + 20), packets[i][2], "Wrong captured length");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + 24), packets[i][3], "Wrong original length");
+      NS_TEST_EXPECT_MSG_EQ (Read32 (data, offset + length - 4), length, "Wrong trailing block length");
+      offset += length;
+    }
+  NS_TEST_EXPECT_MSG_EQ (data.size (), offset, "Unexpected data at the end of the file");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1167,6 +1384,8 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase, TestCase::QUICK);
+  AddTestCase (new PcapNgTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite; //!< Static variable for test initialization
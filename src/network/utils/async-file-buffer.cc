@@ -0,0 +1,334 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "async-file-buffer.h"
+#include "ns3/network-config.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AsyncFileBuffer");
+
+/** The size of the buffer used when writing on the calling thread. */
+static const std::size_t SYNC_BUFFER_SIZE = 64 * 1024;
+
+AsyncFileBuffer::AsyncFileBuffer ()
+  : m_file (0),
+    m_compression (NONE),
+    m_zstream (0),
+    m_bufferSize (0),
+    m_threaded (false),
+    m_error (false)
+#ifdef HAVE_PTHREAD_H
+    ,
+    m_writing (false),
+    m_stop (false)
+#endif /* HAVE_PTHREAD_H */
+{
+  NS_LOG_FUNCTION (this);
+}
+
+AsyncFileBuffer::~AsyncFileBuffer ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+AsyncFileBuffer::IsSupported (Compression compression)
+{
+#ifdef HAVE_ZLIB
+  return true;
+#else
+  return compression == NONE;
+#endif /* HAVE_ZLIB */
+}
+
+bool
+AsyncFileBuffer::Open (const std::string &filename, std::size_t bufferSize,
+                       Compression compression)
+{
+  NS_LOG_FUNCTION (this << filename << bufferSize << compression);
+  NS_ASSERT_MSG (m_file == 0, "File already open");
+  NS_ABORT_MSG_UNLESS (IsSupported (compression),
+                       "Cannot write " << filename << ": ns-3 was built without zlib");
+
+  m_file = std::fopen (filename.c_str (), "wb");
+  if (m_file == 0)
+    {
+      return false;
+    }
+  m_compression = compression;
+  m_error = false;
+#ifdef HAVE_ZLIB
+  if (m_compression == GZIP)
+    {
+      m_zstream = new z_stream ();
+      // 15 bits of window, plus 16 for a gzip header and trailer.  The
+      // fastest level keeps the writer thread ahead of the simulation.
+      if (deflateInit2 (m_zstream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                        Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+          delete m_zstream;
+          m_zstream = 0;
+          std::fclose (m_file);
+          m_file = 0;
+          return false;
+        }
+      m_zbuffer.resize (SYNC_BUFFER_SIZE);
+    }
+#endif /* HAVE_ZLIB */
+
+#ifdef HAVE_PTHREAD_H
+  m_threaded = bufferSize > 0;
+#endif /* HAVE_PTHREAD_H */
+  m_bufferSize = bufferSize > 0 ? bufferSize : SYNC_BUFFER_SIZE;
+  m_put.resize (m_bufferSize);
+  ResetPutArea ();
+
+#ifdef HAVE_PTHREAD_H
+  if (m_threaded)
+    {
+      m_front.reserve (m_bufferSize);
+      m_writing = false;
+      m_stop = false;
+      m_thread = Create<SystemThread> (MakeCallback (&AsyncFileBuffer::Write, this));
+      m_thread->Start ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  return true;
+}
+
+bool
+AsyncFileBuffer::IsOpen (void) const
+{
+  return m_file != 0;
+}
+
+bool
+AsyncFileBuffer::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file == 0)
+    {
+      return true;
+    }
+  bool ok = Submit ();
+#ifdef HAVE_PTHREAD_H
+  if (m_threaded)
+    {
+      m_mutex.Lock ();
+      m_stop = true;
+      m_mutex.Unlock ();
+      m_dataReady.SetCondition (true);
+      m_dataReady.Signal ();
+      m_thread->Join ();
+      m_thread = 0;
+      m_threaded = false;
+      ok = ok && !m_error;
+    }
+#endif /* HAVE_PTHREAD_H */
+  ok = WriteOut (0, 0, 2) && ok;
+#ifdef HAVE_ZLIB
+  if (m_zstream != 0)
+    {
+      deflateEnd (m_zstream);
+      delete m_zstream;
+      m_zstream = 0;
+    }
+#endif /* HAVE_ZLIB */
+  ok = std::fclose (m_file) == 0 && ok;
+  m_file = 0;
+  setp (0, 0);
+  std::vector<char> ().swap (m_put);
+  return ok;
+}
+
+void
+AsyncFileBuffer::ResetPutArea (void)
+{
+  setp (&m_put[0], &m_put[0] + m_put.size ());
+}
+
+AsyncFileBuffer::int_type
+AsyncFileBuffer::overflow (int_type c)
+{
+  if (m_file == 0 || !Submit ())
+    {
+      return traits_type::eof ();
+    }
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      *pptr () = traits_type::to_char_type (c);
+      pbump (1);
+    }
+  return traits_type::not_eof (c);
+}
+
+int
+AsyncFileBuffer::sync (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file == 0 || !Submit ())
+    {
+      return -1;
+    }
+#ifdef HAVE_PTHREAD_H
+  if (m_threaded)
+    {
+      // Wait for the writer thread to write out everything, after which
+      // it does not touch the file until more data is submitted.
+      m_mutex.Lock ();
+      while ((!m_front.empty () || m_writing) && !m_error)
+        {
+          m_spaceReady.SetCondition (false);
+          m_mutex.Unlock ();
+          m_dataReady.SetCondition (true);
+          m_dataReady.Signal ();
+          m_spaceReady.TimedWait (1000000);
+          m_mutex.Lock ();
+        }
+      bool error = m_error;
+      m_mutex.Unlock ();
+      if (error)
+        {
+          return -1;
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
+  return WriteOut (0, 0, 1) ? 0 : -1;
+}
+
+bool
+AsyncFileBuffer::Submit (void)
+{
+  std::size_t size = pptr () - pbase ();
+#ifdef HAVE_PTHREAD_H
+  if (m_threaded)
+    {
+      m_mutex.Lock ();
+      while (!m_front.empty () && !m_error)
+        {
+          // Wait for the writer thread to take the other buffer.
+          m_spaceReady.SetCondition (false);
+          m_mutex.Unlock ();
+          m_dataReady.SetCondition (true);
+          m_dataReady.Signal ();
+          m_spaceReady.TimedWait (1000000);
+          m_mutex.Lock ();
+        }
+      bool error = m_error;
+      if (!error && size > 0)
+        {
+          m_put.resize (size);
+          m_front.swap (m_put);
+        }
+      m_mutex.Unlock ();
+      if (size > 0)
+        {
+          m_dataReady.SetCondition (true);
+          m_dataReady.Signal ();
+          m_put.resize (m_bufferSize);
+        }
+      ResetPutArea ();
+      return !error;
+    }
+#endif /* HAVE_PTHREAD_H */
+  bool ok = WriteOut (pbase (), size, 0);
+  ResetPutArea ();
+  return ok;
+}
+
+bool
+AsyncFileBuffer::WriteOut (const char *data, std::size_t size, int flush)
+{
+#ifdef HAVE_ZLIB
+  if (m_zstream != 0)
+    {
+      m_zstream->next_in = reinterpret_cast<Bytef *> (const_cast<char *> (data));
+      m_zstream->avail_in = size;
+      int mode = flush == 2 ? Z_FINISH : (flush == 1 ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+      int status;
+      do
+        {
+          m_zstream->next_out = reinterpret_cast<Bytef *> (&m_zbuffer[0]);
+          m_zstream->avail_out = m_zbuffer.size ();
+          status = deflate (m_zstream, mode);
+          if (status == Z_STREAM_ERROR)
+            {
+              return false;
+            }
+          std::size_t out = m_zbuffer.size () - m_zstream->avail_out;
+          if (std::fwrite (&m_zbuffer[0], 1, out, m_file) != out)
+            {
+              return false;
+            }
+        }
+      while (m_zstream->avail_out == 0 || (mode == Z_FINISH && status != Z_STREAM_END));
+      return flush == 0 || std::fflush (m_file) == 0;
+    }
+#endif /* HAVE_ZLIB */
+  if (size > 0 && std::fwrite (data, 1, size, m_file) != size)
+    {
+      return false;
+    }
+  return flush == 0 || std::fflush (m_file) == 0;
+}
+
+#ifdef HAVE_PTHREAD_H
+void
+AsyncFileBuffer::Write (void)
+{
+  std::vector<char> back;
+  back.reserve (m_bufferSize);
+  for (;;)
+    {
+      // Signals sent from now on end the wait below at once.
+      m_dataReady.SetCondition (false);
+      m_mutex.Lock ();
+      bool stop = m_stop;
+      m_front.swap (back);
+      m_writing = !back.empty ();
+      m_mutex.Unlock ();
+      if (!back.empty ())
+        {
+          bool ok = WriteOut (&back[0], back.size (), 0);
+          back.clear ();
+          m_mutex.Lock ();
+          m_writing = false;
+          m_error = m_error || !ok;
+          m_mutex.Unlock ();
+          m_spaceReady.SetCondition (true);
+          m_spaceReady.Broadcast ();
+          continue;
+        }
+      if (stop)
+        {
+          break;
+        }
+      m_dataReady.TimedWait (10000000);
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
+} // namespace ns3
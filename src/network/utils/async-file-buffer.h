@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ASYNC_FILE_BUFFER_H
+#define ASYNC_FILE_BUFFER_H
+
+#include "ns3/core-config.h"
+#include "ns3/ptr.h"
+
+#include <cstdio>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif /* HAVE_PTHREAD_H */
+
+/** zlib stream state, declared in zlib.h. */
+struct z_stream_s;
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief A stream buffer which writes a file from a background thread.
+ *
+ * Data written through a \c std::ostream using this stream buffer is
+ * copied into an in-memory buffer.  When the buffer is full it is
+ * handed over to a writer thread, which optionally compresses it and
+ * writes it to the file while the simulation thread fills a second
+ * buffer.  The simulation thread only waits when the writer falls a
+ * whole buffer behind.
+ *
+ * With a buffer size of zero, or when ns-3 is built without thread
+ * support, the data is written out on the calling thread whenever the
+ * buffer is full.
+ *
+ * Flushing the stream (\c std::ostream::flush) waits until all the
+ * data written so far is in the file.
+ */
+class AsyncFileBuffer : public std::streambuf
+{
+public:
+  /** The compression applied to the file. */
+  enum Compression
+  {
+    NONE,  //!< Write the data as is.
+    GZIP   //!< Write a gzip file (requires zlib).
+  };
+
+  AsyncFileBuffer ();
+  /** Write out the buffered data and close the file. */
+  virtual ~AsyncFileBuffer ();
+
+  /**
+   * Check if a compression method is available in this build.
+   * \param [in] compression The compression method.
+   * \returns \c true if files can be written with this compression.
+   */
+  static bool IsSupported (Compression compression);
+
+  /**
+   * Create a file, replacing any existing file of the same name.
+   * \param [in] filename The name of the file.
+   * \param [in] bufferSize The size of each of the two in-memory
+   *             buffers, in bytes; zero writes the file on the calling
+   *             thread.
+   * \param [in] compression The compression applied to the file.
+   * \returns \c false if the file cannot be created.
+   */
+  bool Open (const std::string &filename, std::size_t bufferSize,
+             Compression compression = NONE);
+  /**
+   * Check if a file is open.
+   * \returns \c true between a successful Open() and Close().
+   */
+  bool IsOpen (void) const;
+  /**
+   * Write out the buffered data, stop the writer thread and close the
+   * file.
+   * \returns \c false if writing the file failed.
+   */
+  bool Close (void);
+
+protected:
+  // Inherited from std::streambuf
+  virtual int_type overflow (int_type c);
+  virtual int sync (void);
+
+private:
+  /**
+   * Hand the data in the put area over to be written out.
+   * \returns \c false if writing the file failed.
+   */
+  bool Submit (void);
+  /**
+   * Compress and write data to the file.
+   * \param [in] data The data.
+   * \param [in] size The size of the data.
+   * \param [in] flush Flush the compressor and the file: 1 to make
+   *             the data written so far readable, 2 to end the file.
+   * \returns \c false if writing the file failed.
+   */
+  bool WriteOut (const char *data, std::size_t size, int flush);
+  /** Set the put area to the whole of m_put. */
+  void ResetPutArea (void);
+
+  FILE *m_file;                 //!< The file.
+  Compression m_compression;    //!< The compression applied to the file.
+  struct z_stream_s *m_zstream; //!< The compressor, with GZIP.
+  std::vector<char> m_zbuffer;  //!< The compressor output buffer.
+  std::size_t m_bufferSize;     //!< The size of each buffer.
+  std::vector<char> m_put;      //!< The buffer the calling thread writes into.
+  bool m_threaded;              //!< A writer thread writes the file.
+  bool m_error;                 //!< Writing the file failed.
+
+#ifdef HAVE_PTHREAD_H
+  /** The writer thread. */
+  void Write (void);
+
+  // State shared with the writer thread, guarded by m_mutex.
+  SystemMutex m_mutex;          //!< Guards the shared state.
+  std::vector<char> m_front;    //!< Data waiting to be written.
+  bool m_writing;               //!< The writer thread is writing data.
+  bool m_stop;                  //!< Stop the writer thread.
+
+  SystemCondition m_dataReady;  //!< Wakes up the writer thread.
+  SystemCondition m_spaceReady; //!< Wakes up a waiting calling thread.
+  Ptr<SystemThread> m_thread;   //!< The writer thread.
+#endif /* HAVE_PTHREAD_H */
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_FILE_BUFFER_H */
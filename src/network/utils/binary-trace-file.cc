@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/fatal-impl.h"
+#include "binary-trace-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceFile");
+
+/** The magic string at the start of a binary trace. */
+static const char BINARY_TRACE_MAGIC[8] = { 'n', 's', '3', 't', 'r', 'a', 'c', 'e' };
+/** The format version of the binary traces written. */
+static const uint32_t BINARY_TRACE_VERSION = 1;
+/** The size of a record, without the packet bytes. */
+static const uint32_t RECORD_SIZE = 32;
+
+BinaryTraceFile::BinaryTraceFile (const std::string &filename, uint32_t headerBytes,
+                                  uint32_t bufferSize)
+  : m_headerBytes (headerBytes),
+    m_out (&m_buffer)
+{
+  NS_LOG_FUNCTION (this << filename << headerBytes << bufferSize);
+  FatalImpl::RegisterStream (&m_out);
+  if (!m_buffer.Open (filename, bufferSize))
+    {
+      m_out.setstate (std::ios::failbit);
+      return;
+    }
+  m_out.write (BINARY_TRACE_MAGIC, sizeof (BINARY_TRACE_MAGIC));
+  m_out.write (reinterpret_cast<const char *> (&BINARY_TRACE_VERSION), sizeof (BINARY_TRACE_VERSION));
+  m_out.write (reinterpret_cast<const char *> (&m_headerBytes), sizeof (m_headerBytes));
+}
+
+BinaryTraceFile::~BinaryTraceFile ()
+{
+  NS_LOG_FUNCTION (this);
+  FatalImpl::UnregisterStream (&m_out);
+  m_buffer.Close ();
+}
+
+bool
+BinaryTraceFile::Fail (void) const
+{
+  return m_out.fail ();
+}
+
+uint32_t
+BinaryTraceFile::GetHeaderBytes (void) const
+{
+  return m_headerBytes;
+}
+
+void
+BinaryTraceFile::Write (Time t, uint32_t node, uint32_t device, Event event, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << t << node << device << event << p);
+  struct
+  {
+    int64_t time;
+    uint64_t uid;
+    uint32_t node;
+    uint32_t device;
+    uint32_t size;
+    uint8_t event;
+    uint8_t padding[3];
+  } record;
+  record.time = t.GetNanoSeconds ();
+  record.uid = p->GetUid ();
+  record.node = node;
+  record.device = device;
+  record.size = p->GetSize ();
+  record.event = event;
+  std::memset (record.padding, 0, sizeof (record.padding));
+  m_out.write (reinterpret_cast<const char *> (&record), RECORD_SIZE);
+
+  if (m_headerBytes > 0)
+    {
+      uint32_t copied = std::min (m_headerBytes, record.size);
+      p->CopyData (&m_out, copied);
+      for (uint32_t i = copied; i < m_headerBytes; ++i)
+        {
+          m_out.put (0);
+        }
+    }
+}
+
+void
+BinaryTraceFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_out.flush ();
+}
+
+/**
+ * Read a value from a binary trace.
+ * \param [in] data The record.
+ * \param [in] offset The offset of the value in the record.
+ * \param [out] value The value.
+ */
+template <typename T>
+static void
+ReadValue (const std::vector<char> &data, uint32_t offset, T &value)
+{
+  std::memcpy (&value, &data[offset], sizeof (value));
+}
+
+bool
+BinaryTraceFile::Convert (std::istream &is, std::ostream &os, TextFormat format)
+{
+  char magic[sizeof (BINARY_TRACE_MAGIC)];
+  uint32_t version;
+  uint32_t headerBytes;
+  is.read (magic, sizeof (magic));
+  is.read (reinterpret_cast<char *> (&version), sizeof (version));
+  is.read (reinterpret_cast<char *> (&headerBytes), sizeof (headerBytes));
+  if (!is || std::memcmp (magic, BINARY_TRACE_MAGIC, sizeof (magic)) != 0
+      || version != BINARY_TRACE_VERSION)
+    {
+      return false;
+    }
+
+  if (format == CSV)
+    {
+      os << "time,node,device,event,uid,size";
+      if (headerBytes > 0)
+        {
+          os << ",header";
+        }
+      os << std::endl;
+    }
+
+  std::vector<char> record (RECORD_SIZE + headerBytes);
+  std::ostringstream line;
+  line << std::setfill ('0');
+  for (;;)
+    {
+      is.read (&record[0], record.size ());
+      if (is.gcount () == 0)
+        {
+          return true;
+        }
+      if (is.gcount () != static_cast<std::streamsize> (record.size ()))
+        {
+          return false;
+        }
+      int64_t time;
+      uint64_t uid;
+      uint32_t node;
+      uint32_t device;
+      uint32_t size;
+      uint8_t event;
+      ReadValue (record, 0, time);
+      ReadValue (record, 8, uid);
+      ReadValue (record, 16, node);
+      ReadValue (record, 20, device);
+      ReadValue (record, 24, size);
+      ReadValue (record, 28, event);
+
+      line.str ("");
+      line << time / 1000000000 << "." << std::setw (9) << time % 1000000000;
+      if (format == CSV)
+        {
+          os << line.str () << "," << node << "," << device << "," << event << ","
+             << uid << "," << size;
+          if (headerBytes > 0)
+            {
+              os << ",";
+            }
+        }
+      else
+        {
+          os << event << " " << line.str () << " /NodeList/" << node << "/DeviceList/" << device
+             << " uid=" << uid << " size=" << size;
+          if (headerBytes > 0)
+            {
+              os << " ";
+            }
+        }
+      uint32_t bytes = std::min (headerBytes, size);
+      for (uint32_t i = 0; i < bytes; ++i)
+        {
+          static const char digits[] = "0123456789abcdef";
+          uint8_t byte = record[RECORD_SIZE + i];
+          os << digits[byte >> 4] << digits[byte & 0xf];
+        }
+      os << "\n";
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_FILE_H
+#define BINARY_TRACE_FILE_H
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "async-file-buffer.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief A trace file of packet events in fixed-width binary records.
+ *
+ * Each record holds the time of the event, the node and device ids,
+ * the event type, the packet uid and size, and optionally the first
+ * bytes of the packet, so that a trace is a fraction of the size of
+ * the equivalent ASCII trace and costs no packet printing.  The file
+ * is written through an AsyncFileBuffer, by a background thread.
+ *
+ * The file is made of a 16 byte file header:
+ *
+ *   - the magic string \c "ns3trace",
+ *   - the format version (uint32_t),
+ *   - the number of packet bytes in each record (uint32_t),
+ *
+ * followed by the records:
+ *
+ *   - the time, in nanoseconds (int64_t),
+ *   - the packet uid (uint64_t),
+ *   - the node id (uint32_t),
+ *   - the device index (uint32_t),
+ *   - the packet size (uint32_t),
+ *   - the event type (uint8_t) and three bytes of padding,
+ *   - the first bytes of the packet, padded with zeros.
+ *
+ * All the values are in host byte order.  Convert() prints a trace as
+ * CSV or as ASCII trace lines; the \c trace-convert program in
+ * \c utils/ does the same from the command line.
+ *
+ * BinaryTraceHelper writes the events of devices to such a file.
+ */
+class BinaryTraceFile : public SimpleRefCount<BinaryTraceFile>
+{
+public:
+  /** The event types, with the symbols of the ASCII traces. */
+  enum Event
+  {
+    ENQUEUE = '+',  //!< Packet enqueued in the device queue.
+    DEQUEUE = '-',  //!< Packet dequeued from the device queue.
+    DROP = 'd',     //!< Packet dropped.
+    RECEIVE = 'r'   //!< Packet received.
+  };
+
+  /** The text formats of Convert(). */
+  enum TextFormat
+  {
+    CSV,   //!< Comma separated values, with a header line.
+    ASCII  //!< A line per event, in the style of the ASCII traces.
+  };
+
+  /**
+   * Create a trace file.
+   * \param [in] filename The name of the file.
+   * \param [in] headerBytes The number of bytes of each packet to record.
+   * \param [in] bufferSize The size of the in-memory buffer, in bytes;
+   *             zero writes the file on the simulation thread.
+   */
+  BinaryTraceFile (const std::string &filename, uint32_t headerBytes = 0,
+                   uint32_t bufferSize = 4 * 1024 * 1024);
+  /** Write out the buffered records and close the file. */
+  ~BinaryTraceFile ();
+
+  /**
+   * \returns \c true if creating or writing the file failed.
+   */
+  bool Fail (void) const;
+  /**
+   * \returns The number of bytes of each packet recorded.
+   */
+  uint32_t GetHeaderBytes (void) const;
+
+  /**
+   * Write a record.
+   * \param [in] t The time of the event.
+   * \param [in] node The node id.
+   * \param [in] device The device index.
+   * \param [in] event The event type.
+   * \param [in] p The packet.
+   */
+  void Write (Time t, uint32_t node, uint32_t device, Event event, Ptr<const Packet> p);
+  /**
+   * Write out the buffered records, so that the file can be read while
+   * it is still open.
+   */
+  void Flush (void);
+
+  /**
+   * Print a binary trace as text.
+   * \param [in] is The binary trace.
+   * \param [in] os The stream to print on.
+   * \param [in] format The text format.
+   * \returns \c false if the input is not a valid binary trace.
+   */
+  static bool Convert (std::istream &is, std::ostream &os, TextFormat format);
+
+private:
+  uint32_t m_headerBytes;   //!< The number of packet bytes in each record.
+  AsyncFileBuffer m_buffer; //!< The file buffer.
+  std::ostream m_out;       //!< The stream writing to m_buffer.
+};
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_FILE_H */
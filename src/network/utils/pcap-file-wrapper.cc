@@ -19,6 +19,8 @@
 #include "ns3/log.h"
 #include "ns3/boolean.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/abort.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "pcap-file-wrapper.h"
@@ -46,12 +48,32 @@ PcapFileWrapper::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&PcapFileWrapper::m_nanosecMode),
                    MakeBooleanChecker())
+    .AddAttribute ("BufferSize",
+                   "Size in bytes of the in-memory buffers of files opened for writing, "
+                   "which a background thread writes out.  Zero writes the file directly.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Compression",
+                   "Compression of the files opened for writing.",
+                   EnumValue (AsyncFileBuffer::NONE),
+                   MakeEnumAccessor (&PcapFileWrapper::m_compression),
+                   MakeEnumChecker (AsyncFileBuffer::NONE, "None",
+                                    AsyncFileBuffer::GZIP, "Gzip"))
+    .AddAttribute ("Format",
+                   "Format of the files opened for writing.  The wrappers writing "
+                   "a pcapng file of the same name share it, as separate interfaces.",
+                   EnumValue (PcapFileWrapper::PCAP),
+                   MakeEnumAccessor (&PcapFileWrapper::m_format),
+                   MakeEnumChecker (PcapFileWrapper::PCAP, "Pcap",
+                                    PcapFileWrapper::PCAPNG, "PcapNg"))
   ;
   return tid;
 }
 
 
 PcapFileWrapper::PcapFileWrapper ()
+  : m_ngInterface (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -66,6 +88,10 @@ bool
 PcapFileWrapper::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile)
+    {
+      return m_ngFile->Fail ();
+    }
   return m_file.Fail ();
 }
 
@@ -86,6 +112,7 @@ void
 PcapFileWrapper::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  m_ngFile = 0;
   m_file.Close ();
 }
 
@@ -93,7 +120,20 @@ void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
   NS_LOG_FUNCTION (this << filename << mode);
-  m_file.Open (filename, mode);
+  bool writeOnly = (mode & std::ios::in) == 0 && (mode & std::ios::app) == 0;
+  if (m_format == PCAPNG)
+    {
+      NS_ABORT_MSG_UNLESS (writeOnly, "pcapng files can only be written");
+      m_ngFile = PcapNgFile::Open (filename, m_bufferSize, m_compression);
+    }
+  else if (writeOnly && (m_bufferSize > 0 || m_compression != AsyncFileBuffer::NONE))
+    {
+      m_file.OpenBuffered (filename, m_bufferSize, m_compression);
+    }
+  else
+    {
+      m_file.Open (filename, mode);
+    }
 }
 
 void
@@ -105,6 +145,13 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
+  if (m_ngFile)
+    {
+      // pcapng timestamps are in nanoseconds and UTC
+      m_ngInterface = m_ngFile->AddInterface (dataLinkType,
+                                              snapLen != std::numeric_limits<uint32_t>::max () ? snapLen : m_snapLen);
+      return;
+    }
   if (snapLen != std::numeric_limits<uint32_t>::max ())
     {
       m_file.Init (dataLinkType, snapLen, tzCorrection, false, m_nanosecMode);
@@ -119,6 +166,11 @@ void
 PcapFileWrapper::Write (Time t, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << p);
+  if (m_ngFile)
+    {
+      m_ngFile->Write (m_ngInterface, t, p);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -139,6 +191,11 @@ void
 PcapFileWrapper::Write (Time t, const Header &header, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << t << &header << p);
+  if (m_ngFile)
+    {
+      m_ngFile->Write (m_ngInterface, t, header, p);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -159,6 +216,11 @@ void
 PcapFileWrapper::Write (Time t, uint8_t const *buffer, uint32_t length)
 {
   NS_LOG_FUNCTION (this << t << &buffer << length);
+  if (m_ngFile)
+    {
+      m_ngFile->Write (m_ngInterface, t, buffer, length);
+      return;
+    }
   if (m_file.IsNanoSecMode())
     {
       uint64_t current = t.GetNanoSeconds ();
@@ -246,6 +308,10 @@ uint32_t
 PcapFileWrapper::GetSnapLen (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile)
+    {
+      return m_ngFile->GetSnapLen (m_ngInterface);
+    }
   return m_file.GetSnapLen ();
 }
 
@@ -253,6 +319,10 @@ uint32_t
 PcapFileWrapper::GetDataLinkType (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_ngFile)
+    {
+      return m_ngFile->GetDataLinkType (m_ngInterface);
+    }
   return m_file.GetDataLinkType ();
 }
 
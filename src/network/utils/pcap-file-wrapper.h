@@ -27,6 +27,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 namespace ns3 {
 
@@ -35,10 +36,24 @@ namespace ns3 {
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * Files opened for writing can be written through an in-memory buffer
+ * drained by a background thread ("BufferSize"), gzip-compressed
+ * ("Compression"), or written in the pcapng format ("Format"), in
+ * which case the wrappers opening the same file name share it, each
+ * as its own capture interface.  The header accessors and Read() only
+ * apply to pcap files.
  */
 class PcapFileWrapper : public Object
 {
 public:
+  /** The format of the files written. */
+  enum Format
+  {
+    PCAP,    //!< A pcap file per wrapper.
+    PCAPNG   //!< A pcapng interface per wrapper, in a shared file.
+  };
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -70,6 +85,9 @@ public:
    * selected as a binary file (fstream::binary is automatically ored with the mode
    * field).
    *
+   * A file opened for writing only is written according to the
+   * "BufferSize", "Compression" and "Format" attributes.
+   *
    * \param filename String containing the name of the file.
    *
    * \param mode String containing the access mode for the file.
@@ -224,6 +242,11 @@ private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
   bool     m_nanosecMode; //!< Timestamps in nanosecond mode
+  uint32_t m_bufferSize; //!< Size of the in-memory buffer of written files
+  AsyncFileBuffer::Compression m_compression; //!< Compression of written files
+  Format   m_format; //!< Format of written files
+  Ptr<PcapNgFile> m_ngFile; //!< Pcapng file, with the PCAPNG format
+  uint32_t m_ngInterface; //!< Interface id in the pcapng file
 };
 
 } // namespace ns3
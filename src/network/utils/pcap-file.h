@@ -25,6 +25,7 @@
 #include <fstream>
 #include <stdint.h>
 #include "ns3/ptr.h"
+#include "async-file-buffer.h"
 
 namespace ns3 {
 
@@ -80,6 +81,20 @@ public:
    */
   void Open (std::string const &filename, std::ios::openmode mode);
 
+  /**
+   * Create a new pcap file for writing through an AsyncFileBuffer: the
+   * packets are copied to an in-memory buffer, which a background
+   * thread compresses if requested and writes out.  The file can only
+   * be written, and is complete once closed.
+   *
+   * \param filename String containing the name of the file.
+   * \param bufferSize The size of the in-memory buffer, in bytes; zero
+   * writes the file on the calling thread.
+   * \param compression The compression applied to the file.
+   */
+  void OpenBuffered (std::string const &filename, uint32_t bufferSize,
+                     AsyncFileBuffer::Compression compression = AsyncFileBuffer::NONE);
+
   /**
    * Close the underlying file.
    */
@@ -368,6 +383,9 @@ private:
 
   std::string    m_filename;    //!< file name
   std::fstream   m_file;        //!< file stream
+  AsyncFileBuffer m_buffer;     //!< buffer of a file opened with OpenBuffered()
+  std::ostream   m_bufferStream; //!< stream writing to m_buffer
+  std::ostream  *m_out;         //!< stream the packets are written to
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <map>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ns3/header.h"
+#include "ns3/buffer.h"
+#include "ns3/fatal-impl.h"
+#include "pcapng-file.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapNgFile");
+
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;    /**< Section header block type */
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;      /**< Interface description block type */
+const uint32_t ENHANCED_PACKET_BLOCK = 6;            /**< Enhanced packet block type */
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;        /**< Identifies the byte order of the section */
+const uint16_t IF_TSRESOL = 9;                       /**< Interface timestamp resolution option */
+
+/**
+ * Get the open files, by name.
+ * \returns The open files.
+ */
+static std::map<std::string, PcapNgFile *> &
+GetOpenFiles (void)
+{
+  static std::map<std::string, PcapNgFile *> files;
+  return files;
+}
+
+Ptr<PcapNgFile>
+PcapNgFile::Open (const std::string &filename, uint32_t bufferSize,
+                  AsyncFileBuffer::Compression compression)
+{
+  NS_LOG_FUNCTION (filename << bufferSize << compression);
+  std::map<std::string, PcapNgFile *>::const_iterator it = GetOpenFiles ().find (filename);
+  if (it != GetOpenFiles ().end ())
+    {
+      NS_ASSERT_MSG (it->second->m_bufferSize == bufferSize
+                     && it->second->m_compression == compression,
+                     "PcapNgFile::Open (): " << filename << " is already open with a buffer size of "
+                     << it->second->m_bufferSize << " and compression " << it->second->m_compression);
+      return it->second;
+    }
+  Ptr<PcapNgFile> file = Ptr<PcapNgFile> (new PcapNgFile (filename, bufferSize, compression), false);
+  GetOpenFiles ()[filename] = PeekPointer (file);
+  return file;
+}
+
+PcapNgFile::PcapNgFile (const std::string &filename, uint32_t bufferSize,
+                        AsyncFileBuffer::Compression compression)
+  : m_filename (filename),
+    m_bufferSize (bufferSize),
+    m_compression (compression),
+    m_out (&m_buffer)
+{
+  NS_LOG_FUNCTION (this << filename << bufferSize << compression);
+  FatalImpl::RegisterStream (&m_out);
+  if (!m_buffer.Open (filename, bufferSize, compression))
+    {
+      m_out.setstate (std::ios::failbit);
+      return;
+    }
+  Write32 (SECTION_HEADER_BLOCK);
+  Write32 (28);
+  Write32 (BYTE_ORDER_MAGIC);
+  uint16_t version[2] = { 1, 0 };
+  m_out.write (reinterpret_cast<const char *> (version), sizeof (version));
+  // The length of the section is not known.
+  int64_t sectionLength = -1;
+  m_out.write (reinterpret_cast<const char *> (&sectionLength), sizeof (sectionLength));
+  Write32 (28);
+}
+
+PcapNgFile::~PcapNgFile ()
+{
+  NS_LOG_FUNCTION (this);
+  GetOpenFiles ().erase (m_filename);
+  FatalImpl::UnregisterStream (&m_out);
+  m_buffer.Close ();
+}
+
+bool
+PcapNgFile::Fail (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_out.fail ();
+}
+
+void
+PcapNgFile::Write32 (uint32_t value)
+{
+  m_out.write (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+uint32_t
+PcapNgFile::AddInterface (uint32_t dataLinkType, uint32_t snapLen)
+{
+  NS_LOG_FUNCTION (this << dataLinkType << snapLen);
+  Interface interface;
+  interface.dataLinkType = dataLinkType;
+  interface.snapLen = snapLen;
+  m_interfaces.push_back (interface);
+
+  Write32 (INTERFACE_DESCRIPTION_BLOCK);
+  Write32 (32);
+  uint16_t linkType[2] = { static_cast<uint16_t> (dataLinkType), 0 };
+  m_out.write (reinterpret_cast<const char *> (linkType), sizeof (linkType));
+  Write32 (snapLen);
+  // Timestamps are in units of 10^-9 seconds: the option code and
+  // length, the value and three bytes of padding.
+  uint16_t option[2] = { IF_TSRESOL, 1 };
+  m_out.write (reinterpret_cast<const char *> (option), sizeof (option));
+  uint8_t resolution[4] = { 9, 0, 0, 0 };
+  m_out.write (reinterpret_cast<const char *> (resolution), sizeof (resolution));
+  // End of options
+  Write32 (0);
+  Write32 (32);
+  return m_interfaces.size () - 1;
+}
+
+uint32_t
+PcapNgFile::GetDataLinkType (uint32_t interface) const
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].dataLinkType;
+}
+
+uint32_t
+PcapNgFile::GetSnapLen (uint32_t interface) const
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  return m_interfaces[interface].snapLen;
+}
+
+uint32_t
+PcapNgFile::WritePacketHeader (uint32_t interface, Time t, uint32_t totalLen)
+{
+  NS_ASSERT (interface < m_interfaces.size ());
+  uint32_t inclLen = std::min (totalLen, m_interfaces[interface].snapLen);
+  uint32_t padded = (inclLen + 3) & ~3U;
+  uint64_t ns = t.GetNanoSeconds ();
+
+  uint32_t header[7] = {
+    ENHANCED_PACKET_BLOCK,
+    32 + padded,
+    interface,
+    static_cast<uint32_t> (ns >> 32),
+    static_cast<uint32_t> (ns),
+    inclLen,
+    totalLen
+  };
+  m_out.write (reinterpret_cast<const char *> (header), sizeof (header));
+  return inclLen;
+}
+
+void
+PcapNgFile::WritePacketTrailer (uint32_t inclLen)
+{
+  static const char padding[3] = { 0, 0, 0 };
+  uint32_t padded = (inclLen + 3) & ~3U;
+  m_out.write (padding, padded - inclLen);
+  Write32 (32 + padded);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, Time t, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << t << p);
+  uint32_t inclLen = WritePacketHeader (interface, t, p->GetSize ());
+  p->CopyData (&m_out, inclLen);
+  WritePacketTrailer (inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, Time t, const Header &header, Ptr<const Packet> p)
+{
+  NS_LOG_FUNCTION (this << interface << t << &header << p);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint32_t inclLen = WritePacketHeader (interface, t, headerSize + p->GetSize ());
+
+  Buffer headerBuffer;
+  headerBuffer.AddAtStart (headerSize);
+  header.Serialize (headerBuffer.Begin ());
+  uint32_t toCopy = std::min (headerSize, inclLen);
+  headerBuffer.CopyData (&m_out, toCopy);
+  p->CopyData (&m_out, inclLen - toCopy);
+  WritePacketTrailer (inclLen);
+}
+
+void
+PcapNgFile::Write (uint32_t interface, Time t, uint8_t const *data, uint32_t totalLen)
+{
+  NS_LOG_FUNCTION (this << interface << t << &data << totalLen);
+  uint32_t inclLen = WritePacketHeader (interface, t, totalLen);
+  m_out.write (reinterpret_cast<const char *> (data), inclLen);
+  WritePacketTrailer (inclLen);
+}
+
+} // namespace ns3
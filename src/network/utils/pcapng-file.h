@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "async-file-buffer.h"
+
+namespace ns3 {
+
+class Packet;
+class Header;
+
+/**
+ * \ingroup network
+ *
+ * \brief A pcapng file, written by several interfaces.
+ *
+ * Unlike a pcap file, which holds the packets of a single link type,
+ * a pcapng file describes each capture interface in its own block, so
+ * that all the devices of a node can share one file.  Open() returns
+ * the file already open under the same name, if any, and each user of
+ * the file adds its own interface with AddInterface().  The file is
+ * closed when the last reference to it goes away.
+ *
+ * The file holds a section header block, an interface description
+ * block per interface and an enhanced packet block per packet, in host
+ * byte order, with nanosecond timestamps.  It is written through an
+ * AsyncFileBuffer.
+ */
+class PcapNgFile : public SimpleRefCount<PcapNgFile>
+{
+public:
+  /**
+   * Get the file of the given name, creating it if it is not open.
+   * \param [in] filename The name of the file.
+   * \param [in] bufferSize The in-memory buffer size, in bytes, when
+   *             the file is created; zero writes it on the simulation
+   *             thread.
+   * \param [in] compression The compression, when the file is created.
+   * \returns The file.
+   *
+   * A file that is already open must be opened with the same buffer
+   * size and compression.
+   */
+  static Ptr<PcapNgFile> Open (const std::string &filename, uint32_t bufferSize,
+                               AsyncFileBuffer::Compression compression);
+  /** Close the file. */
+  ~PcapNgFile ();
+
+  /**
+   * \returns \c true if creating or writing the file failed.
+   */
+  bool Fail (void) const;
+
+  /**
+   * Describe a new capture interface.
+   * \param [in] dataLinkType The link type of the packets of the
+   *             interface (cf. PcapHelper::DataLinkType).
+   * \param [in] snapLen The maximum number of bytes captured per packet.
+   * \returns The interface id.
+   */
+  uint32_t AddInterface (uint32_t dataLinkType, uint32_t snapLen);
+  /**
+   * \param [in] interface The interface id.
+   * \returns The link type of the interface.
+   */
+  uint32_t GetDataLinkType (uint32_t interface) const;
+  /**
+   * \param [in] interface The interface id.
+   * \returns The maximum number of bytes captured per packet.
+   */
+  uint32_t GetSnapLen (uint32_t interface) const;
+
+  /**
+   * Write a packet.
+   * \param [in] interface The interface id.
+   * \param [in] t The capture time.
+   * \param [in] p The packet.
+   */
+  void Write (uint32_t interface, Time t, Ptr<const Packet> p);
+  /**
+   * Write a header followed by a packet.
+   * \param [in] interface The interface id.
+   * \param [in] t The capture time.
+   * \param [in] header The header.
+   * \param [in] p The packet.
+   */
+  void Write (uint32_t interface, Time t, const Header &header, Ptr<const Packet> p);
+  /**
+   * Write raw packet data.
+   * \param [in] interface The interface id.
+   * \param [in] t The capture time.
+   * \param [in] data The packet data.
+   * \param [in] totalLen The size of the packet data.
+   */
+  void Write (uint32_t interface, Time t, uint8_t const *data, uint32_t totalLen);
+
+private:
+  /**
+   * Create the file and write the section header block.
+   * \param [in] filename The name of the file.
+   * \param [in] bufferSize The in-memory buffer size.
+   * \param [in] compression The compression.
+   */
+  PcapNgFile (const std::string &filename, uint32_t bufferSize,
+              AsyncFileBuffer::Compression compression);
+
+  /**
+   * Write a 32 bit value.
+   * \param [in] value The value.
+   */
+  void Write32 (uint32_t value);
+  /**
+   * Write the start of an enhanced packet block.
+   * \param [in] interface The interface id.
+   * \param [in] t The capture time.
+   * \param [in] totalLen The size of the packet.
+   * \returns The number of bytes of the packet to write.
+   */
+  uint32_t WritePacketHeader (uint32_t interface, Time t, uint32_t totalLen);
+  /**
+   * Write the end of an enhanced packet block.
+   * \param [in] inclLen The number of bytes of the packet written.
+   */
+  void WritePacketTrailer (uint32_t inclLen);
+
+  /** An interface description. */
+  struct Interface
+  {
+    uint32_t dataLinkType; //!< The link type.
+    uint32_t snapLen;      //!< The maximum number of bytes captured per packet.
+  };
+
+  std::string m_filename;              //!< The name of the file.
+  uint32_t m_bufferSize;               //!< The in-memory buffer size.
+  AsyncFileBuffer::Compression m_compression; //!< The compression.
+  AsyncFileBuffer m_buffer;            //!< The file buffer.
+  std::ostream m_out;                  //!< The stream writing to m_buffer.
+  std::vector<Interface> m_interfaces; //!< The interfaces, by id.
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
@@ -33,7 +33,7 @@
 #include "ns3/queue-item.h"
 #include <string>
 #include <sstream>
-#include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -238,6 +238,13 @@ private:
  * methods in doing so, to ensure that appropriate trace sources are called
  * and statistics are maintained.
  *
+ * The items are stored in a ring buffer, which grows as needed.  Enqueuing
+ * at the head or at the tail and dequeuing from the head take constant
+ * time and allocate no memory once the buffer is large enough.  An item
+ * removed from the middle of the queue leaves a hole, which is skipped
+ * by iterators and reclaimed when the head of the queue reaches it or
+ * when the buffer is rebuilt.
+ *
  * Users of the Queue template class usually hold a queue through a smart pointer,
  * hence forward declaration is recommended to avoid pulling the implementation
  * of the templates included in this file. Thus, do not include queue.h but add
@@ -300,8 +307,59 @@ public:
 
 protected:
 
-  /// Const iterator.
-  typedef typename std::list<Ptr<Item> >::const_iterator ConstIterator;
+  /**
+   * \brief Const iterator over the items in the queue.
+   *
+   * Iterators remain valid when other items are dequeued or removed.
+   * Enqueuing an item may rebuild the storage of the queue, which
+   * invalidates all the iterators.
+   */
+  class ConstIterator
+  {
+public:
+    ConstIterator ();
+    /**
+     * \returns the item this iterator refers to.
+     */
+    const Ptr<Item> & operator* (void) const;
+    /**
+     * \returns a pointer to the item this iterator refers to.
+     */
+    const Ptr<Item> * operator-> (void) const;
+    /**
+     * Move to the next item in the queue.
+     * \returns this iterator.
+     */
+    ConstIterator & operator++ (void);
+    /**
+     * Move to the next item in the queue.
+     * \returns an iterator to the current item.
+     */
+    ConstIterator operator++ (int);
+    /**
+     * \param [in] o The other iterator.
+     * \returns true if both iterators refer to the same position.
+     */
+    bool operator== (const ConstIterator &o) const;
+    /**
+     * \param [in] o The other iterator.
+     * \returns true if the iterators refer to different positions.
+     */
+    bool operator!= (const ConstIterator &o) const;
+
+private:
+    /// Friend class
+    friend class Queue<Item>;
+    /**
+     * Construct an iterator.
+     * \param [in] queue The queue.
+     * \param [in] index The index of the position in the queue.
+     */
+    ConstIterator (const Queue<Item> *queue, std::size_t index);
+
+    const Queue<Item> *m_queue;  //!< the queue
+    std::size_t m_index;         //!< the index of the position in the queue
+  };
 
   /**
    * \brief Get a const iterator which refers to the first item in the queue.
@@ -385,7 +443,47 @@ protected:
   void DropAfterDequeue (Ptr<Item> item);
 
 private:
-  std::list<Ptr<Item> > m_packets;          //!< the items in the queue
+  /**
+   * Get the slot of the ring buffer holding a position.
+   * \param [in] index The index of the position in the queue.
+   * \returns the slot, which is null for a hole.
+   */
+  Ptr<Item> & Slot (std::size_t index);
+  /**
+   * Get the slot of the ring buffer holding a position.
+   * \param [in] index The index of the position in the queue.
+   * \returns the slot, which is null for a hole.
+   */
+  const Ptr<Item> & Slot (std::size_t index) const;
+  /**
+   * Insert an item in the ring buffer.
+   * \param [in] pos The position the item is inserted at.
+   * \param [in] item The item.
+   */
+  void Insert (ConstIterator pos, Ptr<Item> item);
+  /**
+   * Remove an item from the ring buffer.
+   * \param [in] pos The position of the item.
+   */
+  void Erase (ConstIterator pos);
+  /**
+   * Move the items to a new ring buffer without holes, twice as large
+   * if the items fill more than half of the current one.
+   * \param [in] index The index of a position in the queue.
+   * \returns the index of the same position in the new ring buffer.
+   */
+  std::size_t Rebuild (std::size_t index);
+
+  /**
+   * The ring buffer.  Position \c index of the queue is stored in slot
+   * <tt>index \& m_mask</tt>; the queue holds positions m_head to
+   * m_tail - 1, and the slots of removed items are null.
+   */
+  std::vector<Ptr<Item> > m_packets;
+  std::size_t m_mask;                       //!< size of the ring buffer minus one
+  std::size_t m_head;                       //!< index of the first item
+  std::size_t m_tail;                       //!< index past the last item
+  std::size_t m_holes;                      //!< number of holes between m_head and m_tail
   NS_LOG_TEMPLATE_DECLARE;                  //!< the log component
 
   /// Traced callback: fired when a packet is enqueued
@@ -432,9 +530,78 @@ Queue<Item>::GetTypeId (void)
   return tid;
 }
 
+template <typename Item>
+Queue<Item>::ConstIterator::ConstIterator ()
+  : m_queue (0),
+    m_index (0)
+{
+}
+
+template <typename Item>
+Queue<Item>::ConstIterator::ConstIterator (const Queue<Item> *queue, std::size_t index)
+  : m_queue (queue),
+    m_index (index)
+{
+}
+
+template <typename Item>
+const Ptr<Item> &
+Queue<Item>::ConstIterator::operator* (void) const
+{
+  NS_ASSERT (m_index != m_queue->m_tail);
+  return m_queue->Slot (m_index);
+}
+
+template <typename Item>
+const Ptr<Item> *
+Queue<Item>::ConstIterator::operator-> (void) const
+{
+  return &**this;
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator &
+Queue<Item>::ConstIterator::operator++ (void)
+{
+  // skip the holes left by removed items
+  do
+    {
+      ++m_index;
+    }
+  while (m_index != m_queue->m_tail && m_queue->Slot (m_index) == 0);
+  return *this;
+}
+
+template <typename Item>
+typename Queue<Item>::ConstIterator
+Queue<Item>::ConstIterator::operator++ (int)
+{
+  ConstIterator current = *this;
+  ++*this;
+  return current;
+}
+
+template <typename Item>
+bool
+Queue<Item>::ConstIterator::operator== (const ConstIterator &o) const
+{
+  return m_index == o.m_index && m_queue == o.m_queue;
+}
+
+template <typename Item>
+bool
+Queue<Item>::ConstIterator::operator!= (const ConstIterator &o) const
+{
+  return !(*this == o);
+}
+
 template <typename Item>
 Queue<Item>::Queue ()
-  : NS_LOG_TEMPLATE_DEFINE ("Queue")
+  : m_mask (0),
+    m_head (0),
+    m_tail (0),
+    m_holes (0),
+    NS_LOG_TEMPLATE_DEFINE ("Queue")
 {
 }
 
@@ -456,7 +623,7 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item)
       return false;
     }
 
-  m_packets.insert (pos, item);
+  Insert (pos, item);
 
   uint32_t size = item->GetSize ();
   m_nBytes += size;
@@ -484,7 +651,7 @@ Queue<Item>::DoDequeue (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  Erase (pos);
 
   if (item != 0)
     {
@@ -513,7 +680,7 @@ Queue<Item>::DoRemove (ConstIterator pos)
     }
 
   Ptr<Item> item = *pos;
-  m_packets.erase (pos);
+  Erase (pos);
 
   if (item != 0)
     {
@@ -561,13 +728,122 @@ Queue<Item>::DoPeek (ConstIterator pos) const
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Head (void) const
 {
-  return m_packets.cbegin ();
+  return ConstIterator (this, m_head);
 }
 
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::Tail (void) const
 {
-  return m_packets.cend ();
+  return ConstIterator (this, m_tail);
+}
+
+template <typename Item>
+Ptr<Item> &
+Queue<Item>::Slot (std::size_t index)
+{
+  return m_packets[index & m_mask];
+}
+
+template <typename Item>
+const Ptr<Item> &
+Queue<Item>::Slot (std::size_t index) const
+{
+  return m_packets[index & m_mask];
+}
+
+template <typename Item>
+void
+Queue<Item>::Insert (ConstIterator pos, Ptr<Item> item)
+{
+  NS_ASSERT (pos.m_queue == this);
+  std::size_t index = pos.m_index;
+  if (m_tail - m_head == m_packets.size ())
+    {
+      index = Rebuild (index);
+    }
+
+  if (index == m_tail)
+    {
+      Slot (m_tail++) = item;
+    }
+  else if (index == m_head)
+    {
+      Slot (--m_head) = item;
+    }
+  else
+    {
+      // Make room in the middle of the queue
+      for (std::size_t i = m_tail; i != index; --i)
+        {
+          Slot (i) = Slot (i - 1);
+        }
+      Slot (index) = item;
+      m_tail++;
+    }
+}
+
+template <typename Item>
+void
+Queue<Item>::Erase (ConstIterator pos)
+{
+  NS_ASSERT (pos.m_queue == this);
+  NS_ASSERT (pos.m_index != m_tail && Slot (pos.m_index) != 0);
+
+  Slot (pos.m_index) = 0;
+  if (pos.m_index != m_head)
+    {
+      m_holes++;
+      return;
+    }
+  m_head++;
+  while (m_head != m_tail && Slot (m_head) == 0)
+    {
+      m_head++;
+      m_holes--;
+    }
+}
+
+template <typename Item>
+std::size_t
+Queue<Item>::Rebuild (std::size_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+
+  std::size_t n = m_tail - m_head - m_holes;
+  std::size_t size = m_packets.size ();
+  if (size == 0)
+    {
+      size = 16;
+    }
+  else if (2 * n > size)
+    {
+      size *= 2;
+    }
+
+  std::vector<Ptr<Item> > packets (size);
+  std::size_t tail = 0;
+  std::size_t newIndex = 0;
+  for (std::size_t i = m_head; i != m_tail; ++i)
+    {
+      if (i == index)
+        {
+          newIndex = tail;
+        }
+      if (Slot (i) != 0)
+        {
+          packets[tail++] = Slot (i);
+        }
+    }
+  if (index == m_tail)
+    {
+      newIndex = tail;
+    }
+  m_packets.swap (packets);
+  m_mask = size - 1;
+  m_head = 0;
+  m_tail = tail;
+  m_holes = 0;
+  return newIndex;
 }
 
 template <typename Item>
@@ -25,6 +25,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/queue-item.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -67,6 +68,12 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("TxBatchSize",
+                   "The maximum number of packets of the transmit queue sent back to back "
+                   "with a single transmit complete event",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_txBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -177,7 +184,9 @@ PointToPointNetDevice::PointToPointNetDevice ()
     m_txMachineState (READY),
     m_channel (0),
     m_linkUp (false),
-    m_currentPkt (0)
+    m_currentPkt (0),
+    m_txBatchSize (1),
+    m_sendingBatch (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -214,6 +223,7 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_batchPkts.clear ();
   m_queue = 0;
   NetDevice::DoDispose ();
 }
@@ -251,6 +261,25 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
   Time txCompleteTime = txTime + m_tInterframeGap;
 
+  //
+  // Take the following packets of the queue, which are transmitted back to
+  // back with p, so that a single event completes the whole batch.
+  //
+  NS_ASSERT (m_batchPkts.empty ());
+  while (m_batchPkts.size () + 1 < m_txBatchSize)
+    {
+      Ptr<Packet> next = m_queue->Dequeue ();
+      if (next == 0)
+        {
+          break;
+        }
+      m_snifferTrace (next);
+      m_promiscSnifferTrace (next);
+      m_phyTxBeginTrace (next);
+      m_batchPkts.push_back (next);
+      txCompleteTime += m_bps.CalculateBytesTxTime (next->GetSize ()) + m_tInterframeGap;
+    }
+
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
   Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
 
@@ -259,6 +288,21 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
     {
       m_phyTxDropTrace (p);
     }
+
+  //
+  // The channel delivers each packet of the batch once its last bit has been
+  // sent, i.e., at its offset from now plus its own transmission time.
+  //
+  Time offset = txTime + m_tInterframeGap;
+  for (std::vector<Ptr<Packet> >::const_iterator i = m_batchPkts.begin (); i != m_batchPkts.end (); i++)
+    {
+      Time nextTxTime = m_bps.CalculateBytesTxTime ((*i)->GetSize ());
+      if (m_channel->TransmitStart (*i, this, offset + nextTxTime) == false)
+        {
+          m_phyTxDropTrace (*i);
+        }
+      offset += nextTxTime + m_tInterframeGap;
+    }
   return result;
 }
 
@@ -280,6 +324,11 @@ PointToPointNetDevice::TransmitComplete (void)
 
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator i = m_batchPkts.begin (); i != m_batchPkts.end (); i++)
+    {
+      m_phyTxEndTrace (*i);
+    }
+  m_batchPkts.clear ();
 
   Ptr<Packet> p = m_queue->Dequeue ();
   if (p == 0)
@@ -537,9 +586,10 @@ PointToPointNetDevice::Send (
   if (m_queue->Enqueue (packet))
     {
       //
-      // If the channel is ready for transition we send the packet right now
+      // If the channel is ready for transition we send the packet right now,
+      // unless SendBatch has more packets to queue first
       // 
-      if (m_txMachineState == READY)
+      if (m_txMachineState == READY && !m_sendingBatch)
         {
           packet = m_queue->Dequeue ();
           m_snifferTrace (packet);
@@ -556,6 +606,28 @@ PointToPointNetDevice::Send (
   return false;
 }
 
+std::size_t
+PointToPointNetDevice::SendBatch (const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+
+  m_sendingBatch = true;
+  std::size_t sent = NetDevice::SendBatch (items);
+  m_sendingBatch = false;
+
+  if (m_txMachineState == READY)
+    {
+      Ptr<Packet> packet = m_queue->Dequeue ();
+      if (packet != 0)
+        {
+          m_snifferTrace (packet);
+          m_promiscSnifferTrace (packet);
+          TransmitStart (packet);
+        }
+    }
+  return sent;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
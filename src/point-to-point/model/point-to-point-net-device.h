@@ -20,6 +20,7 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -177,6 +178,14 @@ public:
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
+  /**
+   * Queue the whole batch before starting to transmit, so that its packets
+   * can be transmitted back to back (see the TxBatchSize attribute).
+   *
+   * \param items the packets to send
+   * \return the number of packets handed to the device
+   */
+  virtual std::size_t SendBatch (const std::vector<Ptr<QueueDiscItem> > &items);
 
   virtual Ptr<Node> GetNode (void) const;
   virtual void SetNode (Ptr<Node> node);
@@ -260,6 +269,12 @@ private:
    * started sending signals.  An event is scheduled for the time at which
    * the bits have been completely transmitted.
    *
+   * If the TxBatchSize attribute is larger than one, the packets waiting in
+   * the transmit queue, up to TxBatchSize packets including p, are sent
+   * back to back, and a single event is scheduled for the end of the last
+   * one.  The packets are dequeued, and the PhyTxBegin trace is fired for
+   * each of them, when the first packet starts to be transmitted.
+   *
    * \see PointToPointChannel::TransmitStart ()
    * \see TransmitComplete()
    * \param p a reference to the packet to send
@@ -456,6 +471,9 @@ private:
   uint32_t m_mtu;
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
+  std::vector<Ptr<Packet> > m_batchPkts; //!< Packets transmitted back to back after m_currentPkt
+  uint32_t m_txBatchSize;   //!< Maximum number of packets transmitted back to back
+  bool m_sendingBatch;      //!< SendBatch is queueing packets
 
   /**
    * \brief PPP to Ethernet protocol number mapping
@@ -24,6 +24,9 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-item.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -94,6 +97,155 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief QueueDiscItem used to hand packets to PointToPointNetDevice::SendBatch
+ */
+class PointToPointTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \brief Constructor
+   *
+   * \param p the packet
+   * \param addr the destination address
+   */
+  PointToPointTestItem (Ptr<Packet> p, const Address &addr)
+    : QueueDiscItem (p, addr, 0x800)
+  {
+  }
+  virtual void AddHeader (void)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return false;
+  }
+};
+
+/**
+ * \brief Test the transmission of back to back packets
+ *
+ * A batch of packets is sent through PointToPointNetDevice::SendBatch with
+ * TxBatchSize set to 1 and to 4: the packets must be received at the same
+ * times, with fewer events in the second case.
+ */
+class PointToPointBatchTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBatchTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a batch of packets to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendBatch (Ptr<PointToPointNetDevice> device);
+  /**
+   * \brief Record the reception time of a packet
+   *
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+  /**
+   * \brief Run a simulation
+   *
+   * \param txBatchSize the TxBatchSize attribute of the sending device
+   * \param [out] events the number of events executed
+   */
+  void RunBatch (uint32_t txBatchSize, uint64_t &events);
+
+  std::vector<Time> m_rxTimes; //!< The reception times
+};
+
+PointToPointBatchTest::PointToPointBatchTest ()
+  : TestCase ("PointToPoint batch transmission")
+{
+}
+
+void
+PointToPointBatchTest::SendBatch (Ptr<PointToPointNetDevice> device)
+{
+  std::vector<Ptr<QueueDiscItem> > items;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      items.push_back (Create<PointToPointTestItem> (Create<Packet> (100 + 50 * i), device->GetBroadcast ()));
+    }
+  NS_TEST_EXPECT_MSG_EQ (device->SendBatch (items), items.size (), "Packets not accepted");
+}
+
+bool
+PointToPointBatchTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointBatchTest::RunBatch (uint32_t txBatchSize, uint64_t &events)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (2)));
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetDataRate (DataRate ("1Mbps"));
+  devA->SetInterframeGap (MicroSeconds (10));
+  devA->SetAttribute ("TxBatchSize", UintegerValue (txBatchSize));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBatchTest::Receive, this));
+
+  m_rxTimes.clear ();
+  Simulator::Schedule (Seconds (1.0), &PointToPointBatchTest::SendBatch, this, devA);
+  Simulator::Run ();
+  events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+}
+
+void
+PointToPointBatchTest::DoRun (void)
+{
+  uint64_t events;
+  RunBatch (1, events);
+  std::vector<Time> expected = m_rxTimes;
+  NS_TEST_ASSERT_MSG_EQ (expected.size (), 8, "Packets lost");
+  // 100 bytes plus the 2 bytes of the PPP header
+  NS_TEST_EXPECT_MSG_EQ (expected[0], Seconds (1) + DataRate ("1Mbps").CalculateBytesTxTime (102) + MilliSeconds (2),
+                         "Wrong reception time");
+
+  uint64_t batchEvents;
+  RunBatch (4, batchEvents);
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), expected.size (), "Packets lost");
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_rxTimes[i], expected[i], "Packet " << i << " received at a different time");
+    }
+  // two transmit complete events instead of eight
+  NS_TEST_EXPECT_MSG_EQ (events - batchEvents, 6, "Unexpected number of events");
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -110,6 +262,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBatchTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
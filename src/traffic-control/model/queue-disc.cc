@@ -270,6 +270,11 @@ TypeId QueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&QueueDisc::SetQuota,
                                          &QueueDisc::GetQuota),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BatchSize",
+                   "The maximum number of packets dequeued and sent to the device at once",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&QueueDisc::m_batchSize),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("InternalQueueList", "The list of internal queues.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_queues),
@@ -323,6 +328,7 @@ QueueDisc::QueueDisc (QueueDiscSizePolicy policy)
   :  m_nPackets (0),
      m_nBytes (0),
      m_maxSize (QueueSize ("1p")),         // to avoid that setting the mode at construction time is ignored
+     m_batchSize (1),
      m_running (false),
      m_peeked (false),
      m_sizePolicy (policy),
@@ -383,7 +389,9 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_devQueueIface = 0;
   m_send = nullptr;
-  m_requeued = 0;
+  m_sendBatch = nullptr;
+  m_batch.clear ();
+  m_requeued.clear ();
   m_internalQueueDbeFunctor = nullptr;
   m_internalQueueDadFunctor = nullptr;
   m_childQueueDiscDbeFunctor = nullptr;
@@ -423,9 +431,14 @@ QueueDisc::GetStats (void)
   // the total number of sent packets is only updated here to avoid to increase it
   // after a dequeue and then having to decrease it if the packet is dropped after
   // dequeue or requeued
-  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - (m_requeued ? 1 : 0)
+  uint64_t requeuedBytes = 0;
+  for (auto& item : m_requeued)
+    {
+      requeuedBytes += item->GetSize ();
+    }
+  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - m_requeued.size ()
                               - m_stats.nTotalDroppedPacketsAfterDequeue;
-  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - (m_requeued ? m_requeued->GetSize () : 0)
+  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - requeuedBytes
                             - m_stats.nTotalDroppedBytesAfterDequeue;
 
   return m_stats;
@@ -558,6 +571,20 @@ QueueDisc::GetSendCallback (void) const
   return m_send;
 }
 
+void
+QueueDisc::SetSendBatchCallback (SendBatchCallback func)
+{
+  NS_LOG_FUNCTION (this);
+  m_sendBatch = func;
+}
+
+QueueDisc::SendBatchCallback
+QueueDisc::GetSendBatchCallback (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sendBatch;
+}
+
 void
 QueueDisc::SetQuota (const uint32_t quota)
 {
@@ -892,11 +919,12 @@ QueueDisc::Dequeue (void)
   // The QueueDisc::DoPeek method dequeues a packet and keeps it as a requeued
   // packet. Thus, first check whether a peeked packet exists. Otherwise, call
   // the private DoDequeue method.
-  Ptr<QueueDiscItem> item = m_requeued;
+  Ptr<QueueDiscItem> item;
 
-  if (item)
+  if (!m_requeued.empty ())
     {
-      m_requeued = 0;
+      item = m_requeued.front ();
+      m_requeued.pop_front ();
       if (m_peeked)
         {
           // If the packet was requeued because a peek operation was requested
@@ -930,17 +958,19 @@ QueueDisc::DoPeek (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (!m_requeued)
+  if (m_requeued.empty ())
     {
       m_peeked = true;
-      m_requeued = Dequeue ();
+      Ptr<QueueDiscItem> item = Dequeue ();
       // if no packet is returned, reset the m_peeked flag
-      if (!m_requeued)
+      if (!item)
         {
           m_peeked = false;
+          return 0;
         }
+      m_requeued.push_back (item);
     }
-  return m_requeued;
+  return m_requeued.front ();
 }
 
 void
@@ -951,14 +981,15 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets = 0;
+      while (Restart (packets))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (packets >= quota)
             {
               /// \todo netif_schedule (q);
               break;
             }
+          quota -= packets;
         }
       RunEnd ();
     }
@@ -985,17 +1016,34 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &packets)
 {
   NS_LOG_FUNCTION (this);
+  packets = 0;
   Ptr<QueueDiscItem> item = DequeuePacket();
   if (item == 0)
     {
       NS_LOG_LOGIC ("No packet to send");
       return false;
     }
+  packets = 1;
+
+  // Transmit also requeues the packet if its device queue is stopped,
+  // which must be checked before dequeuing more packets for the batch
+  if (m_batchSize == 1 || !m_sendBatch ||
+      (m_devQueueIface && m_devQueueIface->GetTxQueue (item->GetTxQueueIndex ())->IsStopped ()))
+    {
+      return Transmit (item);
+    }
 
-  return Transmit (item);
+  // Here, Linux tries bulk dequeues
+  m_batch.push_back (item);
+  while (m_batch.size () < m_batchSize && (item = DequeuePacket ()) != 0)
+    {
+      m_batch.push_back (item);
+    }
+  packets = m_batch.size ();
+  return TransmitBatch ();
 }
 
 Ptr<QueueDiscItem>
@@ -1006,15 +1054,16 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface || !m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface
+            || !m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
             if (m_peeked)
               {
                 // If the packet was requeued because a peek operation was requested
@@ -1041,7 +1090,6 @@ QueueDisc::DequeuePacket ()
             {
               item->AddHeader ();
             }
-          // Here, Linux tries bulk dequeues
         }
     }
   return item;
@@ -1051,7 +1099,7 @@ void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_back (item);
   /// \todo netif_schedule (q);
 
   m_stats.nTotalRequeuedPackets++;
@@ -1110,4 +1158,45 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return true;
 }
 
+bool
+QueueDisc::TransmitBatch (void)
+{
+  NS_LOG_FUNCTION (this << m_batch.size ());
+  NS_ASSERT (!m_batch.empty ());
+
+  // a single queue device makes no use of the priority tag
+  // a device that does not install a device queue interface likely makes no use of it as well
+  if (!m_devQueueIface || m_devQueueIface->GetNTxQueues () == 1)
+    {
+      SocketPriorityTag priorityTag;
+      for (auto& item : m_batch)
+        {
+          item->GetPacket ()->RemovePacketTag (priorityTag);
+        }
+    }
+
+  // the device accepts the packets at the beginning of the batch until the
+  // device queue is stopped (possibly before the first packet is accepted)
+  std::size_t sent = m_sendBatch (m_batch);
+  NS_ASSERT (sent <= m_batch.size ());
+  NS_LOG_LOGIC ("The device accepted " << sent << " out of " << m_batch.size () << " packets");
+  Ptr<QueueDiscItem> last = sent > 0 ? m_batch[sent - 1] : 0;
+  for (std::size_t i = sent; i < m_batch.size (); i++)
+    {
+      Requeue (m_batch[i]);
+    }
+  bool allSent = sent == m_batch.size ();
+  m_batch.clear ();
+
+  // as in Transmit, return false if the Run method shall not attempt to dequeue
+  // other packets
+  if (!allSent || GetNPackets () == 0 ||
+      (m_devQueueIface && m_devQueueIface->GetTxQueue (last->GetTxQueueIndex ())->IsStopped ()))
+    {
+      return false;
+    }
+
+  return true;
+}
+
 } // namespace ns3
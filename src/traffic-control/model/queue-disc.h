@@ -26,6 +26,7 @@
 #include "ns3/queue-item.h"
 #include "ns3/queue-size.h"
 #include <vector>
+#include <deque>
 #include <map>
 #include <functional>
 #include <string>
@@ -149,6 +150,12 @@ enum QueueDiscSizePolicy
  * is room for another packet in its transmission queue, but the transmission queue
  * is stopped. Waking a queue disc is equivalent to make it run.
  *
+ * If the BatchSize attribute is larger than one, a queue disc which runs dequeues
+ * up to BatchSize packets at once and hands them to the netdevice in a single call
+ * (NetDevice::SendBatch), so that the netdevice can transmit them back to back.
+ * The packets which the netdevice does not accept because its transmission queue
+ * was stopped in the meantime are requeued, in order.
+ *
  * Every queue disc collects statistics about the total number of packets/bytes
  * received from the upper layers (in case of root queue disc) or from the parent
  * queue disc (in case of child queue disc), enqueued, dequeued, requeued, dropped,
@@ -160,7 +167,7 @@ enum QueueDiscSizePolicy
  * - dropped = dropped before enqueue + dropped after dequeue
  * - received = dropped before enqueue + enqueued
  * - queued = enqueued - dequeued
- * - sent = dequeued - dropped after dequeue (- 1 if there is a requeued packet)
+ * - sent = dequeued - dropped after dequeue (- requeued packets not sent yet)
  *
  * Separate counters are also kept for each possible reason to drop a packet.
  * When a packet is dropped by an internal queue, e.g., because the queue is full,
@@ -372,6 +379,25 @@ public:
    */
   SendCallback GetSendCallback (void) const;
 
+  /// Callback invoked to send a batch of packets to the receiving object when Run is
+  /// called. It returns the number of packets, at the beginning of the batch, which
+  /// were accepted by the receiving object.
+  typedef std::function<std::size_t (const std::vector<Ptr<QueueDiscItem> > &)> SendBatchCallback;
+
+  /**
+   * \param func the callback to send a batch of packets to the receiving object.
+   *
+   * Set the callback used to send the packets dequeued at once when the BatchSize
+   * attribute is larger than one. If this callback is not set, the packets are
+   * sent one at a time through the send callback.
+   */
+  void SetSendBatchCallback (SendBatchCallback func);
+
+  /**
+   * \return the callback to send a batch of packets to the receiving object.
+   */
+  SendBatchCallback GetSendBatchCallback (void) const;
+
   /**
    * \brief Set the maximum number of dequeue operations following a packet enqueue
    * \param quota the maximum number of dequeue operations following a packet enqueue.
@@ -639,10 +665,12 @@ private:
 
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
-   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
-   * \return true if a packet is successfully sent to the device.
+   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit),
+   * or dequeue up to BatchSize packets and send them at once (by calling TransmitBatch).
+   * \param packets the number of packets dequeued
+   * \return true if the packets are successfully sent to the device.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -666,6 +694,15 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Modelled after the Linux function sch_direct_xmit (net/sched/sch_generic.c)
+   * Sends the batch of packets stored in m_batch to the device, and requeues
+   * the packets the device did not accept.
+   * \return true if all the packets were sent, the device queue is not stopped
+   *         and the queue disc is not empty
+   */
+  bool TransmitBatch (void);
+
   /**
    *  \brief Perform the actions required when the queue disc is notified of
    *         a packet enqueue
@@ -695,8 +732,11 @@ private:
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   SendCallback m_send;              //!< Callback used to send a packet to the receiving object
+  SendBatchCallback m_sendBatch;    //!< Callback used to send a batch of packets to the receiving object
+  uint32_t m_batchSize;             //!< Maximum number of packets dequeued at once
+  std::vector<Ptr<QueueDiscItem> > m_batch;  //!< The packets dequeued at once
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::deque<Ptr<QueueDiscItem> > m_requeued;  //!< The packets that failed to be transmitted
   bool m_peeked;                    //!< A packet was dequeued because Peek was called
   std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
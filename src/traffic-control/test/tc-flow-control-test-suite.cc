@@ -363,6 +363,124 @@ TcFlowControlTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Test the flow control mechanism when the queue disc sends batches of packets
+ */
+class TcFlowControlBatchTestCase : public TestCase
+{
+public:
+  TcFlowControlBatchTestCase ();
+  virtual ~TcFlowControlBatchTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Instruct a node to send a specified number of packets
+   * \param n the node
+   * \param nPackets the number of packets to send
+   */
+  void SendPackets (Ptr<Node> n, uint16_t nPackets);
+  /**
+   * Check the number of packets in the device queue and in the queue disc,
+   * and the number of packets requeued by the queue disc
+   * \param dev the device
+   * \param devPackets the expected number of packets stored in the device queue
+   * \param requeued the expected number of packets requeued so far
+   */
+  void Check (Ptr<NetDevice> dev, uint16_t devPackets, uint32_t requeued);
+};
+
+TcFlowControlBatchTestCase::TcFlowControlBatchTestCase ()
+  : TestCase ("Test the operation of the flow control mechanism with batches of packets")
+{
+}
+
+TcFlowControlBatchTestCase::~TcFlowControlBatchTestCase ()
+{
+}
+
+void
+TcFlowControlBatchTestCase::SendPackets (Ptr<Node> n, uint16_t nPackets)
+{
+  Ptr<TrafficControlLayer> tc = n->GetObject<TrafficControlLayer> ();
+  for (uint16_t i = 0; i < nPackets; i++)
+    {
+      tc->Send (n->GetDevice (0), Create<QueueDiscTestItem> (Create<Packet> (1000)));
+    }
+}
+
+void
+TcFlowControlBatchTestCase::Check (Ptr<NetDevice> dev, uint16_t devPackets, uint32_t requeued)
+{
+  PointerValue ptr;
+  dev->GetAttributeFailSafe ("TxQueue", ptr);
+  Ptr<Queue<Packet> > queue = ptr.Get<Queue<Packet> > ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), devPackets, "Unexpected number of packets in the device queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 0, "The device queue must not drop packets");
+
+  Ptr<TrafficControlLayer> tc = dev->GetNode ()->GetObject<TrafficControlLayer> ();
+  Ptr<QueueDisc> qdisc = tc->GetRootQueueDiscOnDevice (dev);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalRequeuedPackets, requeued, "Unexpected number of requeued packets");
+}
+
+void
+TcFlowControlBatchTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (2);
+
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+  n.Get (1)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  SimpleNetDeviceHelper simple;
+
+  NetDeviceContainer rxDevC = simple.Install (n.Get (1));
+
+  simple.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("1Mb/s")));
+  simple.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("5p"));
+
+  Ptr<NetDevice> txDev;
+  txDev = simple.Install (n.Get (0), DynamicCast<SimpleChannel> (rxDevC.Get (0)->GetChannel ())).Get (0);
+  txDev->SetMtu (2500);
+
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::FifoQueueDisc", "BatchSize", UintegerValue (4));
+  tch.Install (txDev);
+
+  // transmit 10 packets at time 0: one is being transmitted, 5 are in the
+  // (stopped) device queue and 4 in the queue disc
+  Simulator::Schedule (Time (Seconds (0)), &TcFlowControlBatchTestCase::SendPackets,
+                       this, n.Get (0), 10);
+
+  // The transmission of each packet takes 1000B/1Mbps = 8ms. Every time a
+  // packet leaves the device queue, the queue disc sends the remaining packets
+  // in a batch: the device accepts one of them and the others are requeued.
+  Simulator::Schedule (Time (MilliSeconds (1)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 5, 0);
+  Simulator::Schedule (Time (MilliSeconds (9)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 5, 3);
+  Simulator::Schedule (Time (MilliSeconds (17)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 5, 5);
+  Simulator::Schedule (Time (MilliSeconds (25)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 5, 6);
+  Simulator::Schedule (Time (MilliSeconds (33)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 5, 6);
+  Simulator::Schedule (Time (MilliSeconds (41)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 4, 6);
+  Simulator::Schedule (Time (MilliSeconds (81)), &TcFlowControlBatchTestCase::Check,
+                       this, txDev, 0, 6);
+
+  Simulator::Run ();
+
+  Ptr<QueueDisc> qdisc = n.Get (0)->GetObject<TrafficControlLayer> ()->GetRootQueueDiscOnDevice (txDev);
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalSentPackets, 10, "All the packets must be sent");
+  NS_TEST_EXPECT_MSG_EQ (qdisc->GetStats ().nTotalDroppedPackets, 0, "No packet must be dropped");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -377,5 +495,6 @@ public:
   {
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS), TestCase::QUICK);
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES), TestCase::QUICK);
+    AddTestCase (new TcFlowControlBatchTestCase, TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
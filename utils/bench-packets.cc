@@ -328,6 +328,77 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchForwardMixed (uint32_t n)
+{
+  BenchHeader<20> tcp;
+  BenchHeader<20> ipv4;
+  BenchHeader<14> ethernet;
+  uint8_t jumbo[9000];
+  std::fill (jumbo, jumbo + sizeof (jumbo), 0xa5);
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // Every other packet is a jumbo frame with real payload bytes,
+      // the others are pure ACKs.
+      Ptr<Packet> p;
+      if (i % 2 == 0)
+        {
+          p = Create<Packet> (jumbo, sizeof (jumbo));
+        }
+      else
+        {
+          p = Create<Packet> ();
+        }
+      p->AddHeader (tcp);
+      p->AddHeader (ipv4);
+      p->AddHeader (ethernet);
+
+      // Forward through a router: replace the link-layer header of a
+      // copy, as a queue and a second device would.
+      Ptr<Packet> q = p->Copy ();
+      q->RemoveHeader (ethernet);
+      q->AddHeader (ethernet);
+      p = 0;
+      q->RemoveHeader (ethernet);
+      q->RemoveHeader (ipv4);
+      q->RemoveHeader (tcp);
+    }
+}
+
+static void
+benchTagChurn (uint32_t n)
+{
+  BenchHeader<20> ipv4;
+  BenchTag<3> bearer;
+  BenchTag<8> snr;
+  BenchTag<10> ampdu;
+  BenchTag<20> probe;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      // A flow monitor byte tag, then per-hop packet tags as a wireless
+      // link would add and strip them.
+      Ptr<Packet> p = Create<Packet> (1000);
+      p->AddHeader (ipv4);
+      p->AddByteTag (probe);
+      for (uint32_t hop = 0; hop < 3; hop++)
+        {
+          p->AddPacketTag (bearer);
+          Ptr<Packet> q = p->Copy ();
+          q->AddPacketTag (ampdu);
+          q->AddPacketTag (snr);
+          q->PeekPacketTag (bearer);
+          q->RemovePacketTag (ampdu);
+          q->ReplacePacketTag (snr);
+          q->RemovePacketTag (snr);
+          q->RemovePacketTag (bearer);
+          q->FindFirstMatchingByteTag (probe);
+          p = q;
+        }
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -385,6 +456,16 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchTagChurn, n, minIterations, "Add and remove packet tags per hop");
+
+  Buffer::ResetAllocatorStats ();
+  runBench (&benchForwardMixed, n, minIterations, "Forward mixed ACKs and jumbo frames");
+  Buffer::AllocatorStats stats = Buffer::GetAllocatorStats ();
+  double packets = static_cast<double> (n) * minIterations;
+  std::cout << "Buffer data: " << stats.creates / packets << " creates, "
+            << stats.allocs / packets << " allocator calls per forwarded packet"
+            << std::endl;
+  Buffer::PrintAllocatorStats (std::cout);
 
   return 0;
 }
@@ -0,0 +1,827 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program runs a set of reproducible simulator workloads and reports,
+// for each one, the wall clock time, the number of events executed, the
+// event rate, the peak resident set size and the number of heap
+// allocations.  Results can also be written as JSON, so that they can be
+// compared from one commit to the next.
+//
+// Sample usage:
+//   ./waf --run 'bench-suite --workloads=sched-bursty,tcp-dumbbell --json=out.json'
+//
+// The wifi-dense and lte-cell workloads are only available when the
+// corresponding modules are enabled.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/inline-callback.h"
+#ifdef NS3_BENCH_WIFI
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#endif
+#ifdef NS3_BENCH_LTE
+#include "ns3/mobility-module.h"
+#include "ns3/lte-module.h"
+#endif
+
+#include <chrono>
+#include <cstdlib>    // malloc, free
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>  // getrusage
+
+using namespace ns3;
+
+/// Number of calls to the global operator new since the program started.
+static uint64_t g_allocations = 0;
+
+/**
+ * Count heap allocations made anywhere in the program, including the
+ * ns-3 libraries, by replacing the global allocation functions.
+ * \param [in] size The number of bytes to allocate.
+ * \returns The allocated memory.
+ */
+void *
+operator new (std::size_t size)
+{
+  ++g_allocations;
+  void *p = std::malloc (size == 0 ? 1 : size);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+/**
+ * \copydoc operator new(std::size_t)
+ */
+void *
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+/**
+ * Release memory from the counting operator new.
+ * \param [in] p The memory to release.
+ */
+void
+operator delete (void *p) noexcept
+{
+  std::free (p);
+}
+
+/**
+ * \copydoc operator delete(void*)
+ */
+void
+operator delete[] (void *p) noexcept
+{
+  std::free (p);
+}
+
+namespace {
+
+/**
+ * Get the peak resident set size of the process.
+ * \returns The peak RSS, in kilobytes.
+ */
+uint64_t
+GetPeakRss (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/// Sizes of the workloads, settable from the command line.
+struct BenchParams
+{
+  uint32_t events;     //!< Events executed by the scheduler workloads.
+  uint32_t population; //!< Events pending at once in the scheduler workloads.
+  uint32_t packets;    //!< Packets created by the packet-churn workload.
+  uint32_t draws;      //!< Values drawn by the rng-* workloads.
+  uint32_t flows;      //!< TCP flows in the tcp-dumbbell workload.
+  uint32_t stations;   //!< Stations in the wifi-dense workload.
+  uint32_t ues;        //!< UEs in the lte-cell workload.
+  uint32_t k;          //!< Fat-tree arity in the fat-tree-routing workload.
+  Time duration;       //!< Simulated time of the network workloads.
+};
+
+/// Measurements of a single workload run.
+struct BenchResult
+{
+  std::string workload;  //!< Workload name.
+  uint32_t run;          //!< Run index.
+  double wallSeconds;    //!< Wall clock time.
+  uint64_t events;       //!< Events executed.
+  uint64_t peakRssKb;    //!< Peak resident set size after the run.
+  uint64_t allocations;  //!< Heap allocations during the run.
+};
+
+/**
+ * Scheduler stress: keep a population of events pending, and reschedule
+ * each one on expiry with a delay drawn from a random variable.
+ */
+class SchedulerStress
+{
+public:
+  /**
+   * Constructor.
+   * \param [in] delay The inter-event delay distribution, in ns.
+   * \param [in] total The number of events to execute.
+   */
+  SchedulerStress (Ptr<RandomVariableStream> delay, uint32_t total)
+    : m_delay (delay),
+      m_total (total),
+      m_count (0)
+  {
+  }
+  /**
+   * Schedule the initial population.
+   * \param [in] population The number of pending events.
+   */
+  void Start (uint32_t population)
+  {
+    for (uint32_t i = 0; i < population; ++i)
+      {
+        Simulator::Schedule (NanoSeconds (m_delay->GetInteger ()),
+                             &SchedulerStress::Cb, this);
+      }
+  }
+
+private:
+  /// Event handler: reschedule until the total is reached.
+  void Cb (void)
+  {
+    if (m_count >= m_total)
+      {
+        return;
+      }
+    ++m_count;
+    Simulator::Schedule (NanoSeconds (m_delay->GetInteger ()),
+                         &SchedulerStress::Cb, this);
+  }
+
+  Ptr<RandomVariableStream> m_delay; //!< Inter-event delay, in ns.
+  uint32_t m_total;                  //!< Events to execute.
+  uint32_t m_count;                  //!< Events executed so far.
+};
+
+/**
+ * Bursty scheduler workload: heavy-tailed (Pareto) delays, so that most
+ * events are clustered near the head of the queue with a long tail.
+ * \param [in] params The workload sizes.
+ */
+void
+RunSchedulerBursty (const BenchParams & params)
+{
+  Ptr<ParetoRandomVariable> delay = CreateObject<ParetoRandomVariable> ();
+  delay->SetAttribute ("Scale", DoubleValue (10));
+  delay->SetAttribute ("Shape", DoubleValue (1.2));
+  delay->SetAttribute ("Bound", DoubleValue (1e7));
+  SchedulerStress bench (delay, params.events);
+  bench.Start (params.population);
+  Simulator::Run ();
+}
+
+/**
+ * Paced scheduler workload: near-constant delays with a little jitter,
+ * as produced by rate-paced transmitters.
+ * \param [in] params The workload sizes.
+ */
+void
+RunSchedulerPaced (const BenchParams & params)
+{
+  Ptr<UniformRandomVariable> delay = CreateObject<UniformRandomVariable> ();
+  delay->SetAttribute ("Min", DoubleValue (990));
+  delay->SetAttribute ("Max", DoubleValue (1010));
+  SchedulerStress bench (delay, params.events);
+  bench.Start (params.population);
+  Simulator::Run ();
+}
+
+/**
+ * Packet churn: create packets, add and remove headers and tags,
+ * fragment and reassemble them.  No events are scheduled.
+ * \param [in] params The workload sizes.
+ */
+void
+RunPacketChurn (const BenchParams & params)
+{
+  SocketPriorityTag priority;
+  priority.SetPriority (3);
+  FlowIdTag flowId (7);
+  for (uint32_t i = 0; i < params.packets; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (1400);
+      UdpHeader udp;
+      udp.SetSourcePort (1000);
+      udp.SetDestinationPort (2000);
+      p->AddHeader (udp);
+      Ipv4Header ipv4;
+      ipv4.SetPayloadSize (p->GetSize ());
+      p->AddHeader (ipv4);
+      p->AddPacketTag (priority);
+      p->AddByteTag (flowId);
+
+      Ptr<Packet> reassembled = p->CreateFragment (0, 500);
+      for (uint32_t offset = 500; offset < p->GetSize (); offset += 500)
+        {
+          uint32_t size = std::min<uint32_t> (500, p->GetSize () - offset);
+          reassembled->AddAtEnd (p->CreateFragment (offset, size));
+        }
+
+      reassembled->RemoveHeader (ipv4);
+      reassembled->RemoveHeader (udp);
+      reassembled->RemovePacketTag (priority);
+      reassembled->RemoveAllByteTags ();
+    }
+}
+
+/**
+ * Uniform random draws made one at a time, as error models and
+ * backoff procedures make them.
+ * \param [in] params The workload sizes.
+ */
+void
+RunRngDraws (const BenchParams & params)
+{
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  double sum = 0;
+  for (uint32_t i = 0; i < params.draws; ++i)
+    {
+      sum += u->GetValue ();
+    }
+  NS_ABORT_IF (sum < 0);
+}
+
+/**
+ * The same uniform random draws as rng-draws, made in batches
+ * through RandomVariableStream::GetValues.
+ * \param [in] params The workload sizes.
+ */
+void
+RunRngBatchDraws (const BenchParams & params)
+{
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  double values[64];
+  double sum = 0;
+  for (uint32_t i = 0; i < params.draws; i += 64)
+    {
+      uint32_t n = std::min<uint32_t> (64, params.draws - i);
+      u->GetValues (values, n);
+      for (uint32_t j = 0; j < n; ++j)
+        {
+          sum += values[j];
+        }
+    }
+  NS_ABORT_IF (sum < 0);
+}
+
+/**
+ * A forwarding hop, mimicking Ipv4L3Protocol::Receive, which builds
+ * the unicast, multicast, local delivery and error callbacks for
+ * every packet and passes them by value to the routing protocol.
+ *
+ * \tparam UCB \explicit The unicast forward callback type.
+ * \tparam LCB \explicit The local delivery callback type.
+ */
+template <typename UCB, typename LCB>
+class ForwardingHop
+{
+public:
+  ForwardingHop ()
+    : m_next (0),
+      m_delivered (0)
+  {
+  }
+  /**
+   * Set the next hop.
+   * \param [in] next The next hop, or 0 for the last hop.
+   */
+  void SetNext (ForwardingHop * next)
+  {
+    m_next = next;
+  }
+  /**
+   * Receive a packet: the routing decision picks one of the callbacks.
+   * \param [in] p The packet.
+   * \param [in] ucb The unicast forward callback.
+   * \param [in] mcb The multicast forward callback.
+   * \param [in] lcb The local delivery callback.
+   * \param [in] ecb The error callback.
+   */
+  void RouteInput (Ptr<Packet> p, UCB ucb, UCB mcb, LCB lcb, LCB ecb)
+  {
+    if (m_next != 0)
+      {
+        ucb (p);
+      }
+    else
+      {
+        lcb (p);
+      }
+  }
+  /**
+   * Forward a packet to the next hop.
+   * \param [in] p The packet.
+   */
+  void Forward (Ptr<Packet> p)
+  {
+    m_next->Receive (p);
+  }
+  /**
+   * Deliver a packet locally.
+   * \param [in] p The packet.
+   */
+  void Deliver (Ptr<Packet> p)
+  {
+    ++m_delivered;
+  }
+  /**
+   * Receive a packet.
+   * \param [in] p The packet.
+   */
+  void Receive (Ptr<Packet> p);
+
+  ForwardingHop * m_next;   //!< The next hop.
+  uint32_t m_delivered;     //!< Packets delivered locally.
+};
+
+template <>
+void
+ForwardingHop<Callback<void, Ptr<Packet> >, Callback<void, Ptr<Packet> > >::Receive (Ptr<Packet> p)
+{
+  RouteInput (p,
+              MakeCallback (&ForwardingHop::Forward, this),
+              MakeCallback (&ForwardingHop::Forward, this),
+              MakeCallback (&ForwardingHop::Deliver, this),
+              MakeCallback (&ForwardingHop::Deliver, this));
+}
+
+template <>
+void
+ForwardingHop<InlineCallback<void, Ptr<Packet> >, InlineCallback<void, Ptr<Packet> > >::Receive (Ptr<Packet> p)
+{
+  RouteInput (p,
+              MakeInlineCallback (&ForwardingHop::Forward, this),
+              MakeInlineCallback (&ForwardingHop::Forward, this),
+              MakeInlineCallback (&ForwardingHop::Deliver, this),
+              MakeInlineCallback (&ForwardingHop::Deliver, this));
+}
+
+/**
+ * Forward packets along a chain of hops.
+ * \tparam CB \explicit The callback type.
+ * \param [in] params The workload sizes.
+ */
+template <typename CB>
+void
+RunForwarding (const BenchParams & params)
+{
+  std::vector<ForwardingHop<CB, CB> > hops (8);
+  for (std::size_t i = 0; i + 1 < hops.size (); ++i)
+    {
+      hops[i].SetNext (&hops[i + 1]);
+    }
+  Ptr<Packet> p = Create<Packet> (1400);
+  for (uint32_t i = 0; i < params.packets; ++i)
+    {
+      hops[0].Receive (p);
+    }
+  NS_ABORT_IF (hops.back ().m_delivered != params.packets);
+}
+
+/**
+ * TCP bulk transfer over a dumbbell: N senders and N receivers
+ * attached to two routers joined by a bottleneck link.
+ * \param [in] params The workload sizes.
+ */
+void
+RunTcpDumbbell (const BenchParams & params)
+{
+  NodeContainer routers;
+  routers.Create (2);
+  NodeContainer senders;
+  senders.Create (params.flows);
+  NodeContainer receivers;
+  receivers.Create (params.flows);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper access;
+  access.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+  access.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  bottleneck.SetChannelAttribute ("Delay", StringValue ("10ms"));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.0.0", "255.255.255.0");
+  address.Assign (bottleneck.Install (routers.Get (0), routers.Get (1)));
+
+  std::vector<Ipv4Address> sinkAddresses;
+  for (uint32_t i = 0; i < params.flows; ++i)
+    {
+      address.NewNetwork ();
+      address.Assign (access.Install (senders.Get (i), routers.Get (0)));
+      address.NewNetwork ();
+      Ipv4InterfaceContainer rx =
+        address.Assign (access.Install (receivers.Get (i), routers.Get (1)));
+      sinkAddresses.push_back (rx.GetAddress (0));
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5000;
+  for (uint32_t i = 0; i < params.flows; ++i)
+    {
+      BulkSendHelper source ("ns3::TcpSocketFactory",
+                             InetSocketAddress (sinkAddresses[i], port));
+      source.SetAttribute ("MaxBytes", UintegerValue (0));
+      source.Install (senders.Get (i)).Start (Seconds (0));
+
+      PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                             InetSocketAddress (Ipv4Address::GetAny (), port));
+      sink.Install (receivers.Get (i)).Start (Seconds (0));
+    }
+
+  Simulator::Stop (params.duration);
+  Simulator::Run ();
+}
+
+#ifdef NS3_BENCH_WIFI
+/**
+ * Dense Wi-Fi BSS: one access point and many stations, all sending
+ * saturating UDP traffic to the access point.
+ * \param [in] params The workload sizes.
+ */
+void
+RunWifiDense (const BenchParams & params)
+{
+  NodeContainer ap;
+  ap.Create (1);
+  NodeContainer stations;
+  stations.Create (params.stations);
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211n_5GHZ);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("HtMcs7"),
+                                "ControlMode", StringValue ("HtMcs0"));
+  WifiMacHelper mac;
+  Ssid ssid = Ssid ("bench");
+  mac.SetType ("ns3::StaWifiMac", "Ssid", SsidValue (ssid));
+  NetDeviceContainer staDevices = wifi.Install (phy, mac, stations);
+  mac.SetType ("ns3::ApWifiMac", "Ssid", SsidValue (ssid));
+  NetDeviceContainer apDevice = wifi.Install (phy, mac, ap);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (1.0),
+                                 "DeltaY", DoubleValue (1.0),
+                                 "GridWidth", UintegerValue (10),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (ap);
+  mobility.Install (stations);
+
+  InternetStackHelper stack;
+  stack.Install (ap);
+  stack.Install (stations);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.2.0.0", "255.255.0.0");
+  Ipv4InterfaceContainer apInterface = address.Assign (apDevice);
+  address.Assign (staDevices);
+
+  uint16_t port = 9;
+  UdpServerHelper server (port);
+  server.Install (ap).Start (Seconds (0));
+  UdpClientHelper client (apInterface.GetAddress (0), port);
+  client.SetAttribute ("MaxPackets", UintegerValue (0));
+  client.SetAttribute ("Interval", TimeValue (MicroSeconds (500)));
+  client.SetAttribute ("PacketSize", UintegerValue (1000));
+  client.Install (stations).Start (Seconds (0.1));
+
+  Simulator::Stop (params.duration);
+  Simulator::Run ();
+}
+#endif /* NS3_BENCH_WIFI */
+
+#ifdef NS3_BENCH_LTE
+/**
+ * Single LTE cell: one eNB and many UEs with full-buffer (saturation
+ * mode RLC) data radio bearers, without the EPC.
+ * \param [in] params The workload sizes.
+ */
+void
+RunLteCell (const BenchParams & params)
+{
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+
+  NodeContainer enbNodes;
+  enbNodes.Create (1);
+  NodeContainer ueNodes;
+  ueNodes.Create (params.ues);
+
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (enbNodes);
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (500.0));
+  mobility.Install (ueNodes);
+
+  NetDeviceContainer enbDevs = lteHelper->InstallEnbDevice (enbNodes);
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  lteHelper->Attach (ueDevs, enbDevs.Get (0));
+  EpsBearer bearer (EpsBearer::NGBR_VIDEO_TCP_DEFAULT);
+  lteHelper->ActivateDataRadioBearer (ueDevs, bearer);
+
+  Simulator::Stop (params.duration);
+  Simulator::Run ();
+}
+#endif /* NS3_BENCH_LTE */
+
+/**
+ * Global routing set up in a k-ary fat-tree of point-to-point links.
+ * Only the routing table computation is simulated; no traffic is sent.
+ * \param [in] params The workload sizes.
+ */
+void
+RunFatTreeRouting (const BenchParams & params)
+{
+  NS_ABORT_MSG_IF (params.k % 2 != 0, "The fat-tree arity must be even");
+  uint32_t k = params.k;
+  uint32_t half = k / 2;
+  NodeContainer core;
+  core.Create (half * half);
+  NodeContainer aggregation;
+  aggregation.Create (k * half);
+  NodeContainer edge;
+  edge.Create (k * half);
+  NodeContainer hosts;
+  hosts.Create (k * half * half);
+
+  InternetStackHelper stack;
+  stack.InstallAll ();
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1us"));
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.252");
+
+  for (uint32_t pod = 0; pod < k; ++pod)
+    {
+      for (uint32_t e = 0; e < half; ++e)
+        {
+          Ptr<Node> edgeNode = edge.Get (pod * half + e);
+          for (uint32_t h = 0; h < half; ++h)
+            {
+              Ptr<Node> host = hosts.Get ((pod * half + e) * half + h);
+              address.Assign (link.Install (host, edgeNode));
+              address.NewNetwork ();
+            }
+          for (uint32_t a = 0; a < half; ++a)
+            {
+              address.Assign (link.Install (edgeNode, aggregation.Get (pod * half + a)));
+              address.NewNetwork ();
+            }
+        }
+      for (uint32_t a = 0; a < half; ++a)
+        {
+          Ptr<Node> aggNode = aggregation.Get (pod * half + a);
+          for (uint32_t c = 0; c < half; ++c)
+            {
+              address.Assign (link.Install (aggNode, core.Get (a * half + c)));
+              address.NewNetwork ();
+            }
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  Simulator::Run ();
+}
+
+/// A named benchmark workload.
+struct Workload
+{
+  const char * name;                          //!< Workload name.
+  void (*run) (const BenchParams & params);   //!< Workload function.
+};
+
+/// All workloads compiled into this program.
+const Workload g_workloads[] = {
+  { "sched-bursty",      &RunSchedulerBursty },
+  { "sched-paced",       &RunSchedulerPaced },
+  { "packet-churn",      &RunPacketChurn },
+  { "rng-draws",         &RunRngDraws },
+  { "rng-batch-draws",   &RunRngBatchDraws },
+  { "forward-callback",  &RunForwarding<Callback<void, Ptr<Packet> > > },
+  { "forward-inline-callback", &RunForwarding<InlineCallback<void, Ptr<Packet> > > },
+  { "tcp-dumbbell",      &RunTcpDumbbell },
+#ifdef NS3_BENCH_WIFI
+  { "wifi-dense",        &RunWifiDense },
+#endif
+#ifdef NS3_BENCH_LTE
+  { "lte-cell",          &RunLteCell },
+#endif
+  { "fat-tree-routing",  &RunFatTreeRouting },
+};
+
+/**
+ * Run one workload and measure it.
+ * \param [in] workload The workload to run.
+ * \param [in] params The workload sizes.
+ * \param [in] run The run index, which is also the RNG run number.
+ * \returns The measurements.
+ */
+BenchResult
+RunWorkload (const Workload & workload, const BenchParams & params, uint32_t run)
+{
+  RngSeedManager::SetRun (run + 1);
+  Ipv4AddressGenerator::Reset ();
+
+  BenchResult result;
+  result.workload = workload.name;
+  result.run = run;
+
+  uint64_t allocations = g_allocations;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+  workload.run (params);
+  result.events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  result.wallSeconds = std::chrono::duration<double> (end - start).count ();
+  result.allocations = g_allocations - allocations;
+  result.peakRssKb = GetPeakRss ();
+  return result;
+}
+
+/**
+ * Write the results as JSON.
+ * \param [in] os The output stream.
+ * \param [in] results The results to write.
+ */
+void
+WriteJson (std::ostream & os, const std::vector<BenchResult> & results)
+{
+  os << "{" << std::endl;
+  os << " \"benchmark\" : \"bench-suite\"," << std::endl;
+  os << " \"results\" : [" << std::endl;
+  for (std::size_t i = 0; i < results.size (); ++i)
+    {
+      const BenchResult & r = results[i];
+      double rate = r.wallSeconds > 0 ? r.events / r.wallSeconds : 0;
+      os << "  {\"workload\" : \"" << r.workload << "\""
+         << ", \"run\" : " << r.run
+         << ", \"wall_s\" : " << r.wallSeconds
+         << ", \"events\" : " << r.events
+         << ", \"events_per_s\" : " << rate
+         << ", \"peak_rss_kb\" : " << r.peakRssKb
+         << ", \"allocations\" : " << r.allocations
+         << "}" << (i + 1 < results.size () ? "," : "") << std::endl;
+    }
+  os << " ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+}  // unnamed namespace
+
+
+int main (int argc, char *argv[])
+{
+  BenchParams params;
+  params.events = 1000000;
+  params.population = 100000;
+  params.packets = 100000;
+  params.draws = 10000000;
+  params.flows = 10;
+  params.stations = 50;
+  params.ues = 50;
+  params.k = 8;
+  params.duration = Seconds (5);
+
+  std::string workloads = "";
+  std::string jsonFile = "";
+  uint32_t runs = 1;
+
+  std::ostringstream available;
+  for (std::size_t i = 0; i < sizeof (g_workloads) / sizeof (g_workloads[0]); ++i)
+    {
+      available << (i ? "," : "") << g_workloads[i].name;
+    }
+
+  CommandLine cmd;
+  cmd.Usage ("Run a suite of reproducible simulator benchmarks.\n"
+             "\n"
+             "Available workloads: " + available.str () + "\n"
+             "The peak RSS is that of the whole process, so it can only\n"
+             "grow from one workload to the next.");
+  cmd.AddValue ("workloads",  "comma separated workloads to run (default all)", workloads);
+  cmd.AddValue ("runs",       "number of runs of each workload",               runs);
+  cmd.AddValue ("json",       "write the results as JSON to this file",        jsonFile);
+  cmd.AddValue ("events",     "events executed by the sched-* workloads",      params.events);
+  cmd.AddValue ("population", "pending events in the sched-* workloads",       params.population);
+  cmd.AddValue ("packets",    "packets created by packet-churn and forward-*", params.packets);
+  cmd.AddValue ("draws",      "values drawn by the rng-* workloads",           params.draws);
+  cmd.AddValue ("flows",      "TCP flows in tcp-dumbbell",                     params.flows);
+  cmd.AddValue ("stations",   "stations in wifi-dense",                        params.stations);
+  cmd.AddValue ("ues",        "UEs in lte-cell",                               params.ues);
+  cmd.AddValue ("k",          "fat-tree arity in fat-tree-routing",            params.k);
+  cmd.AddValue ("duration",   "simulated time of the network workloads",       params.duration);
+  cmd.Parse (argc, argv);
+
+  if (workloads == "")
+    {
+      workloads = available.str ();
+    }
+
+  std::vector<const Workload *> selected;
+  std::istringstream names (workloads);
+  std::string name;
+  while (std::getline (names, name, ','))
+    {
+      const Workload * found = 0;
+      for (std::size_t i = 0; i < sizeof (g_workloads) / sizeof (g_workloads[0]); ++i)
+        {
+          if (name == g_workloads[i].name)
+            {
+              found = &g_workloads[i];
+            }
+        }
+      if (found == 0)
+        {
+          std::cerr << "Unknown workload '" << name << "', available: "
+                    << available.str () << std::endl;
+          return 1;
+        }
+      selected.push_back (found);
+    }
+
+  std::cout << std::left << std::setw (26) << "Workload"
+            << std::right << std::setw (5) << "Run"
+            << std::setw (12) << "Wall (s)"
+            << std::setw (14) << "Events"
+            << std::setw (14) << "Rate (ev/s)"
+            << std::setw (14) << "Peak RSS (kB)"
+            << std::setw (14) << "Allocations" << std::endl;
+
+  std::vector<BenchResult> results;
+  for (std::size_t w = 0; w < selected.size (); ++w)
+    {
+      for (uint32_t run = 0; run < runs; ++run)
+        {
+          BenchResult r = RunWorkload (*selected[w], params, run);
+          double rate = r.wallSeconds > 0 ? r.events / r.wallSeconds : 0;
+          std::cout << std::left << std::setw (26) << r.workload
+                    << std::right << std::setw (5) << r.run
+                    << std::setw (12) << std::fixed << std::setprecision (3) << r.wallSeconds
+                    << std::setw (14) << r.events
+                    << std::setw (14) << std::setprecision (0) << rate
+                    << std::setw (14) << r.peakRssKb
+                    << std::setw (14) << r.allocations << std::endl;
+          results.push_back (r);
+        }
+    }
+
+  if (jsonFile != "")
+    {
+      std::ofstream os (jsonFile.c_str ());
+      WriteJson (os, results);
+    }
+  return 0;
+}
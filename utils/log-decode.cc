@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Print a binary log written by LogBinarySink as text.
+//
+//   ./waf --run "log-decode --input=tcp.nslog"
+
+#include <fstream>
+#include <iostream>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.Usage ("Print a binary log written by LogBinarySink (NS_LOG_BINARY) as text.");
+  cmd.AddValue ("input", "The binary log to decode", input);
+  cmd.AddValue ("output", "The text file to write, instead of standard output", output);
+  cmd.Parse (argc, argv);
+
+  if (input.empty ())
+    {
+      std::cerr << "No --input binary log given" << std::endl;
+      return 1;
+    }
+  std::ifstream is (input.c_str (), std::ios::binary);
+  if (!is)
+    {
+      std::cerr << "Cannot open " << input << std::endl;
+      return 1;
+    }
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file)
+        {
+          std::cerr << "Cannot open " << output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+
+  if (!LogBinarySink::Decode (is, os))
+    {
+      std::cerr << input << " is not a valid binary log, or is truncated" << std::endl;
+      return 1;
+    }
+  return 0;
+}
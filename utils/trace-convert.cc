@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Print a binary trace written by BinaryTraceHelper as CSV or ASCII.
+//
+//   ./waf --run "trace-convert --input=example.nstrace --format=csv"
+
+#include <fstream>
+#include <iostream>
+
+#include "ns3/core-module.h"
+#include "ns3/binary-trace-file.h"
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string format = "csv";
+
+  CommandLine cmd;
+  cmd.Usage ("Print a binary trace written by BinaryTraceHelper as text.");
+  cmd.AddValue ("input", "The binary trace to convert", input);
+  cmd.AddValue ("output", "The text file to write, instead of standard output", output);
+  cmd.AddValue ("format", "The text format: csv or ascii", format);
+  cmd.Parse (argc, argv);
+
+  BinaryTraceFile::TextFormat textFormat;
+  if (format == "csv")
+    {
+      textFormat = BinaryTraceFile::CSV;
+    }
+  else if (format == "ascii")
+    {
+      textFormat = BinaryTraceFile::ASCII;
+    }
+  else
+    {
+      std::cerr << "Unknown --format " << format << ", use csv or ascii" << std::endl;
+      return 1;
+    }
+
+  if (input.empty ())
+    {
+      std::cerr << "No --input binary trace given" << std::endl;
+      return 1;
+    }
+  std::ifstream is (input.c_str (), std::ios::binary);
+  if (!is)
+    {
+      std::cerr << "Cannot open " << input << std::endl;
+      return 1;
+    }
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file)
+        {
+          std::cerr << "Cannot open " << output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+
+  if (!BinaryTraceFile::Convert (is, os, textFormat))
+    {
+      std::cerr << input << " is not a valid binary trace, or is truncated" << std::endl;
+      return 1;
+    }
+  return 0;
+}